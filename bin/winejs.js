@@ -0,0 +1,146 @@
+#!/usr/bin/env node
+import fs from 'fs';
+import path from 'path';
+import { CorpusPool } from '../src/runtime/headless/corpus-pool.js';
+import { buildCorpusReport } from '../src/runtime/headless/corpus-report.js';
+
+const IMAGE_EXTENSIONS = new Set(['.exe', '.dll']);
+
+const USAGE = `Usage: winejs run <file-or-directory...> [--max-steps N] [--jobs N] [--timeout MS] [--cache-dir DIR]
+                  [--real-time] [--json]
+
+  --max-steps N      Stop each image after N instructions (default 50000).
+  --jobs N           Worker threads for batch runs (default: core count).
+  --timeout MS       Wall-clock limit per image (default 10000); an image that
+                     runs past it is stopped and reported as a timeout.
+                     --time-limit is the same flag.
+  --cache-dir DIR    Keep parsed PE records and decoded code in DIR and start
+                     later runs of the same image from them.
+  --real-time        Let guest timers and waits take real time instead of
+                     fast-forwarding idle periods.
+  --json             Print machine-readable results instead of a text report.`;
+
+function readNumberFlag(name, value) {
+  const number = Number(value);
+  if (!Number.isInteger(number) || number <= 0) throw new Error(`--${name} expects a positive integer.`);
+  return number;
+}
+
+function parseArgs(argv) {
+  const [command, ...rest] = argv;
+  const options = {
+    command,
+    targets: [],
+    maxSteps: 50000,
+    jobs: undefined,
+    timeLimitMs: 10000,
+    fastForward: true,
+    cacheDirectory: null,
+    json: false,
+  };
+  const flags = { 'max-steps': 'maxSteps', jobs: 'jobs', timeout: 'timeLimitMs', 'time-limit': 'timeLimitMs' };
+  for (let i = 0; i < rest.length; i++) {
+    const arg = rest[i];
+    const [flag, inline] = arg.startsWith('--') ? arg.slice(2).split('=') : [];
+    if (flag === 'json') {
+      options.json = true;
+    } else if (flag === 'real-time') {
+      options.fastForward = false;
+    } else if (flag === 'cache-dir') {
+      options.cacheDirectory = inline ?? rest[++i];
+      if (!options.cacheDirectory) throw new Error('--cache-dir expects a directory.');
+    } else if (flag === 'help' || arg === '-h') {
+      options.command = 'help';
+    } else if (flags[flag]) {
+      options[flags[flag]] = readNumberFlag(flag, inline ?? rest[++i]);
+    } else {
+      options.targets.push(arg);
+    }
+  }
+  return options;
+}
+
+function collectImages(target) {
+  const stat = fs.statSync(target);
+  if (!stat.isDirectory()) return [target];
+  return fs
+    .readdirSync(target, { withFileTypes: true })
+    .sort((a, b) => (a.name < b.name ? -1 : 1))
+    .flatMap((entry) => {
+      const full = path.join(target, entry.name);
+      if (entry.isDirectory()) return collectImages(full);
+      return IMAGE_EXTENSIONS.has(path.extname(entry.name).toLowerCase()) ? [full] : [];
+    });
+}
+
+function printResult(result) {
+  const steps = result.stats.steps ?? '?';
+  const status = result.error ? `${result.exitReason}: ${result.error}` : result.exitReason;
+  console.log(`${result.file} — ${status} — ${steps} steps in ${result.stats.elapsedMs} ms`);
+  result.consoleLines.forEach((line) => console.log(`  | ${line}`));
+  if (result.imports.calls) {
+    const top = result.imports.top.map(({ key, count }) => `${key}×${count}`).join(', ');
+    console.log(`  imports: ${result.imports.calls} calls, ${result.imports.unique} unique (${top})`);
+  }
+}
+
+function printReport({ summary, failures, missingInstructions }) {
+  const reasons = Object.entries(summary.exitReasons)
+    .map(([reason, count]) => `${reason} ${count}`)
+    .join(', ');
+  console.log(
+    `\n${summary.files} images, ${summary.steps} steps in ${summary.elapsedMs} ms ` +
+      `(${summary.filesPerSecond ?? '-'} images/s, ${summary.stepsPerSecond ?? '-'} steps/s) — ${reasons}`,
+  );
+  const failureList = Object.entries(failures);
+  if (failureList.length) {
+    console.log(`failures: ${failureList.map(([reason, count]) => `${reason} ${count}`).join(', ')}`);
+  }
+  missingInstructions.forEach(({ instruction, count }) => console.log(`  missing ${instruction}: ${count}`));
+}
+
+async function runBatch(files, options, size = options.jobs) {
+  const pool = new CorpusPool({
+    size,
+    maxSteps: options.maxSteps,
+    timeLimitMs: options.timeLimitMs,
+    fastForward: options.fastForward,
+    cacheDirectory: options.cacheDirectory,
+  });
+  return pool.run(files, { onResult: (result) => !options.json && printResult(result) });
+}
+
+// A single image also runs in a worker, so a guest that spins or stays
+// parked past the timeout can be stopped like a batch job.
+async function runSingle(file, options) {
+  return runBatch([file], options, 1);
+}
+
+async function main() {
+  const options = parseArgs(process.argv.slice(2));
+  if (options.command !== 'run' || !options.targets.length) {
+    console.log(USAGE);
+    return options.command === 'help' ? 0 : 2;
+  }
+  const files = options.targets.flatMap(collectImages);
+  const batch = files.length > 1 || options.targets.some((target) => fs.statSync(target).isDirectory());
+  const started = performance.now();
+  const results = batch ? await runBatch(files, options) : await runSingle(files[0], options);
+  const report = buildCorpusReport(results, performance.now() - started);
+  if (options.json) {
+    console.log(JSON.stringify(batch ? { results, ...report } : results[0], null, 2));
+  } else if (batch) {
+    printReport(report);
+  }
+  return results.some((result) => result.exitReason === 'error' || result.exitReason === 'timeout') ? 1 : 0;
+}
+
+main().then(
+  (code) => {
+    process.exitCode = code;
+  },
+  (err) => {
+    console.error(`winejs: ${err?.message ?? err}`);
+    process.exitCode = 2;
+  },
+);
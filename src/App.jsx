@@ -22,6 +22,7 @@ import { useTaskManager } from './hooks/useTaskManager.js';
 
 function App() {
   const [statusText, setStatusText] = React.useState('Load a `.exe` to inspect imports or render a mock window.');
+  const [cacheStatus, setCacheStatus] = React.useState(null);
   const consoleRef = React.useRef(null);
   const stringRef = React.useRef(null);
   const canvasRef = React.useRef(null);
@@ -37,6 +38,7 @@ function App() {
     canvasRef,
     statusRef,
     setStatusText,
+    setCacheStatus,
     wineRef,
   });
 
@@ -155,6 +157,25 @@ function App() {
               borderColor: theme.palette.secondary.main,
               boxShadow: `0 0 32px ${alpha(theme.palette.secondary.main, 0.5)}`,
             },
+            '.canvasContainer canvas.compositorOutput': {
+              left: 0,
+              top: 0,
+              border: 'none',
+              borderRadius: 0,
+              background: 'transparent',
+              boxShadow: 'none',
+              pointerEvents: 'none',
+            },
+            '.canvasContainer .compositorWindow': {
+              position: 'absolute',
+              outline: `2px solid ${theme.custom?.canvasBorder ?? theme.palette.primary.main}`,
+              borderRadius: 8,
+              boxShadow: `0 12px 40px ${theme.custom?.canvasGlow ?? alpha(theme.palette.common.black, 0.4)}`,
+            },
+            ".canvasContainer .compositorWindow[data-directx-bridge='webgl']": {
+              outlineColor: theme.palette.secondary.main,
+              boxShadow: `0 0 32px ${alpha(theme.palette.secondary.main, 0.5)}`,
+            },
             '.telemetryList': {
               maxHeight: 260,
               overflowY: 'auto',
@@ -205,7 +226,7 @@ function App() {
         </AppBar>
         <Container maxWidth="lg" sx={{ py: 4 }}>
           <Stack spacing={3}>
-            <StatusCard statusText={statusText} statusRef={statusRef} selectedFile={selectedFile} />
+            <StatusCard statusText={statusText} statusRef={statusRef} selectedFile={selectedFile} cacheStatus={cacheStatus} />
             <Grid container spacing={3}>
               <Grid item xs={12} md={6}>
                 <FileLoaderCard disabled={!wine || isSimulating} isSimulating={isSimulating} onSelect={handleFileSelect} />
@@ -4,7 +4,7 @@ import { alpha } from '@mui/material/styles';
 import TerminalIcon from '@mui/icons-material/Terminal';
 import { formatFileSize } from '../utils/formatters.js';
 
-function StatusCard({ statusText, statusRef, selectedFile }) {
+function StatusCard({ statusText, statusRef, selectedFile, cacheStatus }) {
   return (
     <Card
       variant="outlined"
@@ -31,9 +31,19 @@ function StatusCard({ statusText, statusRef, selectedFile }) {
               </Typography>
             </Alert>
           </Box>
-          {selectedFile ? (
-            <Chip color="secondary" variant="outlined" label={`${selectedFile.name} • ${formatFileSize(selectedFile.size)}`} />
-          ) : null}
+          <Stack direction="row" spacing={1} alignItems="flex-start">
+            {cacheStatus ? (
+              <Chip
+                size="small"
+                color={cacheStatus === 'hit' ? 'success' : 'default'}
+                variant="outlined"
+                label={cacheStatus === 'hit' ? 'Cache hit' : 'Cache miss'}
+              />
+            ) : null}
+            {selectedFile ? (
+              <Chip color="secondary" variant="outlined" label={`${selectedFile.name} • ${formatFileSize(selectedFile.size)}`} />
+            ) : null}
+          </Stack>
         </Stack>
       </CardContent>
     </Card>
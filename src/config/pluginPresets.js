@@ -1,7 +1,13 @@
 import { createConsoleAPIPlugin } from '../runtime/plugins/console-api-plugin.js';
-import { createDirectXWebGLPlugin } from '../runtime/plugins/directx-webgl-plugin.js';
+import { createDirectXWebGLPlugin, createWebGLPresenter } from '../runtime/plugins/directx-webgl-plugin.js';
 import { createConsoleOutputImportPlugin } from '../runtime/import-plugins/console-output-plugin.js';
 import { createWinsockWebSocketImportPlugin } from '../runtime/import-plugins/winsock-websocket-plugin.js';
+import { createModuleLoaderImportPlugin } from '../runtime/import-plugins/module-loader-plugin.js';
+import { createWaitImportPlugin } from '../runtime/import-plugins/wait-plugin.js';
+import { createUser32ImportPlugin } from '../runtime/import-plugins/user32-plugin.js';
+import { createGdiImportPlugin } from '../runtime/import-plugins/gdi-plugin.js';
+import { createDirect2DImportPlugin } from '../runtime/import-plugins/direct2d-plugin.js';
+import { createTimeImportPlugin } from '../runtime/import-plugins/time-plugin.js';
 import { createX86SimulatorPlugin } from '../runtime/simulator/plugins/x86-simulator-plugin.js';
 
 export const pluginSections = [
@@ -61,6 +67,49 @@ export const pluginSections = [
     type: 'import',
     title: 'Import Plugins',
     plugins: [
+      {
+        id: 'user32-messages',
+        label: 'Win32 Message Loop',
+        description: 'Runs guest window procedures through real user32 queues, SendMessage and timers.',
+        defaultEnabled: true,
+        fields: [],
+        factory: (settings, helpers) =>
+          createUser32ImportPlugin({
+            getWindowManager: () => helpers.getWine?.()?.windowManager,
+            getClock: () => helpers.getWine?.()?.clock,
+            waitForObject: (handle, options) => helpers.getWine?.()?.waitForObject(handle, options),
+          }),
+      },
+      {
+        id: 'gdi32',
+        label: 'GDI Canvas',
+        description: 'Draws gdi32 pens, brushes, fonts and text into per-window canvases, batched per frame.',
+        defaultEnabled: true,
+        fields: [],
+        factory: (settings, helpers) =>
+          createGdiImportPlugin({
+            stationFor: (cpu) => helpers.getWine?.()?.stationFor(cpu),
+          }),
+      },
+      {
+        id: 'direct2d',
+        label: 'Direct2D Command Buffer',
+        description: 'Serves ID2D1Factory, render target and brush vtables natively and replays each frame in one pass.',
+        defaultEnabled: true,
+        fields: [
+          {
+            key: 'webgl',
+            label: 'Instanced WebGL replay',
+            type: 'boolean',
+            default: true,
+          },
+        ],
+        factory: (settings, helpers) =>
+          createDirect2DImportPlugin({
+            stationFor: (cpu) => helpers.getWine?.()?.stationFor(cpu),
+            presenter: settings.webgl ? createWebGLPresenter() : null,
+          }),
+      },
       {
         id: 'console-output',
         label: 'Console Import Hooks',
@@ -117,6 +166,47 @@ export const pluginSections = [
             autoConnect: Boolean(settings.autoConnect),
           }),
       },
+      {
+        id: 'module-loader',
+        label: 'Module Loader',
+        description: 'Maps loaded DLL images for LoadLibrary, GetModuleHandle and GetProcAddress.',
+        defaultEnabled: true,
+        fields: [],
+        factory: (settings, helpers) =>
+          createModuleLoaderImportPlugin({
+            log: (message) => helpers.log?.(message),
+          }),
+      },
+      {
+        id: 'kernel32-wait',
+        label: 'Blocking Waits',
+        description: 'Parks the guest on Sleep and WaitForSingleObject instead of returning immediately.',
+        defaultEnabled: true,
+        fields: [],
+        factory: (settings, helpers) =>
+          createWaitImportPlugin({
+            waitForObject: (handle, options) => helpers.getWine?.()?.waitForObject(handle, options),
+            schedule: (fn, ms) => {
+              const clock = helpers.getWine?.()?.clock;
+              return clock ? clock.setTimeout(fn, ms) : setTimeout(fn, ms);
+            },
+            unschedule: (id) => {
+              const clock = helpers.getWine?.()?.clock;
+              return clock ? clock.clearTimeout(id) : clearTimeout(id);
+            },
+          }),
+      },
+      {
+        id: 'virtual-time',
+        label: 'Virtual Clock',
+        description: 'Serves QueryPerformanceCounter, tick counts, system time and waitable timers from the virtual clock.',
+        defaultEnabled: true,
+        fields: [],
+        factory: (settings, helpers) =>
+          createTimeImportPlugin({
+            getClock: () => helpers.getWine?.()?.clock,
+          }),
+      },
     ],
   },
   {
@@ -0,0 +1,66 @@
+const LEAF_SHIFT = 10;
+const LEAF_PAGES = 1 << LEAF_SHIFT;
+const LEAF_WORDS = LEAF_PAGES >> 5;
+
+// Two-level dirty bitmap: a sparse directory of leaves, each leaf covering
+// 1024 pages with one summary word (bit per leaf word) above 32 bitmap words.
+export class DirtyPageBitmap {
+  constructor() {
+    this.leaves = new Map();
+    this.count = 0;
+  }
+
+  mark(page) {
+    const leafIndex = Math.floor(page / LEAF_PAGES);
+    let leaf = this.leaves.get(leafIndex);
+    if (!leaf) {
+      leaf = { summary: 0, words: new Uint32Array(LEAF_WORDS) };
+      this.leaves.set(leafIndex, leaf);
+    }
+    const slot = page - leafIndex * LEAF_PAGES;
+    const word = slot >>> 5;
+    const bit = 1 << (slot & 31);
+    if (leaf.words[word] & bit) return false;
+    leaf.words[word] |= bit;
+    leaf.summary |= 1 << word;
+    this.count++;
+    return true;
+  }
+
+  has(page) {
+    const leafIndex = Math.floor(page / LEAF_PAGES);
+    const leaf = this.leaves.get(leafIndex);
+    if (!leaf) return false;
+    const slot = page - leafIndex * LEAF_PAGES;
+    return (leaf.words[slot >>> 5] & (1 << (slot & 31))) !== 0;
+  }
+
+  forEach(fn) {
+    const leafIndexes = Array.from(this.leaves.keys()).sort((a, b) => a - b);
+    for (const leafIndex of leafIndexes) {
+      const leaf = this.leaves.get(leafIndex);
+      let summary = leaf.summary;
+      while (summary) {
+        const word = 31 - Math.clz32(summary & -summary);
+        summary &= summary - 1;
+        let bits = leaf.words[word];
+        while (bits) {
+          const bit = 31 - Math.clz32(bits & -bits);
+          bits &= bits - 1;
+          fn(leafIndex * LEAF_PAGES + word * 32 + bit);
+        }
+      }
+    }
+  }
+
+  pages() {
+    const pages = [];
+    this.forEach((page) => pages.push(page));
+    return pages;
+  }
+
+  clear() {
+    this.leaves.clear();
+    this.count = 0;
+  }
+}
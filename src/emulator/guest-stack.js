@@ -0,0 +1,90 @@
+import { MemoryRegion } from './memory-region.js';
+
+export const PAGE_SIZE = 0x1000;
+export const DEFAULT_STACK_RESERVE = 0x100000;
+export const DEFAULT_STACK_COMMIT = 0x1000;
+export const STACK_TOP = 0x100000000n;
+
+function alignToPage(value) {
+  return Math.ceil(value / PAGE_SIZE) * PAGE_SIZE;
+}
+
+export class GuestStack extends MemoryRegion {
+  constructor({ top = STACK_TOP, reserve = DEFAULT_STACK_RESERVE, commit = DEFAULT_STACK_COMMIT } = {}) {
+    const reserveBytes = alignToPage(Math.max(Number(reserve) || DEFAULT_STACK_RESERVE, PAGE_SIZE * 2));
+    const commitBytes = Math.min(
+      alignToPage(Math.max(Number(commit) || DEFAULT_STACK_COMMIT, PAGE_SIZE)),
+      reserveBytes - PAGE_SIZE * 2,
+    );
+    super({ base: top - BigInt(reserveBytes), bytes: new Uint8Array(reserveBytes), name: 'stack' });
+    this.buffer = this.bytes.buffer;
+    this.qwords = new BigUint64Array(this.buffer);
+    this.initialCommitOffset = reserveBytes - commitBytes;
+    this.committedOffset = this.initialCommitOffset;
+  }
+
+  get guardOffset() {
+    return this.committedOffset - PAGE_SIZE;
+  }
+
+  get guardPage() {
+    return this.base + BigInt(this.guardOffset);
+  }
+
+  get initialPointer() {
+    return this.top - 8n;
+  }
+
+  ensureCommitted(offset) {
+    if (offset >= this.committedOffset) return;
+    const guardOffset = this.guardOffset;
+    if (offset < guardOffset) {
+      const address = this.base + BigInt(offset);
+      throw new Error(`Stack access violation at 0x${address.toString(16)} below guard page.`);
+    }
+    if (guardOffset < PAGE_SIZE) {
+      throw new Error('Stack overflow: guard page exhausted.');
+    }
+    this.committedOffset = guardOffset;
+  }
+
+  offsetOf(address) {
+    const offset = Number(address - this.base);
+    if (offset < this.committedOffset) this.ensureCommitted(offset);
+    return offset;
+  }
+
+  readUInt64(address) {
+    const offset = this.offsetOf(address);
+    if ((offset & 7) === 0) return this.qwords[offset >> 3];
+    return this.view.getBigUint64(offset, true);
+  }
+
+  writeUInt64(address, value) {
+    const offset = this.offsetOf(address);
+    const masked = BigInt.asUintN(64, BigInt(value));
+    if ((offset & 7) === 0) {
+      this.qwords[offset >> 3] = masked;
+    } else {
+      this.view.setBigUint64(offset, masked, true);
+    }
+  }
+
+  readUInt(address, size) {
+    if (size === 8) return this.readUInt64(address);
+    return super.readUInt(address, size);
+  }
+
+  writeUInt(address, size, value) {
+    if (size === 8) {
+      this.writeUInt64(address, value);
+      return;
+    }
+    super.writeUInt(address, size, value);
+  }
+
+  reset() {
+    this.bytes.fill(0);
+    this.committedOffset = this.initialCommitOffset;
+  }
+}
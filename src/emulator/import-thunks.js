@@ -0,0 +1,53 @@
+import { normalizeModuleName } from './module-loader.js';
+
+export const THUNK_BASE = 0x7ffe00000000n;
+export const THUNK_STRIDE = 8n;
+export const THUNK_REGION_SIZE = 0x10000;
+export const THUNK_LIMIT = THUNK_BASE + BigInt(THUNK_REGION_SIZE);
+// The last slot is never handed to an import: guest callbacks return here.
+export const CALLBACK_RETURN = THUNK_LIMIT - THUNK_STRIDE;
+
+// Every import gets a unique address inside a reserved region that holds no
+// code. The CPU dispatches by range-checking RIP against this region instead
+// of inspecting call operands.
+export class ImportThunks {
+  constructor(memory, { importTable = [], importIndex = new Map() } = {}) {
+    this.region = memory.mapRegion({
+      base: THUNK_BASE,
+      bytes: new Uint8Array(THUNK_REGION_SIZE),
+      name: 'import-thunks',
+    });
+    this.entries = importTable.slice();
+    this.index = new Map(importIndex);
+  }
+
+  get capacity() {
+    return THUNK_REGION_SIZE / Number(THUNK_STRIDE) - 1;
+  }
+
+  intern(dll, name, { hint = null, ordinal = null } = {}) {
+    const existing = this.index.get(`${dll}!${name}`);
+    if (existing) return existing;
+    const module = normalizeModuleName(dll);
+    const key = `${module}!${name}`;
+    let entry = this.index.get(key);
+    if (!entry) {
+      if (this.entries.length >= this.capacity) throw new Error('Import thunk region exhausted.');
+      entry = { id: this.entries.length, dll: module, name, key, hint, ordinal };
+      this.entries.push(entry);
+      this.index.set(key, entry);
+    }
+    return entry;
+  }
+
+  addressOf(id) {
+    return THUNK_BASE + BigInt(id) * THUNK_STRIDE;
+  }
+
+  entryAt(address) {
+    if (address < THUNK_BASE || address >= THUNK_LIMIT) return null;
+    const offset = address - THUNK_BASE;
+    if (offset % THUNK_STRIDE) return null;
+    return this.entries[Number(offset / THUNK_STRIDE)] ?? null;
+  }
+}
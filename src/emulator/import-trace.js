@@ -0,0 +1,72 @@
+export const DEFAULT_TRACE_CAPACITY = 4096;
+
+// Bounded record of import calls: the most recent calls live in parallel
+// typed-array rings (import ID, step, rax) while a per-ID counter table
+// keeps exact totals for the whole run.
+export class ImportTrace {
+  constructor({ capacity = DEFAULT_TRACE_CAPACITY, importCount = 0 } = {}) {
+    this.capacity = capacity;
+    this.ids = new Uint32Array(capacity);
+    this.steps = new Float64Array(capacity);
+    this.results = new BigUint64Array(capacity);
+    this.counts = new Uint32Array(Math.max(16, importCount));
+    this.total = 0;
+  }
+
+  get length() {
+    return Math.min(this.total, this.capacity);
+  }
+
+  record(id, step, rax) {
+    const slot = this.total % this.capacity;
+    this.ids[slot] = id;
+    this.steps[slot] = step;
+    this.results[slot] = BigInt.asUintN(64, rax);
+    if (id >= this.counts.length) {
+      const grown = new Uint32Array(Math.max(id + 1, this.counts.length * 2));
+      grown.set(this.counts);
+      this.counts = grown;
+    }
+    this.counts[id]++;
+    this.total++;
+  }
+
+  clear() {
+    this.counts.fill(0);
+    this.total = 0;
+  }
+
+  // Oldest-first view of the ring, resolved against the thunk entries.
+  recent(entries) {
+    const out = [];
+    const start = this.total - this.length;
+    for (let i = start; i < this.total; i++) {
+      const slot = i % this.capacity;
+      const entry = entries[this.ids[slot]];
+      out.push({ ...entry, step: this.steps[slot], rax: this.results[slot] });
+    }
+    return out;
+  }
+
+  counters(entries) {
+    const out = [];
+    for (let id = 0; id < this.counts.length; id++) {
+      const count = this.counts[id];
+      if (!count) continue;
+      const { key, dll, name } = entries[id] ?? {};
+      out.push({ id, key, dll, name, count });
+    }
+    return out;
+  }
+}
+
+export function countImports(trace = []) {
+  const counts = new Map();
+  trace.forEach((entry) => {
+    const key = entry?.key ?? `${entry?.dll ?? ''}!${entry?.name ?? ''}`;
+    const counter = counts.get(key) ?? { key, dll: entry?.dll, name: entry?.name, count: 0 };
+    counter.count++;
+    counts.set(key, counter);
+  });
+  return Array.from(counts.values());
+}
@@ -0,0 +1,64 @@
+export class MemoryRegion {
+  constructor({ base, bytes, name = 'region' }) {
+    this.base = base;
+    this.size = bytes.length;
+    this.top = base + BigInt(bytes.length);
+    this.name = name;
+    this.bytes = bytes;
+    this.view = new DataView(bytes.buffer, bytes.byteOffset, bytes.byteLength);
+  }
+
+  contains(address, size = 1) {
+    return address >= this.base && address + BigInt(size) <= this.top;
+  }
+
+  overlaps(base, size) {
+    return base < this.top && base + BigInt(size) > this.base;
+  }
+
+  offsetOf(address) {
+    return Number(address - this.base);
+  }
+
+  readByte(address) {
+    return this.bytes[this.offsetOf(address)];
+  }
+
+  readUInt(address, size) {
+    const offset = this.offsetOf(address);
+    switch (size) {
+      case 1:
+        return BigInt(this.bytes[offset]);
+      case 2:
+        return BigInt(this.view.getUint16(offset, true));
+      case 4:
+        return BigInt(this.view.getUint32(offset, true));
+      case 8:
+        return this.view.getBigUint64(offset, true);
+      default: {
+        let value = 0n;
+        for (let i = 0; i < size; i++) {
+          value |= BigInt(this.bytes[offset + i]) << BigInt(8 * i);
+        }
+        return value;
+      }
+    }
+  }
+
+  writeUInt(address, size, value) {
+    const offset = this.offsetOf(address);
+    if (size === 8) {
+      this.view.setBigUint64(offset, BigInt.asUintN(64, BigInt(value)), true);
+      return;
+    }
+    let tmp = BigInt(value);
+    for (let i = 0; i < size; i++) {
+      this.bytes[offset + i] = Number(tmp & 0xffn);
+      tmp >>= 8n;
+    }
+  }
+
+  write(address, bytes) {
+    this.bytes.set(bytes, this.offsetOf(address));
+  }
+}
@@ -0,0 +1,240 @@
+import { PeFile } from './pe-file.js';
+
+const MODULE_ALIGNMENT = 0x10000n;
+const DEFAULT_DLL_BASE = 0x180000000n;
+const VIRTUAL_MODULE_BASE = 0x7ffc00000000n;
+const MAX_FORWARDER_DEPTH = 8;
+// Loaded into every process before its entry point runs.
+const CORE_SYSTEM_MODULES = new Set(['ntdll.dll', 'kernel32.dll', 'kernelbase.dll']);
+
+function alignModule(value) {
+  return ((value + MODULE_ALIGNMENT - 1n) / MODULE_ALIGNMENT) * MODULE_ALIGNMENT;
+}
+
+export function normalizeModuleName(name) {
+  const base = String(name ?? '').split(/[\\/]/).pop().trim().toLowerCase();
+  if (!base) return '';
+  return base.includes('.') ? base : `${base}.dll`;
+}
+
+// DIR64 fixups are done as two 32-bit halves with a carry to stay off BigInt.
+// A DataView measures the same as Uint32Array views once warm (about 6 ms per
+// million fixups) and needs no alignment or host-endianness cases.
+export function applyRelocations(image, relocations, delta) {
+  if (!delta) return 0;
+  const view = new DataView(image.buffer, image.byteOffset, image.byteLength);
+  const wide = BigInt.asUintN(64, delta);
+  const deltaLo = Number(wide & 0xffffffffn);
+  const deltaHi = Number(wide >> 32n);
+  const { dir64, highLow } = relocations;
+  const limit = image.length;
+  let applied = 0;
+  for (let i = 0; i < dir64.length; i++) {
+    const offset = dir64[i];
+    if (offset + 8 > limit) continue;
+    const lo = view.getUint32(offset, true) + deltaLo;
+    const carry = lo > 0xffffffff ? 1 : 0;
+    view.setUint32(offset, lo >>> 0, true);
+    view.setUint32(offset + 4, (view.getUint32(offset + 4, true) + deltaHi + carry) >>> 0, true);
+    applied++;
+  }
+  for (let i = 0; i < highLow.length; i++) {
+    const offset = highLow[i];
+    if (offset + 4 > limit) continue;
+    view.setUint32(offset, (view.getUint32(offset, true) + deltaLo) >>> 0, true);
+    applied++;
+  }
+  return applied;
+}
+
+export class ModuleLoader {
+  constructor(memory, { resolveImage, thunks = null, nextBase = DEFAULT_DLL_BASE } = {}) {
+    this.memory = memory;
+    this.resolveImage = resolveImage;
+    this.thunks = thunks;
+    this.nextVirtualBase = VIRTUAL_MODULE_BASE;
+    this.nextBase = nextBase;
+    this.modules = new Map();
+    this.modulesByBase = new Map();
+    this.mainModule = null;
+  }
+
+  register(module) {
+    this.modules.set(module.name, module);
+    this.modulesByBase.set(module.base, module);
+    return module;
+  }
+
+  registerMainImage(pe, name = 'main.exe') {
+    this.mainModule = this.register({
+      name: normalizeModuleName(name),
+      pe,
+      base: pe.imageBase,
+      size: pe.sizeOfImage ?? 0,
+      region: null,
+      exports: this.indexExports(pe, pe.imageBase),
+    });
+    return this.mainModule;
+  }
+
+  isFree(base, size) {
+    if (!this.memory.isRangeFree(base, size)) return false;
+    for (const module of this.modules.values()) {
+      if (base < module.base + BigInt(module.size) && base + BigInt(size) > module.base) return false;
+    }
+    return true;
+  }
+
+  chooseBase(pe) {
+    if (this.isFree(pe.imageBase, pe.sizeOfImage)) return pe.imageBase;
+    let base = alignModule(this.nextBase);
+    while (!this.isFree(base, pe.sizeOfImage)) {
+      base = alignModule(base + BigInt(pe.sizeOfImage));
+    }
+    this.nextBase = alignModule(base + BigInt(pe.sizeOfImage));
+    return base;
+  }
+
+  indexExports(pe, base) {
+    const directory = pe.getExportDirectory?.();
+    if (!directory) return null;
+    const byOrdinal = new Map();
+    directory.functions.forEach((rva, index) => {
+      if (!rva) return;
+      byOrdinal.set(directory.ordinalBase + index, directory.forwarders.get(index) ?? base + BigInt(rva));
+    });
+    const byName = new Map();
+    directory.byName.forEach((index, name) => {
+      const value = byOrdinal.get(directory.ordinalBase + index);
+      if (value !== undefined) byName.set(name, value);
+    });
+    return { byName, byOrdinal };
+  }
+
+  mapImage(source, { name } = {}) {
+    const pe = source instanceof PeFile ? source : new PeFile(source);
+    const key = normalizeModuleName(name ?? pe.getExportDirectory()?.dll);
+    const existing = this.modules.get(key);
+    if (existing) return existing;
+    const base = this.chooseBase(pe);
+    const image = pe.createMappedImage();
+    const relocations = pe.getRelocations();
+    if (base !== pe.imageBase && !relocations.dir64.length && !relocations.highLow.length) {
+      throw new Error(`${key} cannot be rebased: no relocation data.`);
+    }
+    const relocated = applyRelocations(image, relocations, base - pe.imageBase);
+    const region = this.memory.mapRegion({ base, bytes: image, name: key });
+    const module = this.register({
+      name: key,
+      pe,
+      base,
+      size: pe.sizeOfImage,
+      region,
+      relocated,
+      exports: this.indexExports(pe, base),
+    });
+    this.bindImports(module);
+    return module;
+  }
+
+  getModule(nameOrBase) {
+    if (typeof nameOrBase === 'bigint') return this.modulesByBase.get(nameOrBase) ?? null;
+    return this.modules.get(normalizeModuleName(nameOrBase)) ?? null;
+  }
+
+  loadLibrary(name) {
+    const key = normalizeModuleName(name);
+    if (!key) return null;
+    const existing = this.modules.get(key);
+    if (existing) return existing;
+    const buffer = this.resolveImage?.(key);
+    if (!buffer) return null;
+    return this.mapImage(buffer, { name: key });
+  }
+
+  // Modules with no image on hand (system DLLs) get a handle whose exports
+  // all resolve to import thunks.
+  registerVirtualModule(name) {
+    const key = normalizeModuleName(name);
+    if (!key) return null;
+    const module = this.register({
+      name: key,
+      pe: null,
+      base: this.nextVirtualBase,
+      size: 0,
+      region: null,
+      exports: null,
+      virtual: true,
+    });
+    this.nextVirtualBase += MODULE_ALIGNMENT;
+    return module;
+  }
+
+  ensureModule(name) {
+    return this.loadLibrary(name) ?? this.registerVirtualModule(name);
+  }
+
+  // GetModuleHandle semantics: only modules that are already in the process
+  // count. Besides mapped ones, those are the core system DLLs and the DLLs
+  // the main image statically imports, which get a virtual module on first
+  // use. Nothing is mapped from `resolveImage` here.
+  findLoadedModule(name) {
+    const key = normalizeModuleName(name);
+    if (!key) return null;
+    const module = this.modules.get(key);
+    if (module) return module;
+    if (!CORE_SYSTEM_MODULES.has(key) && !this.staticImports().has(key)) return null;
+    return this.registerVirtualModule(key);
+  }
+
+  staticImports() {
+    const slots = this.mainModule?.pe?.getImportDirectory?.() ?? [];
+    return new Set(slots.filter((slot) => !slot.delayLoad).map((slot) => normalizeModuleName(slot.dll)));
+  }
+
+  getProcAddress(moduleOrName, nameOrOrdinal, depth = 0) {
+    const module =
+      typeof moduleOrName === 'object' && moduleOrName !== null ? moduleOrName : this.getModule(moduleOrName);
+    if (module?.virtual && this.thunks) {
+      const symbol = typeof nameOrOrdinal === 'number' ? `#${nameOrOrdinal}` : nameOrOrdinal;
+      const ordinal = typeof nameOrOrdinal === 'number' ? nameOrOrdinal : null;
+      return this.thunks.addressOf(this.thunks.intern(module.name, symbol, { ordinal }).id);
+    }
+    if (!module?.exports) return null;
+    const value =
+      typeof nameOrOrdinal === 'number'
+        ? module.exports.byOrdinal.get(nameOrOrdinal)
+        : module.exports.byName.get(nameOrOrdinal);
+    if (typeof value === 'string') return this.resolveForwarder(value, depth);
+    return value ?? null;
+  }
+
+  resolveForwarder(forwarder, depth) {
+    if (depth >= MAX_FORWARDER_DEPTH) return null;
+    const split = forwarder.lastIndexOf('.');
+    if (split <= 0) return null;
+    const target = this.loadLibrary(forwarder.slice(0, split));
+    if (!target) return null;
+    const symbol = forwarder.slice(split + 1);
+    const ordinal = symbol.startsWith('#') ? Number(symbol.slice(1)) : null;
+    return this.getProcAddress(target, ordinal ?? symbol, depth + 1);
+  }
+
+  bindImports(module) {
+    let bound = 0;
+    module.pe.getImportDirectory().forEach((slot) => {
+      const target = this.loadLibrary(slot.dll);
+      let address = target ? this.getProcAddress(target, slot.ordinal ?? slot.name) : null;
+      if (address != null) {
+        bound++;
+      } else if (this.thunks) {
+        address = this.thunks.addressOf(this.thunks.intern(slot.dll, slot.name, slot).id);
+      } else {
+        return;
+      }
+      const iatAddress = slot.iatAddress - module.pe.imageBase + module.base;
+      this.memory.writeUInt(iatAddress, 8, address);
+    });
+    return bound;
+  }
+}
@@ -0,0 +1,8 @@
+export class PageFault extends Error {
+  constructor(address, offset) {
+    super(`Page fault at 0x${address.toString(16)}: file offset 0x${offset.toString(16)} not resident yet.`);
+    this.name = 'PageFault';
+    this.address = address;
+    this.offset = offset;
+  }
+}
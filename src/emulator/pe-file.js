@@ -1,5 +1,37 @@
 import { BinaryReader } from './binary-reader.js';
 
+const RVA_PAGE_SHIFT = 12;
+const RVA_PAGE_SIZE = 1 << RVA_PAGE_SHIFT;
+const RVA_PAGE_MASK = RVA_PAGE_SIZE - 1;
+const PAGE_UNMAPPED = -1;
+const PAGE_SPLIT = -2;
+
+const EXPORT_DIR_INDEX = 0;
+const IMPORT_DIR_INDEX = 1;
+const BASERELOC_DIR_INDEX = 5;
+const BOUND_IMPORT_DIR_INDEX = 11;
+const DELAY_IMPORT_DIR_INDEX = 13;
+const IMPORT_DESCRIPTOR_SIZE = 20;
+const DELAY_DESCRIPTOR_SIZE = 32;
+const IMAGE_ORDINAL_FLAG64 = 1n << 63n;
+const IMAGE_REL_BASED_HIGHLOW = 3;
+const IMAGE_REL_BASED_DIR64 = 10;
+const IMAGE_FILE_DLL = 0x2000;
+const CACHED_HEADER_FIELDS = [
+  'characteristics',
+  'isDll',
+  'imageBase',
+  'entryRva',
+  'sectionAlignment',
+  'fileAlignment',
+  'sizeOfImage',
+  'sizeOfHeaders',
+  'sizeOfStackReserve',
+  'sizeOfStackCommit',
+  'sizeOfHeapReserve',
+  'sizeOfHeapCommit',
+];
+
 export class PeFile {
   constructor(buffer) {
     this.reader = new BinaryReader(buffer);
@@ -23,6 +55,8 @@ export class PeFile {
     if (machine !== 0x8664) throw new Error('Only x86-64 PE files are supported.');
     const numberOfSections = reader.readUInt16(coffOffset + 2);
     const optionalHeaderSize = reader.readUInt16(coffOffset + 16);
+    this.characteristics = reader.readUInt16(coffOffset + 18);
+    this.isDll = (this.characteristics & IMAGE_FILE_DLL) !== 0;
 
     const optionalOffset = coffOffset + 20;
     const magic = reader.readUInt16(optionalOffset);
@@ -30,7 +64,14 @@ export class PeFile {
 
     this.imageBase = reader.readUInt64(optionalOffset + 24);
     this.entryRva = reader.readUInt32(optionalOffset + 16);
+    this.sectionAlignment = reader.readUInt32(optionalOffset + 32);
+    this.fileAlignment = reader.readUInt32(optionalOffset + 36);
     this.sizeOfImage = reader.readUInt32(optionalOffset + 56);
+    this.sizeOfHeaders = reader.readUInt32(optionalOffset + 60);
+    this.sizeOfStackReserve = Number(reader.readUInt64(optionalOffset + 72));
+    this.sizeOfStackCommit = Number(reader.readUInt64(optionalOffset + 80));
+    this.sizeOfHeapReserve = Number(reader.readUInt64(optionalOffset + 88));
+    this.sizeOfHeapCommit = Number(reader.readUInt64(optionalOffset + 96));
 
     const NUMBER_OF_RVA_AND_SIZES_OFFSET = 0x6c;
     const DATA_DIRECTORY_OFFSET = 0x70;
@@ -57,9 +98,79 @@ export class PeFile {
       const pointerToRawData = reader.readUInt32(base + 20);
       this.sections.push({ name, virtualSize, virtualAddress, sizeOfRawData, pointerToRawData });
     }
+    this.buildRvaIndex();
+  }
+
+  buildRvaIndex() {
+    const ordered = this.sections
+      .map((section) => ({
+        start: section.virtualAddress,
+        end: section.virtualAddress + Math.max(section.virtualSize, section.sizeOfRawData),
+        pointer: section.pointerToRawData,
+      }))
+      .sort((a, b) => a.start - b.start);
+    if (this.sizeOfHeaders && (!ordered.length || ordered[0].start >= this.sizeOfHeaders)) {
+      ordered.unshift({ start: 0, end: this.sizeOfHeaders, pointer: 0 });
+    }
+    this.sectionsOverlap = ordered.some((entry, i) => i > 0 && entry.start < ordered[i - 1].end);
+    this.sectionStarts = Uint32Array.from(ordered, (entry) => entry.start);
+    this.sectionEnds = Float64Array.from(ordered, (entry) => entry.end);
+    this.sectionPointers = Uint32Array.from(ordered, (entry) => entry.pointer);
+
+    const imageEnd = Math.max(this.sizeOfImage || 0, ...ordered.map((entry) => entry.end), 0);
+    const pageCount = Math.ceil(imageEnd / RVA_PAGE_SIZE);
+    this.rvaPageOffsets = new Int32Array(pageCount).fill(PAGE_UNMAPPED);
+    this.rvaPageLimits = new Uint16Array(pageCount);
+    this.rvaPageLimit = pageCount * RVA_PAGE_SIZE;
+    if (this.sectionsOverlap) {
+      this.rvaPageOffsets.fill(PAGE_SPLIT);
+      return;
+    }
+    ordered.forEach(({ start, end, pointer }) => {
+      const firstPage = start >>> RVA_PAGE_SHIFT;
+      const lastPage = Math.ceil(end / RVA_PAGE_SIZE) - 1;
+      for (let page = firstPage; page <= lastPage; page++) {
+        const pageStart = page * RVA_PAGE_SIZE;
+        const alignedStart = start <= pageStart;
+        if (!alignedStart || this.rvaPageOffsets[page] !== PAGE_UNMAPPED) {
+          this.rvaPageOffsets[page] = PAGE_SPLIT;
+          continue;
+        }
+        this.rvaPageOffsets[page] = pointer + (pageStart - start);
+        this.rvaPageLimits[page] = Math.min(RVA_PAGE_SIZE, end - pageStart);
+      }
+    });
   }
 
   rvaToOffset(rva) {
+    if (rva >= 0 && rva < this.rvaPageLimit) {
+      const page = rva >>> RVA_PAGE_SHIFT;
+      const base = this.rvaPageOffsets[page];
+      if (base >= 0) {
+        const delta = rva & RVA_PAGE_MASK;
+        return delta < this.rvaPageLimits[page] ? base + delta : null;
+      }
+      if (base === PAGE_UNMAPPED) return null;
+    }
+    return this.findSectionOffset(rva);
+  }
+
+  findSectionOffset(rva) {
+    if (this.sectionsOverlap) return this.scanSectionOffset(rva);
+    const starts = this.sectionStarts;
+    let lo = 0;
+    let hi = starts.length - 1;
+    while (lo <= hi) {
+      const mid = (lo + hi) >>> 1;
+      if (starts[mid] <= rva) lo = mid + 1;
+      else hi = mid - 1;
+    }
+    if (hi < 0 || rva >= this.sectionEnds[hi]) return null;
+    return this.sectionPointers[hi] + (rva - starts[hi]);
+  }
+
+  scanSectionOffset(rva) {
+    if (rva >= 0 && rva < (this.sizeOfHeaders ?? 0)) return rva;
     for (const section of this.sections) {
       const size = Math.max(section.virtualSize, section.sizeOfRawData);
       if (rva >= section.virtualAddress && rva < section.virtualAddress + size) {
@@ -87,65 +198,313 @@ export class PeFile {
     return this.reader.readBytes(offset, length);
   }
 
+  readCString(offset, maxLength = 512) {
+    if (offset == null || offset < 0) return '';
+    const limit = Math.min(this.buffer.length, offset + maxLength);
+    let end = offset;
+    while (end < limit && this.buffer[end] !== 0) end++;
+    return String.fromCharCode.apply(null, this.buffer.subarray(offset, end));
+  }
+
   readAnsiString(rva) {
-    const chunk = [];
-    let offset = this.rvaToOffset(rva);
-    if (offset == null) return '';
-    while (offset < this.buffer.length) {
-      const byte = this.buffer[offset++];
-      if (byte === 0) break;
-      chunk.push(byte);
-      if (chunk.length > 4096) break;
+    return this.readCString(this.rvaToOffset(rva), 4097);
+  }
+
+  intern(value) {
+    const existing = this.stringTable.get(value);
+    if (existing !== undefined) return existing;
+    this.stringTable.set(value, value);
+    return value;
+  }
+
+  internImport(dll, name, { hint = null, ordinal = null } = {}) {
+    const key = `${dll}!${name}`;
+    let entry = this.importIndex.get(key);
+    if (!entry) {
+      entry = { id: this.importTable.length, dll, name, key, hint, ordinal };
+      this.importTable.push(entry);
+      this.importIndex.set(key, entry);
     }
-    return String.fromCharCode(...chunk);
+    return entry;
   }
 
-  getImportDirectory() {
-    const IMPORT_DIR_INDEX = 1;
-    const entry = this.dataDirectories[IMPORT_DIR_INDEX];
-    if (!entry || !entry.rva) return [];
-    const imports = [];
-    const descriptorSize = 20;
-    let cursor = entry.rva;
+  readThunkTable({ dll, lookupRva, iatRva, delayLoad = false, bound = false }) {
+    const slots = [];
+    let lookup = lookupRva || iatRva;
+    let address = iatRva;
     while (true) {
-      const thunkRva = this.reader.readUInt32(this.rvaToOffset(cursor));
-      const firstThunk = this.reader.readUInt32(this.rvaToOffset(cursor + 16));
-      if (!thunkRva && !firstThunk) break;
-      const nameRva = this.reader.readUInt32(this.rvaToOffset(cursor + 12));
-      const dllName = this.readAnsiString(nameRva);
-      let lookup = thunkRva;
-      let address = firstThunk;
-      while (true) {
-        const lookupOffset = this.rvaToOffset(lookup);
-        const thunkOffset = this.rvaToOffset(address);
-        if (lookupOffset == null || thunkOffset == null) break;
-        const lookupValue = this.reader.readUInt64(lookupOffset);
-        if (!lookupValue) break;
-        if ((lookupValue & (1n << 63n)) !== 0n) {
-          // Ordinals not supported
-        } else {
-          const hintNameRva = Number(lookupValue & 0xffffffffn);
-          const hintNameOffset = this.rvaToOffset(hintNameRva);
-          if (hintNameOffset != null) {
-            const hint = this.reader.readUInt16(hintNameOffset);
-            let name = '';
-            let idx = hintNameOffset + 2;
-            while (idx < this.buffer.length) {
-              const b = this.buffer[idx++];
-              if (b === 0) break;
-              name += String.fromCharCode(b);
-              if (name.length > 512) break;
-            }
-            const iatAddress = this.imageBase + BigInt(address);
-            this.imports.set(iatAddress, { dll: dllName.toLowerCase(), name, hint });
-            imports.push({ dll: dllName.toLowerCase(), name, iatAddress });
-          }
+      const lookupOffset = this.rvaToOffset(lookup);
+      const thunkOffset = this.rvaToOffset(address);
+      if (lookupOffset == null || thunkOffset == null) break;
+      const lookupValue = this.reader.readUInt64(lookupOffset);
+      if (!lookupValue) break;
+      let entry = null;
+      if ((lookupValue & IMAGE_ORDINAL_FLAG64) !== 0n) {
+        const ordinal = Number(lookupValue & 0xffffn);
+        entry = this.internImport(dll, this.intern(`#${ordinal}`), { ordinal });
+      } else {
+        const hintNameOffset = this.rvaToOffset(Number(lookupValue & 0xffffffffn));
+        if (hintNameOffset != null) {
+          const hint = this.reader.readUInt16(hintNameOffset);
+          const name = this.intern(this.readCString(hintNameOffset + 2, 513));
+          entry = this.internImport(dll, name, { hint });
         }
-        lookup += 8;
-        address += 8;
       }
-      cursor += descriptorSize;
+      if (entry) {
+        const slot = {
+          id: entry.id,
+          dll,
+          name: entry.name,
+          key: entry.key,
+          hint: entry.hint,
+          ordinal: entry.ordinal,
+          iatAddress: this.imageBase + BigInt(address),
+          delayLoad,
+          bound,
+        };
+        this.imports.set(slot.iatAddress, slot);
+        slots.push(slot);
+      }
+      lookup += 8;
+      address += 8;
+    }
+    return slots;
+  }
+
+  parseImportDescriptors() {
+    const entry = this.dataDirectories[IMPORT_DIR_INDEX];
+    if (!entry || !entry.rva) return [];
+    const slots = [];
+    for (let cursor = entry.rva; ; cursor += IMPORT_DESCRIPTOR_SIZE) {
+      const offset = this.rvaToOffset(cursor);
+      if (offset == null || offset + IMPORT_DESCRIPTOR_SIZE > this.buffer.length) break;
+      const lookupRva = this.reader.readUInt32(offset);
+      const timeDateStamp = this.reader.readUInt32(offset + 4);
+      const nameRva = this.reader.readUInt32(offset + 12);
+      const iatRva = this.reader.readUInt32(offset + 16);
+      if (!lookupRva && !iatRva) break;
+      const dll = this.intern(this.readAnsiString(nameRva).toLowerCase());
+      slots.push(...this.readThunkTable({ dll, lookupRva, iatRva, bound: timeDateStamp !== 0 }));
+    }
+    return slots;
+  }
+
+  parseDelayImportDescriptors() {
+    const entry = this.dataDirectories[DELAY_IMPORT_DIR_INDEX];
+    if (!entry || !entry.rva) return [];
+    const slots = [];
+    for (let cursor = entry.rva; ; cursor += DELAY_DESCRIPTOR_SIZE) {
+      const offset = this.rvaToOffset(cursor);
+      if (offset == null || offset + DELAY_DESCRIPTOR_SIZE > this.buffer.length) break;
+      const attributes = this.reader.readUInt32(offset);
+      const fields = [4, 8, 12, 16].map((delta) => this.reader.readUInt32(offset + delta));
+      if (!fields[0]) break;
+      // Pre-VC7 descriptors store VAs rather than RVAs.
+      const toRva = (value) =>
+        attributes & 1 || !value ? value : Number(BigInt(value) - BigInt.asUintN(32, this.imageBase));
+      const [nameRva, moduleHandleRva, iatRva, lookupRva] = fields.map(toRva);
+      const dll = this.intern(this.readAnsiString(nameRva).toLowerCase());
+      this.delayImports.push({ dll, moduleHandleRva, iatRva, lookupRva });
+      slots.push(...this.readThunkTable({ dll, lookupRva, iatRva, delayLoad: true }));
+    }
+    return slots;
+  }
+
+  parseBoundImports() {
+    const entry = this.dataDirectories[BOUND_IMPORT_DIR_INDEX];
+    if (!entry || !entry.rva) return [];
+    const base = this.rvaToOffset(entry.rva);
+    if (base == null) return [];
+    const readRef = (offset) => ({
+      timeDateStamp: this.reader.readUInt32(offset),
+      dll: this.intern(this.readCString(base + this.reader.readUInt16(offset + 4)).toLowerCase()),
+      forwarderCount: this.reader.readUInt16(offset + 6),
+    });
+    const bound = [];
+    let cursor = base;
+    while (cursor + 8 <= this.buffer.length) {
+      const ref = readRef(cursor);
+      if (!ref.timeDateStamp && !ref.dll) break;
+      cursor += 8;
+      const forwarders = [];
+      for (let i = 0; i < ref.forwarderCount && cursor + 8 <= this.buffer.length; i++) {
+        const { timeDateStamp, dll } = readRef(cursor);
+        forwarders.push({ timeDateStamp, dll });
+        cursor += 8;
+      }
+      bound.push({ dll: ref.dll, timeDateStamp: ref.timeDateStamp, forwarders });
     }
-    return imports;
+    return bound;
+  }
+
+  getImportDirectory() {
+    if (this.importSlots) return this.importSlots;
+    this.stringTable = new Map();
+    this.importTable = [];
+    this.importIndex = new Map();
+    this.delayImports = [];
+    this.imports.clear();
+    this.importSlots = [...this.parseImportDescriptors(), ...this.parseDelayImportDescriptors()];
+    this.boundImports = this.parseBoundImports();
+    return this.importSlots;
+  }
+
+  getExportDirectory() {
+    if (this.exportDirectory !== undefined) return this.exportDirectory;
+    this.exportDirectory = null;
+    const entry = this.dataDirectories[EXPORT_DIR_INDEX];
+    const offset = entry?.rva ? this.rvaToOffset(entry.rva) : null;
+    if (offset == null) return null;
+    const reader = this.reader;
+    const ordinalBase = reader.readUInt32(offset + 16);
+    const functionCount = reader.readUInt32(offset + 20);
+    const nameCount = reader.readUInt32(offset + 24);
+    const functionsOffset = this.rvaToOffset(reader.readUInt32(offset + 28));
+    const namesOffset = this.rvaToOffset(reader.readUInt32(offset + 32));
+    const ordinalsOffset = this.rvaToOffset(reader.readUInt32(offset + 36));
+    const functions = new Uint32Array(functionsOffset == null ? 0 : functionCount);
+    for (let i = 0; i < functions.length; i++) {
+      functions[i] = reader.readUInt32(functionsOffset + i * 4);
+    }
+    const byName = new Map();
+    if (namesOffset != null && ordinalsOffset != null) {
+      for (let i = 0; i < nameCount; i++) {
+        const nameOffset = this.rvaToOffset(reader.readUInt32(namesOffset + i * 4));
+        byName.set(this.readCString(nameOffset), reader.readUInt16(ordinalsOffset + i * 2));
+      }
+    }
+    const forwarders = new Map();
+    functions.forEach((rva, index) => {
+      if (rva >= entry.rva && rva < entry.rva + entry.size) {
+        forwarders.set(index, this.readAnsiString(rva));
+      }
+    });
+    this.exportDirectory = {
+      dll: this.readAnsiString(reader.readUInt32(offset + 12)).toLowerCase(),
+      ordinalBase,
+      functions,
+      byName,
+      forwarders,
+    };
+    return this.exportDirectory;
+  }
+
+  getRelocations() {
+    if (this.relocations) return this.relocations;
+    const dir64 = [];
+    const highLow = [];
+    const entry = this.dataDirectories[BASERELOC_DIR_INDEX];
+    let cursor = entry?.rva ?? 0;
+    const end = cursor + (entry?.size ?? 0);
+    while (cursor + 8 <= end) {
+      const offset = this.rvaToOffset(cursor);
+      if (offset == null) break;
+      const pageRva = this.reader.readUInt32(offset);
+      const blockSize = this.reader.readUInt32(offset + 4);
+      if (blockSize < 8) break;
+      for (let i = 8; i + 2 <= blockSize; i += 2) {
+        const value = this.reader.readUInt16(offset + i);
+        const type = value >> 12;
+        if (type === IMAGE_REL_BASED_DIR64) dir64.push(pageRva + (value & 0xfff));
+        else if (type === IMAGE_REL_BASED_HIGHLOW) highLow.push(pageRva + (value & 0xfff));
+      }
+      cursor += blockSize;
+    }
+    this.relocations = { dir64: Uint32Array.from(dir64), highLow: Uint32Array.from(highLow) };
+    return this.relocations;
+  }
+
+  createMappedImage() {
+    const image = new Uint8Array(this.sizeOfImage);
+    const headerBytes = Math.min(this.sizeOfHeaders || 0, this.buffer.length, image.length);
+    image.set(this.buffer.subarray(0, headerBytes), 0);
+    this.sections.forEach((section) => {
+      const length = Math.min(
+        section.sizeOfRawData,
+        section.virtualSize || section.sizeOfRawData,
+        this.buffer.length - section.pointerToRawData,
+        image.length - section.virtualAddress,
+      );
+      if (length <= 0) return;
+      image.set(this.buffer.subarray(section.pointerToRawData, section.pointerToRawData + length), section.virtualAddress);
+    });
+    return image;
+  }
+
+  toCacheRecord() {
+    const slots = this.getImportDirectory();
+    const exportDirectory = this.getExportDirectory();
+    const relocations = this.getRelocations();
+    const header = {};
+    CACHED_HEADER_FIELDS.forEach((field) => {
+      header[field] = this[field];
+    });
+    return {
+      header,
+      sections: this.sections,
+      dataDirectories: this.dataDirectories,
+      imports: {
+        table: this.importTable,
+        slots: slots.map(({ id, iatAddress, delayLoad, bound }) => [id, Number(iatAddress - this.imageBase), delayLoad, bound]),
+        delayImports: this.delayImports,
+        boundImports: this.boundImports,
+      },
+      exports: exportDirectory && {
+        ...exportDirectory,
+        functions: Array.from(exportDirectory.functions),
+        byName: Array.from(exportDirectory.byName),
+        forwarders: Array.from(exportDirectory.forwarders),
+      },
+      relocations: { dir64: Array.from(relocations.dir64), highLow: Array.from(relocations.highLow) },
+    };
+  }
+
+  static fromCacheRecord(buffer, record) {
+    const pe = Object.create(PeFile.prototype);
+    pe.reader = new BinaryReader(buffer);
+    pe.buffer = buffer;
+    CACHED_HEADER_FIELDS.forEach((field) => {
+      pe[field] = record.header[field];
+    });
+    pe.sections = record.sections.map((section) => ({ ...section }));
+    pe.dataDirectories = record.dataDirectories.map((entry) => ({ ...entry }));
+    pe.buildRvaIndex();
+
+    pe.imports = new Map();
+    pe.stringTable = new Map();
+    pe.importTable = [];
+    pe.importIndex = new Map();
+    record.imports.table.forEach(({ dll, name, hint, ordinal }) => {
+      pe.internImport(pe.intern(dll), pe.intern(name), { hint, ordinal });
+    });
+    pe.importSlots = record.imports.slots.map(([id, rva, delayLoad, bound]) => {
+      const entry = pe.importTable[id];
+      const slot = {
+        id,
+        dll: entry.dll,
+        name: entry.name,
+        key: entry.key,
+        hint: entry.hint,
+        ordinal: entry.ordinal,
+        iatAddress: pe.imageBase + BigInt(rva),
+        delayLoad,
+        bound,
+      };
+      pe.imports.set(slot.iatAddress, slot);
+      return slot;
+    });
+    pe.delayImports = record.imports.delayImports;
+    pe.boundImports = record.imports.boundImports;
+    pe.exportDirectory = record.exports && {
+      ...record.exports,
+      functions: Uint32Array.from(record.exports.functions),
+      byName: new Map(record.exports.byName),
+      forwarders: new Map(record.exports.forwarders),
+    };
+    pe.relocations = {
+      dir64: Uint32Array.from(record.relocations.dir64),
+      highLow: Uint32Array.from(record.relocations.highLow),
+    };
+    return pe;
   }
 }
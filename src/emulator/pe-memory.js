@@ -1,19 +1,76 @@
+import { GuestStack, PAGE_SIZE } from './guest-stack.js';
+import { DirtyPageBitmap } from './dirty-pages.js';
+import { MemoryRegion } from './memory-region.js';
+import { PageFault } from './page-fault.js';
+
+const PAGE_SHIFT = 12n;
+const PAGE_MASK = 0xfffn;
+
+function toBytes(bytes) {
+  return bytes instanceof Uint8Array ? bytes : Uint8Array.from(bytes);
+}
+
 export class PeMemory {
   constructor(pe) {
     this.pe = pe;
-    this.overrides = new Map();
+    this.pages = new Map();
+    this.stack = new GuestStack({
+      reserve: pe.sizeOfStackReserve,
+      commit: pe.sizeOfStackCommit,
+    });
+    this.regions = [];
+    this.dirtyPages = new DirtyPageBitmap();
+    this.checkpointPages = new Map();
+    this.checkpointStackCommit = this.stack.committedOffset;
+    this.tracking = false;
+    this.onPageWrite = null;
+    this.residency = null;
   }
 
-  readByte(address) {
-    const key = address.toString();
-    if (this.overrides.has(key)) {
-      return this.overrides.get(key);
-    }
+  readBackingByte(address) {
     const offset = this.pe.vaToOffset(address);
     if (offset == null || offset < 0 || offset >= this.pe.buffer.length) return 0;
+    if (this.residency && offset >= this.residency.loaded) throw new PageFault(address, offset);
     return this.pe.buffer[offset];
   }
 
+  mapRegion({ base, bytes, name }) {
+    const region = new MemoryRegion({ base, bytes, name });
+    const clash = [this.stack, ...this.regions].find((entry) => entry.overlaps(base, bytes.length));
+    if (clash) {
+      throw new Error(`Cannot map ${name} at 0x${base.toString(16)}: overlaps ${clash.name}.`);
+    }
+    this.regions.push(region);
+    this.regions.sort((a, b) => (a.base < b.base ? -1 : 1));
+    return region;
+  }
+
+  unmapRegion(region) {
+    this.regions = this.regions.filter((entry) => entry !== region);
+  }
+
+  isRangeFree(base, size) {
+    return ![this.stack, ...this.regions].some((entry) => entry.overlaps(base, size));
+  }
+
+  regionAt(address, size = 1) {
+    if (this.stack.contains(address, size)) return this.stack;
+    for (const region of this.regions) {
+      if (region.contains(address, size)) return region;
+    }
+    return null;
+  }
+
+  readByte(address) {
+    const region = this.regionAt(address);
+    if (region) {
+      return region.readByte(address);
+    }
+    const page = this.pages.get(Number(address >> PAGE_SHIFT));
+    if (page) return page[Number(address & PAGE_MASK)];
+    return this.readBackingByte(address);
+  }
+
   read(address, size) {
     const bytes = new Uint8Array(size);
     for (let i = 0; i < size; i++) {
@@ -23,6 +80,10 @@ export class PeMemory {
   }
 
   readUInt(address, size) {
+    const region = this.regionAt(address, size);
+    if (region) {
+      return region.readUInt(address, size);
+    }
     const bytes = this.read(address, size);
     let value = 0n;
     for (let i = 0; i < size; i++) {
@@ -31,14 +92,63 @@ export class PeMemory {
     return value;
   }
 
+  materializePage(pageIndex) {
+    let page = this.pages.get(pageIndex);
+    if (page) return page;
+    page = new Uint8Array(PAGE_SIZE);
+    const base = BigInt(pageIndex) << PAGE_SHIFT;
+    for (let i = 0; i < PAGE_SIZE; i++) {
+      page[i] = this.readBackingByte(base + BigInt(i));
+    }
+    this.pages.set(pageIndex, page);
+    return page;
+  }
+
   write(address, bytes) {
-    for (let i = 0; i < bytes.length; i++) {
-      const key = (address + BigInt(i)).toString();
-      this.overrides.set(key, bytes[i]);
+    const source = toBytes(bytes);
+    const region = this.regionAt(address, source.length);
+    if (region) {
+      if (this.tracking) this.trackRegionWrite(region, address, source.length);
+      if (this.onPageWrite) this.notifyPageWrites(address, source.length);
+      region.write(address, source);
+      return;
+    }
+    // Copy in every page the write spans before marking or changing any of
+    // them, so a PageFault leaves memory and dirty state untouched and the
+    // instruction can be retried. Pages copied in here had no contents of
+    // their own, which is what a checkpoint restores them to.
+    if (!source.length) return;
+    const first = Number(address >> PAGE_SHIFT);
+    const last = Number((address + BigInt(source.length - 1)) >> PAGE_SHIFT);
+    const created = [];
+    for (let pageIndex = first; pageIndex <= last; pageIndex++) {
+      if (!this.pages.has(pageIndex)) created.push(pageIndex);
+      this.materializePage(pageIndex);
+    }
+    for (let pageIndex = first; pageIndex <= last; pageIndex++) {
+      if (this.tracking) this.trackPageWrite(pageIndex, created.includes(pageIndex));
+      this.onPageWrite?.(pageIndex);
+    }
+    let cursor = address;
+    let index = 0;
+    while (index < source.length) {
+      const pageIndex = Number(cursor >> PAGE_SHIFT);
+      const offset = Number(cursor & PAGE_MASK);
+      const count = Math.min(PAGE_SIZE - offset, source.length - index);
+      this.pages.get(pageIndex).set(source.subarray(index, index + count), offset);
+      index += count;
+      cursor += BigInt(count);
     }
   }
 
   writeUInt(address, size, value) {
+    const region = this.regionAt(address, size);
+    if (region) {
+      if (this.tracking) this.trackRegionWrite(region, address, size);
+      if (this.onPageWrite) this.notifyPageWrites(address, size);
+      region.writeUInt(address, size, value);
+      return;
+    }
     const bytes = new Uint8Array(size);
     let tmp = BigInt(value);
     for (let i = 0; i < size; i++) {
@@ -47,4 +157,109 @@ export class PeMemory {
     }
     this.write(address, bytes);
   }
+
+  readStackUInt64(address) {
+    if (this.stack.contains(address, 8)) {
+      return this.stack.readUInt64(address);
+    }
+    return this.readUInt(address, 8);
+  }
+
+  writeStackUInt64(address, value) {
+    if (this.stack.contains(address, 8)) {
+      if (this.tracking) this.trackRegionWrite(this.stack, address, 8);
+      this.stack.writeUInt64(address, value);
+      return;
+    }
+    this.writeUInt(address, 8, value);
+  }
+
+  notifyPageWrites(address, size) {
+    const first = Number(address >> PAGE_SHIFT);
+    const last = Number((address + BigInt(size - 1)) >> PAGE_SHIFT);
+    for (let pageIndex = first; pageIndex <= last; pageIndex++) {
+      this.onPageWrite(pageIndex);
+    }
+  }
+
+  trackPageWrite(pageIndex, created = false) {
+    if (!this.dirtyPages.mark(pageIndex)) return;
+    this.checkpointPages.set(pageIndex, created ? null : this.pages.get(pageIndex).slice());
+  }
+
+  trackRegionWrite(region, address, size) {
+    const first = Number(address >> PAGE_SHIFT);
+    const last = Number((address + BigInt(size - 1)) >> PAGE_SHIFT);
+    for (let pageIndex = first; pageIndex <= last; pageIndex++) {
+      if (!this.dirtyPages.mark(pageIndex)) continue;
+      const { start, end } = this.regionPageSpan(region, pageIndex);
+      this.checkpointPages.set(pageIndex, region.bytes.slice(start, end));
+    }
+  }
+
+  regionPageSpan(region, pageIndex) {
+    const start = Math.max(0, Number((BigInt(pageIndex) << PAGE_SHIFT) - region.base));
+    return { start, end: Math.min(region.size, start + PAGE_SIZE) };
+  }
+
+  regionForPage(pageIndex) {
+    const address = BigInt(pageIndex) << PAGE_SHIFT;
+    if (this.stack.contains(address)) return this.stack;
+    return this.regions.find((region) => region.overlaps(address, PAGE_SIZE)) ?? null;
+  }
+
+  checkpoint() {
+    this.dirtyPages.clear();
+    this.checkpointPages.clear();
+    this.checkpointStackCommit = this.stack.committedOffset;
+    this.tracking = true;
+  }
+
+  restoreCheckpoint() {
+    let restored = 0;
+    this.dirtyPages.forEach((pageIndex) => {
+      const saved = this.checkpointPages.get(pageIndex);
+      const region = this.regionForPage(pageIndex);
+      this.onPageWrite?.(pageIndex);
+      if (region) {
+        region.bytes.set(saved, this.regionPageSpan(region, pageIndex).start);
+      } else if (saved) {
+        this.pages.set(pageIndex, saved);
+      } else {
+        this.pages.delete(pageIndex);
+      }
+      restored++;
+    });
+    this.dirtyPages.clear();
+    this.checkpointPages.clear();
+    this.stack.committedOffset = this.checkpointStackCommit;
+    return restored;
+  }
+
+  getDirtyPages() {
+    const pages = [];
+    this.dirtyPages.forEach((pageIndex) => {
+      const region = this.regionForPage(pageIndex);
+      if (region) {
+        const { start, end } = this.regionPageSpan(region, pageIndex);
+        pages.push({ page: pageIndex, bytes: region.bytes.subarray(start, end) });
+      } else {
+        pages.push({ page: pageIndex, bytes: this.pages.get(pageIndex) });
+      }
+    });
+    return pages;
+  }
+
+  applyPages(pages) {
+    pages.forEach(({ page, bytes }) => {
+      const address = BigInt(page) << PAGE_SHIFT;
+      if (this.stack.contains(address)) {
+        const offset = Number(address - this.stack.base);
+        if (offset < this.stack.committedOffset) {
+          this.stack.committedOffset = offset;
+        }
+      }
+      this.write(address, bytes);
+    });
+  }
 }
@@ -0,0 +1,61 @@
+import { PAGE_SIZE } from './guest-stack.js';
+
+export const SNAPSHOT_MAGIC = 0x53534a57; // 'WJSS'
+export const SNAPSHOT_VERSION = 1;
+
+const HEADER_SIZE = 32;
+
+export function encodeSnapshot({ imageBase = 0n, sizeOfImage = 0, registers = [], flags = 0, pages = [] }) {
+  const registerBytes = registers.length * 8;
+  const pageBytes = pages.length * (8 + PAGE_SIZE);
+  const out = new Uint8Array(HEADER_SIZE + registerBytes + pageBytes);
+  const view = new DataView(out.buffer);
+  view.setUint32(0, SNAPSHOT_MAGIC, true);
+  view.setUint32(4, SNAPSHOT_VERSION, true);
+  view.setBigUint64(8, BigInt.asUintN(64, imageBase), true);
+  view.setUint32(16, sizeOfImage >>> 0, true);
+  view.setUint32(20, flags >>> 0, true);
+  view.setUint32(24, registers.length, true);
+  view.setUint32(28, pages.length, true);
+  let cursor = HEADER_SIZE;
+  registers.forEach((value) => {
+    view.setBigUint64(cursor, BigInt.asUintN(64, value), true);
+    cursor += 8;
+  });
+  pages.forEach(({ page, bytes }) => {
+    view.setBigUint64(cursor, BigInt(page), true);
+    out.set(bytes, cursor + 8);
+    cursor += 8 + PAGE_SIZE;
+  });
+  return out;
+}
+
+export function decodeSnapshot(bytes) {
+  if (!(bytes instanceof Uint8Array) || bytes.length < HEADER_SIZE) {
+    throw new Error('Snapshot payload is truncated.');
+  }
+  const view = new DataView(bytes.buffer, bytes.byteOffset, bytes.byteLength);
+  if (view.getUint32(0, true) !== SNAPSHOT_MAGIC) throw new Error('Missing snapshot header.');
+  const version = view.getUint32(4, true);
+  if (version !== SNAPSHOT_VERSION) throw new Error(`Unsupported snapshot version ${version}.`);
+  const imageBase = view.getBigUint64(8, true);
+  const sizeOfImage = view.getUint32(16, true);
+  const flags = view.getUint32(20, true);
+  const registerCount = view.getUint32(24, true);
+  const pageCount = view.getUint32(28, true);
+  const expected = HEADER_SIZE + registerCount * 8 + pageCount * (8 + PAGE_SIZE);
+  if (bytes.length < expected) throw new Error('Snapshot payload is truncated.');
+  let cursor = HEADER_SIZE;
+  const registers = [];
+  for (let i = 0; i < registerCount; i++) {
+    registers.push(view.getBigUint64(cursor, true));
+    cursor += 8;
+  }
+  const pages = [];
+  for (let i = 0; i < pageCount; i++) {
+    const page = Number(view.getBigUint64(cursor, true));
+    pages.push({ page, bytes: bytes.subarray(cursor + 8, cursor + 8 + PAGE_SIZE) });
+    cursor += 8 + PAGE_SIZE;
+  }
+  return { imageBase, sizeOfImage, flags, registers, pages };
+}
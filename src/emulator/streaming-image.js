@@ -0,0 +1,97 @@
+import { PeFile } from './pe-file.js';
+
+const DOS_HEADER_SIZE = 0x40;
+const NT_HEADERS64_SIZE = 0x108;
+// Export, import, base relocation, bound import, IAT and delay-load import
+// tables: the loader walks all of them before the first instruction runs.
+const RESIDENT_DIRECTORIES = [0, 1, 5, 11, 12, 13];
+
+export class StreamingImage {
+  constructor(size) {
+    this.buffer = new Uint8Array(size);
+    this.size = size;
+    this.loaded = 0;
+    this.done = false;
+    this.error = null;
+    this.waiters = [];
+  }
+
+  append(chunk) {
+    const length = Math.min(chunk.length, this.size - this.loaded);
+    this.buffer.set(chunk.subarray(0, length), this.loaded);
+    this.loaded += length;
+    this.wake();
+  }
+
+  finish() {
+    this.done = true;
+    if (this.loaded < this.size) {
+      this.fail(new Error(`Stream ended after ${this.loaded} of ${this.size} bytes.`));
+      return;
+    }
+    this.wake();
+  }
+
+  fail(error) {
+    this.error = error;
+    this.wake();
+  }
+
+  wake() {
+    this.waiters = this.waiters.filter((waiter) => {
+      if (this.error) {
+        waiter.reject(this.error);
+        return false;
+      }
+      if (waiter.end > this.loaded) return true;
+      waiter.resolve();
+      return false;
+    });
+  }
+
+  waitFor(end) {
+    const target = Math.min(end, this.size);
+    if (this.error) return Promise.reject(this.error);
+    if (target <= this.loaded) return Promise.resolve();
+    return new Promise((resolve, reject) => this.waiters.push({ end: target, resolve, reject }));
+  }
+
+  async consume(stream) {
+    const reader = stream.getReader();
+    try {
+      while (true) {
+        const { done, value } = await reader.read();
+        if (done) break;
+        this.append(value);
+      }
+      this.finish();
+    } catch (err) {
+      this.fail(err);
+    }
+  }
+
+  async readHeaders() {
+    await this.waitFor(DOS_HEADER_SIZE);
+    const peOffset = new DataView(this.buffer.buffer).getUint32(0x3c, true);
+    await this.waitFor(peOffset + NT_HEADERS64_SIZE);
+    const probe = new PeFile(this.buffer);
+    if (probe.sizeOfHeaders <= peOffset + NT_HEADERS64_SIZE) return probe;
+    await this.waitFor(probe.sizeOfHeaders);
+    return new PeFile(this.buffer);
+  }
+
+  // File offset that must be resident before the CPU starts: the section
+  // holding the entry point plus every section the loader tables live in.
+  startOffset(pe) {
+    const rvas = [pe.entryRva, ...RESIDENT_DIRECTORIES.map((index) => pe.dataDirectories[index]?.rva ?? 0)];
+    let end = pe.sizeOfHeaders;
+    rvas.forEach((rva) => {
+      if (!rva) return;
+      const section = pe.sections.find(
+        (entry) => rva >= entry.virtualAddress && rva < entry.virtualAddress + Math.max(entry.virtualSize, entry.sizeOfRawData),
+      );
+      if (section) end = Math.max(end, section.pointerToRawData + section.sizeOfRawData);
+    });
+    return Math.min(end, this.size);
+  }
+}
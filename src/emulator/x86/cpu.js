@@ -1,16 +1,39 @@
 import { PeMemory } from '../pe-memory.js';
+import { ModuleLoader } from '../module-loader.js';
+import { PageFault } from '../page-fault.js';
+import { ImportThunks, THUNK_BASE, THUNK_LIMIT, CALLBACK_RETURN } from '../import-thunks.js';
+import { ImportTrace } from '../import-trace.js';
 import { X86Decoder } from './decoder.js';
+import { REG64 } from './instruction.js';
 import { maskBits, signExtend } from '../utils/bit-ops.js';
+import { encodeSnapshot, decodeSnapshot } from '../snapshot.js';
+
+// Only the low 64 bits of each XMM register are kept: enough for scalar
+// float and double arguments, returns and the moves around them.
+const XMM_REGISTERS = Array.from({ length: 16 }, (_, index) => `xmm${index}`);
+const SNAPSHOT_REGISTERS = [...REG64, 'rip', ...XMM_REGISTERS];
+const ARG_REGISTERS = ['rcx', 'rdx', 'r8', 'r9'];
 
 export class X86CPU {
-  constructor(pe) {
+  constructor(pe, { resolveImage, moduleName } = {}) {
     this.pe = pe;
     this.memory = new PeMemory(pe);
+    this.imports = pe.getImportDirectory();
+    this.thunks = new ImportThunks(this.memory, { importTable: pe.importTable, importIndex: pe.importIndex });
+    this.loader = new ModuleLoader(this.memory, { resolveImage, thunks: this.thunks });
+    this.loader.registerMainImage(pe, moduleName);
+    this.loader.bindImports(this.loader.mainModule);
     this.decoder = new X86Decoder(this.memory);
+    this.memory.onPageWrite = (page) => this.decoder.invalidatePage(page);
     this.registers = new Map();
     this.flags = { zf: false, sf: false };
-    this.imports = pe.getImportDirectory();
-    this.iatMap = pe.imports;
+    this.nextRip = 0n;
+    this.importDispatch = [];
+    this.dispatchHooks = null;
+    this.pendingImport = null;
+    this.guestFrames = [];
+    this.runState = null;
+    this.importTrace = new ImportTrace({ importCount: this.thunks.entries.length });
     this.reset();
   }
 
@@ -34,9 +57,54 @@ export class X86CPU {
       'r15',
     ];
     baseRegs.forEach((reg) => this.registers.set(reg, 0n));
-    this.registers.set('rsp', 0x100000000n);
+    XMM_REGISTERS.forEach((reg) => this.registers.set(reg, 0n));
+    this.registers.set('rsp', this.memory.stack.initialPointer);
     this.registers.set('rip', this.pe.imageBase + BigInt(this.pe.entryRva));
     this.flags = { zf: false, sf: false };
+    this.pendingImport = null;
+    this.guestFrames = [];
+  }
+
+  checkpoint() {
+    this.memory.checkpoint();
+    this.savedState = {
+      registers: new Map(this.registers),
+      flags: { ...this.flags },
+    };
+  }
+
+  restoreCheckpoint() {
+    if (!this.savedState) throw new Error('No checkpoint recorded.');
+    const restoredPages = this.memory.restoreCheckpoint();
+    this.registers = new Map(this.savedState.registers);
+    this.flags = { ...this.savedState.flags };
+    this.pendingImport = null;
+    this.guestFrames = [];
+    return restoredPages;
+  }
+
+  createSnapshot() {
+    return encodeSnapshot({
+      imageBase: this.pe.imageBase,
+      sizeOfImage: this.pe.sizeOfImage ?? 0,
+      registers: SNAPSHOT_REGISTERS.map((name) => this.registers.get(name) ?? 0n),
+      flags: (this.flags.zf ? 1 : 0) | (this.flags.sf ? 2 : 0),
+      pages: this.memory.getDirtyPages(),
+    });
+  }
+
+  restoreSnapshot(bytes) {
+    const snapshot = decodeSnapshot(bytes);
+    if (snapshot.imageBase !== BigInt.asUintN(64, this.pe.imageBase)) {
+      throw new Error('Snapshot was taken against a different image base.');
+    }
+    if (snapshot.registers.length !== SNAPSHOT_REGISTERS.length) {
+      throw new Error('Snapshot register layout mismatch.');
+    }
+    this.restoreCheckpoint();
+    this.memory.applyPages(snapshot.pages);
+    SNAPSHOT_REGISTERS.forEach((name, index) => this.registers.set(name, snapshot.registers[index]));
+    this.flags = { zf: (snapshot.flags & 1) !== 0, sf: (snapshot.flags & 2) !== 0 };
   }
 
   baseRegisterName(name) {
@@ -106,7 +174,7 @@ export class X86CPU {
 
   computeAddress(desc) {
     if (desc.address.ripRelative) {
-      return this.readRegister('rip', 64) + BigInt(desc.address.displacement);
+      return this.nextRip + BigInt(desc.address.displacement);
     }
     let base = desc.address.base ? this.readRegister(desc.address.base, 64) : 0n;
     let index = desc.address.index ? this.readRegister(desc.address.index, 64) : 0n;
@@ -138,31 +206,180 @@ export class X86CPU {
   }
 
   push(value) {
-    const rsp = this.readRegister('rsp', 64) - 8n;
+    const rsp = this.registers.get('rsp') - 8n;
     this.registers.set('rsp', rsp);
-    this.memory.writeUInt(rsp, 8, value);
+    this.memory.writeStackUInt64(rsp, value);
   }
 
   pop() {
-    const rsp = this.readRegister('rsp', 64);
-    const value = this.memory.readUInt(rsp, 8);
+    const rsp = this.registers.get('rsp');
+    const value = this.memory.readStackUInt64(rsp);
     this.registers.set('rsp', rsp + 8n);
     return value;
   }
 
+  step(state) {
+    const rip = this.registers.get('rip');
+    if (rip >= THUNK_BASE && rip < THUNK_LIMIT) return this.dispatchImport(rip, state);
+    const { hooks, output } = state;
+    const instr = this.decoder.decode(rip);
+    const nextRip = rip + BigInt(instr.length);
+    this.nextRip = nextRip;
+    const action = this.executeInstruction(instr, { nextRip, hooks, output });
+    if (action === 'halt') return false;
+    if (action !== 'jump') this.registers.set('rip', nextRip);
+    return true;
+  }
+
+  bindImportDispatch(hooks) {
+    if (this.dispatchHooks === hooks) return;
+    this.dispatchHooks = hooks;
+    this.importDispatch = this.thunks.entries.map((entry) => this.bindImport(entry, hooks));
+  }
+
+  bindImport(entry, hooks) {
+    const bound = hooks?.bindImport?.(entry.key);
+    if (bound) return bound;
+    if (!hooks?.handleImport) return null;
+    return (cpu, context, imp) => hooks.handleImport(entry.key, cpu, context, imp);
+  }
+
+  dispatchImport(rip, state) {
+    if (rip === CALLBACK_RETURN) return this.returnFromGuest();
+    const imp = this.thunks.entryAt(rip);
+    if (!imp) throw new Error(`Jump into unassigned import thunk 0x${rip.toString(16)}`);
+    if (this.importDispatch[imp.id] === undefined) {
+      this.importDispatch[imp.id] = this.bindImport(imp, this.dispatchHooks);
+    }
+    const handled = this.importDispatch[imp.id]?.(this, state, imp);
+    this.settleImport(imp, handled);
+    return true;
+  }
+
+  settleImport(imp, handled) {
+    if (typeof handled?.then === 'function') {
+      this.pendingImport = { promise: handled, imp };
+    } else if (handled?.call) {
+      this.callGuest(imp, handled.call);
+    } else {
+      this.completeImport(imp, handled);
+    }
+  }
+
+  // Runs a guest function (a WndProc, a TimerProc) on behalf of the import
+  // parked at the thunk. The callee gets a fresh Win64 frame below the
+  // caller's stack and returns into CALLBACK_RETURN, where `then(rax)`
+  // decides how the import itself completes. Nothing is nested on the host
+  // stack, so callbacks may block or call back into user32 themselves.
+  callGuest(imp, { address, args = [], then }) {
+    const rsp = this.registers.get('rsp');
+    const stackArgs = args.slice(ARG_REGISTERS.length);
+    const entry = ((rsp - 0x28n - BigInt(stackArgs.length * 8)) & ~0xfn) - 8n;
+    this.memory.writeStackUInt64(entry, CALLBACK_RETURN);
+    stackArgs.forEach((value, index) => {
+      this.memory.writeStackUInt64(entry + 0x28n + BigInt(index * 8), BigInt.asUintN(64, BigInt(value)));
+    });
+    args.slice(0, ARG_REGISTERS.length).forEach((value, index) => {
+      this.registers.set(ARG_REGISTERS[index], BigInt.asUintN(64, BigInt(value)));
+    });
+    this.guestFrames.push({ imp, rsp, then });
+    this.registers.set('rsp', entry);
+    this.registers.set('rip', BigInt(address));
+  }
+
+  returnFromGuest() {
+    const frame = this.guestFrames.pop();
+    if (!frame) throw new Error('Guest returned into the callback thunk without a pending call.');
+    const rax = this.registers.get('rax');
+    this.registers.set('rsp', frame.rsp);
+    this.settleImport(frame.imp, frame.then ? frame.then(rax) : { rax });
+    return true;
+  }
+
+  // Blocking imports leave RIP on the thunk with the return address still
+  // pushed, so the guest resumes exactly at the call site.
+  completeImport(imp, handled) {
+    const rax = BigInt(handled?.rax ?? 0);
+    this.writeRegister('rax', rax);
+    this.importTrace.record(imp.id, this.runState?.steps ?? 0, rax);
+    this.registers.set('rip', this.pop());
+  }
+
+  async resumeImport() {
+    const pending = this.pendingImport;
+    const handled = await pending.promise;
+    if (this.pendingImport !== pending) return;
+    this.pendingImport = null;
+    this.settleImport(pending.imp, handled);
+  }
+
+  createRunState(hooks) {
+    this.importTrace.clear();
+    this.runState = { hooks, output: [], steps: 0 };
+    return this.runState;
+  }
+
+  importSummary() {
+    const { entries } = this.thunks;
+    return {
+      imports: this.importTrace.recent(entries),
+      importCounts: this.importTrace.counters(entries),
+      importCalls: this.importTrace.total,
+    };
+  }
+
   run({ maxSteps = 50000, hooks } = {}) {
-    const output = [];
-    const visitedImports = [];
-    for (let step = 0; step < maxSteps; step++) {
-      const rip = this.readRegister('rip', 64);
-      const instr = this.decoder.decode(rip);
-      const nextRip = rip + BigInt(instr.length);
-      const action = this.executeInstruction(instr, { nextRip, hooks, output, visitedImports });
-      if (action === 'halt') break;
-      if (action === 'jump') continue;
-      this.registers.set('rip', nextRip);
+    if (this.pendingImport) throw new Error('CPU is suspended in an import; resume it with runAsync.');
+    this.bindImportDispatch(hooks);
+    const state = this.createRunState(hooks);
+    let halted = false;
+    while (state.steps < maxSteps) {
+      state.steps++;
+      if (!this.step(state)) {
+        halted = true;
+        break;
+      }
+      if (this.pendingImport) break;
+    }
+    return this.describeRun(state, halted);
+  }
+
+  describeRun(state, halted) {
+    const exitReason = halted ? 'halt' : this.pendingImport ? 'suspended' : 'max-steps';
+    return {
+      output: state.output,
+      ...this.importSummary(),
+      steps: state.steps,
+      exitReason,
+      suspended: exitReason === 'suspended',
+    };
+  }
+
+  // The step budget lives on the run state so a host can lift it while the
+  // run is parked (see X86Simulator.interact). A PageFault re-runs the
+  // faulting instruction once its page is in. That is safe because every
+  // instruction reads all of its operands before its one memory store, pop
+  // only writes registers, and PeMemory.write is all-or-nothing across pages.
+  async runAsync({ maxSteps = 50000, hooks, onFault } = {}) {
+    this.bindImportDispatch(hooks);
+    const state = this.createRunState(hooks);
+    state.maxSteps = maxSteps;
+    let halted = false;
+    while (state.steps < state.maxSteps) {
+      if (this.pendingImport) await this.resumeImport();
+      try {
+        state.steps++;
+        if (!this.step(state)) {
+          halted = true;
+          break;
+        }
+      } catch (err) {
+        if (!(err instanceof PageFault) || !onFault) throw err;
+        state.steps--;
+        await onFault(err);
+      }
     }
-    return { output, imports: visitedImports };
+    return this.describeRun(state, halted);
   }
 
   executeInstruction(instr, context) {
@@ -292,6 +509,25 @@ export class X86CPU {
         this.flags.zf = value === 0n;
         return;
       }
+      case 'movss':
+      case 'movsd': {
+        const [dest, source] = instr.operands;
+        const value = this.readOperand(source);
+        if (dest.kind === 'reg' && source.kind === 'reg') {
+          // Between registers only the low lane is replaced.
+          const mask = (1n << BigInt(dest.size)) - 1n;
+          this.writeRegister(dest.name, (this.readRegister(dest.name) & ~mask) | value);
+        } else {
+          this.writeOperand(dest, value);
+        }
+        return;
+      }
+      case 'movd':
+        this.writeOperand(instr.operands[0], this.readOperand(instr.operands[1]));
+        return;
+      case 'xorps':
+        this.writeOperand(instr.operands[0], this.readOperand(instr.operands[0]) ^ this.readOperand(instr.operands[1]));
+        return;
       case 'push': {
         const value = this.readOperand(instr.operands[0]);
         this.push(value);
@@ -323,46 +559,24 @@ export class X86CPU {
   }
 
   handleCall(instr, context) {
-    const rip = this.readRegister('rip', 64);
     if (instr.rel != null) {
-      const target = rip + BigInt(instr.rel);
+      const target = context.nextRip + BigInt(instr.rel);
       this.push(context.nextRip);
       this.registers.set('rip', target);
       return 'jump';
     }
     if (!instr.operands.length) throw new Error('call requires operand');
     const operand = instr.operands[0];
-    let target;
-    if (operand.kind === 'mem') {
-      const address = this.computeAddress(operand);
-      target = this.memory.readUInt(address, 8);
-      const imp = this.iatMap.get(target);
-      if (imp) {
-        context.visitedImports.push(imp);
-        const hookName = `${imp.dll}!${imp.name}`;
-        const handled = context.hooks?.handleImport?.(hookName, this, context);
-        if (handled) {
-          if (typeof handled === 'object' && handled.rax !== undefined) {
-            this.writeRegister('rax', BigInt(handled.rax));
-          }
-          this.registers.set('rip', context.nextRip);
-          return 'jump';
-        }
-      }
-    } else if (operand.kind === 'reg') {
-      target = this.readOperand(operand);
-    } else {
-      target = this.readOperand(operand);
-    }
+    const target =
+      operand.kind === 'mem' ? this.memory.readUInt(this.computeAddress(operand), 8) : this.readOperand(operand);
     this.push(context.nextRip);
     this.registers.set('rip', target);
     return 'jump';
   }
 
   handleJump(instr) {
-    const rip = this.readRegister('rip', 64);
     if (instr.rel != null) {
-      this.registers.set('rip', rip + BigInt(instr.rel));
+      this.registers.set('rip', this.nextRip + BigInt(instr.rel));
       return 'jump';
     }
     if (instr.operands.length) {
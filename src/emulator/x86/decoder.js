@@ -1,8 +1,13 @@
 import { Operand, X86Instruction, REG64, REG32, REG16, REG8 } from './instruction.js';
 
+const PAGE_SHIFT = 12n;
+
 export class X86Decoder {
   constructor(memory) {
     this.memory = memory;
+    this.pages = new Map();
+    this.crossingPages = new Set();
+    this.size = 0;
   }
 
   readByte(addr) {
@@ -10,6 +15,65 @@ export class X86Decoder {
   }
 
   decode(rip) {
+    const cached = this.pages.get(Number(rip >> PAGE_SHIFT))?.get(rip);
+    if (cached) return cached;
+    const instr = this.decodeUncached(rip);
+    this.remember(rip, instr);
+    return instr;
+  }
+
+  remember(rip, instr) {
+    const page = Number(rip >> PAGE_SHIFT);
+    let entries = this.pages.get(page);
+    if (!entries) {
+      entries = new Map();
+      this.pages.set(page, entries);
+    }
+    if (!entries.has(rip)) this.size++;
+    entries.set(rip, instr);
+    if (Number((rip + BigInt(instr.length - 1)) >> PAGE_SHIFT) !== page) {
+      this.crossingPages.add(page);
+    }
+  }
+
+  invalidatePage(page) {
+    this.dropPage(page);
+    if (this.crossingPages.has(page - 1)) this.dropPage(page - 1);
+  }
+
+  dropPage(page) {
+    const entries = this.pages.get(page);
+    if (!entries) return;
+    this.size -= entries.size;
+    this.pages.delete(page);
+    this.crossingPages.delete(page);
+  }
+
+  exportInstructions(base, size) {
+    const limit = base + BigInt(size);
+    const out = [];
+    this.pages.forEach((entries) => {
+      entries.forEach((instr, rip) => {
+        if (rip >= base && rip < limit) out.push([Number(rip - base), instr]);
+      });
+    });
+    return out;
+  }
+
+  importInstructions(base, entries) {
+    entries.forEach(([rva, { mnemonic, length, operands = [], imm, rel }]) => {
+      const instr = new X86Instruction({
+        mnemonic,
+        length,
+        imm,
+        rel,
+        operands: operands.map(({ kind, ...props }) => new Operand(kind, props)),
+      });
+      this.remember(base + BigInt(rva), instr);
+    });
+  }
+
+  decodeUncached(rip) {
     const start = rip;
     let cursor = rip;
     const prefixes = [];
@@ -221,6 +285,22 @@ export class X86Decoder {
     return new Operand('mem', { size, address });
   }
 
+  // XMM registers are named xmm0-xmm15 whatever the lane size; `size` is the
+  // width of the scalar moved.
+  resolveXmmOperand(opInfo, isReg, size) {
+    if (isReg) return new Operand('reg', { name: `xmm${opInfo.reg}`, size });
+    if (opInfo.mod === 3) return new Operand('reg', { name: `xmm${opInfo.rm}`, size });
+    return this.resolveOperand(opInfo, false, size);
+  }
+
+  // F3 selects the single-precision scalar form of 0F 10/11, F2 the double.
+  scalarSize(state) {
+    const last = state.prefixes.findLast((byte) => byte === 0xf3 || byte === 0xf2);
+    if (last === 0xf3) return 32;
+    if (last === 0xf2) return 64;
+    return 0;
+  }
+
   registerNameForSize(index, size) {
     switch (size) {
       case 8:
@@ -456,6 +536,9 @@ export class X86Decoder {
           case 6:
             mnemonic = 'xor';
             break;
+          case 7:
+            mnemonic = 'cmp';
+            break;
           default:
             mnemonic = null;
         }
@@ -484,11 +567,35 @@ export class X86Decoder {
             this.resolveOperand(opInfo, false, 16),
           ],
         });
+      case 0x0f10:
+      case 0x0f11: {
+        const size = this.scalarSize(state);
+        if (!size) {
+          this.resolveOperand(opInfo, false, 128);
+          return new X86Instruction({ mnemonic: 'nop' });
+        }
+        const xmm = this.resolveXmmOperand(opInfo, true, size);
+        const rm = this.resolveXmmOperand(opInfo, false, size);
+        return new X86Instruction({
+          mnemonic: size === 32 ? 'movss' : 'movsd',
+          operands: opcode === 0x0f10 ? [xmm, rm] : [rm, xmm],
+        });
+      }
+      case 0x0f57:
+        return new X86Instruction({
+          mnemonic: 'xorps',
+          operands: [this.resolveXmmOperand(opInfo, true, 64), this.resolveXmmOperand(opInfo, false, 64)],
+        });
+      case 0x0f6e:
+      case 0x0f7e: {
+        if (!state.prefixes.includes(0x66)) break;
+        const size = state.rex.w ? 64 : 32;
+        const xmm = this.resolveXmmOperand(opInfo, true, size);
+        const rm = this.resolveOperand(opInfo, false, size);
+        return new X86Instruction({ mnemonic: 'movd', operands: opcode === 0x0f6e ? [xmm, rm] : [rm, xmm] });
+      }
       case 0x0f28:
       case 0x0f29:
-      case 0x0f57:
-      case 0x0f10:
-      case 0x0f11:
       case 0x0f1f:
         this.resolveOperand(opInfo, false, 128);
         return new X86Instruction({ mnemonic: 'nop' });
@@ -1,13 +1,109 @@
 import { PeFile } from '../pe-file.js';
 import { X86CPU } from './cpu.js';
+import { normalizeModuleName } from '../module-loader.js';
+import { PAGE_SIZE } from '../guest-stack.js';
 
+function createImageResolver(modules) {
+  if (!modules) return undefined;
+  const entries = modules instanceof Map ? Array.from(modules.entries()) : Object.entries(modules);
+  const index = new Map(entries.map(([name, buffer]) => [normalizeModuleName(name), buffer]));
+  return (name) => index.get(normalizeModuleName(name)) ?? null;
+}
+
+// Re-running a simulator starts the guest over. With `checkpoint`, memory
+// writes are tracked against the freshly loaded image so reset() puts back
+// only the pages a run touched (and snapshots can be taken), at the cost of
+// copying each page on its first write. Without it, which suits one-shot
+// runs, reset() builds a new CPU instead.
 export class X86Simulator {
-  constructor(buffer) {
-    this.pe = new PeFile(buffer);
+  constructor(buffer, { modules, file, cacheRecord, pe, streamingImage, checkpoint = false } = {}) {
+    this.pe = pe ?? (cacheRecord?.pe ? PeFile.fromCacheRecord(buffer, cacheRecord.pe) : new PeFile(buffer));
+    this.streamingImage = streamingImage ?? null;
+    this.cachedCode = cacheRecord?.code ?? null;
+    this.moduleName = file?.name;
+    this.resolveImage = createImageResolver(modules);
+    this.checkpointing = checkpoint;
+    this.loadedModules = [];
+    this.cpu = null;
+    this.dirty = false;
+  }
+
+  ensureCpu() {
+    if (!this.cpu) {
+      this.cpu = new X86CPU(this.pe, { resolveImage: this.resolveImage, moduleName: this.moduleName });
+      if (this.streamingImage) this.cpu.memory.residency = this.streamingImage;
+      if (this.cachedCode) this.cpu.decoder.importInstructions(this.pe.imageBase, this.cachedCode);
+      this.loadedModules.forEach(({ buffer, name }) => this.mapModule(buffer, name));
+      if (this.checkpointing) this.cpu.checkpoint();
+    }
+    return this.cpu;
+  }
+
+  reset() {
+    this.dirty = false;
+    if (!this.checkpointing) {
+      this.cpu = null;
+      this.ensureCpu();
+      return 0;
+    }
+    return this.ensureCpu().restoreCheckpoint();
   }
 
-  run(options = {}) {
-    const cpu = new X86CPU(this.pe);
+  run({ resume = false, ...options } = {}) {
+    if (this.dirty && !resume) this.reset();
+    const cpu = this.ensureCpu();
+    this.dirty = true;
     return cpu.run(options);
   }
+
+  runAsync({ resume = false, ...options } = {}) {
+    if (this.dirty && !resume) this.reset();
+    const cpu = this.ensureCpu();
+    this.dirty = true;
+    const image = this.streamingImage;
+    const onFault = image ? (fault) => image.waitFor(fault.offset + PAGE_SIZE) : undefined;
+    return cpu.runAsync({ onFault, ...options });
+  }
+
+  // Summary of a run whose guest has parked in its message loop. The run
+  // keeps going as an interactive session with no step budget: it ends when
+  // the guest quits, not after a fixed number of instructions.
+  interact() {
+    const cpu = this.ensureCpu();
+    if (cpu.runState) cpu.runState.maxSteps = Infinity;
+    return { ...cpu.describeRun(cpu.runState ?? { output: [], steps: 0 }, false), exitReason: 'message-loop' };
+  }
+
+  loadModule(buffer, name) {
+    const cpu = this.ensureCpu();
+    const module = this.mapModule(buffer, name);
+    this.loadedModules.push({ buffer, name });
+    if (this.checkpointing) cpu.checkpoint();
+    return module;
+  }
+
+  mapModule(buffer, name) {
+    const { loader } = this.cpu;
+    const module = loader.mapImage(buffer, { name });
+    loader.bindImports(loader.mainModule);
+    return module;
+  }
+
+  exportCacheRecord() {
+    const decoder = this.cpu?.decoder;
+    if (this.cachedCode && (!decoder || decoder.size <= this.cachedCode.length)) return null;
+    return {
+      pe: this.pe.toCacheRecord(),
+      code: decoder ? decoder.exportInstructions(this.pe.imageBase, this.pe.sizeOfImage) : [],
+    };
+  }
+
+  createSnapshot() {
+    return this.ensureCpu().createSnapshot();
+  }
+
+  restoreSnapshot(bytes) {
+    this.ensureCpu().restoreSnapshot(bytes);
+    this.dirty = true;
+  }
 }
@@ -32,8 +32,7 @@ export function useTaskManager(wine, setStatusText) {
       });
       setIsSimulating(true);
       try {
-        await wine.loadBinary(file);
-        const simulation = wine.run(file);
+        const simulation = await wine.loadAndRun(file);
         setTasks((prev) =>
           prev.map((task) =>
             task.id === taskId
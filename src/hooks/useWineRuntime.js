@@ -8,6 +8,7 @@ export function useWineRuntime({
   canvasRef,
   statusRef,
   setStatusText,
+  setCacheStatus,
   wineRef,
 }) {
   const [wine, setWine] = React.useState(null);
@@ -30,6 +31,11 @@ export function useWineRuntime({
       setStatusText(text);
       defaultSetStatus(text);
     };
+    const defaultSetCacheStatus = instance.setCacheStatus.bind(instance);
+    instance.setCacheStatus = (state) => {
+      setCacheStatus?.(state);
+      defaultSetCacheStatus(state);
+    };
     wineRef.current = instance;
     setWine(instance);
     setStatusText('Load a `.exe` to inspect imports or render a mock window.');
@@ -39,7 +45,7 @@ export function useWineRuntime({
         wineRef.current = null;
       }
     };
-  }, [pluginInstances, consoleRef, stringRef, canvasRef, statusRef, setStatusText, wineRef]);
+  }, [pluginInstances, consoleRef, stringRef, canvasRef, statusRef, setStatusText, setCacheStatus, wineRef]);
 
   return wine;
 }
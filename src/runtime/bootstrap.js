@@ -37,8 +37,7 @@ export function setupWineRuntime() {
     if (!file) return;
     wine.setStatus(`Loading ${file.name} (${(file.size / 1024).toFixed(1)} KB)…`);
     try {
-      await wine.loadBinary(file);
-      wine.run(file);
+      await wine.loadAndRun(file);
     } catch (err) {
       wine.setStatus(`Failed to load ${file.name}. ${err?.message ?? err}`);
     }
@@ -0,0 +1,36 @@
+import { mkdir, readFile, writeFile, rename, rm } from 'node:fs/promises';
+import path from 'node:path';
+import { threadId } from 'node:worker_threads';
+
+export class FileCacheStore {
+  constructor({ directory }) {
+    this.directory = directory;
+    this.ready = null;
+  }
+
+  pathFor(key) {
+    return path.join(this.directory, `${key}.json`);
+  }
+
+  async get(key) {
+    try {
+      return await readFile(this.pathFor(key), 'utf8');
+    } catch (err) {
+      if (err?.code === 'ENOENT') return null;
+      throw err;
+    }
+  }
+
+  async put(key, text) {
+    this.ready ??= mkdir(this.directory, { recursive: true });
+    await this.ready;
+    const target = this.pathFor(key);
+    const temp = `${target}.${process.pid}-${threadId}.tmp`;
+    await writeFile(temp, text);
+    await rename(temp, target);
+  }
+
+  async delete(key) {
+    await rm(this.pathFor(key), { force: true });
+  }
+}
@@ -0,0 +1,82 @@
+// Bump whenever the shape of PeFile.toCacheRecord() or the decoded
+// instruction encoding changes; older records are treated as misses.
+export const IMAGE_CACHE_VERSION = 1;
+
+function toHex(bytes) {
+  let out = '';
+  for (let i = 0; i < bytes.length; i++) out += bytes[i].toString(16).padStart(2, '0');
+  return out;
+}
+
+export async function hashImage(buffer) {
+  const subtle = globalThis.crypto?.subtle;
+  if (!subtle) throw new Error('SHA-256 is unavailable: WebCrypto not present.');
+  const digest = await subtle.digest('SHA-256', buffer);
+  return toHex(new Uint8Array(digest));
+}
+
+export function encodeCacheRecord(record) {
+  return JSON.stringify(record, (key, value) => (typeof value === 'bigint' ? { $big: value.toString(16) } : value));
+}
+
+export function decodeCacheRecord(text) {
+  return JSON.parse(text, (key, value) =>
+    value && typeof value === 'object' && typeof value.$big === 'string' ? BigInt(`0x${value.$big}`) : value,
+  );
+}
+
+export class MemoryCacheStore {
+  constructor() {
+    this.entries = new Map();
+  }
+
+  async get(key) {
+    return this.entries.get(key) ?? null;
+  }
+
+  async put(key, text) {
+    this.entries.set(key, text);
+  }
+
+  async delete(key) {
+    this.entries.delete(key);
+  }
+}
+
+export class ImageCache {
+  constructor({ store, version = IMAGE_CACHE_VERSION, log } = {}) {
+    this.store = store;
+    this.version = version;
+    this.log = log;
+    this.stats = { hits: 0, misses: 0 };
+  }
+
+  async lookup(buffer) {
+    const hash = await hashImage(buffer);
+    let record = null;
+    try {
+      const text = await this.store.get(hash);
+      const decoded = text ? decodeCacheRecord(text) : null;
+      if (decoded?.version === this.version && decoded.size === buffer.length) {
+        record = decoded;
+      } else if (decoded) {
+        await this.store.delete(hash);
+      }
+    } catch (err) {
+      this.log?.(`[WineJS] Image cache read failed: ${err?.message ?? err}`);
+    }
+    if (record) this.stats.hits++;
+    else this.stats.misses++;
+    return { hash, hit: Boolean(record), record };
+  }
+
+  async save(hash, size, record) {
+    try {
+      await this.store.put(hash, encodeCacheRecord({ ...record, version: this.version, size }));
+      return true;
+    } catch (err) {
+      this.log?.(`[WineJS] Image cache write failed: ${err?.message ?? err}`);
+      return false;
+    }
+  }
+}
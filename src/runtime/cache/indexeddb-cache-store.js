@@ -0,0 +1,46 @@
+function promisify(request) {
+  return new Promise((resolve, reject) => {
+    request.onsuccess = () => resolve(request.result);
+    request.onerror = () => reject(request.error);
+  });
+}
+
+export class IndexedDbCacheStore {
+  constructor({ indexedDB = globalThis.indexedDB, dbName = 'winejs-image-cache', storeName = 'images' } = {}) {
+    this.indexedDB = indexedDB;
+    this.dbName = dbName;
+    this.storeName = storeName;
+    this.dbPromise = null;
+  }
+
+  open() {
+    if (!this.dbPromise) {
+      const request = this.indexedDB.open(this.dbName, 1);
+      request.onupgradeneeded = () => {
+        if (!request.result.objectStoreNames.contains(this.storeName)) {
+          request.result.createObjectStore(this.storeName);
+        }
+      };
+      this.dbPromise = promisify(request);
+    }
+    return this.dbPromise;
+  }
+
+  async transact(mode, fn) {
+    const db = await this.open();
+    const store = db.transaction(this.storeName, mode).objectStore(this.storeName);
+    return promisify(fn(store));
+  }
+
+  async get(key) {
+    return (await this.transact('readonly', (store) => store.get(key))) ?? null;
+  }
+
+  put(key, text) {
+    return this.transact('readwrite', (store) => store.put(text, key));
+  }
+
+  delete(key) {
+    return this.transact('readwrite', (store) => store.delete(key));
+  }
+}
@@ -0,0 +1,77 @@
+const OBJECT_SIZE = 16n;
+const POINTER_SIZE = 8n;
+
+export const S_OK = 0n;
+export const E_NOINTERFACE = 0x80004002n;
+export const E_NOTIMPL = 0x80004001n;
+export const E_POINTER = 0x80004003n;
+export const E_INVALIDARG = 0x80070057n;
+
+// Guest-visible COM objects whose methods are native JS. Each interface gets
+// one vtable in a reserved region, filled with import-thunk addresses named
+// `Interface::Method` after the interface that declares the slot, so
+// inherited methods share a thunk and show up in the import trace by name.
+// An object is a vtable pointer in guest memory plus a JS-side record keyed
+// by its address; `this` (rcx) finds the record again.
+export class ComHeap {
+  constructor(cpu, { base, size, dll }) {
+    this.cpu = cpu;
+    this.dll = dll;
+    this.base = base;
+    this.limit = base + BigInt(size);
+    this.top = base;
+    this.free = [];
+    this.vtables = new Map();
+    this.objects = new Map();
+    cpu.memory.mapRegion({ base, bytes: new Uint8Array(size), name: `${dll}-com` });
+  }
+
+  // `slots` lists [declaringInterface, method] pairs in vtable order.
+  vtableFor(name, slots) {
+    let vtable = this.vtables.get(name);
+    if (vtable) return vtable;
+    vtable = this.allocate(BigInt(slots.length) * POINTER_SIZE);
+    slots.forEach(([owner, method], index) => {
+      const entry = this.cpu.thunks.intern(this.dll, `${owner}::${method}`);
+      this.cpu.memory.writeUInt(vtable + BigInt(index) * POINTER_SIZE, 8, this.cpu.thunks.addressOf(entry.id));
+    });
+    this.vtables.set(name, vtable);
+    return vtable;
+  }
+
+  allocate(size) {
+    const address = this.top;
+    const aligned = (size + 15n) & ~15n;
+    if (address + aligned > this.limit) throw new Error(`${this.dll} COM heap exhausted.`);
+    this.top += aligned;
+    return address;
+  }
+
+  create(vtable, record) {
+    const address = this.free.pop() ?? this.allocate(OBJECT_SIZE);
+    this.cpu.memory.writeUInt(address, 8, vtable);
+    this.objects.set(address, Object.assign(record, { address, refs: 1 }));
+    return record;
+  }
+
+  get(address) {
+    return this.objects.get(address) ?? null;
+  }
+
+  addRef(object) {
+    object.refs += 1;
+    return object.refs;
+  }
+
+  // Freed slots are zeroed so a stale pointer faults on a null vtable
+  // instead of reaching a recycled object.
+  release(object) {
+    object.refs -= 1;
+    if (object.refs > 0) return object.refs;
+    this.objects.delete(object.address);
+    this.cpu.memory.writeUInt(object.address, 8, 0n);
+    this.free.push(object.address);
+    object.onRelease?.();
+    return 0;
+  }
+}
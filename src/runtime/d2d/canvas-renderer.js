@@ -0,0 +1,99 @@
+import {
+  CMD_CLEAR,
+  CMD_FILL_ELLIPSE,
+  CMD_FILL_RECT,
+  CMD_LINE,
+  CMD_POP_CLIP,
+  CMD_PUSH_CLIP,
+  CMD_STROKE_ELLIPSE,
+  CMD_STROKE_RECT,
+  CMD_TRANSFORM,
+} from './command-buffer.js';
+
+function colorAt(data, offset) {
+  const channel = (index) => Math.round(Math.min(1, Math.max(0, data[offset + index])) * 255);
+  return `rgba(${channel(0)}, ${channel(1)}, ${channel(2)}, ${Math.min(1, Math.max(0, data[offset + 3]))})`;
+}
+
+function traceEllipse(ctx, data, offset) {
+  const radiusX = Math.abs(data[offset + 2]);
+  const radiusY = Math.abs(data[offset + 3]);
+  ctx.beginPath();
+  ctx.ellipse(data[offset], data[offset + 1], radiusX, radiusY, 0, 0, Math.PI * 2);
+}
+
+// Replays one frame's command buffer into a Canvas 2D context in a single
+// pass. `originX/originY` place the render target's client area inside the
+// canvas (non-zero for child windows) and `width/height` bound Clear.
+export function replayCommands(commands, ctx, { originX = 0, originY = 0, width, height } = {}) {
+  const { data } = commands;
+  const clearWidth = width ?? ctx.canvas?.width ?? 0;
+  const clearHeight = height ?? ctx.canvas?.height ?? 0;
+  let matrix = [1, 0, 0, 1, 0, 0];
+  let clips = 0;
+  const applyMatrix = () =>
+    ctx.setTransform(matrix[0], matrix[1], matrix[2], matrix[3], matrix[4] + originX, matrix[5] + originY);
+  ctx.save();
+  applyMatrix();
+  commands.forEach((opcode, at) => {
+    switch (opcode) {
+      case CMD_CLEAR:
+        ctx.save();
+        ctx.setTransform(1, 0, 0, 1, 0, 0);
+        ctx.clearRect(originX, originY, clearWidth, clearHeight);
+        ctx.fillStyle = colorAt(data, at);
+        ctx.fillRect(originX, originY, clearWidth, clearHeight);
+        ctx.restore();
+        break;
+      case CMD_TRANSFORM:
+        matrix = Array.from(data.subarray(at, at + 6));
+        applyMatrix();
+        break;
+      case CMD_FILL_RECT:
+        ctx.fillStyle = colorAt(data, at + 4);
+        ctx.fillRect(data[at], data[at + 1], data[at + 2] - data[at], data[at + 3] - data[at + 1]);
+        break;
+      case CMD_STROKE_RECT:
+        ctx.strokeStyle = colorAt(data, at + 5);
+        ctx.lineWidth = data[at + 4];
+        ctx.strokeRect(data[at], data[at + 1], data[at + 2] - data[at], data[at + 3] - data[at + 1]);
+        break;
+      case CMD_FILL_ELLIPSE:
+        traceEllipse(ctx, data, at);
+        ctx.fillStyle = colorAt(data, at + 4);
+        ctx.fill();
+        break;
+      case CMD_STROKE_ELLIPSE:
+        traceEllipse(ctx, data, at);
+        ctx.strokeStyle = colorAt(data, at + 5);
+        ctx.lineWidth = data[at + 4];
+        ctx.stroke();
+        break;
+      case CMD_LINE:
+        ctx.beginPath();
+        ctx.moveTo(data[at], data[at + 1]);
+        ctx.lineTo(data[at + 2], data[at + 3]);
+        ctx.strokeStyle = colorAt(data, at + 5);
+        ctx.lineWidth = data[at + 4];
+        ctx.stroke();
+        break;
+      case CMD_PUSH_CLIP:
+        clips += 1;
+        ctx.save();
+        ctx.beginPath();
+        ctx.rect(data[at], data[at + 1], data[at + 2] - data[at], data[at + 3] - data[at + 1]);
+        ctx.clip();
+        break;
+      case CMD_POP_CLIP:
+        if (!clips) break;
+        clips -= 1;
+        ctx.restore();
+        applyMatrix();
+        break;
+      default:
+        break;
+    }
+  });
+  for (; clips > 0; clips--) ctx.restore();
+  ctx.restore();
+}
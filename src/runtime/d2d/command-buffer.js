@@ -0,0 +1,53 @@
+export const CMD_CLEAR = 1;
+export const CMD_TRANSFORM = 2;
+export const CMD_FILL_RECT = 3;
+export const CMD_STROKE_RECT = 4;
+export const CMD_FILL_ELLIPSE = 5;
+export const CMD_STROKE_ELLIPSE = 6;
+export const CMD_LINE = 7;
+export const CMD_PUSH_CLIP = 8;
+export const CMD_POP_CLIP = 9;
+
+// Operand counts per opcode, not counting the opcode slot itself. Colors are
+// four floats (premultiplied by brush opacity), geometry is in DIPs.
+export const COMMAND_OPERANDS = [0, 4, 6, 8, 9, 8, 9, 9, 4, 0];
+
+const INITIAL_CAPACITY = 1024;
+
+// Draw calls between BeginDraw and EndDraw, packed into one Float32Array:
+// an opcode followed by its operands. Buffers are reset and reused frame to
+// frame, so steady-state recording allocates nothing.
+export class CommandBuffer {
+  constructor(capacity = INITIAL_CAPACITY) {
+    this.data = new Float32Array(capacity);
+    this.length = 0;
+    this.count = 0;
+  }
+
+  reset() {
+    this.length = 0;
+    this.count = 0;
+  }
+
+  push(opcode, ...operands) {
+    const needed = this.length + 1 + operands.length;
+    if (needed > this.data.length) {
+      const grown = new Float32Array(Math.max(needed, this.data.length * 2));
+      grown.set(this.data.subarray(0, this.length));
+      this.data = grown;
+    }
+    this.data[this.length++] = opcode;
+    for (let index = 0; index < operands.length; index++) this.data[this.length++] = operands[index];
+    this.count += 1;
+  }
+
+  // Calls visit(opcode, offset) with the offset of the first operand.
+  forEach(visit) {
+    let cursor = 0;
+    while (cursor < this.length) {
+      const opcode = this.data[cursor];
+      visit(opcode, cursor + 1);
+      cursor += 1 + COMMAND_OPERANDS[opcode];
+    }
+  }
+}
@@ -0,0 +1,154 @@
+import {
+  CMD_CLEAR,
+  CMD_FILL_ELLIPSE,
+  CMD_FILL_RECT,
+  CMD_LINE,
+  CMD_POP_CLIP,
+  CMD_PUSH_CLIP,
+  CMD_STROKE_ELLIPSE,
+  CMD_STROKE_RECT,
+  CMD_TRANSFORM,
+} from './command-buffer.js';
+
+export const SHAPE_FILL_RECT = 0;
+export const SHAPE_STROKE_RECT = 1;
+export const SHAPE_FILL_ELLIPSE = 2;
+export const SHAPE_STROKE_ELLIPSE = 3;
+export const SHAPE_LINE = 4;
+
+// One instanced quad: geometry (rect l/t/r/b, ellipse cx/cy/rx/ry or line
+// x0/y0/x1/y1), straight RGBA, the two rows of the 2x3 transform and
+// (shape, stroke width). Sixteen floats keeps the stride at 64 bytes.
+export const INSTANCE_FLOATS = 16;
+export const INSTANCE_GEOMETRY = 0;
+export const INSTANCE_COLOR = 4;
+export const INSTANCE_ROW0 = 8;
+export const INSTANCE_ROW1 = 11;
+export const INSTANCE_PARAMS = 14;
+
+const INITIAL_INSTANCES = 256;
+
+function intersect(a, b) {
+  const left = Math.max(a.left, b.left);
+  const top = Math.max(a.top, b.top);
+  return {
+    left,
+    top,
+    right: Math.max(left, Math.min(a.right, b.right)),
+    bottom: Math.max(top, Math.min(a.bottom, b.bottom)),
+  };
+}
+
+// Axis-aligned clips take the bounding box of the transformed rect, like
+// PushAxisAlignedClip does.
+function transformedBounds(matrix, left, top, right, bottom) {
+  const xs = [];
+  const ys = [];
+  for (const [x, y] of [[left, top], [right, top], [left, bottom], [right, bottom]]) {
+    xs.push(x * matrix[0] + y * matrix[2] + matrix[4]);
+    ys.push(x * matrix[1] + y * matrix[3] + matrix[5]);
+  }
+  return {
+    left: Math.floor(Math.min(...xs)),
+    top: Math.floor(Math.min(...ys)),
+    right: Math.ceil(Math.max(...xs)),
+    bottom: Math.ceil(Math.max(...ys)),
+  };
+}
+
+// Turns a CommandBuffer into instance data plus the steps that draw it: runs
+// of instances sharing a scissor rect, broken only by Clear and clip changes,
+// so a frame of thousands of shapes is a handful of instanced draws.
+export class InstanceBatch {
+  constructor(capacity = INITIAL_INSTANCES) {
+    this.data = new Float32Array(capacity * INSTANCE_FLOATS);
+    this.count = 0;
+    this.steps = [];
+  }
+
+  reset() {
+    this.count = 0;
+    this.steps.length = 0;
+  }
+
+  add(shape, data, at, width, colorAt, matrix) {
+    if ((this.count + 1) * INSTANCE_FLOATS > this.data.length) {
+      const grown = new Float32Array(this.data.length * 2);
+      grown.set(this.data);
+      this.data = grown;
+    }
+    const base = this.count * INSTANCE_FLOATS;
+    const out = this.data;
+    for (let index = 0; index < 4; index++) {
+      out[base + INSTANCE_GEOMETRY + index] = data[at + index];
+      out[base + INSTANCE_COLOR + index] = data[colorAt + index];
+    }
+    out[base + INSTANCE_ROW0] = matrix[0];
+    out[base + INSTANCE_ROW0 + 1] = matrix[2];
+    out[base + INSTANCE_ROW0 + 2] = matrix[4];
+    out[base + INSTANCE_ROW1] = matrix[1];
+    out[base + INSTANCE_ROW1 + 1] = matrix[3];
+    out[base + INSTANCE_ROW1 + 2] = matrix[5];
+    out[base + INSTANCE_PARAMS] = shape;
+    out[base + INSTANCE_PARAMS + 1] = width;
+    this.count += 1;
+  }
+
+  // Steps are { clear: [r, g, b, a], scissor } or { first, count, scissor }
+  // with the scissor in target pixels, top-left origin.
+  encode(commands, { width, height }) {
+    this.reset();
+    const { data } = commands;
+    const viewport = { left: 0, top: 0, right: width, bottom: height };
+    const clips = [viewport];
+    let matrix = [1, 0, 0, 1, 0, 0];
+    let run = null;
+    const scissor = () => clips[clips.length - 1];
+    const draw = (shape, at, strokeWidth, colorAt) => {
+      if (!run) {
+        run = { first: this.count, count: 0, scissor: scissor() };
+        this.steps.push(run);
+      }
+      this.add(shape, data, at, strokeWidth, colorAt, matrix);
+      run.count += 1;
+    };
+    commands.forEach((opcode, at) => {
+      switch (opcode) {
+        case CMD_CLEAR:
+          run = null;
+          this.steps.push({ clear: Array.from(data.subarray(at, at + 4)), scissor: scissor() });
+          break;
+        case CMD_TRANSFORM:
+          matrix = Array.from(data.subarray(at, at + 6));
+          break;
+        case CMD_FILL_RECT:
+          draw(SHAPE_FILL_RECT, at, 0, at + 4);
+          break;
+        case CMD_STROKE_RECT:
+          draw(SHAPE_STROKE_RECT, at, data[at + 4], at + 5);
+          break;
+        case CMD_FILL_ELLIPSE:
+          draw(SHAPE_FILL_ELLIPSE, at, 0, at + 4);
+          break;
+        case CMD_STROKE_ELLIPSE:
+          draw(SHAPE_STROKE_ELLIPSE, at, data[at + 4], at + 5);
+          break;
+        case CMD_LINE:
+          draw(SHAPE_LINE, at, data[at + 4], at + 5);
+          break;
+        case CMD_PUSH_CLIP:
+          run = null;
+          clips.push(intersect(scissor(), transformedBounds(matrix, data[at], data[at + 1], data[at + 2], data[at + 3])));
+          break;
+        case CMD_POP_CLIP:
+          if (clips.length === 1) break;
+          run = null;
+          clips.pop();
+          break;
+        default:
+          break;
+      }
+    });
+    return this;
+  }
+}
@@ -0,0 +1,92 @@
+// Vtable layouts from d2d1.h, in slot order. Each slot is named after the
+// interface that declares it.
+const slots = (owner, methods) => methods.map((method) => [owner, method]);
+
+const IUNKNOWN = slots('IUnknown', ['QueryInterface', 'AddRef', 'Release']);
+const ID2D1_RESOURCE = [...IUNKNOWN, ...slots('ID2D1Resource', ['GetFactory'])];
+
+export const ID2D1_FACTORY = [
+  ...IUNKNOWN,
+  ...slots('ID2D1Factory', [
+    'ReloadSystemMetrics',
+    'GetDesktopDpi',
+    'CreateRectangleGeometry',
+    'CreateRoundedRectangleGeometry',
+    'CreateEllipseGeometry',
+    'CreateGeometryGroup',
+    'CreateTransformedGeometry',
+    'CreatePathGeometry',
+    'CreateStrokeStyle',
+    'CreateDrawingStateBlock',
+    'CreateWicBitmapRenderTarget',
+    'CreateHwndRenderTarget',
+    'CreateDxgiSurfaceRenderTarget',
+    'CreateDCRenderTarget',
+  ]),
+];
+
+export const ID2D1_SOLID_COLOR_BRUSH = [
+  ...ID2D1_RESOURCE,
+  ...slots('ID2D1Brush', ['SetOpacity', 'SetTransform', 'GetOpacity', 'GetTransform']),
+  ...slots('ID2D1SolidColorBrush', ['SetColor', 'GetColor']),
+];
+
+export const ID2D1_HWND_RENDER_TARGET = [
+  ...ID2D1_RESOURCE,
+  ...slots('ID2D1RenderTarget', [
+    'CreateBitmap',
+    'CreateBitmapFromWicBitmap',
+    'CreateSharedBitmap',
+    'CreateBitmapBrush',
+    'CreateSolidColorBrush',
+    'CreateGradientStopCollection',
+    'CreateLinearGradientBrush',
+    'CreateRadialGradientBrush',
+    'CreateCompatibleRenderTarget',
+    'CreateLayer',
+    'CreateMesh',
+    'DrawLine',
+    'DrawRectangle',
+    'FillRectangle',
+    'DrawRoundedRectangle',
+    'FillRoundedRectangle',
+    'DrawEllipse',
+    'FillEllipse',
+    'DrawGeometry',
+    'FillGeometry',
+    'FillMesh',
+    'FillOpacityMask',
+    'DrawBitmap',
+    'DrawText',
+    'DrawTextLayout',
+    'DrawGlyphRun',
+    'SetTransform',
+    'GetTransform',
+    'SetAntialiasMode',
+    'GetAntialiasMode',
+    'SetTextAntialiasMode',
+    'GetTextAntialiasMode',
+    'SetTextRenderingParams',
+    'GetTextRenderingParams',
+    'SetTags',
+    'GetTags',
+    'PushLayer',
+    'PopLayer',
+    'Flush',
+    'SaveDrawingState',
+    'RestoreDrawingState',
+    'PushAxisAlignedClip',
+    'PopAxisAlignedClip',
+    'Clear',
+    'BeginDraw',
+    'EndDraw',
+    'GetPixelFormat',
+    'SetDpi',
+    'GetDpi',
+    'GetSize',
+    'GetPixelSize',
+    'GetMaximumBitmapSize',
+    'IsSupported',
+  ]),
+  ...slots('ID2D1HwndRenderTarget', ['CheckWindowState', 'Resize', 'GetHwnd']),
+];
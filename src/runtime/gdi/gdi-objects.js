@@ -0,0 +1,132 @@
+export const WHITE_BRUSH = 0;
+export const LTGRAY_BRUSH = 1;
+export const GRAY_BRUSH = 2;
+export const DKGRAY_BRUSH = 3;
+export const BLACK_BRUSH = 4;
+export const NULL_BRUSH = 5;
+export const WHITE_PEN = 6;
+export const BLACK_PEN = 7;
+export const NULL_PEN = 8;
+export const OEM_FIXED_FONT = 10;
+export const ANSI_FIXED_FONT = 11;
+export const ANSI_VAR_FONT = 12;
+export const SYSTEM_FONT = 13;
+export const DEVICE_DEFAULT_FONT = 14;
+export const SYSTEM_FIXED_FONT = 16;
+export const DEFAULT_GUI_FONT = 17;
+export const DC_BRUSH = 18;
+export const DC_PEN = 19;
+
+export const PS_SOLID = 0;
+export const PS_DASH = 1;
+export const PS_DOT = 2;
+export const PS_NULL = 5;
+
+export const TRANSPARENT = 1;
+export const OPAQUE = 2;
+
+export const DT_CENTER = 0x1;
+export const DT_RIGHT = 0x2;
+export const DT_VCENTER = 0x4;
+export const DT_BOTTOM = 0x8;
+export const DT_SINGLELINE = 0x20;
+export const DT_NOCLIP = 0x100;
+export const DT_CALCRECT = 0x400;
+
+export const FIXED_PITCH = 1;
+export const FW_NORMAL = 400;
+export const CLR_INVALID = 0xffffffff;
+
+export const COLOR_WINDOW = 5;
+export const COLOR_WINDOWTEXT = 8;
+export const COLOR_HIGHLIGHT = 13;
+export const COLOR_HIGHLIGHTTEXT = 14;
+
+const COLOR_MAX = 30;
+const DEFAULT_FONT_PX = 16;
+
+// GetSysColor defaults (COLORREF, 0x00BBGGRR) for the indices guests use
+// for backgrounds and text; anything else reads as the button face.
+const SYSTEM_COLORS = new Map([
+  [0, 0xc8c8c8],
+  [1, 0x000000],
+  [2, 0xd1b499],
+  [4, 0xf0f0f0],
+  [5, 0xffffff],
+  [6, 0x646464],
+  [7, 0x000000],
+  [8, 0x000000],
+  [9, 0x000000],
+  [12, 0xababab],
+  [13, 0xd77800],
+  [14, 0xffffff],
+  [15, 0xf0f0f0],
+  [16, 0xa0a0a0],
+  [17, 0x6d6d6d],
+  [18, 0x000000],
+  [20, 0xffffff],
+]);
+
+export function isSystemColorIndex(index) {
+  return index >= 0 && index <= COLOR_MAX;
+}
+
+export function systemColor(index) {
+  return SYSTEM_COLORS.get(index) ?? 0xf0f0f0;
+}
+
+export function colorToCss(color) {
+  return `rgb(${color & 0xff}, ${(color >>> 8) & 0xff}, ${(color >>> 16) & 0xff})`;
+}
+
+// LOGFONT heights: negative is the character height, positive the cell
+// height, zero the default.
+export function fontMetrics(font) {
+  if (font.height < 0) return { px: -font.height, lineHeight: Math.ceil(-font.height * 1.2) };
+  if (font.height > 0) return { px: Math.max(1, Math.round(font.height / 1.2)), lineHeight: font.height };
+  return { px: DEFAULT_FONT_PX, lineHeight: Math.ceil(DEFAULT_FONT_PX * 1.2) };
+}
+
+export function fontToCss(font) {
+  const style = font.italic ? 'italic ' : '';
+  const family = font.pitch & FIXED_PITCH ? 'monospace' : 'sans-serif';
+  const face = font.face ? `"${font.face.replace(/"/g, '')}", ` : '';
+  return `${style}${font.weight || FW_NORMAL} ${fontMetrics(font).px}px ${face}${family}`;
+}
+
+export function makeFont({
+  height = 0,
+  weight = FW_NORMAL,
+  italic = false,
+  underline = false,
+  pitch = 0,
+  face = '',
+} = {}) {
+  return { type: 'font', height, weight, italic, underline, pitch, face };
+}
+
+export function makeStockObjects() {
+  const brush = (color) => ({ type: 'brush', color });
+  const pen = (color) => ({ type: 'pen', style: PS_SOLID, width: 1, color });
+  const fixed = makeFont({ pitch: FIXED_PITCH, face: 'Consolas' });
+  return new Map([
+    [WHITE_BRUSH, brush(0xffffff)],
+    [LTGRAY_BRUSH, brush(0xc0c0c0)],
+    [GRAY_BRUSH, brush(0x808080)],
+    [DKGRAY_BRUSH, brush(0x404040)],
+    [BLACK_BRUSH, brush(0x000000)],
+    [NULL_BRUSH, { type: 'brush', color: 0, hollow: true }],
+    [WHITE_PEN, pen(0xffffff)],
+    [BLACK_PEN, pen(0x000000)],
+    [NULL_PEN, { type: 'pen', style: PS_NULL, width: 1, color: 0 }],
+    [OEM_FIXED_FONT, fixed],
+    [ANSI_FIXED_FONT, fixed],
+    [ANSI_VAR_FONT, makeFont({ face: 'Segoe UI' })],
+    [SYSTEM_FONT, makeFont({ weight: 700, face: 'Segoe UI' })],
+    [DEVICE_DEFAULT_FONT, makeFont({ face: 'Segoe UI' })],
+    [SYSTEM_FIXED_FONT, fixed],
+    [DEFAULT_GUI_FONT, makeFont({ height: -12, face: 'Segoe UI' })],
+    [DC_BRUSH, { type: 'brush', fromDc: true }],
+    [DC_PEN, { type: 'pen', style: PS_SOLID, width: 1, fromDc: true }],
+  ]);
+}
@@ -0,0 +1,490 @@
+import { addRect, intersectRect, isEmptyRect, makeRect } from './rect-list.js';
+import {
+  BLACK_PEN,
+  CLR_INVALID,
+  DT_BOTTOM,
+  DT_CALCRECT,
+  DT_CENTER,
+  DT_NOCLIP,
+  DT_RIGHT,
+  DT_SINGLELINE,
+  DT_VCENTER,
+  OPAQUE,
+  PS_DASH,
+  PS_DOT,
+  PS_NULL,
+  SYSTEM_FONT,
+  WHITE_BRUSH,
+  colorToCss,
+  fontMetrics,
+  fontToCss,
+  isSystemColorIndex,
+  makeStockObjects,
+  systemColor,
+} from './gdi-objects.js';
+import { GlyphAtlas } from './glyph-atlas.js';
+
+const STOCK_OBJECT_BASE = 0x1900000;
+const SYS_COLOR_BRUSH_BASE = 0x1910000;
+const FIRST_OBJECT = 0x2100000;
+const FIRST_DC = 0x1010;
+const HANDLE_STEP = 4;
+
+function defaultRequestFrame(fn) {
+  if (typeof requestAnimationFrame === 'function') return requestAnimationFrame(fn);
+  return setTimeout(fn, 16);
+}
+
+function defaultBackingStore(width, height) {
+  return typeof OffscreenCanvas === 'function' ? new OffscreenCanvas(width, height) : null;
+}
+
+function dashFor(pen) {
+  const unit = Math.max(1, pen.width);
+  if (pen.style === PS_DASH) return [unit * 6, unit * 2];
+  if (pen.style === PS_DOT) return [unit, unit];
+  return [];
+}
+
+// GDI for one window station: the object table (stock and created pens,
+// brushes and fonts), device contexts and per-window drawing surfaces.
+// Drawing calls don't touch a canvas; each DC records them as ops in
+// surface coordinates, and ReleaseDC/EndPaint hand the DC's ops plus its clip
+// rects (the update region for a paint DC) to the next frame. A DC still open
+// at frame time gives up the ops recorded so far, so a GetDC that is never
+// released still draws and doesn't accumulate ops. One frame then
+// replays every batch clipped to its rects into the window's OffscreenCanvas
+// backing store and copies only the dirty rects to the visible canvas.
+// Without an OffscreenCanvas the batches draw into the visible canvas
+// directly; without a WindowManager nothing is drawn but object and DC
+// state, measurements and return values still behave. The dirty rects are
+// reported to the WindowManager for composition, and `onPresent` runs after
+// every frame that reached the screen. Text is measured and drawn from
+// `glyphAtlas` (see glyph-atlas.js), so repainting a text-heavy window blits
+// cached glyphs instead of rasterizing every string again.
+export class Gdi {
+  constructor({
+    windowManager = null,
+    requestFrame = defaultRequestFrame,
+    createBackingStore = defaultBackingStore,
+    onPresent = null,
+    glyphAtlas = new GlyphAtlas(),
+  } = {}) {
+    this.windowManager = windowManager;
+    this.glyphAtlas = glyphAtlas;
+    this.requestFrame = requestFrame;
+    this.onPresent = onPresent;
+    this.createBackingStore = createBackingStore;
+    this.objects = new Map();
+    this.dcs = new Map();
+    this.surfaces = new Map();
+    this.pending = [];
+    this.frame = null;
+    this.nextObject = FIRST_OBJECT;
+    this.nextDc = FIRST_DC;
+    makeStockObjects().forEach((object, index) => {
+      this.objects.set(STOCK_OBJECT_BASE + index * HANDLE_STEP, { ...object, stock: true });
+    });
+  }
+
+  getStockObject(index) {
+    const handle = STOCK_OBJECT_BASE + index * HANDLE_STEP;
+    return this.objects.has(handle) ? handle : 0;
+  }
+
+  sysColorBrush(index) {
+    if (!isSystemColorIndex(index)) return 0;
+    const handle = SYS_COLOR_BRUSH_BASE + index * HANDLE_STEP;
+    if (!this.objects.has(handle)) this.objects.set(handle, { type: 'brush', color: systemColor(index), stock: true });
+    return handle;
+  }
+
+  addObject(object) {
+    const handle = this.nextObject;
+    this.nextObject += HANDLE_STEP;
+    this.objects.set(handle, object);
+    return handle;
+  }
+
+  createPen(style, width, color) {
+    return this.addObject({ type: 'pen', style, width: Math.max(1, width), color });
+  }
+
+  createSolidBrush(color) {
+    return this.addObject({ type: 'brush', color });
+  }
+
+  createFont(font) {
+    return this.addObject(font);
+  }
+
+  deleteObject(handle) {
+    const object = this.objects.get(handle);
+    if (!object) return false;
+    if (!object.stock) this.objects.delete(handle);
+    return true;
+  }
+
+  // Brush arguments below the handle ranges are COLOR_* + 1, as in
+  // WNDCLASS.hbrBackground and FillRect.
+  resolveBrush(dc, handle) {
+    if (handle > 0 && isSystemColorIndex(handle - 1)) return { type: 'brush', color: systemColor(handle - 1) };
+    const brush = this.objects.get(handle);
+    if (brush?.type !== 'brush') return null;
+    return brush.fromDc ? { type: 'brush', color: dc.dcBrushColor } : brush;
+  }
+
+  pen(dc) {
+    const pen = this.objects.get(dc.pen);
+    if (!pen || pen.style === PS_NULL) return null;
+    return pen.fromDc ? { ...pen, color: dc.dcPenColor } : pen;
+  }
+
+  font(dc) {
+    return this.objects.get(dc.font);
+  }
+
+  surfaceFor(id) {
+    if (!id) return null;
+    let surface = this.surfaces.get(id);
+    if (surface) return surface;
+    const win = this.windowManager?.getWindow?.(id);
+    if (!win?.canvas) return null;
+    const store = this.createBackingStore(win.width, win.height);
+    surface = { id, canvas: win.canvas, store, context: null, storeContext: null, width: win.width, height: win.height };
+    this.surfaces.set(id, surface);
+    return surface;
+  }
+
+  drawingContext(surface) {
+    if (surface.store) {
+      surface.storeContext ??= surface.store.getContext('2d');
+      return surface.storeContext;
+    }
+    surface.context ??= surface.canvas.getContext('2d');
+    return surface.context;
+  }
+
+  releaseSurface(id) {
+    this.surfaces.delete(id);
+  }
+
+  // `target` is the top-level surface and the offset of the window's client
+  // area inside it; `rects` is the clip in client coordinates.
+  openDC(window, target, rects) {
+    const hdc = this.nextDc;
+    this.nextDc += HANDLE_STEP;
+    const dc = {
+      hdc,
+      hwnd: window.hwnd,
+      surface: this.surfaceFor(target.surface),
+      originX: target.x,
+      originY: target.y,
+      clip: rects.map((rect) =>
+        makeRect(rect.left + target.x, rect.top + target.y, rect.right + target.x, rect.bottom + target.y),
+      ),
+      pen: this.getStockObject(BLACK_PEN),
+      brush: this.getStockObject(WHITE_BRUSH),
+      font: this.getStockObject(SYSTEM_FONT),
+      textColor: 0x000000,
+      bkColor: 0xffffff,
+      bkMode: OPAQUE,
+      dcBrushColor: 0xffffff,
+      dcPenColor: 0x000000,
+      x: 0,
+      y: 0,
+      ops: [],
+    };
+    this.dcs.set(hdc, dc);
+    return dc;
+  }
+
+  getDC(hdc) {
+    return this.dcs.get(hdc) ?? null;
+  }
+
+  releaseDC(hdc) {
+    const dc = this.dcs.get(hdc);
+    if (!dc) return false;
+    this.dcs.delete(hdc);
+    if (dc.surface && dc.ops.length && dc.clip.length) {
+      this.pending.push({ surface: dc.surface, clip: dc.clip, ops: dc.ops });
+      this.scheduleFrame();
+    }
+    return true;
+  }
+
+  scheduleFrame() {
+    if (this.frame !== null) return;
+    this.frame = this.requestFrame(() => this.flush());
+  }
+
+  flush() {
+    this.frame = null;
+    const dirty = new Map();
+    this.dcs.forEach((dc) => {
+      if (!dc.ops.length) return;
+      if (dc.surface && dc.clip.length) this.pending.push({ surface: dc.surface, clip: dc.clip, ops: dc.ops });
+      dc.ops = [];
+    });
+    this.pending.splice(0).forEach(({ surface, clip, ops }) => {
+      if (this.surfaces.get(surface.id) !== surface) return;
+      const ctx = this.drawingContext(surface);
+      if (!ctx) return;
+      ctx.save();
+      ctx.beginPath();
+      clip.forEach((rect) => ctx.rect(rect.left, rect.top, rect.right - rect.left, rect.bottom - rect.top));
+      ctx.clip();
+      ops.forEach((op) => op(ctx));
+      ctx.restore();
+      dirty.set(surface, clip.reduce(addRect, dirty.get(surface) ?? []));
+    });
+    dirty.forEach((rects, surface) => {
+      this.present(surface, rects);
+      this.windowManager?.damage?.(surface.id, rects);
+    });
+    if (dirty.size) this.onPresent?.();
+  }
+
+  present(surface, rects) {
+    if (!surface.store) return;
+    surface.context ??= surface.canvas.getContext('2d');
+    const bounds = makeRect(0, 0, surface.width, surface.height);
+    rects.forEach((dirty) => {
+      const rect = intersectRect(dirty, bounds);
+      if (isEmptyRect(rect)) return;
+      const width = rect.right - rect.left;
+      const height = rect.bottom - rect.top;
+      surface.context.drawImage(surface.store, rect.left, rect.top, width, height, rect.left, rect.top, width, height);
+    });
+  }
+
+  record(dc, op) {
+    if (!dc.surface) return;
+    dc.ops.push(op);
+    this.scheduleFrame();
+  }
+
+  selectObject(hdc, handle) {
+    const dc = this.dcs.get(hdc);
+    const object = this.objects.get(handle);
+    if (!dc || !object) return 0;
+    const previous = dc[object.type];
+    dc[object.type] = handle;
+    return previous;
+  }
+
+  swapState(hdc, key, value) {
+    const dc = this.dcs.get(hdc);
+    if (!dc) return key === 'bkMode' ? 0 : CLR_INVALID;
+    const previous = dc[key];
+    dc[key] = value;
+    return previous;
+  }
+
+  moveTo(hdc, x, y) {
+    const dc = this.dcs.get(hdc);
+    if (!dc) return null;
+    const previous = { x: dc.x, y: dc.y };
+    dc.x = x;
+    dc.y = y;
+    return previous;
+  }
+
+  lineTo(hdc, x, y) {
+    const dc = this.dcs.get(hdc);
+    if (!dc) return false;
+    const pen = this.pen(dc);
+    const from = { x: dc.x + dc.originX, y: dc.y + dc.originY };
+    dc.x = x;
+    dc.y = y;
+    if (!pen) return true;
+    const to = { x: x + dc.originX, y: y + dc.originY };
+    const offset = pen.width % 2 ? 0.5 : 0;
+    this.record(dc, (ctx) => {
+      ctx.strokeStyle = colorToCss(pen.color);
+      ctx.lineWidth = pen.width;
+      ctx.setLineDash(dashFor(pen));
+      ctx.beginPath();
+      ctx.moveTo(from.x + offset, from.y + offset);
+      ctx.lineTo(to.x + offset, to.y + offset);
+      ctx.stroke();
+    });
+    return true;
+  }
+
+  fillRect(hdc, rect, brushHandle) {
+    const dc = this.dcs.get(hdc);
+    const brush = dc && this.resolveBrush(dc, brushHandle);
+    if (!brush) return false;
+    if (brush.hollow || isEmptyRect(rect)) return true;
+    const { left, top } = rect;
+    this.record(dc, (ctx) => {
+      ctx.fillStyle = colorToCss(brush.color);
+      ctx.fillRect(left + dc.originX, top + dc.originY, rect.right - left, rect.bottom - top);
+    });
+    return true;
+  }
+
+  frameRect(hdc, rect, brushHandle) {
+    const dc = this.dcs.get(hdc);
+    const brush = dc && this.resolveBrush(dc, brushHandle);
+    if (!brush) return false;
+    if (brush.hollow || isEmptyRect(rect)) return true;
+    this.record(dc, (ctx) => {
+      ctx.strokeStyle = colorToCss(brush.color);
+      ctx.lineWidth = 1;
+      ctx.setLineDash([]);
+      ctx.strokeRect(
+        rect.left + dc.originX + 0.5,
+        rect.top + dc.originY + 0.5,
+        rect.right - rect.left - 1,
+        rect.bottom - rect.top - 1,
+      );
+    });
+    return true;
+  }
+
+  // Rectangle and Ellipse fill with the selected brush and outline with the
+  // selected pen, inside the bounding box like GDI's inside-frame drawing.
+  shape(hdc, rect, trace) {
+    const dc = this.dcs.get(hdc);
+    if (!dc) return false;
+    const brush = this.resolveBrush(dc, dc.brush);
+    const pen = this.pen(dc);
+    const inset = pen ? pen.width / 2 : 0;
+    const box = makeRect(
+      rect.left + dc.originX + inset,
+      rect.top + dc.originY + inset,
+      rect.right + dc.originX - inset,
+      rect.bottom + dc.originY - inset,
+    );
+    if (isEmptyRect(box)) return true;
+    this.record(dc, (ctx) => {
+      ctx.beginPath();
+      trace(ctx, box);
+      if (brush && !brush.hollow) {
+        ctx.fillStyle = colorToCss(brush.color);
+        ctx.fill();
+      }
+      if (pen) {
+        ctx.strokeStyle = colorToCss(pen.color);
+        ctx.lineWidth = pen.width;
+        ctx.setLineDash(dashFor(pen));
+        ctx.stroke();
+      }
+    });
+    return true;
+  }
+
+  rectangle(hdc, rect) {
+    return this.shape(hdc, rect, (ctx, box) => ctx.rect(box.left, box.top, box.right - box.left, box.bottom - box.top));
+  }
+
+  ellipse(hdc, rect) {
+    return this.shape(hdc, rect, (ctx, box) => {
+      const rx = (box.right - box.left) / 2;
+      const ry = (box.bottom - box.top) / 2;
+      ctx.ellipse(box.left + rx, box.top + ry, rx, ry, 0, 0, Math.PI * 2);
+    });
+  }
+
+  // Null when there is no canvas to rasterize glyphs into.
+  glyphFace(font) {
+    return this.glyphAtlas.face(fontToCss(font), fontMetrics(font).lineHeight);
+  }
+
+  measureText(dc, text) {
+    const font = this.font(dc);
+    const face = this.glyphFace(font);
+    if (face) return face.measure(text);
+    const ctx = dc.surface ? this.drawingContext(dc.surface) : null;
+    if (!ctx) return Math.ceil(text.length * fontMetrics(font).px * 0.5);
+    ctx.font = fontToCss(font);
+    return Math.ceil(ctx.measureText(text).width);
+  }
+
+  textExtent(hdc, text) {
+    const dc = this.dcs.get(hdc);
+    if (!dc) return null;
+    return { cx: this.measureText(dc, text), cy: fontMetrics(this.font(dc)).lineHeight };
+  }
+
+  // Text ops capture the DC's text state when recorded, not when replayed.
+  textStyle(dc) {
+    const font = this.font(dc);
+    return { font, face: this.glyphFace(font), textColor: dc.textColor, bkColor: dc.bkColor, bkMode: dc.bkMode };
+  }
+
+  drawTextLine(ctx, style, text, x, y, width) {
+    const { font } = style;
+    const { lineHeight } = fontMetrics(font);
+    if (style.bkMode === OPAQUE) {
+      ctx.fillStyle = colorToCss(style.bkColor);
+      ctx.fillRect(x, y, width, lineHeight);
+    }
+    const color = colorToCss(style.textColor);
+    ctx.fillStyle = color;
+    if (style.face) {
+      style.face.draw(ctx, text, x, y, color);
+    } else {
+      ctx.font = fontToCss(font);
+      ctx.textBaseline = 'top';
+      ctx.fillText(text, x, y);
+    }
+    if (font.underline) ctx.fillRect(x, y + lineHeight - 2, width, 1);
+  }
+
+  textOut(hdc, x, y, text) {
+    const dc = this.dcs.get(hdc);
+    if (!dc) return false;
+    if (!text) return true;
+    const width = this.measureText(dc, text);
+    const style = this.textStyle(dc);
+    this.record(dc, (ctx) => this.drawTextLine(ctx, style, text, x + dc.originX, y + dc.originY, width));
+    return true;
+  }
+
+  // Returns the text height and the rect it occupies; DT_CALCRECT only
+  // measures.
+  drawText(hdc, text, rect, format) {
+    const dc = this.dcs.get(hdc);
+    if (!dc) return null;
+    const lines = format & DT_SINGLELINE ? [text.replace(/\r?\n/g, ' ')] : text.split(/\r?\n/);
+    const { lineHeight } = fontMetrics(this.font(dc));
+    const widths = lines.map((line) => this.measureText(dc, line));
+    const height = lines.length * lineHeight;
+    if (format & DT_CALCRECT) {
+      const width = Math.max(0, ...widths);
+      return { height, rect: makeRect(rect.left, rect.top, rect.left + width, rect.top + height) };
+    }
+    let top = rect.top;
+    if (format & DT_SINGLELINE && format & DT_VCENTER) top += Math.floor((rect.bottom - rect.top - height) / 2);
+    else if (format & DT_SINGLELINE && format & DT_BOTTOM) top = rect.bottom - height;
+    const placed = lines.map((line, index) => {
+      let left = rect.left;
+      if (format & DT_CENTER) left += Math.floor((rect.right - rect.left - widths[index]) / 2);
+      else if (format & DT_RIGHT) left = rect.right - widths[index];
+      return { line, x: left + dc.originX, y: top + index * lineHeight + dc.originY, width: widths[index] };
+    });
+    const style = this.textStyle(dc);
+    const clip = format & DT_NOCLIP ? null : rect;
+    this.record(dc, (ctx) => {
+      ctx.save();
+      if (clip) {
+        ctx.beginPath();
+        ctx.rect(clip.left + dc.originX, clip.top + dc.originY, clip.right - clip.left, clip.bottom - clip.top);
+        ctx.clip();
+      }
+      placed.forEach(({ line, x, y, width }) => this.drawTextLine(ctx, style, line, x, y, width));
+      ctx.restore();
+    });
+    return { height, rect: makeRect(rect.left, top, rect.right, top + height) };
+  }
+
+  dispose() {
+    this.pending = [];
+    this.dcs.clear();
+    this.surfaces.clear();
+  }
+}
@@ -0,0 +1,157 @@
+const PAGE_SIZE = 512;
+const MAX_PAGES = 8;
+const MAX_TINTS = 16;
+
+function defaultCreateCanvas(width, height) {
+  if (typeof OffscreenCanvas === 'function') return new OffscreenCanvas(width, height);
+  if (typeof document !== 'undefined') return Object.assign(document.createElement('canvas'), { width, height });
+  return null;
+}
+
+// One font's glyphs. Each glyph is rasterized into the atlas the first time
+// it is used and measured with it, so drawing and measuring a string after
+// that never sets a canvas font or calls fillText/measureText. Glyphs are
+// stored as white coverage with `pad` pixels around the advance box, which
+// keeps overhangs and italics from being clipped.
+export class GlyphFace {
+  constructor(atlas, css, lineHeight) {
+    this.atlas = atlas;
+    this.css = css;
+    this.lineHeight = lineHeight;
+    this.pad = Math.ceil(lineHeight / 6);
+    this.glyphs = new Map();
+  }
+
+  glyph(char) {
+    let glyph = this.glyphs.get(char);
+    if (!glyph) {
+      glyph = this.atlas.rasterize(this, char);
+      this.glyphs.set(char, glyph);
+    }
+    return glyph;
+  }
+
+  measure(text) {
+    let width = 0;
+    for (const char of text) width += this.glyph(char).advance;
+    return Math.ceil(width);
+  }
+
+  // Where each glyph of `text` goes when its advance box starts at (x, y):
+  // the atlas source rect and the destination corner, one quad per inked
+  // glyph. This is also the per-instance data for a textured quad batch.
+  layout(text, x, y) {
+    const quads = [];
+    let pen = x;
+    for (const char of text) {
+      const glyph = this.glyph(char);
+      if (glyph.width) quads.push({ glyph, x: Math.round(pen) - this.pad, y: y - this.pad });
+      pen += glyph.advance;
+    }
+    return quads;
+  }
+
+  // Blits `text` in a CSS color with its advance box's top-left at (x, y).
+  draw(ctx, text, x, y, color) {
+    const quads = this.layout(text, x, y);
+    for (const { glyph, x: left, y: top } of quads) {
+      const source = this.atlas.tinted(glyph.page, color);
+      ctx.drawImage(source, glyph.x, glyph.y, glyph.width, glyph.height, left, top, glyph.width, glyph.height);
+    }
+  }
+}
+
+// Glyph cache shared by everything that draws text on one thread. Glyphs are
+// packed in rows ("shelves") into fixed-size pages; a full set of pages is
+// dropped and refilled rather than evicted glyph by glyph, since one UI
+// rarely uses more than a few fonts. Canvas can't tint an image, so each
+// page keeps a copy per text color, redrawn only when the page gained
+// glyphs. Without a canvas to rasterize into, `face` returns null and the
+// caller draws with fillText.
+export class GlyphAtlas {
+  constructor({ createCanvas = defaultCreateCanvas, pageSize = PAGE_SIZE } = {}) {
+    this.createCanvas = createCanvas;
+    this.pageSize = pageSize;
+    this.pages = [];
+    this.faces = new Map();
+    this.measuring = undefined;
+  }
+
+  face(css, lineHeight) {
+    this.measuring ??= this.createCanvas(1, 1)?.getContext('2d') ?? null;
+    if (!this.measuring) return null;
+    const key = `${lineHeight}/${css}`;
+    let face = this.faces.get(key);
+    if (!face) {
+      face = new GlyphFace(this, css, lineHeight);
+      this.faces.set(key, face);
+    }
+    return face;
+  }
+
+  clear() {
+    this.pages = [];
+    this.faces.forEach((face) => face.glyphs.clear());
+  }
+
+  // A free spot of width x height, opening a new shelf or page when needed.
+  allocate(width, height) {
+    let page = this.pages[this.pages.length - 1];
+    if (page && page.x + width > this.pageSize) {
+      page.y += page.shelf;
+      page.x = 0;
+      page.shelf = 0;
+    }
+    if (!page || page.y + height > this.pageSize) {
+      if (this.pages.length === MAX_PAGES) this.clear();
+      const canvas = this.createCanvas(this.pageSize, this.pageSize);
+      page = { canvas, context: canvas.getContext('2d'), x: 0, y: 0, shelf: 0, version: 0, tints: new Map() };
+      this.pages.push(page);
+    }
+    const spot = { page, x: page.x, y: page.y };
+    page.x += width;
+    page.shelf = Math.max(page.shelf, height);
+    return spot;
+  }
+
+  rasterize(face, char) {
+    this.measuring.font = face.css;
+    const advance = this.measuring.measureText(char).width;
+    if (!char.trim()) return { page: null, x: 0, y: 0, width: 0, height: 0, advance };
+    const width = Math.min(this.pageSize, Math.ceil(advance) + face.pad * 2);
+    const height = Math.min(this.pageSize, face.lineHeight + face.pad * 2);
+    const { page, x, y } = this.allocate(width, height);
+    const ctx = page.context;
+    ctx.save();
+    ctx.beginPath();
+    ctx.rect(x, y, width, height);
+    ctx.clip();
+    ctx.font = face.css;
+    ctx.textBaseline = 'top';
+    ctx.fillStyle = '#fff';
+    ctx.fillText(char, x + face.pad, y + face.pad);
+    ctx.restore();
+    page.version++;
+    return { page, x, y, width, height, advance };
+  }
+
+  tinted(page, color) {
+    let tint = page.tints.get(color);
+    if (tint?.version === page.version) return tint.canvas;
+    if (!tint) {
+      if (page.tints.size === MAX_TINTS) page.tints.delete(page.tints.keys().next().value);
+      const canvas = this.createCanvas(this.pageSize, this.pageSize);
+      tint = { canvas, context: canvas.getContext('2d'), version: -1 };
+      page.tints.set(color, tint);
+    }
+    const ctx = tint.context;
+    ctx.globalCompositeOperation = 'copy';
+    ctx.drawImage(page.canvas, 0, 0);
+    ctx.globalCompositeOperation = 'source-in';
+    ctx.fillStyle = color;
+    ctx.fillRect(0, 0, this.pageSize, this.pageSize);
+    ctx.globalCompositeOperation = 'source-over';
+    tint.version = page.version;
+    return tint.canvas;
+  }
+}
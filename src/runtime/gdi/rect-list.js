@@ -0,0 +1,52 @@
+const MAX_RECTS = 8;
+
+export function makeRect(left, top, right, bottom) {
+  return { left, top, right, bottom };
+}
+
+export function isEmptyRect(rect) {
+  return rect.right <= rect.left || rect.bottom <= rect.top;
+}
+
+export function containsRect(outer, inner) {
+  return (
+    outer.left <= inner.left && outer.top <= inner.top && outer.right >= inner.right && outer.bottom >= inner.bottom
+  );
+}
+
+export function intersectRect(a, b) {
+  return makeRect(
+    Math.max(a.left, b.left),
+    Math.max(a.top, b.top),
+    Math.min(a.right, b.right),
+    Math.min(a.bottom, b.bottom),
+  );
+}
+
+export function boundingRect(rects) {
+  if (!rects.length) return makeRect(0, 0, 0, 0);
+  return rects.reduce((acc, rect) =>
+    makeRect(
+      Math.min(acc.left, rect.left),
+      Math.min(acc.top, rect.top),
+      Math.max(acc.right, rect.right),
+      Math.max(acc.bottom, rect.bottom),
+    ),
+  );
+}
+
+// Update regions are kept as a short list of rects rather than a true
+// region: rects already covered are dropped, rects the new one covers are
+// replaced, and past MAX_RECTS the list collapses to its bounding box.
+export function addRect(rects, rect) {
+  if (isEmptyRect(rect) || rects.some((existing) => containsRect(existing, rect))) return rects;
+  const merged = rects.filter((existing) => !containsRect(rect, existing));
+  merged.push(rect);
+  return merged.length > MAX_RECTS ? [boundingRect(merged)] : merged;
+}
+
+// Validation only removes rects the validated area fully covers; partially
+// covered rects stay invalid, which can only cause extra painting.
+export function subtractRect(rects, rect) {
+  return rects.filter((existing) => !containsRect(rect, existing));
+}
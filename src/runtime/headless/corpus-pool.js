@@ -0,0 +1,99 @@
+import fs from 'fs';
+import os from 'os';
+import path from 'path';
+import { Worker } from 'worker_threads';
+
+const WORKER_URL = new URL('./corpus-worker.js', import.meta.url);
+
+function defaultPoolSize() {
+  return typeof os.availableParallelism === 'function' ? os.availableParallelism() : os.cpus().length;
+}
+
+function failedResult(file, exitReason, error, elapsedMs) {
+  return {
+    file: path.basename(file),
+    path: file,
+    size: fs.statSync(file, { throwIfNoEntry: false })?.size ?? 0,
+    cache: null,
+    exitReason,
+    error,
+    rip: null,
+    guiIntent: false,
+    consoleLines: [],
+    imports: { calls: 0, unique: 0, top: [] },
+    stats: { steps: null, elapsedMs, stepsPerSecond: null },
+  };
+}
+
+// Runs one image per worker at a time. A job that exceeds timeLimitMs has
+// its worker terminated and replaced, since a spinning guest never yields.
+// Workers share an on-disk image cache when given a `cacheDirectory`.
+export class CorpusPool {
+  constructor({
+    size = defaultPoolSize(),
+    maxSteps = 50000,
+    timeLimitMs = 10000,
+    fastForward = true,
+    cacheDirectory = null,
+    workerUrl = WORKER_URL,
+  } = {}) {
+    this.size = Math.max(1, size);
+    this.maxSteps = maxSteps;
+    this.fastForward = fastForward;
+    this.timeLimitMs = timeLimitMs;
+    this.cacheDirectory = cacheDirectory;
+    this.workerUrl = workerUrl;
+  }
+
+  async run(files, { onResult } = {}) {
+    const results = new Array(files.length);
+    let next = 0;
+    const lanes = Array.from({ length: Math.min(this.size, files.length) }, async () => {
+      let worker = null;
+      try {
+        while (next < files.length) {
+          const index = next++;
+          worker ??= new Worker(this.workerUrl, { workerData: { cacheDirectory: this.cacheDirectory } });
+          const outcome = await this.runJob(worker, index, files[index]);
+          if (outcome.terminated) worker = null;
+          results[index] = outcome.result;
+          onResult?.(outcome.result, index);
+        }
+      } finally {
+        await worker?.terminate();
+      }
+    });
+    await Promise.all(lanes);
+    return results;
+  }
+
+  runJob(worker, id, file) {
+    const started = performance.now();
+    const elapsed = () => Number((performance.now() - started).toFixed(3));
+    return new Promise((resolve) => {
+      const settle = (outcome) => {
+        clearTimeout(timer);
+        worker.off('message', onMessage);
+        worker.off('error', onError);
+        resolve(outcome);
+      };
+      const onMessage = (message) => {
+        if (message.id !== id) return;
+        settle({ result: message.result ?? failedResult(file, 'error', message.error, elapsed()) });
+      };
+      const onError = (err) => {
+        settle({ terminated: true, result: failedResult(file, 'error', err?.message ?? String(err), elapsed()) });
+      };
+      const timer = setTimeout(() => {
+        worker.terminate();
+        settle({
+          terminated: true,
+          result: failedResult(file, 'timeout', `Exceeded ${this.timeLimitMs} ms`, elapsed()),
+        });
+      }, this.timeLimitMs);
+      worker.on('message', onMessage);
+      worker.on('error', onError);
+      worker.postMessage({ id, file, maxSteps: this.maxSteps, fastForward: this.fastForward });
+    });
+  }
+}
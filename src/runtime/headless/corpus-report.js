@@ -0,0 +1,52 @@
+const UNSUPPORTED_REGEX = /^Unsupported (opcode|instruction) (\S+)/;
+const EXAMPLE_LIMIT = 5;
+
+export function classifyFailure(result) {
+  if (result.exitReason === 'timeout') return { reason: 'timeout' };
+  if (result.exitReason !== 'error') return null;
+  const match = UNSUPPORTED_REGEX.exec(result.error ?? '');
+  if (match) {
+    return { reason: `unsupported-${match[1]}`, instruction: match[2] };
+  }
+  if (/not resident/.test(result.error ?? '')) return { reason: 'page-fault' };
+  if (result.rip == null) return { reason: 'invalid-image' };
+  return { reason: 'runtime-error' };
+}
+
+// Folds per-image results into one report: throughput, exit reasons,
+// failure categories and a histogram of the opcodes/mnemonics that stopped
+// images.
+export function buildCorpusReport(results, elapsedMs) {
+  const exitReasons = {};
+  const failures = {};
+  const missing = new Map();
+  let steps = 0;
+  let bytes = 0;
+  results.forEach((result) => {
+    exitReasons[result.exitReason] = (exitReasons[result.exitReason] ?? 0) + 1;
+    steps += result.stats?.steps ?? 0;
+    bytes += result.size ?? 0;
+    const failure = classifyFailure(result);
+    if (!failure) return;
+    failures[failure.reason] = (failures[failure.reason] ?? 0) + 1;
+    if (!failure.instruction) return;
+    const entry = missing.get(failure.instruction) ?? { instruction: failure.instruction, count: 0, examples: [] };
+    entry.count++;
+    if (entry.examples.length < EXAMPLE_LIMIT) entry.examples.push(result.path ?? result.file);
+    missing.set(failure.instruction, entry);
+  });
+  const seconds = elapsedMs / 1000;
+  return {
+    summary: {
+      files: results.length,
+      bytes,
+      steps,
+      elapsedMs: Number(elapsedMs.toFixed(3)),
+      filesPerSecond: seconds > 0 ? Number((results.length / seconds).toFixed(2)) : null,
+      stepsPerSecond: seconds > 0 ? Math.round(steps / seconds) : null,
+      exitReasons,
+    },
+    failures,
+    missingInstructions: Array.from(missing.values()).sort((a, b) => b.count - a.count),
+  };
+}
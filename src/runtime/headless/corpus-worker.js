@@ -0,0 +1,21 @@
+import fs from 'fs';
+import path from 'path';
+import { parentPort, workerData } from 'worker_threads';
+import { HeadlessRunner } from './headless-runner.js';
+import { ImageCache } from '../cache/image-cache.js';
+import { FileCacheStore } from '../cache/file-cache-store.js';
+
+const cacheDirectory = workerData?.cacheDirectory;
+const runner = new HeadlessRunner({
+  imageCache: cacheDirectory ? new ImageCache({ store: new FileCacheStore({ directory: cacheDirectory }) }) : null,
+});
+
+parentPort.on('message', async ({ id, file, maxSteps, fastForward }) => {
+  try {
+    const buffer = new Uint8Array(fs.readFileSync(file));
+    const result = await runner.run(buffer, { name: path.basename(file), maxSteps, fastForward });
+    parentPort.postMessage({ id, result: { ...result, path: file } });
+  } catch (err) {
+    parentPort.postMessage({ id, error: err?.message ?? String(err) });
+  }
+});
@@ -0,0 +1,163 @@
+import { createImportHandler, createImportBinder } from '../import-handler.js';
+import { readAnsiString, readWideString } from '../memory-readers.js';
+import { SimulatorBridge } from '../simulator/simulator-bridge.js';
+import { createX86SimulatorPlugin } from '../simulator/plugins/x86-simulator-plugin.js';
+import { createConsoleOutputImportPlugin } from '../import-plugins/console-output-plugin.js';
+import { createModuleLoaderImportPlugin } from '../import-plugins/module-loader-plugin.js';
+import { createWaitImportPlugin } from '../import-plugins/wait-plugin.js';
+import { createUser32ImportPlugin } from '../import-plugins/user32-plugin.js';
+import { createGdiImportPlugin } from '../import-plugins/gdi-plugin.js';
+import { createDirect2DImportPlugin } from '../import-plugins/direct2d-plugin.js';
+import { createTimeImportPlugin } from '../import-plugins/time-plugin.js';
+import { VirtualClock } from '../services/virtual-clock.js';
+import { X86Simulator } from '../../emulator/x86/simulator.js';
+
+const TOP_IMPORTS = 10;
+const MAX_WAIT_MS = 60000;
+
+export function summarizeImports(importCounts, calls) {
+  const top = importCounts
+    .map(({ key, count }) => ({ key, count }))
+    .sort((a, b) => b.count - a.count || (a.key < b.key ? -1 : 1))
+    .slice(0, TOP_IMPORTS);
+  return { calls: calls ?? importCounts.reduce((sum, { count }) => sum + count, 0), unique: importCounts.length, top };
+}
+
+// Drives SimulatorBridge without any DOM: console output is collected from
+// the run context and windows exist only as user32 state. Plugins are reset
+// after every run so timers from one image never outlive it. The virtual
+// clock fast-forwards by default, so idle waits cost no wall time; waits are
+// still capped at MAX_WAIT_MS of virtual time so Sleep(INFINITE) ends. With
+// an `imageCache`, each image starts from its cached PE record and decoded
+// code when there is one, and the record a run ends with is stored back.
+export class HeadlessRunner {
+  constructor({
+    importPlugins,
+    maxSteps = 50000,
+    fastForward = true,
+    imageCache = null,
+    log = () => {},
+    now = () => performance.now(),
+  } = {}) {
+    this.maxSteps = maxSteps;
+    this.fastForward = fastForward;
+    this.imageCache = imageCache;
+    this.log = log;
+    this.now = now;
+    this.clock = new VirtualClock({ fastForward });
+    const getClock = () => this.clock;
+    const waitForObject = (handle, options) => this.waitForObject(handle, options);
+    const utf8 = new TextDecoder();
+    const utf16 = new TextDecoder('utf-16le');
+    const helpers = {
+      readAnsiString: (cpu, address, maxLength) => readAnsiString(cpu, address, utf8, maxLength),
+      readWideString: (cpu, address, maxChars) => readWideString(cpu, address, utf16, maxChars),
+      log: (message) => this.log(message),
+      plugins: importPlugins ?? [
+        createUser32ImportPlugin({ quitWhenIdle: true, getClock, waitForObject }),
+        createGdiImportPlugin({ stationFor: (cpu) => this.stationFor(cpu) }),
+        createDirect2DImportPlugin({ stationFor: (cpu) => this.stationFor(cpu) }),
+        createConsoleOutputImportPlugin({ logMessageBoxes: false }),
+        createModuleLoaderImportPlugin({ log: (message) => this.log(message) }),
+        createTimeImportPlugin({ getClock }),
+        createWaitImportPlugin({
+          maxWaitMs: MAX_WAIT_MS,
+          waitForObject,
+          schedule: (fn, ms) => this.clock.setTimeout(fn, ms),
+          unschedule: (id) => this.clock.clearTimeout(id),
+        }),
+      ],
+    };
+    this.importPlugins = helpers.plugins;
+    this.bridge = new SimulatorBridge({
+      importHandler: createImportHandler(helpers),
+      importBinder: createImportBinder(helpers),
+    });
+    this.bridge.registerPlugin(createX86SimulatorPlugin({ getSimulatorClass: () => X86Simulator }));
+  }
+
+  waitForObject(handle, options) {
+    for (const plugin of this.importPlugins) {
+      const pending = plugin?.waitForObject?.(handle, options);
+      if (pending) return pending;
+    }
+    return null;
+  }
+
+  stationFor(cpu) {
+    const plugin = this.importPlugins.find((candidate) => typeof candidate?.stationFor === 'function');
+    return plugin?.stationFor(cpu) ?? null;
+  }
+
+  async run(buffer, { name = 'image.exe', maxSteps = this.maxSteps, modules, fastForward = this.fastForward } = {}) {
+    this.clock.reset({ fastForward });
+    const started = this.now();
+    const cached = await this.lookupImageCache(buffer);
+    const base = { file: name, size: buffer.length, cache: cached ? (cached.hit ? 'hit' : 'miss') : null };
+    let created;
+    try {
+      created = this.bridge.createSimulator(buffer, { file: { name }, modules, cacheRecord: cached?.record });
+    } catch (err) {
+      return this.describe(base, started, { exitReason: 'error', error: err?.message ?? String(err) });
+    }
+    if (!created) {
+      return this.describe(base, started, { exitReason: 'error', error: this.bridge.describeMissingSimulator() });
+    }
+    const { simulator } = created;
+    const { hooks, finish } = this.bridge.createRunContext();
+    try {
+      const simulation = finish(simulator, await simulator.runAsync({ hooks, maxSteps }));
+      await this.storeImageCache(cached, buffer, simulation.cacheRecord);
+      return this.describe(base, started, simulation);
+    } catch (err) {
+      const { cpu } = simulator;
+      const partial = finish(simulator, {
+        ...cpu?.importSummary(),
+        steps: cpu?.runState?.steps,
+        exitReason: 'error',
+      });
+      return this.describe(base, started, {
+        ...partial,
+        error: err?.message ?? String(err),
+        rip: cpu ? `0x${cpu.readRegister('rip').toString(16)}` : null,
+      });
+    } finally {
+      this.importPlugins.forEach((plugin) => plugin?.reset?.());
+      this.clock.reset();
+    }
+  }
+
+  async lookupImageCache(buffer) {
+    if (!this.imageCache) return null;
+    try {
+      return await this.imageCache.lookup(buffer);
+    } catch (err) {
+      this.log(`[WineJS] Image cache unavailable: ${err?.message ?? err}`);
+      return null;
+    }
+  }
+
+  async storeImageCache(entry, buffer, record) {
+    if (!entry || !record) return;
+    await this.imageCache.save(entry.hash, buffer.length, record);
+  }
+
+  describe(base, started, simulation) {
+    const elapsedMs = this.now() - started;
+    const steps = simulation.steps ?? null;
+    return {
+      ...base,
+      exitReason: simulation.exitReason,
+      error: simulation.error ?? null,
+      rip: simulation.rip ?? null,
+      guiIntent: Boolean(simulation.guiIntent),
+      consoleLines: simulation.consoleLines ?? [],
+      imports: summarizeImports(simulation.importCounts ?? [], simulation.importCalls),
+      stats: {
+        steps,
+        elapsedMs: Number(elapsedMs.toFixed(3)),
+        stepsPerSecond: steps && elapsedMs > 0 ? Math.round((steps * 1000) / elapsedMs) : null,
+      },
+    };
+  }
+}
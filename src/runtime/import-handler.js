@@ -2,6 +2,7 @@ function normalizeResult(result) {
   if (result == null) return undefined;
   if (typeof result === 'number') return { rax: result };
   if (typeof result === 'object') {
+    if (result.call) return { rax: result.rax ?? 0, call: result.call };
     return {
       rax: result.rax ?? 0,
     };
@@ -9,13 +10,32 @@ function normalizeResult(result) {
   return undefined;
 }
 
+function isPending(result) {
+  return typeof result?.then === 'function';
+}
+
+// A handler may return a Promise for blocking calls; the CPU parks at the
+// thunk until it settles. `{ call: { address, args, then } }` runs guest code
+// first and completes the import with whatever `then(rax)` returns.
+function settleResult(result) {
+  if (isPending(result)) return result.then((value) => normalizeResult(value) ?? { rax: 0 });
+  return normalizeResult(result);
+}
+
+function resolvePluginHandler(plugin, key) {
+  if (typeof plugin.resolveHandler === 'function') return plugin.resolveHandler(key);
+  if (typeof plugin.handle !== 'function') return null;
+  return (context) => (plugin.match && !plugin.match(context) ? undefined : plugin.handle(context));
+}
+
 export function createImportHandler({ readAnsiString, readWideString, log, plugins = [] }) {
-  return function handleImportCall({ name, cpu, consoleLines, flagGui }) {
+  return function handleImportCall({ name, cpu, consoleLines, flagGui, enterMessageLoop }) {
     const context = {
       name,
       cpu,
       consoleLines,
       flagGui,
+      enterMessageLoop,
       readAnsiString,
       readWideString,
       log,
@@ -25,7 +45,7 @@ export function createImportHandler({ readAnsiString, readWideString, log, plugi
       const shouldRun = plugin.match ? plugin.match(context) : true;
       if (!shouldRun) continue;
       const result = plugin.handle?.(context);
-      const normalized = normalizeResult(result);
+      const normalized = settleResult(result);
       if (normalized) {
         return normalized;
       }
@@ -33,3 +53,43 @@ export function createImportHandler({ readAnsiString, readWideString, log, plugi
     return { rax: 0 };
   };
 }
+
+// Resolves the plugin chain for one import key up front. The returned
+// function is bound into the CPU's per-import dispatch table, so a call only
+// runs the handlers that claimed this key.
+export function createImportBinder({ readAnsiString, readWideString, log, plugins = [] }) {
+  return function bindImport(name, { consoleLines, flagGui, enterMessageLoop } = {}) {
+    const key = String(name ?? '').toLowerCase();
+    const handlers = [];
+    for (const plugin of plugins) {
+      if (!plugin) continue;
+      const handler = resolvePluginHandler(plugin, key);
+      if (handler) handlers.push(handler);
+    }
+    const context = {
+      name,
+      cpu: null,
+      consoleLines,
+      flagGui,
+      enterMessageLoop,
+      readAnsiString,
+      readWideString,
+      log,
+    };
+    if (handlers.length === 1) {
+      const [handler] = handlers;
+      return (cpu) => {
+        context.cpu = cpu;
+        return settleResult(handler(context)) ?? { rax: 0 };
+      };
+    }
+    return (cpu) => {
+      context.cpu = cpu;
+      for (const handler of handlers) {
+        const normalized = settleResult(handler(context));
+        if (normalized) return normalized;
+      }
+      return { rax: 0 };
+    };
+  };
+}
@@ -5,41 +5,57 @@ export function createConsoleOutputImportPlugin({
   const normalizedKeywords = guiKeywords
     ?.map((keyword) => keyword?.toLowerCase?.())
     .filter((keyword) => Boolean(keyword?.length)) ?? ['createwindow', 'dialogbox', 'registerclass'];
+
+  function writeConsoleW({ cpu, consoleLines, readWideString }) {
+    const pointer = cpu.readRegister('rdx');
+    const charCount = Number(cpu.readRegister('r8') & 0xffffffffn) || undefined;
+    const text = readWideString(cpu, pointer, charCount);
+    if (text) consoleLines.push(text);
+    return { rax: 1 };
+  }
+
+  function writeConsoleA({ cpu, consoleLines, readAnsiString }) {
+    const pointer = cpu.readRegister('rdx');
+    const byteCount = Number(cpu.readRegister('r8') & 0xffffffffn) || undefined;
+    const text = readAnsiString(cpu, pointer, byteCount);
+    if (text) consoleLines.push(text);
+    return { rax: 1 };
+  }
+
+  function messageBox({ cpu, flagGui, readWideString, log }) {
+    flagGui?.();
+    const textPtr = cpu.readRegister('rdx');
+    if (logMessageBoxes) {
+      const text = readWideString(cpu, textPtr, 256);
+      if (text) log?.(`[WineJS] MessageBox payload: ${text}`);
+    }
+    return { rax: 1 };
+  }
+
+  function guiCall({ flagGui }) {
+    flagGui?.();
+    return { rax: 1 };
+  }
+
+  function resolveHandler(key) {
+    let handler = null;
+    if (key.endsWith('writeconsolew')) handler = writeConsoleW;
+    else if (key.endsWith('writeconsolea')) handler = writeConsoleA;
+    else if (key.includes('messagebox')) handler = messageBox;
+    else if (normalizedKeywords.some((keyword) => key.includes(keyword))) handler = guiCall;
+    if (!key.includes('user32.dll')) return handler;
+    return (context) => {
+      context.flagGui?.();
+      return handler?.(context);
+    };
+  }
+
   return {
     id: 'console-output',
     match: () => true,
+    resolveHandler,
     handle(context) {
-      const { name, cpu, consoleLines, flagGui, readAnsiString, readWideString, log } = context;
-      const lower = name.toLowerCase();
-      if (lower.includes('user32.dll')) flagGui?.();
-      if (lower.endsWith('writeconsolew')) {
-        const pointer = cpu.readRegister('rdx');
-        const charCount = Number(cpu.readRegister('r8') & 0xffffffffn) || undefined;
-        const text = readWideString(cpu, pointer, charCount);
-        if (text) consoleLines.push(text);
-        return { rax: 1 };
-      }
-      if (lower.endsWith('writeconsolea')) {
-        const pointer = cpu.readRegister('rdx');
-        const byteCount = Number(cpu.readRegister('r8') & 0xffffffffn) || undefined;
-        const text = readAnsiString(cpu, pointer, byteCount);
-        if (text) consoleLines.push(text);
-        return { rax: 1 };
-      }
-      if (lower.includes('messagebox')) {
-        flagGui?.();
-        const textPtr = cpu.readRegister('rdx');
-        if (logMessageBoxes) {
-          const text = readWideString(cpu, textPtr, 256);
-          if (text) log?.(`[WineJS] MessageBox payload: ${text}`);
-        }
-        return { rax: 1 };
-      }
-      if (normalizedKeywords.some((keyword) => lower.includes(keyword))) {
-        flagGui?.();
-        return { rax: 1 };
-      }
-      return undefined;
+      return resolveHandler(context.name.toLowerCase())?.(context);
     },
   };
 }
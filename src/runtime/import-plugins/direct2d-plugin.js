@@ -0,0 +1,409 @@
+import { ComHeap, E_NOTIMPL, E_POINTER, S_OK } from '../com/com-heap.js';
+import {
+  CMD_CLEAR,
+  CMD_FILL_ELLIPSE,
+  CMD_FILL_RECT,
+  CMD_LINE,
+  CMD_POP_CLIP,
+  CMD_PUSH_CLIP,
+  CMD_STROKE_ELLIPSE,
+  CMD_STROKE_RECT,
+  CMD_TRANSFORM,
+  CommandBuffer,
+} from '../d2d/command-buffer.js';
+import { replayCommands } from '../d2d/canvas-renderer.js';
+import { ID2D1_FACTORY, ID2D1_HWND_RENDER_TARGET, ID2D1_SOLID_COLOR_BRUSH } from '../d2d/interfaces.js';
+import { makeRect } from '../gdi/rect-list.js';
+import { ARG_REGISTERS, arg } from './win64-args.js';
+
+const D2D1_DLL_REGEX = /^d2d1(\.dll)?!/i;
+const COM_BASE = 0x7ffc00000000n;
+const COM_SIZE = 0x10000;
+const DEFAULT_DPI = 96;
+const D2DERR_WRONG_STATE = 0x88990001n;
+const IDENTITY = [1, 0, 0, 1, 0, 0];
+
+const floatView = new DataView(new ArrayBuffer(4));
+
+function defaultRequestFrame(fn) {
+  if (typeof requestAnimationFrame === 'function') return requestAnimationFrame(fn);
+  return setTimeout(fn, 16);
+}
+
+function bitsToFloat(bits) {
+  floatView.setUint32(0, Number(bits & 0xffffffffn), true);
+  return floatView.getFloat32(0, true);
+}
+
+function floatToBits(value) {
+  floatView.setFloat32(0, value, true);
+  return BigInt(floatView.getUint32(0, true));
+}
+
+function readFloats(cpu, address, count) {
+  return Array.from({ length: count }, (_, index) => bitsToFloat(cpu.memory.readUInt(address + BigInt(index * 4), 4)));
+}
+
+function writeFloats(cpu, address, values) {
+  values.forEach((value, index) => cpu.memory.writeUInt(address + BigInt(index * 4), 4, floatToBits(value)));
+}
+
+// Scalar float arguments in the first four positions travel in XMM0-3 (the
+// slot, not the count of float arguments, picks the register); later ones
+// are read from their stack slot.
+function floatArg(cpu, index) {
+  if (index < ARG_REGISTERS.length) return bitsToFloat(cpu.readRegister(`xmm${index}`, 32));
+  return bitsToFloat(arg(cpu, index));
+}
+
+// D2D1_POINT_2F is eight bytes, so it is passed by value in one register.
+function pointArg(cpu, index) {
+  const packed = arg(cpu, index);
+  return [bitsToFloat(packed), bitsToFloat(packed >> 32n)];
+}
+
+// ID2D1Factory, ID2D1HwndRenderTarget and ID2D1SolidColorBrush as COM
+// objects whose vtables point at import thunks. Draw calls between BeginDraw
+// and EndDraw are recorded into a CommandBuffer with the brush color of the
+// moment baked in; EndDraw queues the buffer and one frame replays the latest
+// buffer of every render target into its window's canvas in a single pass.
+// A guest that draws faster than the display drops the frames in between,
+// like a flip-model swap chain, and is never blocked on presentation.
+// Windows and their canvases come from the user32 station `stationFor(cpu)`
+// returns; without one the calls still succeed and nothing is shown. A
+// `presenter` (see createWebGLPresenter) takes over replay when it can;
+// otherwise frames are replayed with Canvas 2D.
+export function createDirect2DImportPlugin({ stationFor, requestFrame = defaultRequestFrame, presenter = null } = {}) {
+  const sessions = new WeakMap();
+  const live = new Set();
+
+  function sessionFor(cpu) {
+    let session = sessions.get(cpu);
+    if (session) return session;
+    session = {
+      heap: new ComHeap(cpu, { base: COM_BASE, size: COM_SIZE, dll: 'd2d1.dll' }),
+      targets: new Set(),
+      frame: null,
+    };
+    sessions.set(cpu, session);
+    live.add(session);
+    return session;
+  }
+
+  function create(cpu, kind, layout, fields) {
+    const { heap } = sessionFor(cpu);
+    return heap.create(heap.vtableFor(kind, layout), { kind, ...fields });
+  }
+
+  function writeOut(cpu, pointer, object) {
+    cpu.memory.writeUInt(pointer, 8, object.address);
+    return { rax: S_OK };
+  }
+
+  function self(kind, handler) {
+    return (context) => {
+      const object = sessionFor(context.cpu).heap.get(arg(context.cpu, 0));
+      if (!object || (kind && object.kind !== kind)) return { rax: E_POINTER };
+      return handler(context, object);
+    };
+  }
+
+  function brushColor(cpu, pointer) {
+    const brush = sessionFor(cpu).heap.get(pointer);
+    if (brush?.kind !== 'brush') return null;
+    const [r, g, b, a] = brush.color;
+    return [r, g, b, a * brush.opacity];
+  }
+
+  // Draw calls outside BeginDraw/EndDraw are ignored, and EndDraw reports it.
+  function record(target, opcode, operands) {
+    if (!target.drawing) {
+      target.error = true;
+      return;
+    }
+    target.recording.push(opcode, ...operands);
+  }
+
+  function canvasFor(target) {
+    const station = target.station;
+    const window = station?.getWindow(target.hwnd);
+    if (!window) return null;
+    const { surface, x, y } = station.paintTarget(window);
+    const canvas = station.windowManager?.getWindow?.(surface)?.canvas;
+    return canvas ? { canvas, surface, originX: x, originY: y } : null;
+  }
+
+  function present(session) {
+    session.frame = null;
+    const stations = new Set();
+    session.targets.forEach((target) => {
+      const frame = target.queued;
+      if (!frame) return;
+      target.queued = null;
+      target.spare = frame;
+      const output = canvasFor(target);
+      if (!output) return;
+      target.context ??= output.canvas.getContext('2d');
+      if (!target.context) return;
+      const placement = {
+        originX: output.originX,
+        originY: output.originY,
+        width: target.width,
+        height: target.height,
+      };
+      if (!presenter?.present(target, frame, target.context, placement)) {
+        replayCommands(frame, target.context, placement);
+      }
+      const { originX: left, originY: top } = output;
+      target.station.windowManager?.damage?.(output.surface, [
+        makeRect(left, top, left + target.width, top + target.height),
+      ]);
+      target.presented += 1;
+      stations.add(target.station);
+    });
+    stations.forEach((station) => station.input?.presented());
+  }
+
+  function endDraw(cpu, target) {
+    const session = sessionFor(cpu);
+    const hresult = target.drawing && !target.error ? S_OK : D2DERR_WRONG_STATE;
+    target.drawing = false;
+    const finished = target.recording;
+    target.recording = target.queued ?? target.spare ?? new CommandBuffer();
+    target.spare = null;
+    target.queued = finished;
+    if (session.frame === null && canvasFor(target)) session.frame = requestFrame(() => present(session));
+    return hresult;
+  }
+
+  function createRenderTarget({ cpu }, factory) {
+    const propsPtr = arg(cpu, 1);
+    const hwndPropsPtr = arg(cpu, 2);
+    const out = arg(cpu, 3);
+    if (!hwndPropsPtr || !out) return { rax: E_POINTER };
+    const hwnd = Number(cpu.memory.readUInt(hwndPropsPtr, 8) & 0xffffffffn);
+    const station = stationFor?.(cpu) ?? null;
+    const window = station?.getWindow(hwnd);
+    const [dpiX, dpiY] = propsPtr ? readFloats(cpu, propsPtr + 12n, 2) : [0, 0];
+    const target = create(cpu, 'target', ID2D1_HWND_RENDER_TARGET, {
+      factory,
+      station,
+      hwnd,
+      width: Number(cpu.memory.readUInt(hwndPropsPtr + 8n, 4)) || window?.width || 0,
+      height: Number(cpu.memory.readUInt(hwndPropsPtr + 12n, 4)) || window?.height || 0,
+      dpiX: dpiX || DEFAULT_DPI,
+      dpiY: dpiY || DEFAULT_DPI,
+      transform: IDENTITY.slice(),
+      recording: new CommandBuffer(),
+      queued: null,
+      spare: null,
+      context: null,
+      drawing: false,
+      error: false,
+      presented: 0,
+    });
+    const session = sessionFor(cpu);
+    session.targets.add(target);
+    target.onRelease = () => {
+      session.targets.delete(target);
+      presenter?.release(target);
+    };
+    session.heap.addRef(factory);
+    return writeOut(cpu, out, target);
+  }
+
+  function createBrush({ cpu }) {
+    const colorPtr = arg(cpu, 1);
+    const propsPtr = arg(cpu, 2);
+    const out = arg(cpu, 3);
+    if (!colorPtr || !out) return { rax: E_POINTER };
+    const brush = create(cpu, 'brush', ID2D1_SOLID_COLOR_BRUSH, {
+      color: readFloats(cpu, colorPtr, 4),
+      opacity: propsPtr ? readFloats(cpu, propsPtr, 1)[0] : 1,
+    });
+    return writeOut(cpu, out, brush);
+  }
+
+  const shape = (opcode, operandCount, stroke) =>
+    self('target', ({ cpu }, target) => {
+      const geometry = arg(cpu, 1);
+      const color = brushColor(cpu, arg(cpu, 2));
+      if (!geometry || !color) return { rax: 0n };
+      const widths = stroke ? [floatArg(cpu, 3)] : [];
+      record(target, opcode, [...readFloats(cpu, geometry, operandCount), ...widths, ...color]);
+      return { rax: 0n };
+    });
+
+  const unknownHandlers = {
+    'iunknown::queryinterface': self(null, ({ cpu }, object) => {
+      const out = arg(cpu, 2);
+      if (!out) return { rax: E_POINTER };
+      sessionFor(cpu).heap.addRef(object);
+      return writeOut(cpu, out, object);
+    }),
+    'iunknown::addref': self(null, ({ cpu }, object) => ({ rax: BigInt(sessionFor(cpu).heap.addRef(object)) })),
+    'iunknown::release': self(null, ({ cpu }, object) => ({ rax: BigInt(sessionFor(cpu).heap.release(object)) })),
+    'id2d1resource::getfactory': self(null, ({ cpu }, object) => {
+      const factory = object.kind === 'factory' ? object : object.factory;
+      const out = arg(cpu, 1);
+      if (factory && out) {
+        sessionFor(cpu).heap.addRef(factory);
+        cpu.memory.writeUInt(out, 8, factory.address);
+      }
+      return { rax: 0n };
+    }),
+  };
+
+  const factoryHandlers = {
+    'id2d1factory::reloadsystemmetrics': self('factory', () => ({ rax: S_OK })),
+    'id2d1factory::getdesktopdpi': self('factory', ({ cpu }) => {
+      [arg(cpu, 1), arg(cpu, 2)].forEach((pointer) => pointer && writeFloats(cpu, pointer, [DEFAULT_DPI]));
+      return { rax: 0n };
+    }),
+    'id2d1factory::createhwndrendertarget': self('factory', createRenderTarget),
+  };
+
+  const targetHandlers = {
+    'id2d1rendertarget::createsolidcolorbrush': self('target', createBrush),
+    'id2d1rendertarget::drawline': self('target', ({ cpu }, target) => {
+      const color = brushColor(cpu, arg(cpu, 3));
+      if (color) record(target, CMD_LINE, [...pointArg(cpu, 1), ...pointArg(cpu, 2), floatArg(cpu, 4), ...color]);
+      return { rax: 0n };
+    }),
+    'id2d1rendertarget::drawrectangle': shape(CMD_STROKE_RECT, 4, true),
+    'id2d1rendertarget::fillrectangle': shape(CMD_FILL_RECT, 4, false),
+    'id2d1rendertarget::drawellipse': shape(CMD_STROKE_ELLIPSE, 4, true),
+    'id2d1rendertarget::fillellipse': shape(CMD_FILL_ELLIPSE, 4, false),
+    'id2d1rendertarget::settransform': self('target', ({ cpu }, target) => {
+      const pointer = arg(cpu, 1);
+      target.transform = pointer ? readFloats(cpu, pointer, 6) : IDENTITY.slice();
+      record(target, CMD_TRANSFORM, target.transform);
+      return { rax: 0n };
+    }),
+    'id2d1rendertarget::gettransform': self('target', ({ cpu }, target) => {
+      const pointer = arg(cpu, 1);
+      if (pointer) writeFloats(cpu, pointer, target.transform);
+      return { rax: 0n };
+    }),
+    'id2d1rendertarget::setantialiasmode': self('target', () => ({ rax: 0n })),
+    'id2d1rendertarget::settextantialiasmode': self('target', () => ({ rax: 0n })),
+    'id2d1rendertarget::settags': self('target', () => ({ rax: 0n })),
+    'id2d1rendertarget::flush': self('target', () => ({ rax: S_OK })),
+    'id2d1rendertarget::pushaxisalignedclip': self('target', ({ cpu }, target) => {
+      const pointer = arg(cpu, 1);
+      if (pointer) record(target, CMD_PUSH_CLIP, readFloats(cpu, pointer, 4));
+      return { rax: 0n };
+    }),
+    'id2d1rendertarget::popaxisalignedclip': self('target', ({ cpu }, target) => {
+      record(target, CMD_POP_CLIP, []);
+      return { rax: 0n };
+    }),
+    'id2d1rendertarget::clear': self('target', ({ cpu }, target) => {
+      const pointer = arg(cpu, 1);
+      record(target, CMD_CLEAR, pointer ? readFloats(cpu, pointer, 4) : [0, 0, 0, 0]);
+      return { rax: 0n };
+    }),
+    'id2d1rendertarget::begindraw': self('target', (context, target) => {
+      target.recording.reset();
+      target.transform = IDENTITY.slice();
+      target.drawing = true;
+      target.error = false;
+      return { rax: 0n };
+    }),
+    'id2d1rendertarget::enddraw': self('target', ({ cpu }, target) => {
+      [arg(cpu, 1), arg(cpu, 2)].forEach((pointer) => pointer && cpu.memory.writeUInt(pointer, 8, 0n));
+      return { rax: endDraw(cpu, target) };
+    }),
+    'id2d1rendertarget::setdpi': self('target', () => ({ rax: 0n })),
+    'id2d1rendertarget::getdpi': self('target', ({ cpu }, target) => {
+      if (arg(cpu, 1)) writeFloats(cpu, arg(cpu, 1), [target.dpiX]);
+      if (arg(cpu, 2)) writeFloats(cpu, arg(cpu, 2), [target.dpiY]);
+      return { rax: 0n };
+    }),
+    // Struct returns from member functions go through a hidden pointer in
+    // rdx, which is also returned in rax.
+    'id2d1rendertarget::getsize': self('target', ({ cpu }, target) => {
+      const out = arg(cpu, 1);
+      writeFloats(cpu, out, [(target.width * DEFAULT_DPI) / target.dpiX, (target.height * DEFAULT_DPI) / target.dpiY]);
+      return { rax: out };
+    }),
+    'id2d1rendertarget::getpixelsize': self('target', ({ cpu }, target) => {
+      const out = arg(cpu, 1);
+      cpu.memory.writeUInt(out, 4, BigInt(target.width));
+      cpu.memory.writeUInt(out + 4n, 4, BigInt(target.height));
+      return { rax: out };
+    }),
+    'id2d1hwndrendertarget::checkwindowstate': self('target', () => ({ rax: 0n })),
+    'id2d1hwndrendertarget::resize': self('target', ({ cpu }, target) => {
+      const pointer = arg(cpu, 1);
+      if (!pointer) return { rax: E_POINTER };
+      target.width = Number(cpu.memory.readUInt(pointer, 4));
+      target.height = Number(cpu.memory.readUInt(pointer + 4n, 4));
+      return { rax: S_OK };
+    }),
+    'id2d1hwndrendertarget::gethwnd': self('target', (context, target) => ({ rax: BigInt(target.hwnd) })),
+  };
+
+  const brushHandlers = {
+    'id2d1brush::setopacity': self('brush', ({ cpu }, brush) => {
+      brush.opacity = floatArg(cpu, 1);
+      return { rax: 0n };
+    }),
+    'id2d1solidcolorbrush::setcolor': self('brush', ({ cpu }, brush) => {
+      const pointer = arg(cpu, 1);
+      if (pointer) brush.color = readFloats(cpu, pointer, 4);
+      return { rax: 0n };
+    }),
+    'id2d1solidcolorbrush::getcolor': self('brush', ({ cpu }, brush) => {
+      const out = arg(cpu, 1);
+      writeFloats(cpu, out, brush.color);
+      return { rax: out };
+    }),
+  };
+
+  const exportHandlers = {
+    d2d1createfactory: ({ cpu }) => {
+      const out = arg(cpu, 3);
+      if (!out) return { rax: E_POINTER };
+      return writeOut(cpu, out, create(cpu, 'factory', ID2D1_FACTORY, {}));
+    },
+    // Rotation is about `center` by an angle in degrees.
+    d2d1makerotatematrix: ({ cpu }) => {
+      const radians = (floatArg(cpu, 0) * Math.PI) / 180;
+      const [cx, cy] = pointArg(cpu, 1);
+      const cos = Math.cos(radians);
+      const sin = Math.sin(radians);
+      const out = arg(cpu, 2);
+      if (out) writeFloats(cpu, out, [cos, sin, -sin, cos, cx - cx * cos + cy * sin, cy - cx * sin - cy * cos]);
+      return { rax: 0n };
+    },
+  };
+
+  const handlers = { ...unknownHandlers, ...factoryHandlers, ...targetHandlers, ...brushHandlers, ...exportHandlers };
+  const notImplemented = () => ({ rax: E_NOTIMPL });
+
+  function resolveHandler(key) {
+    if (!D2D1_DLL_REGEX.test(key)) return null;
+    const name = key.slice(key.indexOf('!') + 1);
+    return handlers[name] ?? (name.includes('::') ? notImplemented : null);
+  }
+
+  return {
+    id: 'direct2d',
+    match({ name }) {
+      return D2D1_DLL_REGEX.test(name ?? '');
+    },
+    resolveHandler,
+    handle(context) {
+      return resolveHandler(String(context.name ?? '').toLowerCase())?.(context);
+    },
+    targetsFor(cpu) {
+      return Array.from(sessionFor(cpu).targets);
+    },
+    reset() {
+      live.forEach((session) => session.targets.clear());
+      live.clear();
+      presenter?.dispose();
+    },
+  };
+}
@@ -0,0 +1,152 @@
+import { makeFont } from '../gdi/gdi-objects.js';
+import { arg, int32, uint32 } from './win64-args.js';
+
+const GDI32_DLL_REGEX = /^gdi32(\.dll)?!/i;
+const LF_FACESIZE = 32;
+
+// gdi32 objects, DC state and drawing, served by the GDI of the window
+// station `stationFor(cpu)` returns (the user32 plugin's), so HDCs from
+// BeginPaint/GetDC and handles from here are the same tables user32's
+// FillRect and DrawText use.
+export function createGdiImportPlugin({ stationFor } = {}) {
+  const gdiFor = (cpu) => stationFor?.(cpu)?.gdi ?? null;
+
+  function withGdi(handler) {
+    return (context) => {
+      const gdi = gdiFor(context.cpu);
+      return gdi ? handler(context, gdi) : { rax: 0n };
+    };
+  }
+
+  function readText(context, pointer, count, wide) {
+    if (!pointer || count <= 0) return '';
+    const { cpu, readAnsiString, readWideString } = context;
+    return (wide ? readWideString(cpu, pointer, count) : readAnsiString(cpu, pointer, count)).slice(0, count);
+  }
+
+  function readFace(context, pointer, wide) {
+    if (!pointer) return '';
+    const { cpu, readAnsiString, readWideString } = context;
+    return wide ? readWideString(cpu, pointer, LF_FACESIZE) : readAnsiString(cpu, pointer, LF_FACESIZE);
+  }
+
+  const createFont = (wide) =>
+    withGdi((context, gdi) => {
+      const { cpu } = context;
+      const font = makeFont({
+        height: int32(arg(cpu, 0)),
+        weight: int32(arg(cpu, 4)),
+        italic: uint32(arg(cpu, 5)) !== 0,
+        underline: uint32(arg(cpu, 6)) !== 0,
+        pitch: uint32(arg(cpu, 12)) & 0xff,
+        face: readFace(context, arg(cpu, 13), wide),
+      });
+      return { rax: BigInt(gdi.createFont(font)) };
+    });
+
+  // LOGFONT: height at 0, weight at 16, italic/underline bytes at 20/21,
+  // pitch and family at 27, face name at 28.
+  const createFontIndirect = (wide) =>
+    withGdi((context, gdi) => {
+      const { cpu } = context;
+      const pointer = arg(cpu, 0);
+      if (!pointer) return { rax: 0n };
+      const read = (offset, size) => cpu.memory.readUInt(pointer + BigInt(offset), size);
+      const font = makeFont({
+        height: int32(read(0, 4)),
+        weight: int32(read(16, 4)),
+        italic: read(20, 1) !== 0n,
+        underline: read(21, 1) !== 0n,
+        pitch: Number(read(27, 1)),
+        face: readFace(context, pointer + 28n, wide),
+      });
+      return { rax: BigInt(gdi.createFont(font)) };
+    });
+
+  const textOut = (wide) =>
+    withGdi((context, gdi) => {
+      const { cpu } = context;
+      const text = readText(context, arg(cpu, 3), int32(arg(cpu, 4)), wide);
+      return { rax: gdi.textOut(uint32(arg(cpu, 0)), int32(arg(cpu, 1)), int32(arg(cpu, 2)), text) ? 1n : 0n };
+    });
+
+  const textExtent = (wide) =>
+    withGdi((context, gdi) => {
+      const { cpu } = context;
+      const size = gdi.textExtent(uint32(arg(cpu, 0)), readText(context, arg(cpu, 1), int32(arg(cpu, 2)), wide));
+      const sizePtr = arg(cpu, 3);
+      if (!size || !sizePtr) return { rax: 0n };
+      cpu.memory.writeUInt(sizePtr, 4, BigInt(size.cx));
+      cpu.memory.writeUInt(sizePtr + 4n, 4, BigInt(size.cy));
+      return { rax: 1n };
+    });
+
+  const shape = (method) =>
+    withGdi(({ cpu }, gdi) => {
+      const [left, top, right, bottom] = [1, 2, 3, 4].map((index) => int32(arg(cpu, index)));
+      return { rax: gdi[method](uint32(arg(cpu, 0)), { left, top, right, bottom }) ? 1n : 0n };
+    });
+
+  const swapColor = (key) =>
+    withGdi(({ cpu }, gdi) => ({
+      rax: BigInt(gdi.swapState(uint32(arg(cpu, 0)), key, uint32(arg(cpu, 1)) & 0xffffff)),
+    }));
+
+  const handlers = {
+    getstockobject: withGdi(({ cpu }, gdi) => ({ rax: BigInt(gdi.getStockObject(uint32(arg(cpu, 0)))) })),
+    createpen: withGdi(({ cpu }, gdi) => ({
+      rax: BigInt(gdi.createPen(uint32(arg(cpu, 0)) & 0xf, int32(arg(cpu, 1)), uint32(arg(cpu, 2)) & 0xffffff)),
+    })),
+    createsolidbrush: withGdi(({ cpu }, gdi) => ({ rax: BigInt(gdi.createSolidBrush(uint32(arg(cpu, 0)) & 0xffffff)) })),
+    createfonta: createFont(false),
+    createfontw: createFont(true),
+    createfontindirecta: createFontIndirect(false),
+    createfontindirectw: createFontIndirect(true),
+    selectobject: withGdi(({ cpu }, gdi) => ({
+      rax: BigInt(gdi.selectObject(uint32(arg(cpu, 0)), uint32(arg(cpu, 1)))),
+    })),
+    deleteobject: withGdi(({ cpu }, gdi) => ({ rax: gdi.deleteObject(uint32(arg(cpu, 0))) ? 1n : 0n })),
+    settextcolor: swapColor('textColor'),
+    setbkcolor: swapColor('bkColor'),
+    setdcbrushcolor: swapColor('dcBrushColor'),
+    setdcpencolor: swapColor('dcPenColor'),
+    setbkmode: withGdi(({ cpu }, gdi) => ({
+      rax: BigInt(gdi.swapState(uint32(arg(cpu, 0)), 'bkMode', uint32(arg(cpu, 1)))),
+    })),
+    textouta: textOut(false),
+    textoutw: textOut(true),
+    gettextextentpoint32a: textExtent(false),
+    gettextextentpoint32w: textExtent(true),
+    rectangle: shape('rectangle'),
+    ellipse: shape('ellipse'),
+    movetoex: withGdi(({ cpu }, gdi) => {
+      const previous = gdi.moveTo(uint32(arg(cpu, 0)), int32(arg(cpu, 1)), int32(arg(cpu, 2)));
+      const pointPtr = arg(cpu, 3);
+      if (!previous) return { rax: 0n };
+      if (pointPtr) {
+        cpu.memory.writeUInt(pointPtr, 4, BigInt(previous.x >>> 0));
+        cpu.memory.writeUInt(pointPtr + 4n, 4, BigInt(previous.y >>> 0));
+      }
+      return { rax: 1n };
+    }),
+    lineto: withGdi(({ cpu }, gdi) => ({
+      rax: gdi.lineTo(uint32(arg(cpu, 0)), int32(arg(cpu, 1)), int32(arg(cpu, 2))) ? 1n : 0n,
+    })),
+  };
+
+  function resolveHandler(key) {
+    if (!GDI32_DLL_REGEX.test(key)) return null;
+    return handlers[key.slice(key.indexOf('!') + 1)] ?? null;
+  }
+
+  return {
+    id: 'gdi32',
+    match({ name }) {
+      return GDI32_DLL_REGEX.test(name ?? '');
+    },
+    resolveHandler,
+    handle(context) {
+      return resolveHandler(String(context.name ?? '').toLowerCase())?.(context);
+    },
+  };
+}
@@ -0,0 +1,72 @@
+const ORDINAL_LIMIT = 0x10000n;
+const KERNEL_DLL_REGEX = /^kernel(32|base)(\.dll)?!/i;
+
+function readModuleName(context, wide) {
+  const { cpu, readAnsiString, readWideString } = context;
+  const pointer = cpu.readRegister('rcx');
+  return wide ? readWideString(cpu, pointer, 260) : readAnsiString(cpu, pointer, 260);
+}
+
+// LoadLibrary maps an image when one was supplied and otherwise hands out a
+// virtual module, so system DLLs such as user32 get a handle whose
+// GetProcAddress lands on import thunks. GetModuleHandle never loads
+// anything: it answers 0 for a DLL the process has not loaded.
+export function createModuleLoaderImportPlugin({ log } = {}) {
+  function handleLoadLibrary(context, wide) {
+    const loader = context.cpu.loader;
+    const name = readModuleName(context, wide);
+    try {
+      const module = loader.ensureModule(name);
+      return { rax: module ? module.base : 0n };
+    } catch (err) {
+      log?.(`[WineJS] LoadLibrary(${name}) failed: ${err?.message ?? err}`);
+      return { rax: 0n };
+    }
+  }
+
+  function handleGetModuleHandle(context, wide) {
+    const loader = context.cpu.loader;
+    if (!context.cpu.readRegister('rcx')) {
+      return { rax: loader.mainModule?.base ?? 0n };
+    }
+    const module = loader.findLoadedModule(readModuleName(context, wide));
+    return { rax: module ? module.base : 0n };
+  }
+
+  function handleGetProcAddress(context) {
+    const { cpu, readAnsiString } = context;
+    const module = cpu.loader.getModule(cpu.readRegister('rcx'));
+    if (!module) return { rax: 0n };
+    const procName = cpu.readRegister('rdx');
+    const symbol = procName < ORDINAL_LIMIT ? Number(procName) : readAnsiString(cpu, procName, 512);
+    return { rax: cpu.loader.getProcAddress(module, symbol) ?? 0n };
+  }
+
+  const handlers = {
+    loadlibrarya: (context) => handleLoadLibrary(context, false),
+    loadlibraryexa: (context) => handleLoadLibrary(context, false),
+    loadlibraryw: (context) => handleLoadLibrary(context, true),
+    loadlibraryexw: (context) => handleLoadLibrary(context, true),
+    getmodulehandlea: (context) => handleGetModuleHandle(context, false),
+    getmodulehandlew: (context) => handleGetModuleHandle(context, true),
+    getprocaddress: handleGetProcAddress,
+  };
+
+  function resolveHandler(key) {
+    if (!KERNEL_DLL_REGEX.test(key)) return null;
+    const handler = handlers[key.slice(key.indexOf('!') + 1)];
+    if (!handler) return null;
+    return (context) => (context.cpu?.loader ? handler(context) : undefined);
+  }
+
+  return {
+    id: 'module-loader',
+    match({ name, cpu }) {
+      return Boolean(cpu?.loader) && KERNEL_DLL_REGEX.test(name ?? '');
+    },
+    resolveHandler,
+    handle(context) {
+      return resolveHandler(String(context.name ?? '').toLowerCase())?.(context);
+    },
+  };
+}
@@ -0,0 +1,165 @@
+const KERNEL_DLL_REGEX = /^kernel(32|base)(\.dll)?!/i;
+const WINMM_DLL_REGEX = /^winmm(\.dll)?!/i;
+const PERFORMANCE_FREQUENCY = 10000000n;
+const FILETIME_UNIX_EPOCH = 116444736000000000n;
+const FILETIME_TICKS_PER_MS = 10000n;
+const FIRST_TIMER_HANDLE = 0x3000n;
+
+function toFileTime(ms) {
+  return FILETIME_UNIX_EPOCH + BigInt(Math.floor(ms)) * FILETIME_TICKS_PER_MS;
+}
+
+// Due times are in 100 ns units: negative is relative, positive is an
+// absolute FILETIME.
+function dueTimeToDelay(clock, dueTime) {
+  const signed = BigInt.asIntN(64, dueTime);
+  if (signed <= 0n) return Number(-signed / FILETIME_TICKS_PER_MS);
+  return Math.max(0, Number((signed - toFileTime(clock.wallTime())) / FILETIME_TICKS_PER_MS));
+}
+
+// kernel32/winmm time sources and waitable timers, all read from the
+// VirtualClock `getClock()` returns, so QueryPerformanceCounter, GetTickCount64
+// and the system time agree with Sleep, SetTimer and each other.
+// `waitForObject(handle, { signal })` plugs waitable timers into the kernel32
+// wait plugin.
+export function createTimeImportPlugin({ getClock }) {
+  const timers = new Map();
+  let nextHandle = FIRST_TIMER_HANDLE;
+
+  function writeQuad(cpu, pointer, value) {
+    if (pointer) cpu.memory.writeUInt(pointer, 8, value);
+    return { rax: pointer ? 1n : 0n };
+  }
+
+  function signal(timer) {
+    if (timer.manualReset) {
+      timer.signaled = true;
+      timer.waiters.splice(0).forEach((resolve) => resolve());
+      return;
+    }
+    const waiter = timer.waiters.shift();
+    if (waiter) waiter();
+    else timer.signaled = true;
+  }
+
+  function cancel(timer) {
+    if (timer.clockTimer !== null) getClock().clearTimeout(timer.clockTimer);
+    timer.clockTimer = null;
+  }
+
+  function addTimer(manualReset) {
+    const handle = nextHandle;
+    nextHandle += 4n;
+    timers.set(handle, { manualReset, signaled: false, waiters: [], clockTimer: null });
+    return { rax: handle };
+  }
+
+  // CreateWaitableTimerExW carries the manual-reset bit in dwFlags.
+  const createTimer = ({ cpu }) => addTimer((cpu.readRegister('rdx') & 0xffffffffn) !== 0n);
+  const createTimerEx = ({ cpu }) => addTimer((cpu.readRegister('r8') & 1n) !== 0n);
+
+  function setTimer({ cpu }) {
+    const timer = timers.get(cpu.readRegister('rcx'));
+    const dueTime = cpu.readRegister('rdx');
+    if (!timer || !dueTime) return { rax: 0n };
+    cancel(timer);
+    timer.signaled = false;
+    const delay = dueTimeToDelay(getClock(), cpu.memory.readUInt(dueTime, 8));
+    const period = Number(cpu.readRegister('r8') & 0xffffffffn);
+    const fire = () => {
+      timer.clockTimer = period ? getClock().setTimeout(fire, period) : null;
+      signal(timer);
+    };
+    timer.clockTimer = getClock().setTimeout(fire, delay);
+    return { rax: 1n };
+  }
+
+  function cancelTimer({ cpu }) {
+    const timer = timers.get(cpu.readRegister('rcx'));
+    if (!timer) return { rax: 0n };
+    cancel(timer);
+    return { rax: 1n };
+  }
+
+  function closeHandle({ cpu }) {
+    const handle = cpu.readRegister('rcx');
+    const timer = timers.get(handle);
+    if (!timer) return undefined;
+    cancel(timer);
+    timers.delete(handle);
+    return { rax: 1n };
+  }
+
+  const tickCount = () => BigInt(Math.floor(getClock().now()));
+  const systemTime = ({ cpu }) => {
+    writeQuad(cpu, cpu.readRegister('rcx'), toFileTime(getClock().wallTime()));
+    return { rax: 0n };
+  };
+
+  const kernelHandlers = {
+    queryperformancecounter: ({ cpu }) =>
+      writeQuad(cpu, cpu.readRegister('rcx'), BigInt(Math.floor(getClock().now() * 10000))),
+    queryperformancefrequency: ({ cpu }) => writeQuad(cpu, cpu.readRegister('rcx'), PERFORMANCE_FREQUENCY),
+    gettickcount: () => ({ rax: tickCount() & 0xffffffffn }),
+    gettickcount64: () => ({ rax: tickCount() }),
+    getsystemtimeasfiletime: systemTime,
+    getsystemtimepreciseasfiletime: systemTime,
+    createwaitabletimera: createTimer,
+    createwaitabletimerw: createTimer,
+    createwaitabletimerexa: createTimerEx,
+    createwaitabletimerexw: createTimerEx,
+    setwaitabletimer: setTimer,
+    setwaitabletimerex: setTimer,
+    cancelwaitabletimer: cancelTimer,
+    closehandle: closeHandle,
+  };
+
+  const winmmHandlers = {
+    timegettime: () => ({ rax: tickCount() & 0xffffffffn }),
+  };
+
+  function resolveHandler(key) {
+    const name = key.slice(key.indexOf('!') + 1);
+    if (KERNEL_DLL_REGEX.test(key)) return kernelHandlers[name] ?? null;
+    if (WINMM_DLL_REGEX.test(key)) return winmmHandlers[name] ?? null;
+    return null;
+  }
+
+  return {
+    id: 'virtual-time',
+    match({ name }) {
+      return KERNEL_DLL_REGEX.test(name ?? '') || WINMM_DLL_REGEX.test(name ?? '');
+    },
+    resolveHandler,
+    handle(context) {
+      return resolveHandler(String(context.name ?? '').toLowerCase())?.(context);
+    },
+    // Resolves once the timer is signaled; null means signaled already (or
+    // not a timer), which the wait plugin treats as an immediate wake. Once
+    // `signal` aborts (the wait timed out) the waiter is dropped, so it can't
+    // swallow a later auto-reset signal meant for the next wait.
+    waitForObject(handle, { signal } = {}) {
+      const timer = timers.get(BigInt(handle));
+      if (!timer) return null;
+      if (timer.signaled) {
+        if (!timer.manualReset) timer.signaled = false;
+        return null;
+      }
+      return new Promise((resolve) => {
+        timer.waiters.push(resolve);
+        signal?.addEventListener(
+          'abort',
+          () => {
+            const index = timer.waiters.indexOf(resolve);
+            if (index >= 0) timer.waiters.splice(index, 1);
+          },
+          { once: true },
+        );
+      });
+    },
+    reset() {
+      timers.forEach(cancel);
+      timers.clear();
+    },
+  };
+}
@@ -0,0 +1,728 @@
+import { WindowStation } from '../user32/window-station.js';
+import { DT_CALCRECT, systemColor } from '../gdi/gdi-objects.js';
+import {
+  GWLP_HINSTANCE,
+  GWLP_ID,
+  GWLP_WNDPROC,
+  GWL_EXSTYLE,
+  GWL_STYLE,
+  PM_REMOVE,
+  SIZE_RESTORED,
+  SW_HIDE,
+  WM_CHAR,
+  WM_CLOSE,
+  WM_COMMAND,
+  WM_CREATE,
+  WM_DESTROY,
+  WM_ERASEBKGND,
+  WM_GETTEXT,
+  WM_GETTEXTLENGTH,
+  WM_KEYDOWN,
+  WM_NCCREATE,
+  WM_NCDESTROY,
+  WM_PAINT,
+  WM_QUIT,
+  WM_SETTEXT,
+  WM_SIZE,
+  WM_SYSCHAR,
+  WM_SYSKEYDOWN,
+  WM_TIMER,
+  WS_VISIBLE,
+  makeLParam,
+} from '../user32/messages.js';
+import { arg, int32, uint32 } from './win64-args.js';
+
+const USER32_DLL_REGEX = /^user32(\.dll)?!/i;
+const ATOM_LIMIT = 0x10000n;
+const SCRATCH_BASE = 0x7ffd00000000n;
+const SCRATCH_SIZE = 0x10000;
+const CREATESTRUCT_SIZE = 80;
+const INFINITE = 0xffffffff;
+const WAIT_OBJECT_0 = 0n;
+const WAIT_TIMEOUT = 0x102n;
+const FAKE_RESOURCE_BASE = 0x20000n;
+const MAX_DRAW_TEXT = 4096;
+const MAX_WINDOW_TEXT = 4096;
+
+function toHandle(value) {
+  return BigInt.asIntN(64, value) === -1n ? -1 : uint32(value);
+}
+
+function readMessageFilter(cpu) {
+  return { hwnd: toHandle(arg(cpu, 1)), min: uint32(arg(cpu, 2)), max: uint32(arg(cpu, 3)) };
+}
+
+function writeMessage(cpu, address, msg) {
+  const { memory } = cpu;
+  memory.writeUInt(address, 8, BigInt(msg.hwnd));
+  memory.writeUInt(address + 8n, 4, BigInt(msg.message));
+  memory.writeUInt(address + 16n, 8, BigInt.asUintN(64, msg.wParam));
+  memory.writeUInt(address + 24n, 8, BigInt.asUintN(64, msg.lParam));
+  memory.writeUInt(address + 32n, 4, BigInt(msg.time >>> 0));
+  memory.writeUInt(address + 36n, 4, BigInt(msg.pt.x >>> 0));
+  memory.writeUInt(address + 40n, 4, BigInt(msg.pt.y >>> 0));
+}
+
+function readMessage(cpu, address) {
+  const { memory } = cpu;
+  return {
+    hwnd: Number(memory.readUInt(address, 8) & 0xffffffffn),
+    message: Number(memory.readUInt(address + 8n, 4)),
+    wParam: memory.readUInt(address + 16n, 8),
+    lParam: memory.readUInt(address + 24n, 8),
+    time: Number(memory.readUInt(address + 32n, 4)),
+  };
+}
+
+function writeRect(cpu, address, left, top, right, bottom) {
+  [left, top, right, bottom].forEach((value, index) => {
+    cpu.memory.writeUInt(address + BigInt(index * 4), 4, BigInt(value >>> 0));
+  });
+}
+
+function readRect(cpu, address) {
+  if (!address) return null;
+  const [left, top, right, bottom] = [0, 4, 8, 12].map((offset) =>
+    int32(cpu.memory.readUInt(address + BigInt(offset), 4)),
+  );
+  return { left, top, right, bottom };
+}
+
+// Sequences import results that may call back into the guest: `next` runs
+// with the rax of `result` once any guest calls it requested have returned.
+function after(result, next) {
+  if (typeof result?.then === 'function') return result.then((value) => after(value, next));
+  if (result?.call) {
+    const { then } = result.call;
+    return { call: { ...result.call, then: (rax) => after(then ? then(rax) : { rax }, next) } };
+  }
+  return next(BigInt(result?.rax ?? 0));
+}
+
+function sequence(steps) {
+  return steps.reduce((previous, step) => after(previous, step), { rax: 0n });
+}
+
+// user32 windowing and messaging. Window procedures run as real guest code
+// through the CPU's callback frames, so SendMessage, DispatchMessage and the
+// messages CreateWindowEx, ShowWindow and DestroyWindow send all re-enter the
+// guest synchronously, while PostMessage, timers and invalidation go through
+// the per-thread queue. GetMessage parks the guest until the queue has
+// something. `quitWhenIdle` makes an empty queue with no timers read as
+// WM_QUIT, which keeps headless runs from waiting on input that never comes.
+// Message times, timers and wait timeouts follow `getClock()` (a
+// VirtualClock) when one is given. Painting goes through the station's GDI;
+// `requestFrame` overrides how it schedules frames.
+export function createUser32ImportPlugin({
+  getWindowManager,
+  quitWhenIdle = false,
+  getClock,
+  waitForObject,
+  yieldToHost = (fn) => setTimeout(fn, 0),
+  requestFrame,
+} = {}) {
+  const schedule = (fn, ms) => (getClock?.() ? getClock().setTimeout(fn, ms) : setTimeout(fn, ms));
+  const unschedule = (id) => (getClock?.() ? getClock().clearTimeout(id) : clearTimeout(id));
+  const sessions = new WeakMap();
+  const live = new Set();
+  let latest = null;
+
+  function sessionFor(cpu) {
+    let session = sessions.get(cpu);
+    if (session) return session;
+    const clock = getClock?.();
+    const station = new WindowStation({
+      windowManager: getWindowManager?.() ?? null,
+      requestFrame,
+      ...(clock && {
+        now: () => Math.floor(clock.now()),
+        setInterval: (fn, ms) => clock.setInterval(fn, ms),
+        clearInterval: (id) => clock.clearInterval(id),
+      }),
+    });
+    const scratchBase = cpu.memory.isRangeFree(SCRATCH_BASE, SCRATCH_SIZE) ? SCRATCH_BASE : null;
+    if (scratchBase) {
+      cpu.memory.mapRegion({ base: scratchBase, bytes: new Uint8Array(SCRATCH_SIZE), name: 'user32-scratch' });
+    }
+    session = { station, scratchTop: scratchBase ?? 0n };
+    sessions.set(cpu, session);
+    live.add(session);
+    latest = session;
+    return session;
+  }
+
+  function allocScratch(session, size) {
+    const address = session.scratchTop;
+    if (!address) return 0n;
+    session.scratchTop += BigInt((size + 15) & ~15);
+    return address;
+  }
+
+  function readString(context, pointer, wide) {
+    const { cpu, readAnsiString, readWideString } = context;
+    return wide ? readWideString(cpu, pointer, 256) : readAnsiString(cpu, pointer, 256);
+  }
+
+  function readClassName(context, pointer, wide) {
+    if (pointer < ATOM_LIMIT) return Number(pointer);
+    return readString(context, pointer, wide);
+  }
+
+  function sendMessage(context, window, message, wParam = 0n, lParam = 0n) {
+    if (window.control && !window.wndProc) return controlMessage(context, window, message, wParam, lParam);
+    if (!window.wndProc) return defWindowProc(context, window.hwnd, message, wParam, lParam);
+    return { call: { address: window.wndProc, args: [BigInt(window.hwnd), BigInt(message), wParam, lParam] } };
+  }
+
+  // Guest text buffers in the window's character set, for WM_*TEXT and the
+  // built-in controls.
+  function textIo(context, wide) {
+    const { cpu } = context;
+    return {
+      readText: (pointer) => (pointer ? readCounted(context, pointer, MAX_WINDOW_TEXT, wide) : ''),
+      writeText(pointer, text, capacity) {
+        if (!pointer || capacity <= 0) return 0;
+        const chars = text.slice(0, capacity - 1);
+        const width = wide ? 2 : 1;
+        const bytes = new Uint8Array((chars.length + 1) * width);
+        for (let index = 0; index < chars.length; index++) {
+          const code = chars.charCodeAt(index);
+          bytes[index * width] = code & 0xff;
+          if (wide) bytes[index * 2 + 1] = code >> 8;
+        }
+        cpu.memory.write(pointer, bytes);
+        return chars.length;
+      },
+      writeUInt32: (pointer, value) => cpu.memory.writeUInt(pointer, 4, BigInt(value >>> 0)),
+    };
+  }
+
+  // Built-in controls answer on the host; the notification a message raised
+  // goes to the parent as WM_COMMAND once it is handled.
+  function controlMessage(context, window, message, wParam, lParam) {
+    const result = window.control.handle(message, wParam, lParam, textIo(context, window.unicode));
+    if (!result) return defWindowProc(context, window.hwnd, message, wParam, lParam);
+    const answer = { rax: BigInt.asUintN(64, BigInt(result.rax)) };
+    const parent = result.notify && station(context.cpu).getWindow(window.parent);
+    if (!parent) return answer;
+    const command = BigInt(makeLParam(Number(window.id & 0xffffn), result.notify));
+    return after(sendMessage(context, parent, WM_COMMAND, command, BigInt(window.hwnd)), () => answer);
+  }
+
+  function defWindowProc(context, hwnd, message, wParam = 0n, lParam = 0n) {
+    const { station } = sessionFor(context.cpu);
+    switch (message) {
+      case WM_NCCREATE:
+        return { rax: 1n };
+      case WM_SETTEXT: {
+        const window = station.getWindow(hwnd);
+        if (window) window.title = textIo(context, window.unicode).readText(lParam);
+        return { rax: window ? 1n : 0n };
+      }
+      case WM_GETTEXT: {
+        const window = station.getWindow(hwnd);
+        const copied = window ? textIo(context, window.unicode).writeText(lParam, window.title, Number(wParam)) : 0;
+        return { rax: BigInt(copied) };
+      }
+      case WM_GETTEXTLENGTH:
+        return { rax: BigInt(station.getWindow(hwnd)?.title.length ?? 0) };
+      case WM_ERASEBKGND: {
+        const window = station.getWindow(hwnd);
+        const brush = window?.windowClass.background;
+        if (!brush) return { rax: 0n };
+        station.gdi.fillRect(uint32(wParam), station.clientRect(window), brush);
+        return { rax: 1n };
+      }
+      case WM_CLOSE: {
+        const window = station.getWindow(hwnd);
+        return window ? after(destroyWindow(context, window), () => ({ rax: 0n })) : { rax: 0n };
+      }
+      case WM_PAINT:
+        station.validate(hwnd);
+        return { rax: 0n };
+      default:
+        return { rax: 0n };
+    }
+  }
+
+  function destroyWindow(context, window) {
+    const { station } = sessionFor(context.cpu);
+    if (window.destroying || !station.getWindow(window.hwnd)) return { rax: 0n };
+    window.destroying = true;
+    return sequence([
+      () => sendMessage(context, window, WM_DESTROY),
+      ...station.childrenOf(window.hwnd).map((child) => () => destroyWindow(context, child)),
+      () => sendMessage(context, window, WM_NCDESTROY),
+      () => {
+        station.removeWindow(window.hwnd);
+        return { rax: 1n };
+      },
+    ]);
+  }
+
+  function showWindow(context, window, command) {
+    const { station } = sessionFor(context.cpu);
+    const previous = { rax: window.visible ? 1n : 0n };
+    if (command === SW_HIDE) {
+      station.showWindow(window, false);
+      return previous;
+    }
+    station.showWindow(window, true);
+    station.invalidate(window.hwnd);
+    if (window.sizeSent) return previous;
+    window.sizeSent = true;
+    const size = BigInt(makeLParam(window.width, window.height));
+    return after(sendMessage(context, window, WM_SIZE, BigInt(SIZE_RESTORED), size), () => previous);
+  }
+
+  function writeCreateStruct(cpu, address, window, { param, namePtr, classPtr }) {
+    const { memory } = cpu;
+    memory.writeUInt(address, 8, param);
+    memory.writeUInt(address + 8n, 8, window.instance);
+    memory.writeUInt(address + 16n, 8, window.id);
+    memory.writeUInt(address + 24n, 8, BigInt(window.parent));
+    [window.height, window.width, window.y, window.x, window.style].forEach((value, index) => {
+      memory.writeUInt(address + 32n + BigInt(index * 4), 4, BigInt(value >>> 0));
+    });
+    memory.writeUInt(address + 56n, 8, namePtr);
+    memory.writeUInt(address + 64n, 8, classPtr);
+    memory.writeUInt(address + 72n, 4, BigInt(window.exStyle >>> 0));
+  }
+
+  function registerClass(context, extended, wide) {
+    const { cpu } = context;
+    const pointer = arg(cpu, 0);
+    const read = (offset, size) => cpu.memory.readUInt(pointer + BigInt(offset), size);
+    const className = readClassName(context, read(64, 8), wide);
+    const atom = sessionFor(cpu).station.registerClass({
+      name: typeof className === 'number' ? `#${className}` : className,
+      style: Number(extended ? read(4, 4) : read(0, 4)),
+      wndProc: read(8, 8),
+      windowExtra: Number(read(20, 4)),
+      instance: read(24, 8),
+      background: uint32(read(48, 8)),
+    });
+    context.flagGui?.();
+    return { rax: BigInt(atom) };
+  }
+
+  function createWindow(context, wide) {
+    const { cpu } = context;
+    const session = sessionFor(cpu);
+    const classPtr = arg(cpu, 1);
+    const namePtr = arg(cpu, 2);
+    const window = session.station.createWindow({
+      className: readClassName(context, classPtr, wide),
+      title: namePtr ? readString(context, namePtr, wide) : '',
+      exStyle: uint32(arg(cpu, 0)),
+      style: uint32(arg(cpu, 3)),
+      x: int32(arg(cpu, 4)),
+      y: int32(arg(cpu, 5)),
+      width: int32(arg(cpu, 6)),
+      height: int32(arg(cpu, 7)),
+      parent: uint32(arg(cpu, 8)),
+      menu: arg(cpu, 9),
+      instance: arg(cpu, 10),
+      unicode: wide,
+    });
+    if (!window) return { rax: 0n };
+    context.flagGui?.();
+    const scratchTop = session.scratchTop;
+    const createStruct = allocScratch(session, CREATESTRUCT_SIZE);
+    if (createStruct) writeCreateStruct(cpu, createStruct, window, { param: arg(cpu, 11), namePtr, classPtr });
+    const fail = () => {
+      session.scratchTop = scratchTop;
+      return after(destroyWindow(context, window), () => ({ rax: 0n }));
+    };
+    return after(sendMessage(context, window, WM_NCCREATE, 0n, createStruct), (accepted) => {
+      if (!accepted) return fail();
+      return after(sendMessage(context, window, WM_CREATE, 0n, createStruct), (result) => {
+        if (BigInt.asIntN(64, result) === -1n) return fail();
+        session.scratchTop = scratchTop;
+        const created = { rax: BigInt(window.hwnd) };
+        if (!(window.style & WS_VISIBLE)) return created;
+        return after(showWindow(context, window, 1), () => created);
+      });
+    });
+  }
+
+  function withWindow(handler) {
+    return (context) => {
+      const window = sessionFor(context.cpu).station.getWindow(uint32(arg(context.cpu, 0)));
+      return window ? handler(context, window) : { rax: 0n };
+    };
+  }
+
+  function getMessage({ cpu, enterMessageLoop }) {
+    const { station } = sessionFor(cpu);
+    const queue = station.queue();
+    const msgPtr = arg(cpu, 0);
+    const filter = readMessageFilter(cpu);
+    const take = () => {
+      const msg = queue.next(filter, true);
+      if (!msg) return null;
+      station.input.retrieve(msg);
+      writeMessage(cpu, msgPtr, msg);
+      return { rax: msg.message === WM_QUIT ? 0n : 1n };
+    };
+    const ready = take();
+    if (ready) return ready;
+    if (quitWhenIdle && !queue.hasTimers()) {
+      queue.postQuit(0);
+      return take();
+    }
+    enterMessageLoop?.();
+    return (async () => {
+      for (;;) {
+        await queue.wait();
+        const result = take();
+        if (result) return result;
+      }
+    })();
+  }
+
+  // An empty PeekMessage yields to the host once, so timers and input can
+  // land while a game loop polls.
+  function peekMessage({ cpu }) {
+    const { station } = sessionFor(cpu);
+    const queue = station.queue();
+    const msgPtr = arg(cpu, 0);
+    const filter = readMessageFilter(cpu);
+    const remove = (uint32(arg(cpu, 4)) & PM_REMOVE) !== 0;
+    const peek = () => {
+      const msg = queue.next(filter, remove);
+      if (!msg) return { rax: 0n };
+      if (remove) station.input.retrieve(msg);
+      writeMessage(cpu, msgPtr, msg);
+      return { rax: 1n };
+    };
+    const result = peek();
+    if (result.rax || !yieldToHost) return result;
+    return new Promise((resolve) => yieldToHost(() => resolve(peek())));
+  }
+
+  function waitForMessage(queue, ms, signaled, timedOut, abort) {
+    if (queue.next({}, false)) return { rax: signaled };
+    const ready = queue.wait().then(() => ({ rax: signaled }));
+    if (ms === INFINITE) return ready;
+    const timeout = new Promise((resolve) => {
+      const timer = schedule(() => resolve({ rax: timedOut }), ms);
+      abort?.addEventListener('abort', () => unschedule(timer), { once: true });
+    });
+    return Promise.race([ready, timeout]);
+  }
+
+  // Handles are waited on through `waitForObject`, the hook the kernel32 wait
+  // plugin takes; without it every handle counts as signaled and the wait
+  // only yields to the host once.
+  function msgWaitForMultipleObjects(cpu, count, handles, ms) {
+    const queue = sessionFor(cpu).station.queue();
+    const messageReady = WAIT_OBJECT_0 + BigInt(count);
+    if (queue.next({}, false)) return { rax: messageReady };
+    const settled = new AbortController();
+    const waits = [];
+    for (let index = 0; index < count; index++) {
+      const signaled = { rax: WAIT_OBJECT_0 + BigInt(index) };
+      const handle = cpu.memory.readUInt(handles + BigInt(index * 8), 8);
+      const pending = waitForObject?.(handle, { signal: settled.signal });
+      if (!pending) {
+        settled.abort();
+        return new Promise((resolve) => yieldToHost(() => resolve(signaled)));
+      }
+      waits.push(Promise.resolve(pending).then(() => signaled));
+    }
+    const message = waitForMessage(queue, ms, messageReady, WAIT_TIMEOUT, settled.signal);
+    return Promise.race([message, ...waits]).finally(() => settled.abort());
+  }
+
+  function dispatchMessage(context) {
+    const { cpu } = context;
+    const msg = readMessage(cpu, arg(cpu, 0));
+    if (msg.message === WM_TIMER && msg.lParam) {
+      return { call: { address: msg.lParam, args: [BigInt(msg.hwnd), BigInt(WM_TIMER), msg.wParam, BigInt(msg.time)] } };
+    }
+    const window = sessionFor(cpu).station.getWindow(msg.hwnd);
+    if (!window) return { rax: 0n };
+    return sendMessage(context, window, msg.message, msg.wParam, msg.lParam);
+  }
+
+  // Posts the character a key down produced, WM_SYSCHAR for Alt combinations.
+  function translateMessage(cpu) {
+    const msg = readMessage(cpu, arg(cpu, 0));
+    if (msg.message !== WM_KEYDOWN && msg.message !== WM_SYSKEYDOWN) return { rax: 0n };
+    const { station } = sessionFor(cpu);
+    const text = station.input.translate(Number(msg.wParam & 0xffn));
+    if (!text) return { rax: 0n };
+    const message = msg.message === WM_SYSKEYDOWN ? WM_SYSCHAR : WM_CHAR;
+    station.post(msg.hwnd, message, BigInt(text.charCodeAt(0)), msg.lParam);
+    return { rax: 1n };
+  }
+
+  function getWindowLong(window, index) {
+    switch (index) {
+      case GWLP_WNDPROC:
+        return window.wndProc;
+      case GWLP_HINSTANCE:
+        return window.instance;
+      case GWLP_ID:
+        return window.id;
+      case GWL_STYLE:
+        return BigInt(window.style);
+      case GWL_EXSTYLE:
+        return BigInt(window.exStyle);
+      default:
+        return window.longs.get(index) ?? 0n;
+    }
+  }
+
+  function setWindowLong(window, index, value) {
+    const previous = getWindowLong(window, index);
+    switch (index) {
+      case GWLP_WNDPROC:
+        window.wndProc = value;
+        break;
+      case GWLP_HINSTANCE:
+        window.instance = value;
+        break;
+      case GWLP_ID:
+        window.id = value;
+        break;
+      case GWL_STYLE:
+        window.style = uint32(value);
+        break;
+      case GWL_EXSTYLE:
+        window.exStyle = uint32(value);
+        break;
+      default:
+        window.longs.set(index, value);
+    }
+    return previous;
+  }
+
+  function windowLongHandlers(width) {
+    const clamp = (value) => (width === 32 ? BigInt.asUintN(32, value) : value);
+    return {
+      get: withWindow(({ cpu }, window) => ({ rax: clamp(getWindowLong(window, int32(arg(cpu, 1)))) })),
+      set: withWindow(({ cpu }, window) => ({
+        rax: clamp(setWindowLong(window, int32(arg(cpu, 1)), clamp(arg(cpu, 2)))),
+      })),
+    };
+  }
+
+  // fErase in the PAINTSTRUCT tells the guest whether it still has to erase:
+  // only when an erase was owed and WM_ERASEBKGND returned 0.
+  function beginPaint(context, window) {
+    const { cpu } = context;
+    const paint = station(cpu).beginPaint(window);
+    const hdc = BigInt(paint.hdc);
+    const finish = (mustErase) => {
+      const paintStruct = arg(cpu, 1);
+      if (paintStruct) {
+        const { left, top, right, bottom } = paint.rect;
+        cpu.memory.writeUInt(paintStruct, 8, hdc);
+        cpu.memory.writeUInt(paintStruct + 8n, 4, mustErase ? 1n : 0n);
+        writeRect(cpu, paintStruct + 12n, left, top, right, bottom);
+      }
+      return { rax: hdc };
+    };
+    if (!paint.erase) return finish(false);
+    return after(sendMessage(context, window, WM_ERASEBKGND, hdc), (erased) => finish(!erased));
+  }
+
+  // A negative count means the string is NUL-terminated.
+  function drawText(context, wide) {
+    const { cpu } = context;
+    const count = int32(arg(cpu, 2));
+    const rectPtr = arg(cpu, 3);
+    const rect = readRect(cpu, rectPtr);
+    const textPtr = arg(cpu, 1);
+    if (!rect || !textPtr) return { rax: 0n };
+    const text = readCounted(context, textPtr, count < 0 ? MAX_DRAW_TEXT : count, wide);
+    const format = uint32(arg(cpu, 4));
+    const drawn = station(cpu).gdi.drawText(uint32(arg(cpu, 0)), text, rect, format);
+    if (!drawn) return { rax: 0n };
+    if (format & DT_CALCRECT) writeRect(cpu, rectPtr, rect.left, rect.top, drawn.rect.right, drawn.rect.bottom);
+    return { rax: BigInt(drawn.height) };
+  }
+
+  function readCounted(context, pointer, count, wide) {
+    if (!count) return '';
+    const { cpu, readAnsiString, readWideString } = context;
+    return (wide ? readWideString(cpu, pointer, count) : readAnsiString(cpu, pointer, count)).slice(0, count);
+  }
+
+  const defWindowProcFromArgs = (context) => {
+    const { cpu } = context;
+    return defWindowProc(context, uint32(arg(cpu, 0)), uint32(arg(cpu, 1)), arg(cpu, 2), arg(cpu, 3));
+  };
+  const station = (cpu) => sessionFor(cpu).station;
+  const longs = windowLongHandlers(64);
+  const shortLongs = windowLongHandlers(32);
+
+  const handlers = {
+    registerclassa: (context) => registerClass(context, false, false),
+    registerclassw: (context) => registerClass(context, false, true),
+    registerclassexa: (context) => registerClass(context, true, false),
+    registerclassexw: (context) => registerClass(context, true, true),
+    unregisterclassa: (context) => ({
+      rax: station(context.cpu).unregisterClass(readClassName(context, arg(context.cpu, 0), false)) ? 1n : 0n,
+    }),
+    unregisterclassw: (context) => ({
+      rax: station(context.cpu).unregisterClass(readClassName(context, arg(context.cpu, 0), true)) ? 1n : 0n,
+    }),
+    createwindowexa: (context) => createWindow(context, false),
+    createwindowexw: (context) => createWindow(context, true),
+    destroywindow: withWindow((context, window) => destroyWindow(context, window)),
+    iswindow: ({ cpu }) => ({ rax: station(cpu).getWindow(uint32(arg(cpu, 0))) ? 1n : 0n }),
+    showwindow: withWindow((context, window) => showWindow(context, window, int32(arg(context.cpu, 1)))),
+    updatewindow: withWindow((context, window) => {
+      if (!station(context.cpu).queue(window.threadId).isInvalid(window.hwnd)) return { rax: 1n };
+      return after(sendMessage(context, window, WM_PAINT), () => ({ rax: 1n }));
+    }),
+    invalidaterect: ({ cpu }) => ({
+      rax: station(cpu).invalidate(uint32(arg(cpu, 0)), readRect(cpu, arg(cpu, 1)), uint32(arg(cpu, 2)) !== 0) ? 1n : 0n,
+    }),
+    validaterect: ({ cpu }) => ({
+      rax: station(cpu).validate(uint32(arg(cpu, 0)), readRect(cpu, arg(cpu, 1))) ? 1n : 0n,
+    }),
+    beginpaint: withWindow(beginPaint),
+    endpaint: ({ cpu }) => {
+      const paint = arg(cpu, 1);
+      if (paint) station(cpu).gdi.releaseDC(uint32(cpu.memory.readUInt(paint, 8)));
+      return { rax: 1n };
+    },
+    getdc: withWindow(({ cpu }, window) => ({ rax: BigInt(station(cpu).getDC(window)) })),
+    releasedc: ({ cpu }) => ({ rax: station(cpu).gdi.releaseDC(uint32(arg(cpu, 1))) ? 1n : 0n }),
+    fillrect: ({ cpu }) => ({
+      rax: station(cpu).gdi.fillRect(uint32(arg(cpu, 0)), readRect(cpu, arg(cpu, 1)), uint32(arg(cpu, 2))) ? 1n : 0n,
+    }),
+    framerect: ({ cpu }) => ({
+      rax: station(cpu).gdi.frameRect(uint32(arg(cpu, 0)), readRect(cpu, arg(cpu, 1)), uint32(arg(cpu, 2))) ? 1n : 0n,
+    }),
+    drawtexta: (context) => drawText(context, false),
+    drawtextw: (context) => drawText(context, true),
+    getsyscolor: ({ cpu }) => ({ rax: BigInt(systemColor(uint32(arg(cpu, 0)))) }),
+    getsyscolorbrush: ({ cpu }) => ({ rax: BigInt(station(cpu).gdi.sysColorBrush(uint32(arg(cpu, 0)))) }),
+    getclientrect: withWindow(({ cpu }, window) => {
+      writeRect(cpu, arg(cpu, 1), 0, 0, window.width, window.height);
+      return { rax: 1n };
+    }),
+    getwindowrect: withWindow(({ cpu }, window) => {
+      writeRect(cpu, arg(cpu, 1), window.x, window.y, window.x + window.width, window.y + window.height);
+      return { rax: 1n };
+    }),
+    getwindowlongptra: longs.get,
+    getwindowlongptrw: longs.get,
+    setwindowlongptra: longs.set,
+    setwindowlongptrw: longs.set,
+    getwindowlonga: shortLongs.get,
+    getwindowlongw: shortLongs.get,
+    setwindowlonga: shortLongs.set,
+    setwindowlongw: shortLongs.set,
+    setwindowtexta: withWindow((context, window) => sendMessage(context, window, WM_SETTEXT, 0n, arg(context.cpu, 1))),
+    setwindowtextw: withWindow((context, window) => sendMessage(context, window, WM_SETTEXT, 0n, arg(context.cpu, 1))),
+    getwindowtexta: withWindow(getWindowText),
+    getwindowtextw: withWindow(getWindowText),
+    getwindowtextlengtha: withWindow((context, window) => sendMessage(context, window, WM_GETTEXTLENGTH)),
+    getwindowtextlengthw: withWindow((context, window) => sendMessage(context, window, WM_GETTEXTLENGTH)),
+    defwindowproca: (context) => defWindowProcFromArgs(context),
+    defwindowprocw: (context) => defWindowProcFromArgs(context),
+    getmessagea: getMessage,
+    getmessagew: getMessage,
+    peekmessagea: peekMessage,
+    peekmessagew: peekMessage,
+    waitmessage: ({ cpu, enterMessageLoop }) => {
+      const queue = station(cpu).queue();
+      if (!queue.next({}, false)) enterMessageLoop?.();
+      return waitForMessage(queue, INFINITE, 1n, 0n);
+    },
+    msgwaitformultipleobjects: ({ cpu }) =>
+      msgWaitForMultipleObjects(cpu, uint32(arg(cpu, 0)), arg(cpu, 1), uint32(arg(cpu, 3))),
+    msgwaitformultipleobjectsex: ({ cpu }) =>
+      msgWaitForMultipleObjects(cpu, uint32(arg(cpu, 0)), arg(cpu, 1), uint32(arg(cpu, 2))),
+    translatemessage: ({ cpu }) => translateMessage(cpu),
+    getkeystate: ({ cpu }) => ({
+      rax: BigInt.asUintN(64, BigInt(station(cpu).input.getKeyState(uint32(arg(cpu, 0))))),
+    }),
+    getasynckeystate: ({ cpu }) => ({
+      rax: BigInt.asUintN(64, BigInt(station(cpu).input.getAsyncKeyState(uint32(arg(cpu, 0))))),
+    }),
+    setfocus: ({ cpu }) => ({ rax: BigInt(station(cpu).setFocus(uint32(arg(cpu, 0)))) }),
+    getfocus: ({ cpu }) => ({ rax: BigInt(station(cpu).focus) }),
+    setcapture: ({ cpu }) => ({ rax: BigInt(station(cpu).setCapture(uint32(arg(cpu, 0)))) }),
+    releasecapture: ({ cpu }) => {
+      station(cpu).setCapture(0);
+      return { rax: 1n };
+    },
+    getcapture: ({ cpu }) => ({ rax: BigInt(station(cpu).capture) }),
+    dispatchmessagea: dispatchMessage,
+    dispatchmessagew: dispatchMessage,
+    sendmessagea: (context) => sendTo(context),
+    sendmessagew: (context) => sendTo(context),
+    postmessagea: ({ cpu }) => postTo(cpu),
+    postmessagew: ({ cpu }) => postTo(cpu),
+    postthreadmessagea: ({ cpu }) => postToThread(cpu),
+    postthreadmessagew: ({ cpu }) => postToThread(cpu),
+    postquitmessage: ({ cpu }) => {
+      station(cpu).queue().postQuit(int32(arg(cpu, 0)));
+      return { rax: 0n };
+    },
+    settimer: ({ cpu }) => ({
+      rax: BigInt(station(cpu).setTimer(uint32(arg(cpu, 0)), arg(cpu, 1), uint32(arg(cpu, 2)), arg(cpu, 3))),
+    }),
+    killtimer: ({ cpu }) => ({ rax: station(cpu).killTimer(uint32(arg(cpu, 0)), arg(cpu, 1)) ? 1n : 0n }),
+    loadcursora: ({ cpu }) => ({ rax: FAKE_RESOURCE_BASE + (arg(cpu, 1) & 0xffffn) }),
+    loadcursorw: ({ cpu }) => ({ rax: FAKE_RESOURCE_BASE + (arg(cpu, 1) & 0xffffn) }),
+    loadicona: ({ cpu }) => ({ rax: FAKE_RESOURCE_BASE + (arg(cpu, 1) & 0xffffn) }),
+    loadiconw: ({ cpu }) => ({ rax: FAKE_RESOURCE_BASE + (arg(cpu, 1) & 0xffffn) }),
+    setcursor: () => ({ rax: 0n }),
+  };
+
+  function getWindowText(context, window) {
+    const { cpu } = context;
+    return sendMessage(context, window, WM_GETTEXT, BigInt(Math.max(0, int32(arg(cpu, 2)))), arg(cpu, 1));
+  }
+
+  function sendTo(context) {
+    const { cpu } = context;
+    const window = station(cpu).getWindow(uint32(arg(cpu, 0)));
+    if (!window) return { rax: 0n };
+    return sendMessage(context, window, uint32(arg(cpu, 1)), arg(cpu, 2), arg(cpu, 3));
+  }
+
+  function postTo(cpu) {
+    return { rax: station(cpu).post(uint32(arg(cpu, 0)), uint32(arg(cpu, 1)), arg(cpu, 2), arg(cpu, 3)) ? 1n : 0n };
+  }
+
+  function postToThread(cpu) {
+    station(cpu).queue(uint32(arg(cpu, 0))).post(0, uint32(arg(cpu, 1)), arg(cpu, 2), arg(cpu, 3));
+    return { rax: 1n };
+  }
+
+  function resolveHandler(key) {
+    if (!USER32_DLL_REGEX.test(key)) return null;
+    return handlers[key.slice(key.indexOf('!') + 1)] ?? null;
+  }
+
+  return {
+    id: 'user32-messages',
+    match({ name }) {
+      return USER32_DLL_REGEX.test(name ?? '');
+    },
+    resolveHandler,
+    handle(context) {
+      return resolveHandler(String(context.name ?? '').toLowerCase())?.(context);
+    },
+    stationFor(cpu) {
+      return sessionFor(cpu).station;
+    },
+    get station() {
+      return latest?.station ?? null;
+    },
+    reset() {
+      live.forEach((session) => session.station.dispose());
+      live.clear();
+      latest = null;
+    },
+  };
+}
@@ -0,0 +1,87 @@
+const KERNEL_DLL_REGEX = /^kernel(32|base)(\.dll)?!/i;
+const INFINITE = 0xffffffff;
+const WAIT_OBJECT_0 = 0n;
+const WAIT_TIMEOUT = 0x102n;
+
+function readTimeout(cpu, register) {
+  return Number(cpu.readRegister(register) & 0xffffffffn);
+}
+
+// Blocking kernel32 waits return Promises so the guest is parked instead of
+// spinning through its step budget. `waitForObject(handle, { signal })` lets
+// the host signal handles and is told through `signal` when a wait gives up;
+// without it every handle is treated as already signaled. `maxWaitMs` caps
+// every timeout, INFINITE included. `reset()` fails every pending wait, which
+// ends a guest still parked in one.
+export function createWaitImportPlugin({
+  waitForObject,
+  maxWaitMs = Infinity,
+  schedule = (fn, ms) => setTimeout(fn, ms),
+  unschedule = (id) => clearTimeout(id),
+} = {}) {
+  const pending = new Set();
+
+  function delay(ms, value, signal) {
+    const wait = Math.min(ms === INFINITE ? Infinity : ms, maxWaitMs);
+    return new Promise((resolve, reject) => {
+      pending.add(reject);
+      const fire = () => {
+        pending.delete(reject);
+        resolve(value);
+      };
+      const timer = wait === Infinity ? null : schedule(fire, wait);
+      signal?.addEventListener(
+        'abort',
+        () => {
+          pending.delete(reject);
+          if (timer !== null) unschedule(timer);
+        },
+        { once: true },
+      );
+    });
+  }
+
+  function handleSleep({ cpu }) {
+    const ms = readTimeout(cpu, 'rcx');
+    if (ms === 0) return { rax: 0 };
+    return delay(ms, { rax: 0 });
+  }
+
+  function handleWait({ cpu }) {
+    const settled = new AbortController();
+    const signaled = waitForObject?.(cpu.readRegister('rcx'), { signal: settled.signal });
+    if (!signaled) return { rax: WAIT_OBJECT_0 };
+    const ms = readTimeout(cpu, 'rdx');
+    const ready = Promise.resolve(signaled).then(() => ({ rax: WAIT_OBJECT_0 }));
+    if (ms === INFINITE && maxWaitMs === Infinity) return ready;
+    return Promise.race([ready, delay(ms, { rax: WAIT_TIMEOUT }, settled.signal)]).finally(() => settled.abort());
+  }
+
+  const handlers = {
+    sleep: handleSleep,
+    sleepex: handleSleep,
+    waitforsingleobject: handleWait,
+    waitforsingleobjectex: handleWait,
+  };
+
+  function resolveHandler(key) {
+    if (!KERNEL_DLL_REGEX.test(key)) return null;
+    return handlers[key.slice(key.indexOf('!') + 1)] ?? null;
+  }
+
+  return {
+    id: 'kernel32-wait',
+    match({ name }) {
+      return KERNEL_DLL_REGEX.test(name ?? '');
+    },
+    resolveHandler,
+    handle(context) {
+      return resolveHandler(String(context.name ?? '').toLowerCase())?.(context);
+    },
+    reset() {
+      const waits = Array.from(pending);
+      pending.clear();
+      waits.forEach((reject) => reject(new Error('Wait abandoned: guest services were reset.')));
+    },
+  };
+}
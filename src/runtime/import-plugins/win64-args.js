@@ -0,0 +1,17 @@
+// Integer and pointer arguments of a Win64 call, as an import handler sees
+// them at the thunk: the first four in registers, the rest on the stack
+// above the return address and the 32-byte home area.
+export const ARG_REGISTERS = ['rcx', 'rdx', 'r8', 'r9'];
+
+export function arg(cpu, index) {
+  if (index < ARG_REGISTERS.length) return cpu.readRegister(ARG_REGISTERS[index]);
+  return cpu.memory.readUInt(cpu.readRegister('rsp') + 0x28n + BigInt((index - ARG_REGISTERS.length) * 8), 8);
+}
+
+export function int32(value) {
+  return Number(BigInt.asIntN(32, BigInt(value)));
+}
+
+export function uint32(value) {
+  return Number(BigInt(value) & 0xffffffffn);
+}
@@ -1,4 +1,5 @@
 const WINSOCK_DLL_REGEX = /(ws2_32|winsock|wsock32)/i;
+const SOCKET_ERROR = 0xffffffffn;
 
 function parseIPv4Sockaddr(bytes) {
   if (!bytes || bytes.length < 8) return null;
@@ -54,10 +55,13 @@ export function createWinsockWebSocketImportPlugin({
       trafficLogger?.(`[WineJS] Auto-connect disabled. Skipping socket ${socketHandle} → ${target.host}:${target.port}`);
       return { rax: 0 };
     }
-    bridge
-      .openConnection({ connectionId: socketHandle, ...target })
-      .catch((err) => errorLogger?.(`[WineJS] Winsock connect failed: ${err?.message ?? err}`));
-    return { rax: 0 };
+    return bridge.openConnection({ connectionId: socketHandle, ...target }).then(
+      () => ({ rax: 0 }),
+      (err) => {
+        errorLogger?.(`[WineJS] Winsock connect failed: ${err?.message ?? err}`);
+        return { rax: SOCKET_ERROR };
+      },
+    );
   }
 
   function handleSend(context) {
@@ -83,12 +87,20 @@ export function createWinsockWebSocketImportPlugin({
     const bufferPtr = cpu.readRegister('rdx');
     const length = Number(cpu.readRegister('r8') & 0xffffffffn) || 0;
     if (length <= 0) return { rax: 0 };
-    const chunk = bridge.consume(socketHandle, length);
-    if (chunk.length) {
-      cpu.memory.write(bufferPtr, chunk);
+    const deliver = () => {
+      const chunk = bridge.consume(socketHandle, length);
+      if (chunk.length) cpu.memory.write(bufferPtr, chunk);
       return { rax: chunk.length };
-    }
-    return { rax: 0 };
+    };
+    const received = deliver();
+    if (received.rax) return received;
+    // A gracefully closed socket reads as end of stream; one that failed or
+    // was never connected is an error.
+    const ended = () => {
+      const status = bridge.connectionMeta?.get(String(socketHandle))?.status;
+      return { rax: status === 'closed' ? 0 : SOCKET_ERROR };
+    };
+    return bridge.waitForData(socketHandle).then((open) => (open ? deliver() : ended()));
   }
 
   function handleClose(context) {
@@ -101,29 +113,26 @@ export function createWinsockWebSocketImportPlugin({
     return { rax: 0 };
   }
 
+  function resolveHandler(key) {
+    if (!WINSOCK_DLL_REGEX.test(key)) return null;
+    if (key.endsWith('wsastartup') || key.endsWith('wsacleanup') || key.endsWith('socket')) {
+      return () => ({ rax: 0 });
+    }
+    if (key.endsWith('connect')) return handleConnect;
+    if (key.endsWith('send')) return handleSend;
+    if (key.endsWith('recv')) return handleRecv;
+    if (key.endsWith('closesocket')) return handleClose;
+    return null;
+  }
+
   return {
     id: 'winsock-websocket',
     match({ name }) {
       return WINSOCK_DLL_REGEX.test(name ?? '');
     },
+    resolveHandler,
     handle(context) {
-      const lower = String(context.name ?? '').toLowerCase();
-      if (lower.endsWith('wsastartup') || lower.endsWith('wsacleanup') || lower.endsWith('socket')) {
-        return { rax: 0 };
-      }
-      if (lower.endsWith('connect')) {
-        return handleConnect(context);
-      }
-      if (lower.endsWith('send')) {
-        return handleSend(context);
-      }
-      if (lower.endsWith('recv')) {
-        return handleRecv(context);
-      }
-      if (lower.endsWith('closesocket')) {
-        return handleClose(context);
-      }
-      return undefined;
+      return resolveHandler(String(context.name ?? '').toLowerCase())?.(context);
     },
   };
 }
@@ -1,8 +1,21 @@
+import { CMD_CLEAR, CMD_FILL_RECT, CommandBuffer } from '../d2d/command-buffer.js';
+import {
+  INSTANCE_COLOR,
+  INSTANCE_FLOATS,
+  INSTANCE_GEOMETRY,
+  INSTANCE_PARAMS,
+  INSTANCE_ROW0,
+  INSTANCE_ROW1,
+  InstanceBatch,
+} from '../d2d/instance-batch.js';
+
 const DIRECTX_DLL_KEYWORDS = ['d3d', 'direct3d', 'direct2d', 'dxgi', 'dxcore', 'dxva', 'dxguid', 'd2d'];
 
-export function detectDirectXImports(importTrace = []) {
-  if (!Array.isArray(importTrace)) return false;
-  return importTrace.some((entry) => {
+// Accepts the per-import counter table (one row per distinct import) or, for
+// simulators that only report a trace, the trace itself.
+export function detectDirectXImports(importCounts = []) {
+  if (!Array.isArray(importCounts)) return false;
+  return importCounts.some((entry) => {
     const dll = String(entry?.dll ?? entry?.name ?? '').toLowerCase();
     if (!dll) return false;
     return DIRECTX_DLL_KEYWORDS.some((keyword) => dll.includes(keyword));
@@ -10,142 +23,343 @@ export function detectDirectXImports(importTrace = []) {
 }
 
 const VERTEX_SHADER_SOURCE = `
-attribute vec2 aPosition;
-attribute vec3 aColor;
-varying vec3 vColor;
+attribute vec2 aCorner;
+attribute vec4 aGeometry;
+attribute vec4 aColor;
+attribute vec3 aRow0;
+attribute vec3 aRow1;
+attribute vec2 aParams;
+uniform vec2 uResolution;
+varying vec2 vLocal;
+varying vec2 vHalf;
+varying vec4 vColor;
+varying vec2 vParams;
 void main() {
-  gl_Position = vec4(aPosition, 0.0, 1.0);
-  vColor = aColor;
+  float shape = aParams.x;
+  float width = aParams.y;
+  vec2 position;
+  if (shape > 3.5) {
+    vec2 delta = aGeometry.zw - aGeometry.xy;
+    float len = max(length(delta), 0.0001);
+    vec2 along = delta / len;
+    vec2 across = vec2(-along.y, along.x);
+    position = aGeometry.xy + along * (aCorner.x * len) + across * ((aCorner.y - 0.5) * max(width, 1.0));
+    vLocal = vec2(0.0);
+    vHalf = vec2(1.0);
+  } else {
+    bool ellipse = shape > 1.5;
+    bool stroke = (shape > 0.5 && shape < 1.5) || shape > 2.5;
+    vec2 center = ellipse ? aGeometry.xy : (aGeometry.xy + aGeometry.zw) * 0.5;
+    vec2 extent = ellipse ? abs(aGeometry.zw) : abs(aGeometry.zw - aGeometry.xy) * 0.5;
+    vLocal = (aCorner * 2.0 - 1.0) * (extent + vec2(stroke ? width * 0.5 : 0.0));
+    vHalf = extent;
+    position = center + vLocal;
+  }
+  vec2 device = vec2(dot(aRow0, vec3(position, 1.0)), dot(aRow1, vec3(position, 1.0)));
+  vec2 clip = device / uResolution * 2.0 - 1.0;
+  gl_Position = vec4(clip.x, -clip.y, 0.0, 1.0);
+  vColor = vec4(aColor.rgb * aColor.a, aColor.a);
+  vParams = aParams;
 }
 `;
 
 const FRAGMENT_SHADER_SOURCE = `
 precision mediump float;
-varying vec3 vColor;
+varying vec2 vLocal;
+varying vec2 vHalf;
+varying vec4 vColor;
+varying vec2 vParams;
 void main() {
-  gl_FragColor = vec4(vColor, 1.0);
+  float shape = vParams.x;
+  float halfWidth = vParams.y * 0.5;
+  if (shape > 1.5 && shape < 3.5) {
+    bool stroke = shape > 2.5;
+    vec2 outer = max(vHalf + vec2(stroke ? halfWidth : 0.0), vec2(0.0001));
+    if (length(vLocal / outer) > 1.0) discard;
+    vec2 inner = vHalf - vec2(halfWidth);
+    if (stroke && inner.x > 0.0 && inner.y > 0.0 && length(vLocal / inner) < 1.0) discard;
+  } else if (shape > 0.5 && shape < 1.5) {
+    vec2 inner = vHalf - vec2(halfWidth);
+    if (abs(vLocal.x) < inner.x && abs(vLocal.y) < inner.y) discard;
+  }
+  gl_FragColor = vColor;
 }
 `;
 
+// Per-instance attributes: name, float count, offset into the instance.
+const INSTANCE_ATTRIBUTES = [
+  ['aGeometry', 4, INSTANCE_GEOMETRY],
+  ['aColor', 4, INSTANCE_COLOR],
+  ['aRow0', 3, INSTANCE_ROW0],
+  ['aRow1', 3, INSTANCE_ROW1],
+  ['aParams', 2, INSTANCE_PARAMS],
+];
+const INSTANCE_STRIDE = INSTANCE_FLOATS * Float32Array.BYTES_PER_ELEMENT;
+const INITIAL_INSTANCE_CAPACITY = 256;
+const BACKGROUND_BANDS = 4;
+
+// Programs are compiled once per WebGL context and shared by every renderer
+// drawing through it; the last renderer to let go deletes them.
+const pipelines = new WeakMap();
+
+function compileShader(gl, type, source) {
+  const shader = gl.createShader(type);
+  gl.shaderSource(shader, source);
+  gl.compileShader(shader);
+  if (!gl.getShaderParameter(shader, gl.COMPILE_STATUS)) {
+    console.warn('[WineJS] Failed to compile DirectX WebGL shader:', gl.getShaderInfoLog(shader));
+    gl.deleteShader(shader);
+    return null;
+  }
+  return shader;
+}
+
+// WebGL2 draws instanced natively; WebGL1 needs ANGLE_instanced_arrays.
+function instancingFor(gl) {
+  if (typeof gl.drawArraysInstanced === 'function') {
+    return {
+      divisor: (location, divisor) => gl.vertexAttribDivisor(location, divisor),
+      draw: (mode, first, count, instances) => gl.drawArraysInstanced(mode, first, count, instances),
+    };
+  }
+  const ext = gl.getExtension?.('ANGLE_instanced_arrays');
+  if (!ext) return null;
+  return {
+    divisor: (location, divisor) => ext.vertexAttribDivisorANGLE(location, divisor),
+    draw: (mode, first, count, instances) => ext.drawArraysInstancedANGLE(mode, first, count, instances),
+  };
+}
+
+function acquirePipeline(gl) {
+  const existing = pipelines.get(gl);
+  if (existing) {
+    existing.users += 1;
+    return existing;
+  }
+  const instancing = instancingFor(gl);
+  if (!instancing) {
+    console.warn('[WineJS] WebGL instancing is unavailable; DirectX renderer disabled.');
+    return null;
+  }
+  const vertexShader = compileShader(gl, gl.VERTEX_SHADER, VERTEX_SHADER_SOURCE);
+  const fragmentShader = compileShader(gl, gl.FRAGMENT_SHADER, FRAGMENT_SHADER_SOURCE);
+  if (!vertexShader || !fragmentShader) return null;
+  const program = gl.createProgram();
+  gl.attachShader(program, vertexShader);
+  gl.attachShader(program, fragmentShader);
+  gl.linkProgram(program);
+  if (!gl.getProgramParameter(program, gl.LINK_STATUS)) {
+    console.warn('[WineJS] Failed to link DirectX WebGL shader program:', gl.getProgramInfoLog(program));
+    gl.deleteProgram(program);
+    gl.deleteShader(vertexShader);
+    gl.deleteShader(fragmentShader);
+    return null;
+  }
+  const corners = gl.createBuffer();
+  gl.bindBuffer(gl.ARRAY_BUFFER, corners);
+  gl.bufferData(gl.ARRAY_BUFFER, new Float32Array([0, 0, 1, 0, 0, 1, 1, 1]), gl.STATIC_DRAW);
+  const pipeline = {
+    program,
+    vertexShader,
+    fragmentShader,
+    corners,
+    instancing,
+    cornerLocation: gl.getAttribLocation(program, 'aCorner'),
+    resolutionLocation: gl.getUniformLocation(program, 'uResolution'),
+    instanceLocations: INSTANCE_ATTRIBUTES.map(([name, size, offset]) => ({
+      location: gl.getAttribLocation(program, name),
+      size,
+      offset: offset * Float32Array.BYTES_PER_ELEMENT,
+    })),
+    users: 1,
+  };
+  pipelines.set(gl, pipeline);
+  return pipeline;
+}
+
+function releasePipeline(gl, pipeline) {
+  pipeline.users -= 1;
+  if (pipeline.users > 0) return;
+  gl.deleteBuffer(pipeline.corners);
+  gl.deleteProgram(pipeline.program);
+  gl.deleteShader(pipeline.vertexShader);
+  gl.deleteShader(pipeline.fragmentShader);
+  pipelines.delete(gl);
+}
+
+// A 2D batch renderer: replays a Direct2D CommandBuffer as instanced quads
+// (rects, ellipses and lines shaded per fragment) in one draw per scissor
+// run. Each renderer keeps a persistent, growable instance buffer and only
+// re-uploads the span of instances that differ from the previous frame.
+// Renderers given the same canvas share its context and programs.
 export class DirectXWebGLRenderer {
   constructor({ canvas, contextAttributes } = {}) {
     this.canvas = canvas;
     this.contextAttributes = contextAttributes;
     this.gl = null;
-    this.program = null;
-    this.vertexShader = null;
-    this.fragmentShader = null;
+    this.pipeline = null;
     this.buffer = null;
-    this.positionLocation = null;
-    this.colorLocation = null;
-    this.vertexCount = 6;
-    this.stride = Float32Array.BYTES_PER_ELEMENT * 5;
+    this.capacity = 0;
+    this.uploaded = new Float32Array(0);
+    this.uploadedCount = 0;
+    this.lastUpload = null;
+    this.batch = new InstanceBatch();
+    this.viewport = null;
+    this.background = null;
+    this.backgroundKey = null;
   }
 
   ensureContext() {
     if (this.gl) return this.gl;
     if (!this.canvas) return null;
     this.gl =
+      this.canvas.getContext('webgl2', this.contextAttributes) ??
       this.canvas.getContext('webgl', this.contextAttributes) ??
       this.canvas.getContext('experimental-webgl', this.contextAttributes) ??
       null;
     return this.gl;
   }
 
-  render({ importTrace = [] } = {}) {
+  // Draws `commands` into the top-left width x height pixels of the canvas.
+  // Without commands it draws the import-trace palette as a backdrop.
+  render({ commands = null, width, height, importTrace = [] } = {}) {
     const gl = this.ensureContext();
     if (!gl) return false;
-    if (!this.program && !this.setupPipeline()) {
+    if (!this.pipeline && !this.setupPipeline()) {
       return false;
     }
-    this.resizeViewport();
-    this.uploadGradient(importTrace);
-    gl.clearColor(0.02, 0.02, 0.06, 1);
-    gl.clear(gl.COLOR_BUFFER_BIT);
-    gl.useProgram(this.program);
-    gl.bindBuffer(gl.ARRAY_BUFFER, this.buffer);
-    gl.vertexAttribPointer(this.positionLocation, 2, gl.FLOAT, false, this.stride, 0);
-    gl.vertexAttribPointer(
-      this.colorLocation,
-      3,
-      gl.FLOAT,
-      false,
-      this.stride,
-      Float32Array.BYTES_PER_ELEMENT * 2,
-    );
-    gl.drawArrays(gl.TRIANGLES, 0, this.vertexCount);
+    const frame = commands ?? this.backgroundCommands(importTrace);
+    const size = this.resizeViewport(width, height);
+    this.batch.encode(frame, size);
+    this.upload(this.batch);
+    this.drawSteps(size);
     return true;
   }
 
-  resizeViewport() {
+  resizeViewport(width, height) {
     const gl = this.gl;
-    const width = this.canvas.clientWidth || this.canvas.width || 1;
-    const height = this.canvas.clientHeight || this.canvas.height || 1;
-    if (this.canvas.width !== width) this.canvas.width = width;
-    if (this.canvas.height !== height) this.canvas.height = height;
-    gl.viewport(0, 0, this.canvas.width, this.canvas.height);
+    const targetWidth = Math.max(1, Math.round(width ?? (this.canvas.clientWidth || this.canvas.width || 1)));
+    const targetHeight = Math.max(1, Math.round(height ?? (this.canvas.clientHeight || this.canvas.height || 1)));
+    if (this.canvas.width < targetWidth) this.canvas.width = targetWidth;
+    if (this.canvas.height < targetHeight) this.canvas.height = targetHeight;
+    const y = this.canvas.height - targetHeight;
+    const viewport = this.viewport;
+    if (!viewport || viewport.width !== targetWidth || viewport.height !== targetHeight || viewport.y !== y) {
+      gl.viewport(0, y, targetWidth, targetHeight);
+      this.viewport = { width: targetWidth, height: targetHeight, y };
+    }
+    return { width: targetWidth, height: targetHeight };
   }
 
   setupPipeline() {
     const gl = this.gl;
-    const vertexShader = this.compileShader(gl.VERTEX_SHADER, VERTEX_SHADER_SOURCE);
-    const fragmentShader = this.compileShader(gl.FRAGMENT_SHADER, FRAGMENT_SHADER_SOURCE);
-    if (!vertexShader || !fragmentShader) return false;
-    const program = gl.createProgram();
-    gl.attachShader(program, vertexShader);
-    gl.attachShader(program, fragmentShader);
-    gl.linkProgram(program);
-    if (!gl.getProgramParameter(program, gl.LINK_STATUS)) {
-      console.warn('[WineJS] Failed to link DirectX WebGL shader program:', gl.getProgramInfoLog(program));
-      gl.deleteProgram(program);
-      gl.deleteShader(vertexShader);
-      gl.deleteShader(fragmentShader);
-      return false;
-    }
-    this.program = program;
-    this.vertexShader = vertexShader;
-    this.fragmentShader = fragmentShader;
-    this.positionLocation = gl.getAttribLocation(program, 'aPosition');
-    this.colorLocation = gl.getAttribLocation(program, 'aColor');
+    this.pipeline = acquirePipeline(gl);
+    if (!this.pipeline) return false;
     this.buffer = gl.createBuffer();
-    gl.bindBuffer(gl.ARRAY_BUFFER, this.buffer);
-    gl.enableVertexAttribArray(this.positionLocation);
-    gl.enableVertexAttribArray(this.colorLocation);
     return true;
   }
 
-  compileShader(type, source) {
+  // Grows the GPU buffer geometrically; otherwise uploads only the range of
+  // floats that changed since the last frame, so a mostly static scene (a
+  // clock face, Pong's court) costs a few bufferSubData bytes per frame.
+  upload(batch) {
     const gl = this.gl;
-    const shader = gl.createShader(type);
-    gl.shaderSource(shader, source);
-    gl.compileShader(shader);
-    if (!gl.getShaderParameter(shader, gl.COMPILE_STATUS)) {
-      console.warn('[WineJS] Failed to compile DirectX WebGL shader:', gl.getShaderInfoLog(shader));
-      gl.deleteShader(shader);
-      return null;
+    const floats = batch.count * INSTANCE_FLOATS;
+    const data = batch.data;
+    gl.bindBuffer(gl.ARRAY_BUFFER, this.buffer);
+    if (floats > this.capacity) {
+      this.capacity = Math.max(floats, this.capacity * 2, INITIAL_INSTANCE_CAPACITY * INSTANCE_FLOATS);
+      gl.bufferData(gl.ARRAY_BUFFER, this.capacity * Float32Array.BYTES_PER_ELEMENT, gl.DYNAMIC_DRAW);
+      const uploaded = new Float32Array(this.capacity);
+      uploaded.set(data.subarray(0, floats));
+      this.uploaded = uploaded;
+      gl.bufferSubData(gl.ARRAY_BUFFER, 0, data.subarray(0, floats));
+      this.uploadedCount = batch.count;
+      this.lastUpload = { offset: 0, length: floats };
+      return;
+    }
+    const uploaded = this.uploaded;
+    let first = 0;
+    while (first < floats && uploaded[first] === data[first]) first++;
+    let last = floats;
+    while (last > first && uploaded[last - 1] === data[last - 1]) last--;
+    this.uploadedCount = batch.count;
+    if (first === last) {
+      this.lastUpload = null;
+      return;
     }
-    return shader;
+    uploaded.set(data.subarray(first, last), first);
+    gl.bufferSubData(gl.ARRAY_BUFFER, first * Float32Array.BYTES_PER_ELEMENT, data.subarray(first, last));
+    this.lastUpload = { offset: first, length: last - first };
   }
 
-  uploadGradient(importTrace) {
+  bindInstances(first) {
     const gl = this.gl;
-    const palette = this.createPalette(importTrace);
-    const vertices = new Float32Array([
-      -1, -1, ...palette[0],
-      1, -1, ...palette[1],
-      -1, 1, ...palette[2],
-      -1, 1, ...palette[2],
-      1, -1, ...palette[1],
-      1, 1, ...palette[3],
-    ]);
+    const base = first * INSTANCE_STRIDE;
     gl.bindBuffer(gl.ARRAY_BUFFER, this.buffer);
-    gl.bufferData(gl.ARRAY_BUFFER, vertices, gl.STATIC_DRAW);
+    this.pipeline.instanceLocations.forEach(({ location, size, offset }) => {
+      if (location < 0) return;
+      gl.enableVertexAttribArray(location);
+      gl.vertexAttribPointer(location, size, gl.FLOAT, false, INSTANCE_STRIDE, base + offset);
+      this.pipeline.instancing.divisor(location, 1);
+    });
+  }
+
+  drawSteps({ width, height }) {
+    const gl = this.gl;
+    const { program, corners, cornerLocation, resolutionLocation, instancing } = this.pipeline;
+    gl.useProgram(program);
+    gl.uniform2f(resolutionLocation, width, height);
+    gl.bindBuffer(gl.ARRAY_BUFFER, corners);
+    gl.enableVertexAttribArray(cornerLocation);
+    gl.vertexAttribPointer(cornerLocation, 2, gl.FLOAT, false, 0, 0);
+    instancing.divisor(cornerLocation, 0);
+    gl.enable(gl.BLEND);
+    gl.blendFunc(gl.ONE, gl.ONE_MINUS_SRC_ALPHA);
+    gl.enable(gl.SCISSOR_TEST);
+    const canvasHeight = this.canvas.height;
+    gl.scissor(0, canvasHeight - height, width, height);
+    gl.clearColor(0, 0, 0, 0);
+    gl.clear(gl.COLOR_BUFFER_BIT);
+    this.batch.steps.forEach((step) => {
+      const { left, top, right, bottom } = step.scissor;
+      gl.scissor(left, canvasHeight - bottom, right - left, bottom - top);
+      if (step.clear) {
+        const [r, g, b, a] = step.clear;
+        gl.clearColor(r * a, g * a, b * a, a);
+        gl.clear(gl.COLOR_BUFFER_BIT);
+        return;
+      }
+      this.bindInstances(step.first);
+      instancing.draw(gl.TRIANGLE_STRIP, 0, 4, step.count);
+    });
+    gl.disable(gl.SCISSOR_TEST);
+  }
+
+  // The mirror backdrop for DirectX apps whose calls are not emulated: a dark
+  // clear and a band per leading import, colored from its name.
+  backgroundCommands(importTrace = []) {
+    const palette = this.createPalette(importTrace);
+    const key = palette.join('|');
+    if (this.background && this.backgroundKey === key) return this.background;
+    const width = this.canvas.clientWidth || this.canvas.width || 1;
+    const height = this.canvas.clientHeight || this.canvas.height || 1;
+    const commands = this.background ?? new CommandBuffer(64);
+    commands.reset();
+    commands.push(CMD_CLEAR, 0.02, 0.02, 0.06, 1);
+    palette.forEach((color, index) => {
+      const top = (height * index) / BACKGROUND_BANDS;
+      commands.push(CMD_FILL_RECT, 0, top, width, top + height / BACKGROUND_BANDS, ...color, 1);
+    });
+    this.background = commands;
+    this.backgroundKey = key;
+    return commands;
   }
 
   createPalette(importTrace = []) {
     const labels = importTrace.map((entry) => entry?.name || entry?.dll || '').filter(Boolean);
     const palette = [];
-    for (let i = 0; i < 4; i++) {
+    for (let i = 0; i < BACKGROUND_BANDS; i++) {
       const label = labels[i] || `directx-${i}`;
       palette.push(this.colorFromText(label));
     }
@@ -167,16 +381,57 @@ export class DirectXWebGLRenderer {
     const gl = this.gl;
     if (!gl) return;
     if (this.buffer) gl.deleteBuffer(this.buffer);
-    if (this.program) gl.deleteProgram(this.program);
-    if (this.vertexShader) gl.deleteShader(this.vertexShader);
-    if (this.fragmentShader) gl.deleteShader(this.fragmentShader);
+    if (this.pipeline) releasePipeline(gl, this.pipeline);
     this.buffer = null;
-    this.program = null;
-    this.vertexShader = null;
-    this.fragmentShader = null;
+    this.pipeline = null;
+    this.capacity = 0;
+    this.uploaded = new Float32Array(0);
+    this.viewport = null;
   }
 }
 
+function defaultCreateCanvas() {
+  return typeof OffscreenCanvas === 'function' ? new OffscreenCanvas(1, 1) : null;
+}
+
+// Presents Direct2D frames through one WebGL context on an offscreen canvas
+// shared by every render target, then copies each result into the target's
+// window canvas. Window canvases stay 2D, so GDI and Direct2D can share them.
+// `present` returns false when WebGL is unavailable and the caller should
+// fall back to Canvas 2D replay.
+export function createWebGLPresenter({ createCanvas = defaultCreateCanvas, contextAttributes } = {}) {
+  let canvas;
+  const renderers = new Map();
+
+  function rendererFor(target) {
+    let renderer = renderers.get(target);
+    if (renderer) return renderer;
+    if (canvas === undefined) canvas = createCanvas() ?? null;
+    if (!canvas) return null;
+    renderer = new DirectXWebGLRenderer({ canvas, contextAttributes });
+    renderers.set(target, renderer);
+    return renderer;
+  }
+
+  return {
+    present(target, commands, context, { originX = 0, originY = 0, width, height }) {
+      if (!width || !height) return false;
+      const renderer = rendererFor(target);
+      if (!renderer?.render({ commands, width, height })) return false;
+      context.drawImage(canvas, 0, 0, width, height, originX, originY, width, height);
+      return true;
+    },
+    release(target) {
+      renderers.get(target)?.dispose();
+      renderers.delete(target);
+    },
+    dispose() {
+      renderers.forEach((renderer) => renderer.dispose());
+      renderers.clear();
+    },
+  };
+}
+
 export function createDirectXWebGLPlugin({
   detectDirectX = detectDirectXImports,
   rendererFactory,
@@ -201,11 +456,11 @@ export function createDirectXWebGLPlugin({
       disposeRenderers();
     },
     onAfterSimulate({ wine, simulation }) {
-      if (!detectDirectX(simulation?.importTrace)) return;
+      if (!detectDirectX(simulation?.importCounts ?? simulation?.importTrace)) return;
       wine.log?.('[WineJS] DirectX imports detected — streaming drawing calls into WebGL.');
     },
     onGuiIntent({ wine, hwnd, simulation }) {
-      if (!detectDirectX(simulation?.importTrace)) return;
+      if (!detectDirectX(simulation?.importCounts ?? simulation?.importTrace)) return;
       const windowInfo = wine.windowManager?.getWindow?.(hwnd);
       if (!windowInfo?.canvas) return;
       wine.windowManager?.markAsExternallyRendered?.(hwnd);
@@ -214,7 +469,8 @@ export function createDirectXWebGLPlugin({
       if (!renderer) return;
       renderers.set(hwnd, renderer);
       renderer.render?.({ importTrace: simulation?.importTrace ?? [] });
-      windowInfo.canvas.dataset.directxBridge = 'webgl';
+      wine.windowManager?.damage?.(hwnd);
+      (windowInfo.element ?? windowInfo.canvas).dataset.directxBridge = 'webgl';
     },
   };
 }
@@ -0,0 +1,117 @@
+const defaultHostNow = () => performance.now();
+
+// Guest-visible time source. Virtual milliseconds start at zero per run and
+// advance with host time. In fast-forward mode, whenever the host event loop
+// gets control (which only happens while the guest is parked in a wait)
+// time jumps straight to the earliest pending deadline, so idle waits cost
+// nothing and a long timer-driven session takes only its compute time.
+export class VirtualClock {
+  constructor({
+    fastForward = false,
+    epochMs = Date.now(),
+    hostNow = defaultHostNow,
+    hostSetTimeout = (fn, ms) => setTimeout(fn, ms),
+    hostClearTimeout = (id) => clearTimeout(id),
+  } = {}) {
+    this.hostNow = hostNow;
+    this.hostSetTimeout = hostSetTimeout;
+    this.hostClearTimeout = hostClearTimeout;
+    this.timers = new Map();
+    this.nextTimerId = 1;
+    this.armed = null;
+    this.tick = () => this.fireDue();
+    this.reset({ fastForward, epochMs });
+  }
+
+  reset({ fastForward = this.fastForward, epochMs = Date.now() } = {}) {
+    this.timers.clear();
+    this.disarm();
+    this.fastForward = fastForward;
+    this.epochMs = epochMs;
+    this.origin = this.hostNow();
+    this.skipped = 0;
+  }
+
+  now() {
+    return this.hostNow() - this.origin + this.skipped;
+  }
+
+  // Wall-clock milliseconds since the Unix epoch, for FILETIME and friends.
+  wallTime() {
+    return this.epochMs + this.now();
+  }
+
+  setTimeout(fn, ms) {
+    return this.addTimer(fn, ms, 0);
+  }
+
+  setInterval(fn, ms) {
+    return this.addTimer(fn, ms, Math.max(1, ms));
+  }
+
+  clearTimeout(id) {
+    if (this.timers.delete(id) && !this.timers.size) this.disarm();
+  }
+
+  clearInterval(id) {
+    this.clearTimeout(id);
+  }
+
+  sleep(ms) {
+    return new Promise((resolve) => this.setTimeout(resolve, ms));
+  }
+
+  addTimer(fn, ms, period) {
+    const id = this.nextTimerId++;
+    this.timers.set(id, { fn, deadline: this.now() + Math.max(0, ms), period });
+    this.arm();
+    return id;
+  }
+
+  nextDeadline() {
+    let next = Infinity;
+    this.timers.forEach(({ deadline }) => {
+      if (deadline < next) next = deadline;
+    });
+    return next;
+  }
+
+  arm() {
+    this.disarm();
+    if (!this.timers.size) return;
+    const delay = this.fastForward ? 0 : Math.max(0, this.nextDeadline() - this.now());
+    this.armed = this.hostSetTimeout(this.tick, delay);
+  }
+
+  disarm() {
+    if (this.armed === null) return;
+    this.hostClearTimeout(this.armed);
+    this.armed = null;
+  }
+
+  // Periodic timers that fell behind fire once and re-arm from now, the way
+  // coalesced WM_TIMERs behave.
+  fireDue() {
+    this.armed = null;
+    if (this.fastForward) {
+      const next = this.nextDeadline();
+      const now = this.now();
+      if (next > now && next !== Infinity) this.skipped += next - now;
+    }
+    const now = this.now();
+    const due = Array.from(this.timers.entries())
+      .filter(([, timer]) => timer.deadline <= now)
+      .sort(([, a], [, b]) => a.deadline - b.deadline);
+    due.forEach(([id, timer]) => {
+      if (this.timers.get(id) !== timer) return;
+      if (timer.period) {
+        const next = timer.deadline + timer.period;
+        timer.deadline = next > now ? next : now + timer.period;
+      } else {
+        this.timers.delete(id);
+      }
+      timer.fn();
+    });
+    this.arm();
+  }
+}
@@ -1,5 +1,9 @@
 import { bytesToBase64, base64ToBytes } from '../utils/base64-buffer.js';
 
+// Statuses a connection can still receive data in; 'unknown' is a connection
+// the backend reported data for before the open was acknowledged.
+const LIVE_STATUSES = new Set(['opening', 'open', 'unknown']);
+
 export class WinsockBridge {
   constructor({ bridge, log } = {}) {
     this.bridge = null;
@@ -15,6 +19,11 @@ export class WinsockBridge {
 
   setBridge(bridge) {
     this.cleanup();
+    this.connectionMeta.forEach((meta, id) => {
+      if (!LIVE_STATUSES.has(meta.status)) return;
+      meta.status = 'closed';
+      this.emit('closed', { connectionId: id, meta });
+    });
     this.bridge = bridge ?? null;
     this.buffers.clear();
     this.connectionMeta.clear();
@@ -179,6 +188,31 @@ export class WinsockBridge {
     return result;
   }
 
+  isOpen(connectionId) {
+    const status = this.connectionMeta.get(String(connectionId))?.status;
+    return Boolean(this.bridge?.isConnected?.()) && LIVE_STATUSES.has(status);
+  }
+
+  // Resolves true once the connection has queued data, false if it closes or
+  // errors first or was never open to begin with.
+  waitForData(connectionId) {
+    const id = String(connectionId);
+    if (this.buffers.get(id)?.length) return Promise.resolve(true);
+    if (!this.isOpen(id)) return Promise.resolve(false);
+    return new Promise((resolve) => {
+      const unsubscribe = [];
+      const settle = (value) => {
+        unsubscribe.forEach((fn) => fn());
+        resolve(value);
+      };
+      unsubscribe.push(
+        this.subscribe('data', (event) => event.connectionId === id && settle(true)),
+        this.subscribe('closed', (event) => event.connectionId === id && settle(false)),
+        this.subscribe('error', (event) => String(event?.connectionId) === id && settle(false)),
+      );
+    });
+  }
+
   touchMeta(connectionId, delta = {}) {
     if (!connectionId) return null;
     const id = String(connectionId);
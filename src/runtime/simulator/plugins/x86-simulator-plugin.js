@@ -11,10 +11,10 @@ export function createX86SimulatorPlugin({ getSimulatorClass, globalKey = 'WineX
   return {
     id: 'x86-simulator',
     match: () => true,
-    createSimulator({ buffer }) {
+    createSimulator({ buffer, options }) {
       const Simulator = resolver();
       if (!Simulator) return null;
-      return new Simulator(buffer);
+      return new Simulator(buffer, options);
     },
   };
 }
@@ -1,8 +1,10 @@
 import { decodeBase64Executable } from '../base64.js';
+import { countImports } from '../../emulator/import-trace.js';
 
 export class SimulatorBridge {
-  constructor({ importHandler }) {
+  constructor({ importHandler, importBinder }) {
     this.importHandler = importHandler;
+    this.importBinder = importBinder;
     this.plugins = [];
   }
 
@@ -24,6 +26,51 @@ export class SimulatorBridge {
     return null;
   }
 
+  // With `interactive`, import handlers get `enterMessageLoop`, which a
+  // blocking message wait calls just before the guest parks; `parked`
+  // resolves the first time it does. A guest pumping messages is a GUI one
+  // even though the parked call has not been traced yet.
+  createRunContext({ interactive = false } = {}) {
+    const consoleLines = [];
+    let guiIntent = false;
+    const flagGui = () => {
+      guiIntent = true;
+    };
+    let enterMessageLoop;
+    const parked = interactive
+      ? new Promise((resolve) => {
+          enterMessageLoop = () => {
+            guiIntent = true;
+            resolve();
+          };
+        })
+      : null;
+    const state = { consoleLines, flagGui, enterMessageLoop };
+    const hooks = {
+      handleImport: (name, cpu) => this.importHandler({ name, cpu, ...state }),
+      bindImport: this.importBinder ? (name) => this.importBinder(name, state) : undefined,
+    };
+    return {
+      hooks,
+      parked,
+      finish: (simulator, result) => {
+        const importTrace = result.imports ?? [];
+        const importCounts = result.importCounts ?? countImports(importTrace);
+        return {
+          consoleLines,
+          guiIntent: guiIntent || importCounts.some((counter) => counter.dll?.includes('user32')),
+          importTrace,
+          importCounts,
+          importCalls: result.importCalls ?? importTrace.length,
+          suspended: Boolean(result.suspended),
+          steps: result.steps ?? null,
+          exitReason: result.exitReason ?? null,
+          cacheRecord: this.exportCacheRecord(simulator),
+        };
+      },
+    };
+  }
+
   simulateBinary(buffer, options = {}) {
     const created = this.createSimulator(buffer, options);
     if (!created) {
@@ -31,30 +78,44 @@ export class SimulatorBridge {
     }
     const { simulator } = created;
     try {
-      const consoleLines = [];
-      let guiIntent = false;
-      const hooks = {
-        handleImport: (name, cpu, context) =>
-          this.importHandler({
-            name,
-            cpu,
-            consoleLines,
-            flagGui: () => {
-              guiIntent = true;
-            },
-          }),
-      };
-      const result = simulator.run({ hooks });
-      if (!guiIntent) {
-        guiIntent = result.imports?.some((imp) => imp.dll?.includes('user32')) ?? false;
-      }
-      return {
-        consoleLines,
-        guiIntent,
-        importTrace: result.imports ?? [],
-      };
+      const { hooks, finish } = this.createRunContext();
+      return finish(simulator, simulator.run({ hooks, maxSteps: options.maxSteps }));
     } catch (err) {
-      return { error: err?.message ?? String(err) };
+      return { error: err?.message ?? String(err), cacheRecord: this.exportCacheRecord(simulator) };
+    }
+  }
+
+  async simulateBinaryAsync(buffer, options = {}) {
+    const created = this.createSimulator(buffer, options);
+    if (!created) {
+      return { error: this.describeMissingSimulator() };
+    }
+    const { simulator } = created;
+    const failed = (err) => ({ error: err?.message ?? String(err), cacheRecord: this.exportCacheRecord(simulator) });
+    try {
+      const { hooks, finish, parked } = this.createRunContext({ interactive: options.interactive });
+      const { maxSteps } = options;
+      if (!simulator.runAsync) return finish(simulator, simulator.run({ hooks, maxSteps }));
+      const running = simulator.runAsync({ hooks, maxSteps });
+      if (!parked) return finish(simulator, await running);
+      // A guest that reaches its message loop waits for input that only
+      // arrives once the run has been presented, so the result is reported
+      // then and the rest of the run is handed back as `session`.
+      const session = running.then((result) => finish(simulator, result), failed);
+      const ended = await Promise.race([session, parked.then(() => null)]);
+      if (ended) return ended;
+      const result = simulator.interact?.() ?? { exitReason: 'message-loop' };
+      return { ...finish(simulator, result), interactive: true, session };
+    } catch (err) {
+      return failed(err);
+    }
+  }
+
+  exportCacheRecord(simulator) {
+    try {
+      return simulator.exportCacheRecord?.() ?? null;
+    } catch {
+      return null;
     }
   }
 
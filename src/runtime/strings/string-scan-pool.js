@@ -0,0 +1,129 @@
+import { scanStringsInRange, createSectionLocator, DEFAULT_MIN_LENGTH } from './string-scanner.js';
+
+const CHUNK_SIZE = 1 << 20;
+const CHUNK_LEAD = 4;
+const MAX_WORKERS = 4;
+
+function defaultWorkerCount() {
+  const cores = typeof navigator !== 'undefined' ? navigator.hardwareConcurrency : 0;
+  return Math.max(1, Math.min(MAX_WORKERS, (cores || 2) - 1));
+}
+
+function defaultCreateWorker() {
+  if (typeof Worker === 'undefined') return null;
+  return new Worker(new URL('./string-scanner.worker.js', import.meta.url), { type: 'module' });
+}
+
+function yieldToEventLoop() {
+  return new Promise((resolve) => setTimeout(resolve, 0));
+}
+
+export class StringScanPool {
+  constructor({ workerCount = defaultWorkerCount(), createWorker = defaultCreateWorker, chunkSize = CHUNK_SIZE } = {}) {
+    this.workerCount = workerCount;
+    this.createWorker = createWorker;
+    this.chunkSize = chunkSize;
+    this.workers = null;
+    this.nextJobId = 0;
+    this.pending = new Map();
+  }
+
+  ensureWorkers() {
+    if (this.workers) return this.workers;
+    this.workers = [];
+    for (let i = 0; i < this.workerCount; i++) {
+      const worker = this.createWorker();
+      if (!worker) break;
+      worker.onmessage = ({ data }) => {
+        const job = this.pending.get(data.id);
+        this.pending.delete(data.id);
+        job?.resolve(data.strings);
+      };
+      worker.onerror = (event) => {
+        this.pending.forEach((job) => job.reject(new Error(event?.message ?? 'String scanner worker failed.')));
+        this.pending.clear();
+      };
+      this.workers.push(worker);
+    }
+    return this.workers;
+  }
+
+  // Each chunk ships with a few lead bytes so the worker can tell whether a
+  // run started in the previous chunk; runs that reach the end of the copy
+  // are finished on this thread against the full buffer.
+  runOnWorker(worker, buffer, start, end, options) {
+    const sliceStart = Math.max(0, start - CHUNK_LEAD);
+    const sliceEnd = Math.min(buffer.length, end + this.chunkSize / 16);
+    const bytes = buffer.slice(sliceStart, sliceEnd);
+    const id = this.nextJobId++;
+    return new Promise((resolve, reject) => {
+      this.pending.set(id, { resolve, reject });
+      worker.postMessage(
+        { id, bytes, start: start - sliceStart, end: end - sliceStart, options: { ...options, baseOffset: sliceStart } },
+        [bytes.buffer],
+      );
+    }).then((strings) => {
+      if (sliceEnd === buffer.length) return strings;
+      return strings.map((entry) =>
+        entry.offset + entry.length < sliceEnd - 1 ? entry : this.finishRun(buffer, entry, options),
+      );
+    });
+  }
+
+  finishRun(buffer, entry, options) {
+    const [finished] = scanStringsInRange(buffer, entry.offset, entry.offset + 1, {
+      ...options,
+      utf16: entry.encoding !== 'ascii',
+    }).filter((candidate) => candidate.offset === entry.offset && candidate.encoding === entry.encoding);
+    return finished ?? entry;
+  }
+
+  async scan(buffer, { minLength = DEFAULT_MIN_LENGTH, utf16 = true, sections, onStrings, isCancelled } = {}) {
+    const options = { minLength, utf16 };
+    const locate = createSectionLocator(sections);
+    const chunkCount = Math.max(1, Math.ceil(buffer.length / this.chunkSize));
+    const results = new Array(chunkCount);
+    const all = [];
+    let flushed = 0;
+    const flush = () => {
+      while (flushed < chunkCount && results[flushed]) {
+        const batch = results[flushed];
+        results[flushed++] = null;
+        batch.forEach((entry) => {
+          entry.section = locate(entry.offset);
+        });
+        all.push(...batch);
+        if (batch.length && !isCancelled?.()) onStrings?.(batch);
+      }
+    };
+
+    const workers = this.ensureWorkers();
+    if (!workers.length) {
+      for (let index = 0; index < chunkCount && !isCancelled?.(); index++) {
+        const start = index * this.chunkSize;
+        results[index] = scanStringsInRange(buffer, start, Math.min(buffer.length, start + this.chunkSize), options);
+        flush();
+        if (index + 1 < chunkCount) await yieldToEventLoop();
+      }
+      return all;
+    }
+
+    let nextChunk = 0;
+    const drain = async (worker) => {
+      while (nextChunk < chunkCount && !isCancelled?.()) {
+        const index = nextChunk++;
+        const start = index * this.chunkSize;
+        results[index] = await this.runOnWorker(worker, buffer, start, Math.min(buffer.length, start + this.chunkSize), options);
+        flush();
+      }
+    };
+    await Promise.all(workers.map(drain));
+    return all;
+  }
+
+  dispose() {
+    this.workers?.forEach((worker) => worker.terminate());
+    this.workers = null;
+    this.pending.clear();
+  }
+}
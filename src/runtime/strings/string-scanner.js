@@ -0,0 +1,156 @@
+const ASCII_CLASS = new Uint8Array(256);
+for (let byte = 32; byte <= 126; byte++) ASCII_CLASS[byte] = 1;
+ASCII_CLASS[10] = 1;
+ASCII_CLASS[13] = 1;
+
+// 16-bit lookup tables so one 32-bit word is classified with two loads:
+// PAIR_CLASS sets a bit per printable byte, WIDE_CLASS flags a printable
+// UTF-16LE code unit (printable low byte, zero high byte).
+const PAIR_CLASS = new Uint8Array(0x10000);
+const WIDE_CLASS = new Uint8Array(0x10000);
+for (let value = 0; value < 0x10000; value++) {
+  PAIR_CLASS[value] = ASCII_CLASS[value & 0xff] | (ASCII_CLASS[value >>> 8] << 1);
+  WIDE_CLASS[value] = value >>> 8 ? 0 : ASCII_CLASS[value];
+}
+
+const asciiDecoder = new TextDecoder('latin1');
+const wideDecoder = new TextDecoder('utf-16le');
+
+export const DEFAULT_MIN_LENGTH = 4;
+
+function wordView(bytes) {
+  return bytes.byteOffset % 4 === 0 ? new Uint32Array(bytes.buffer, bytes.byteOffset, bytes.length >>> 2) : null;
+}
+
+function scanAscii(bytes, words, start, end, minLength, emit) {
+  const length = bytes.length;
+  let i = start;
+  if (i > 0 && ASCII_CLASS[bytes[i - 1]]) {
+    while (i < length && ASCII_CLASS[bytes[i]]) i++;
+  }
+  let runStart = -1;
+  while (i < length && (runStart >= 0 || i < end)) {
+    if (words && (i & 3) === 0 && i + 4 <= length) {
+      const word = words[i >>> 2];
+      const mask = PAIR_CLASS[word & 0xffff] | (PAIR_CLASS[word >>> 16] << 2);
+      if (mask === 0xf) {
+        if (runStart < 0) runStart = i;
+        i += 4;
+        continue;
+      }
+      if (mask === 0) {
+        if (runStart >= 0) {
+          if (i - runStart >= minLength) emit(runStart, i);
+          runStart = -1;
+        }
+        i += 4;
+        continue;
+      }
+    }
+    if (ASCII_CLASS[bytes[i]]) {
+      if (runStart < 0) runStart = i;
+    } else if (runStart >= 0) {
+      if (i - runStart >= minLength) emit(runStart, i);
+      runStart = -1;
+    }
+    i++;
+  }
+  if (runStart >= 0 && i - runStart >= minLength) emit(runStart, i);
+}
+
+function scanWide(bytes, words, start, end, minLength, emit) {
+  const length = bytes.length - 1;
+  const unit = (index) => bytes[index] | (bytes[index + 1] << 8);
+  let i = start + (start & 1);
+  if (i >= 2 && WIDE_CLASS[unit(i - 2)]) {
+    while (i < length && WIDE_CLASS[unit(i)]) i += 2;
+  }
+  const minBytes = minLength * 2;
+  let runStart = -1;
+  while (i < length && (runStart >= 0 || i < end)) {
+    if (words && (i & 3) === 0 && i + 4 <= bytes.length) {
+      const word = words[i >>> 2];
+      const mask = WIDE_CLASS[word & 0xffff] | (WIDE_CLASS[word >>> 16] << 1);
+      if (mask === 3) {
+        if (runStart < 0) runStart = i;
+        i += 4;
+        continue;
+      }
+      if (mask === 0) {
+        if (runStart >= 0) {
+          if (i - runStart >= minBytes) emit(runStart, i);
+          runStart = -1;
+        }
+        i += 4;
+        continue;
+      }
+    }
+    if (WIDE_CLASS[unit(i)]) {
+      if (runStart < 0) runStart = i;
+    } else if (runStart >= 0) {
+      if (i - runStart >= minBytes) emit(runStart, i);
+      runStart = -1;
+    }
+    i += 2;
+  }
+  if (runStart >= 0 && i - runStart >= minBytes) emit(runStart, i);
+}
+
+// Scans runs that start inside [start, end); runs that began before start
+// belong to the previous range and runs crossing end are followed to their
+// natural end. Offsets are reported relative to baseOffset.
+export function scanStringsInRange(
+  bytes,
+  start = 0,
+  end = bytes.length,
+  { minLength = DEFAULT_MIN_LENGTH, utf16 = true, baseOffset = 0 } = {},
+) {
+  const words = wordView(bytes);
+  const strings = [];
+  scanAscii(bytes, words, start, end, minLength, (from, to) => {
+    strings.push({
+      offset: baseOffset + from,
+      length: to - from,
+      encoding: 'ascii',
+      value: asciiDecoder.decode(bytes.subarray(from, to)),
+    });
+  });
+  if (utf16) {
+    const ascii = strings.length;
+    scanWide(bytes, words, start, end, minLength, (from, to) => {
+      strings.push({
+        offset: baseOffset + from,
+        length: to - from,
+        encoding: 'utf-16le',
+        value: wideDecoder.decode(bytes.subarray(from, to)),
+      });
+    });
+    if (strings.length > ascii) strings.sort((a, b) => a.offset - b.offset);
+  }
+  return strings;
+}
+
+export function extractPrintableStrings(buffer, { minLength = 1 } = {}) {
+  return scanStringsInRange(buffer, 0, buffer.length, { minLength, utf16: false }).map((entry) => entry.value);
+}
+
+export function createSectionLocator(sections = []) {
+  const ordered = sections
+    .filter((section) => section.sizeOfRawData)
+    .map((section) => ({
+      name: section.name,
+      start: section.pointerToRawData,
+      end: section.pointerToRawData + section.sizeOfRawData,
+    }))
+    .sort((a, b) => a.start - b.start);
+  return (offset) => {
+    let lo = 0;
+    let hi = ordered.length - 1;
+    while (lo <= hi) {
+      const mid = (lo + hi) >>> 1;
+      if (ordered[mid].start <= offset) lo = mid + 1;
+      else hi = mid - 1;
+    }
+    return hi >= 0 && offset < ordered[hi].end ? ordered[hi].name : null;
+  };
+}
@@ -0,0 +1,6 @@
+import { scanStringsInRange } from './string-scanner.js';
+
+self.onmessage = ({ data }) => {
+  const { id, bytes, start, end, options } = data;
+  self.postMessage({ id, strings: scanStringsInRange(bytes, start, end, options) });
+};
@@ -0,0 +1,34 @@
+import { CompositorCore } from './compositor-core.js';
+
+function defaultCreateWorker() {
+  if (typeof Worker === 'undefined') return null;
+  return new Worker(new URL('./compositor.worker.js', import.meta.url), { type: 'module' });
+}
+
+// Starts composition onto `output`. When the canvas can be transferred,
+// composition runs in a worker that owns it and the main thread only posts
+// layer changes and damaged pixels (`worker: true`). Otherwise the same core
+// runs here on the canvas's 2D context and reads window canvases directly.
+export function createCompositor(output, { createWorker = defaultCreateWorker } = {}) {
+  if (typeof output?.transferControlToOffscreen === 'function') {
+    const worker = createWorker();
+    if (worker) {
+      const canvas = output.transferControlToOffscreen();
+      worker.postMessage({ type: 'init', canvas }, [canvas]);
+      return {
+        worker: true,
+        post: (message, transfer = []) => worker.postMessage(message, transfer),
+        dispose: () => worker.terminate(),
+      };
+    }
+  }
+  const context = output?.getContext?.('2d') ?? null;
+  if (!context) return null;
+  const core = new CompositorCore({ context });
+  return {
+    worker: false,
+    core,
+    post: (message) => core.handle(message),
+    dispose: () => core.dispose(),
+  };
+}
@@ -0,0 +1,126 @@
+import { intersectRect, isEmptyRect, makeRect } from '../../gdi/rect-list.js';
+import { LayerTree } from './layer-tree.js';
+
+function defaultRequestFrame(fn) {
+  if (typeof requestAnimationFrame === 'function') return requestAnimationFrame(fn);
+  return setTimeout(fn, 16);
+}
+
+// Composes window layers onto one output context. Every layer keeps its
+// pixels in a store: an OffscreenCanvas made by `createSurface` (the worker
+// case, filled by `update` messages carrying ImageBitmaps, a frame's worth
+// in one `batch`), or a canvas passed in with `create` that the main thread
+// draws into itself (the inline case, where `update` only reports damage).
+// Messages only change the layer tree; the next frame redraws just the
+// damaged rects, each from the layers that intersect it, back to front.
+export class CompositorCore {
+  constructor({ context, createSurface = () => null, requestFrame = defaultRequestFrame }) {
+    this.context = context;
+    this.createSurface = createSurface;
+    this.requestFrame = requestFrame;
+    this.tree = new LayerTree();
+    this.stores = new Map();
+    this.frame = null;
+    this.frames = 0;
+  }
+
+  handle(message) {
+    const { tree } = this;
+    switch (message.type) {
+      case 'create': {
+        const layer = tree.create(message);
+        if (!layer) break;
+        const canvas = message.surface ?? this.createSurface(layer.width, layer.height);
+        if (canvas) this.stores.set(layer.id, { canvas, owned: !message.surface });
+        break;
+      }
+      case 'destroy':
+        tree.destroy(message.id).forEach((id) => this.stores.delete(id));
+        break;
+      case 'move': {
+        const layer = tree.get(message.id);
+        if (!layer) break;
+        const { width = layer.width, height = layer.height } = message;
+        if (width !== layer.width || height !== layer.height) this.resizeStore(layer.id, width, height);
+        tree.move(layer.id, message.x, message.y, width, height);
+        break;
+      }
+      case 'raise':
+        tree.raise(message.id);
+        break;
+      case 'visible':
+        tree.setVisible(message.id, Boolean(message.visible));
+        break;
+      case 'update':
+        this.update(message);
+        break;
+      case 'batch':
+        message.messages.forEach((entry) => this.handle(entry));
+        break;
+      case 'resize':
+        if (this.context?.canvas) {
+          this.context.canvas.width = message.width;
+          this.context.canvas.height = message.height;
+        }
+        tree.damageAll(message.width, message.height);
+        break;
+      default:
+        break;
+    }
+    if (tree.hasDamage()) this.schedule();
+  }
+
+  // Owned stores are reallocated keeping what still fits; borrowed ones are
+  // resized by whoever draws into them.
+  resizeStore(id, width, height) {
+    const store = this.stores.get(id);
+    if (!store?.owned) return;
+    const canvas = this.createSurface(width, height);
+    canvas?.getContext('2d')?.drawImage(store.canvas, 0, 0);
+    store.canvas = canvas;
+  }
+
+  // (x, y, width, height) is the changed rect in layer coordinates; `source`
+  // holds its pixels starting at (sx, sy).
+  update({ id, source = null, sx = 0, sy = 0, x = 0, y = 0, width, height }) {
+    const store = this.stores.get(id);
+    if (source && store?.canvas) {
+      store.canvas.getContext('2d')?.drawImage(source, sx, sy, width, height, x, y, width, height);
+    }
+    source?.close?.();
+    this.tree.damageContents(id, makeRect(x, y, x + width, y + height));
+  }
+
+  schedule() {
+    if (this.frame !== null) return;
+    this.frame = this.requestFrame(() => this.compose());
+  }
+
+  // Returns the number of damaged rects redrawn.
+  compose() {
+    this.frame = null;
+    const damage = this.tree.takeDamage();
+    const ctx = this.context;
+    if (!damage.length || !ctx) return 0;
+    const order = this.tree.paintOrder();
+    damage.forEach((rect) => {
+      ctx.clearRect(rect.left, rect.top, rect.right - rect.left, rect.bottom - rect.top);
+      order.forEach(({ layer, x, y, clip }) => {
+        const store = this.stores.get(layer.id);
+        const area = intersectRect(rect, clip);
+        if (!store?.canvas || isEmptyRect(area)) return;
+        const width = area.right - area.left;
+        const height = area.bottom - area.top;
+        ctx.drawImage(store.canvas, area.left - x, area.top - y, width, height, area.left, area.top, width, height);
+      });
+    });
+    this.frames += 1;
+    return damage.length;
+  }
+
+  // A frame already requested finds no context and draws nothing.
+  dispose() {
+    this.context = null;
+    this.stores.clear();
+  }
+}
@@ -0,0 +1,20 @@
+import { CompositorCore } from './compositor-core.js';
+
+let core = null;
+
+function requestFrame(fn) {
+  if (typeof self.requestAnimationFrame === 'function') return self.requestAnimationFrame(fn);
+  return setTimeout(fn, 16);
+}
+
+self.onmessage = ({ data }) => {
+  if (data.type === 'init') {
+    core = new CompositorCore({
+      context: data.canvas.getContext('2d'),
+      createSurface: (width, height) => new OffscreenCanvas(width, height),
+      requestFrame,
+    });
+    return;
+  }
+  core?.handle(data);
+};
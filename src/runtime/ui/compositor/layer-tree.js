@@ -0,0 +1,133 @@
+import { addRect, intersectRect, isEmptyRect, makeRect } from '../../gdi/rect-list.js';
+
+// Window layers in z-order: children above their parent, later siblings above
+// earlier ones, every layer clipped to its ancestors. Damage (contents that
+// changed, or area exposed by a move, raise, hide or destroy) accumulates in
+// screen coordinates as a short rect list until the next compose takes it.
+export class LayerTree {
+  constructor() {
+    this.layers = new Map();
+    this.roots = [];
+    this.damage = [];
+  }
+
+  get(id) {
+    return this.layers.get(id) ?? null;
+  }
+
+  siblingsOf(layer) {
+    return layer.parent ? (this.get(layer.parent)?.children ?? []) : this.roots;
+  }
+
+  create({ id, parent = 0, x = 0, y = 0, width, height, visible = true }) {
+    if (this.layers.has(id) || (parent && !this.layers.has(parent))) return null;
+    const layer = { id, parent, x, y, width, height, visible, children: [] };
+    this.layers.set(id, layer);
+    this.siblingsOf(layer).push(id);
+    this.damageLayer(layer);
+    return layer;
+  }
+
+  // Returns the ids removed: the layer and all of its descendants.
+  destroy(id) {
+    const layer = this.get(id);
+    if (!layer) return [];
+    this.damageLayer(layer);
+    const siblings = this.siblingsOf(layer);
+    siblings.splice(siblings.indexOf(id), 1);
+    const removed = [];
+    const remove = (current) => {
+      current.children.forEach((child) => remove(this.get(child)));
+      this.layers.delete(current.id);
+      removed.push(current.id);
+    };
+    remove(layer);
+    return removed;
+  }
+
+  move(id, x, y, width, height) {
+    const layer = this.get(id);
+    if (!layer) return false;
+    this.damageLayer(layer);
+    Object.assign(layer, { x, y, width: width ?? layer.width, height: height ?? layer.height });
+    this.damageLayer(layer);
+    return true;
+  }
+
+  raise(id) {
+    const layer = this.get(id);
+    if (!layer) return false;
+    const siblings = this.siblingsOf(layer);
+    if (siblings[siblings.length - 1] === id) return true;
+    siblings.splice(siblings.indexOf(id), 1);
+    siblings.push(id);
+    this.damageLayer(layer);
+    return true;
+  }
+
+  setVisible(id, visible) {
+    const layer = this.get(id);
+    if (!layer || layer.visible === visible) return Boolean(layer);
+    layer.visible = visible;
+    this.damageLayer(layer);
+    return true;
+  }
+
+  // `rect` is in layer coordinates.
+  damageContents(id, rect) {
+    const layer = this.get(id);
+    if (!layer) return;
+    const { x, y, clip } = this.placement(layer);
+    const area = intersectRect(makeRect(rect.left + x, rect.top + y, rect.right + x, rect.bottom + y), clip);
+    if (!isEmptyRect(area)) this.damage = addRect(this.damage, area);
+  }
+
+  damageAll(width, height) {
+    this.damage = addRect(this.damage, makeRect(0, 0, width, height));
+  }
+
+  damageLayer(layer) {
+    const { clip } = this.placement(layer);
+    if (!isEmptyRect(clip)) this.damage = addRect(this.damage, clip);
+  }
+
+  // Screen origin of a layer and its rect clipped by every ancestor.
+  placement(layer) {
+    const parent = this.get(layer.parent);
+    const origin = parent ? this.placement(parent) : { x: 0, y: 0, clip: null };
+    const x = origin.x + layer.x;
+    const y = origin.y + layer.y;
+    const own = makeRect(x, y, x + layer.width, y + layer.height);
+    return { x, y, clip: origin.clip ? intersectRect(own, origin.clip) : own };
+  }
+
+  // Visible layers back to front, each with its screen origin and clip.
+  paintOrder() {
+    const order = [];
+    const visit = (ids, originX, originY, bounds) => {
+      ids.forEach((id) => {
+        const layer = this.get(id);
+        if (!layer?.visible) return;
+        const x = originX + layer.x;
+        const y = originY + layer.y;
+        const own = makeRect(x, y, x + layer.width, y + layer.height);
+        const clip = bounds ? intersectRect(own, bounds) : own;
+        if (isEmptyRect(clip)) return;
+        order.push({ layer, x, y, clip });
+        visit(layer.children, x, y, clip);
+      });
+    };
+    visit(this.roots, 0, 0, null);
+    return order;
+  }
+
+  hasDamage() {
+    return this.damage.length > 0;
+  }
+
+  takeDamage() {
+    const damage = this.damage;
+    this.damage = [];
+    return damage;
+  }
+}
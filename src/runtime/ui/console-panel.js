@@ -0,0 +1,97 @@
+import { LineRing, DEFAULT_LINE_CAPACITY } from './line-ring.js';
+
+const ROW_HEIGHT = 18;
+const OVERSCAN = 8;
+const FOLLOW_SLACK = 4;
+
+function defaultRequestFrame(fn) {
+  if (typeof requestAnimationFrame === 'function') return requestAnimationFrame(fn);
+  return setTimeout(fn, 16);
+}
+
+// Console sink that buffers lines in a ring and paints once per animation
+// frame, keeping only the rows inside the scroll viewport in the DOM.
+export class ConsolePanel {
+  constructor(element, { capacity = DEFAULT_LINE_CAPACITY, rowHeight = ROW_HEIGHT, requestFrame } = {}) {
+    this.element = element;
+    this.lines = new LineRing(capacity);
+    this.rowHeight = rowHeight;
+    this.requestFrame = requestFrame ?? defaultRequestFrame;
+    this.frame = null;
+    this.follow = true;
+    this.rows = [];
+    if (element) this.mount();
+  }
+
+  mount() {
+    this.element.textContent = '';
+    this.spacer = document.createElement('div');
+    this.spacer.style.position = 'relative';
+    this.viewport = document.createElement('div');
+    this.viewport.style.position = 'absolute';
+    this.viewport.style.left = '0';
+    this.viewport.style.right = '0';
+    this.viewport.style.top = '0';
+    this.spacer.appendChild(this.viewport);
+    this.element.appendChild(this.spacer);
+    this.element.addEventListener(
+      'scroll',
+      () => {
+        const { scrollTop, clientHeight, scrollHeight } = this.element;
+        this.follow = scrollTop + clientHeight >= scrollHeight - FOLLOW_SLACK;
+        this.schedule();
+      },
+      { passive: true },
+    );
+  }
+
+  append(message) {
+    String(message).split('\n').forEach((line) => this.lines.push(line));
+    this.schedule();
+  }
+
+  clear() {
+    this.lines.clear();
+    this.follow = true;
+    this.schedule();
+  }
+
+  schedule() {
+    if (!this.element || this.frame !== null) return;
+    this.frame = this.requestFrame(() => {
+      this.frame = null;
+      this.render();
+    });
+  }
+
+  ensureRows(count) {
+    while (this.rows.length < count) {
+      const row = document.createElement('div');
+      row.style.height = `${this.rowHeight}px`;
+      row.style.lineHeight = `${this.rowHeight}px`;
+      row.style.whiteSpace = 'pre';
+      row.style.overflow = 'hidden';
+      row.style.textOverflow = 'ellipsis';
+      this.viewport.appendChild(row);
+      this.rows.push(row);
+    }
+  }
+
+  render() {
+    if (!this.element) return;
+    const total = this.lines.length;
+    const height = total * this.rowHeight;
+    this.spacer.style.height = `${height}px`;
+    if (this.follow) this.element.scrollTop = height;
+    const { scrollTop, clientHeight } = this.element;
+    const first = Math.max(0, Math.floor(scrollTop / this.rowHeight) - OVERSCAN);
+    const visible = Math.ceil(clientHeight / this.rowHeight) + OVERSCAN * 2;
+    this.ensureRows(visible);
+    this.viewport.style.transform = `translateY(${first * this.rowHeight}px)`;
+    this.rows.forEach((row, offset) => {
+      const line = this.lines.get(first + offset);
+      row.style.display = line === undefined ? 'none' : '';
+      if (row.textContent !== (line ?? '')) row.textContent = line ?? '';
+    });
+  }
+}
@@ -0,0 +1,39 @@
+export const DEFAULT_LINE_CAPACITY = 10000;
+
+// Fixed-capacity FIFO of console lines; once full, each push drops the oldest.
+export class LineRing {
+  constructor(capacity = DEFAULT_LINE_CAPACITY) {
+    this.capacity = Math.max(1, capacity | 0);
+    this.items = new Array(this.capacity);
+    this.head = 0;
+    this.length = 0;
+    this.dropped = 0;
+  }
+
+  push(line) {
+    const slot = (this.head + this.length) % this.capacity;
+    this.items[slot] = line;
+    if (this.length < this.capacity) {
+      this.length++;
+    } else {
+      this.head = (this.head + 1) % this.capacity;
+      this.dropped++;
+    }
+  }
+
+  get(index) {
+    if (index < 0 || index >= this.length) return undefined;
+    return this.items[(this.head + index) % this.capacity];
+  }
+
+  toArray() {
+    return Array.from({ length: this.length }, (_, index) => this.get(index));
+  }
+
+  clear() {
+    this.items = new Array(this.capacity);
+    this.head = 0;
+    this.length = 0;
+    this.dropped = 0;
+  }
+}
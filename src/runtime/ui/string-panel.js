@@ -1,10 +1,16 @@
+const RENDER_LIMIT = 120;
+
 export class StringPanel {
   constructor(element) {
     this.element = element;
+    this.count = 0;
+    this.rendered = 0;
   }
 
   clear() {
     if (this.element) this.element.innerHTML = '';
+    this.count = 0;
+    this.rendered = 0;
   }
 
   showNoStringsMessage() {
@@ -12,17 +18,13 @@ export class StringPanel {
     this.element.textContent = 'No printable strings located in this executable.';
   }
 
-  render(strings) {
+  append(entries) {
     if (!this.element) return;
-    this.clear();
-    if (!strings.length) {
-      this.showNoStringsMessage();
-      return;
-    }
     const frag = document.createDocumentFragment();
-    const limit = 120;
-    let rendered = 0;
-    strings.slice(0, limit).forEach((value, index) => {
+    entries.forEach((entry) => {
+      const index = this.count++;
+      if (index >= RENDER_LIMIT) return;
+      const value = typeof entry === 'string' ? entry : entry.value;
       if (!value.trim()) return;
       const div = document.createElement('div');
       div.className = 'stringList__item';
@@ -31,17 +33,33 @@ export class StringPanel {
       const text = document.createElement('span');
       text.textContent = value.trim();
       div.append(label, text);
+      if (entry.section || entry.encoding === 'utf-16le') {
+        const origin = document.createElement('small');
+        origin.textContent = [entry.section, entry.encoding === 'utf-16le' ? 'UTF-16' : null].filter(Boolean).join(' · ');
+        div.append(origin);
+      }
       frag.appendChild(div);
-      rendered++;
+      this.rendered++;
     });
     this.element.appendChild(frag);
-    if (strings.length > limit) {
+  }
+
+  finish() {
+    if (!this.element) return;
+    if (this.count > RENDER_LIMIT) {
       const note = document.createElement('div');
       note.className = 'stringList__item';
-      note.textContent = `…and ${strings.length - limit} more strings. Refine the binary to narrow things down.`;
+      note.textContent = `…and ${this.count - RENDER_LIMIT} more strings. Refine the binary to narrow things down.`;
       this.element.appendChild(note);
-    } else if (!rendered) {
+    } else if (!this.rendered) {
       this.showNoStringsMessage();
     }
   }
+
+  render(strings) {
+    if (!this.element) return;
+    this.clear();
+    this.append(strings);
+    this.finish();
+  }
 }
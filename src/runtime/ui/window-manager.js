@@ -1,44 +1,264 @@
+import { GlyphAtlas } from '../gdi/glyph-atlas.js';
+import { addRect, makeRect } from '../gdi/rect-list.js';
+import { createCompositor as defaultCreateCompositor } from './compositor/compositor-client.js';
+
+const LABEL_FONT = '16px "Segoe UI", sans-serif';
+const LABEL_LINE_HEIGHT = 20;
+
+function defaultRequestFrame(fn) {
+  if (typeof requestAnimationFrame === 'function') return requestAnimationFrame(fn);
+  return setTimeout(fn, 16);
+}
+
+// Host windows for the guest. By default every window is a compositor layer:
+// its canvas stays off the page, drawing code reports what it changed with
+// `damage`, and once per frame the damaged rects are sent to the compositor
+// (see compositor-client.js), which draws all layers into one output canvas.
+// Top-level windows get a transparent element over their area for input and
+// focus; pressing it raises the window. Child windows (`createChildWindow`)
+// are layers clipped to their parent. Without a compositor every top-level
+// window is its own canvas on the page, as before, and children get none.
 export class WindowManager {
-  constructor(canvasEl) {
+  constructor(
+    canvasEl,
+    {
+      compositor = true,
+      createCompositor = defaultCreateCompositor,
+      requestFrame = defaultRequestFrame,
+      glyphAtlas = new GlyphAtlas(),
+    } = {},
+  ) {
     this.canvasEl = canvasEl;
+    this.glyphAtlas = glyphAtlas;
     this.windows = new Map();
     this.messageQueue = [];
     this.nextHwnd = 1;
+    this.useCompositor = compositor;
+    this.createCompositor = createCompositor;
+    this.requestFrame = requestFrame;
+    this.compositor = null;
+    this.output = null;
+    this.outputWidth = 0;
+    this.outputHeight = 0;
+    this.damaged = new Map();
+    this.commitFrame = null;
+    this.outbox = null;
+    this.topZ = 0;
   }
 
   clear() {
     if (this.canvasEl) {
       this.canvasEl.innerHTML = '';
     }
+    this.compositor?.dispose();
+    this.compositor = null;
+    this.output = null;
+    this.outputWidth = 0;
+    this.outputHeight = 0;
+    this.damaged.clear();
+    this.commitFrame = null;
+    this.outbox = null;
+    this.topZ = 0;
     this.windows.clear();
     this.messageQueue = [];
     this.nextHwnd = 1;
   }
 
+  // Starts the compositor on first use; null once it is known to be
+  // unavailable, which leaves every window on its own page canvas.
+  ensureCompositor() {
+    if (this.compositor || !this.useCompositor || !this.canvasEl) return this.compositor;
+    const output = document.createElement('canvas');
+    output.className = 'compositorOutput';
+    this.compositor = this.createCompositor(output);
+    if (!this.compositor) {
+      this.useCompositor = false;
+      return null;
+    }
+    this.output = output;
+    this.canvasEl.appendChild(output);
+    return this.compositor;
+  }
+
   createWindow(x, y, width, height, title) {
     if (!this.canvasEl) return 0;
     const hwnd = this.nextHwnd++;
     const canvas = document.createElement('canvas');
     canvas.width = width;
     canvas.height = height;
-    canvas.style.left = `${x}px`;
-    canvas.style.top = `${y}px`;
-    this.canvasEl.appendChild(canvas);
+    const compositor = this.ensureCompositor();
+    let element = canvas;
+    if (compositor) {
+      element = document.createElement('div');
+      element.className = 'compositorWindow';
+      element.style.width = `${width}px`;
+      element.style.height = `${height}px`;
+      element.style.zIndex = String(++this.topZ);
+      element.addEventListener('pointerdown', () => this.raiseWindow(hwnd));
+    }
+    element.style.left = `${x}px`;
+    element.style.top = `${y}px`;
+    this.canvasEl.appendChild(element);
     this.windows.set(hwnd, {
       canvas,
+      element,
       ctx: null,
+      x,
+      y,
       width,
       height,
       title,
+      parent: 0,
       skipDefaultPaint: false,
     });
+    if (compositor) {
+      this.coverOutput(x + width, y + height);
+      this.postLayer(hwnd, { parent: 0, x, y, width, height, visible: true });
+    }
+    return hwnd;
+  }
+
+  // A layer inside `parentHwnd` at (x, y) in its client area, or 0 when
+  // windows are not composited.
+  createChildWindow(parentHwnd, x, y, width, height) {
+    const parent = this.windows.get(parentHwnd);
+    if (!parent || !this.compositor) return 0;
+    const hwnd = this.nextHwnd++;
+    const canvas = document.createElement('canvas');
+    canvas.width = width;
+    canvas.height = height;
+    this.windows.set(hwnd, {
+      canvas,
+      element: null,
+      ctx: null,
+      x,
+      y,
+      width,
+      height,
+      title: '',
+      parent: parentHwnd,
+      skipDefaultPaint: true,
+    });
+    this.postLayer(hwnd, { parent: parentHwnd, x, y, width, height, visible: false });
     return hwnd;
   }
 
+  postLayer(hwnd, layer) {
+    const win = this.windows.get(hwnd);
+    const surface = this.compositor.worker ? undefined : win.canvas;
+    this.post({ type: 'create', id: hwnd, ...layer, surface });
+  }
+
+  // The output canvas grows to cover every top-level window.
+  coverOutput(right, bottom) {
+    if (right <= this.outputWidth && bottom <= this.outputHeight) return;
+    this.outputWidth = Math.max(this.outputWidth, right);
+    this.outputHeight = Math.max(this.outputHeight, bottom);
+    this.output.style.width = `${this.outputWidth}px`;
+    this.output.style.height = `${this.outputHeight}px`;
+    this.post({ type: 'resize', width: this.outputWidth, height: this.outputHeight });
+  }
+
+  destroyWindow(hwnd) {
+    const win = this.windows.get(hwnd);
+    if (!win) return;
+    win.element?.remove();
+    this.windows.delete(hwnd);
+    this.damaged.delete(hwnd);
+    if (!this.compositor) return;
+    this.post({ type: 'destroy', id: hwnd });
+    Array.from(this.windows.entries())
+      .filter(([, child]) => child.parent === hwnd)
+      .forEach(([child]) => this.destroyWindow(child));
+  }
+
   showWindow(hwnd) {
+    this.setWindowVisible(hwnd, true);
     this.pumpMessage(hwnd, 'WM_PAINT');
   }
 
+  setWindowVisible(hwnd, visible) {
+    if (!this.windows.has(hwnd)) return;
+    if (this.compositor) this.post({ type: 'visible', id: hwnd, visible });
+  }
+
+  raiseWindow(hwnd) {
+    const win = this.windows.get(hwnd);
+    if (!win || !this.compositor) return;
+    if (win.element) win.element.style.zIndex = String(++this.topZ);
+    this.post({ type: 'raise', id: hwnd });
+  }
+
+  // `rects` are in window coordinates; none means the whole window. The
+  // damage is sent to the compositor with the next frame.
+  damage(hwnd, rects = null) {
+    const win = this.windows.get(hwnd);
+    if (!win || !this.compositor) return;
+    const bounds = makeRect(0, 0, win.width, win.height);
+    this.damaged.set(hwnd, (rects ?? [bounds]).reduce(addRect, this.damaged.get(hwnd) ?? []));
+    if (this.commitFrame === null) this.commitFrame = this.requestFrame(() => this.commit());
+  }
+
+  // Inline, the compositor reads window canvases itself and only needs the
+  // rects. A worker gets each rect's pixels as a transferred ImageBitmap, all
+  // of a frame's in one batch.
+  commit() {
+    this.commitFrame = null;
+    const compositor = this.compositor;
+    const damaged = Array.from(this.damaged.entries());
+    this.damaged.clear();
+    if (!compositor) return;
+    const updates = [];
+    damaged.forEach(([hwnd, rects]) => {
+      const win = this.windows.get(hwnd);
+      if (!win) return;
+      rects.forEach((rect) => {
+        const x = Math.max(0, rect.left);
+        const y = Math.max(0, rect.top);
+        const width = Math.min(win.width, rect.right) - x;
+        const height = Math.min(win.height, rect.bottom) - y;
+        if (width <= 0 || height <= 0) return;
+        updates.push({ win, update: { type: 'update', id: hwnd, x, y, width, height } });
+      });
+    });
+    if (!compositor.worker) {
+      updates.forEach(({ update }) => this.post(update));
+      return;
+    }
+    if (!updates.length) return;
+    const sources = Promise.all(
+      updates.map(({ win, update }) => createImageBitmap(win.canvas, update.x, update.y, update.width, update.height)),
+    );
+    this.post(
+      sources.then((bitmaps) => {
+        const messages = updates.map(({ update }, index) => ({ ...update, source: bitmaps[index] }));
+        return { message: { type: 'batch', messages }, transfer: bitmaps };
+      }),
+    );
+  }
+
+  // Messages reach the compositor in the order they were posted. `message`
+  // may be a promise of { message, transfer } -- a frame whose bitmaps are
+  // still being captured -- which holds back everything posted after it.
+  post(message) {
+    const compositor = this.compositor;
+    if (!this.outbox && !(message instanceof Promise)) {
+      compositor.post(message);
+      return;
+    }
+    const ready = message instanceof Promise ? message : { message };
+    const sent = (this.outbox ?? Promise.resolve())
+      .then(() => ready)
+      .then(({ message: payload, transfer = [] }) => {
+        if (this.compositor === compositor) compositor.post(payload, transfer);
+        else transfer.forEach((source) => source.close());
+      }, () => {});
+    this.outbox = sent;
+    sent.then(() => {
+      if (this.outbox === sent) this.outbox = null;
+    });
+  }
+
   pumpMessage(hwnd, msg) {
     this.messageQueue.push({ hwnd, msg });
     this.processMessages();
@@ -58,14 +278,25 @@ export class WindowManager {
       ctx.fillRect(0, 0, win.width, win.height);
       ctx.fillStyle = '#0f62fe';
       ctx.fillRect(0, 0, win.width, 32);
-      ctx.fillStyle = '#fff';
-      ctx.font = '16px "Segoe UI", sans-serif';
-      ctx.fillText(win.title, 12, 22);
+      this.drawLabel(ctx, win.title, 12, 9, '#fff');
       ctx.strokeStyle = '#0d1b2a';
       ctx.strokeRect(0, 0, win.width, win.height);
-      ctx.fillStyle = '#222';
-      ctx.fillText('WM_PAINT dispatched by WineJS shim', 12, 56);
+      this.drawLabel(ctx, 'WM_PAINT dispatched by WineJS shim', 12, 43, '#222');
+      this.damage(hwnd);
+    }
+  }
+
+  // Text with its top-left at (x, y), from the glyph atlas when there is one.
+  drawLabel(ctx, text, x, y, color) {
+    const face = this.glyphAtlas.face(LABEL_FONT, LABEL_LINE_HEIGHT);
+    if (face) {
+      face.draw(ctx, text, x, y, color);
+      return;
     }
+    ctx.fillStyle = color;
+    ctx.font = LABEL_FONT;
+    ctx.textBaseline = 'top';
+    ctx.fillText(text, x, y);
   }
 
   getWindow(hwnd) {
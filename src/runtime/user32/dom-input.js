@@ -0,0 +1,162 @@
+import {
+  MK_CONTROL,
+  MK_LBUTTON,
+  MK_MBUTTON,
+  MK_RBUTTON,
+  MK_SHIFT,
+  WHEEL_DELTA,
+  WM_KEYDOWN,
+  WM_KEYUP,
+  WM_LBUTTONDOWN,
+  WM_LBUTTONUP,
+  WM_MBUTTONDOWN,
+  WM_MBUTTONUP,
+  WM_MOUSEMOVE,
+  WM_RBUTTONDOWN,
+  WM_RBUTTONUP,
+  WM_SYSKEYDOWN,
+  WM_SYSKEYUP,
+} from './messages.js';
+import {
+  GENERIC_MODIFIER,
+  VK_LBUTTON,
+  VK_LMENU,
+  VK_MBUTTON,
+  VK_RBUTTON,
+  VK_RMENU,
+  virtualKeyForCode,
+} from './virtual-keys.js';
+
+const VK_F10 = 0x79;
+const DOM_DELTA_LINE = 1;
+const DOM_DELTA_PAGE = 2;
+const PIXELS_PER_NOTCH = 100;
+const LINES_PER_NOTCH = 3;
+
+// MouseEvent.button -> [down message, up message, virtual key].
+const BUTTONS = [
+  [WM_LBUTTONDOWN, WM_LBUTTONUP, VK_LBUTTON],
+  [WM_MBUTTONDOWN, WM_MBUTTONUP, VK_MBUTTON],
+  [WM_RBUTTONDOWN, WM_RBUTTONUP, VK_RBUTTON],
+];
+
+const CONTROL_TEXT = { Enter: '\r', Backspace: '\b', Tab: '\t', Escape: '\x1b' };
+
+// WM_KEYDOWN/WM_KEYUP lParam: repeat count 1, scan code, extended flag,
+// context code (Alt held), previous key state and transition state.
+export function keyLParam({ scan, extended }, { down, repeat = false, alt = false }) {
+  let value = 1 | ((scan & 0xff) << 16);
+  if (extended) value |= 1 << 24;
+  if (alt) value |= 1 << 29;
+  if (!down || repeat) value |= 1 << 30;
+  if (!down) value |= 1 << 31;
+  return BigInt(value >>> 0);
+}
+
+// A DOM KeyboardEvent as a key message, or null for unmapped keys. Alt
+// combinations and F10 become WM_SYSKEY*; AltGr (reported as Ctrl+Alt) does
+// not. `key` is the sided virtual key, `text` what TranslateMessage yields.
+export function translateKeyEvent(event, down) {
+  const key = virtualKeyForCode(event.code);
+  if (!key) return null;
+  const alt = event.altKey && !event.ctrlKey;
+  const system = alt || key.vk === VK_LMENU || key.vk === VK_RMENU || key.vk === VK_F10;
+  const pressed = system ? WM_SYSKEYDOWN : WM_KEYDOWN;
+  const released = system ? WM_SYSKEYUP : WM_KEYUP;
+  const text = event.key?.length === 1 ? event.key : (CONTROL_TEXT[event.key] ?? '');
+  return {
+    message: down ? pressed : released,
+    wParam: BigInt(GENERIC_MODIFIER.get(key.vk) ?? key.vk),
+    lParam: keyLParam(key, { down, repeat: Boolean(event.repeat), alt }),
+    key: key.vk,
+    text,
+  };
+}
+
+// MK_* flags for a mouse message's wParam from MouseEvent.buttons.
+export function mouseKeys(event) {
+  let keys = 0;
+  if (event.buttons & 1) keys |= MK_LBUTTON;
+  if (event.buttons & 2) keys |= MK_RBUTTON;
+  if (event.buttons & 4) keys |= MK_MBUTTON;
+  if (event.shiftKey) keys |= MK_SHIFT;
+  if (event.ctrlKey) keys |= MK_CONTROL;
+  return keys;
+}
+
+// Wheel distance in WHEEL_DELTA units, positive away from the user.
+export function wheelDelta(event) {
+  const scale =
+    event.deltaMode === DOM_DELTA_PAGE
+      ? WHEEL_DELTA
+      : event.deltaMode === DOM_DELTA_LINE
+        ? WHEEL_DELTA / LINES_PER_NOTCH
+        : WHEEL_DELTA / PIXELS_PER_NOTCH;
+  return Math.max(-0x8000, Math.min(0x7fff, Math.round(-event.deltaY * scale)));
+}
+
+// Feeds a top-level window's events into the station as Win32 input. They
+// arrive on `element`: the canvas itself, or the element over it when the
+// canvas is composited off the page. Points are scaled from CSS pixels to
+// canvas pixels, the element takes keyboard focus and pointer capture on
+// press, and keys still held when it loses focus are released so nothing
+// stays stuck down. Returns the unbind function, or null when there is no
+// DOM element to listen on.
+export function bindCanvasInput(canvas, station, window, element = canvas) {
+  if (typeof element?.addEventListener !== 'function') return null;
+  if (!(element.tabIndex >= 0)) element.tabIndex = 0;
+  const held = new Map();
+
+  const point = (event) => {
+    const bounds = element.getBoundingClientRect();
+    const scaleX = bounds.width ? canvas.width / bounds.width : 1;
+    const scaleY = bounds.height ? canvas.height / bounds.height : 1;
+    return [Math.floor((event.clientX - bounds.left) * scaleX), Math.floor((event.clientY - bounds.top) * scaleY)];
+  };
+
+  const key = (down) => (event) => {
+    const translated = translateKeyEvent(event, down);
+    if (!translated) return;
+    event.preventDefault();
+    if (down) held.set(event.code, event);
+    else held.delete(event.code);
+    station.input.hostKey(translated.key, down, translated.text);
+    station.postKey(window, translated);
+  };
+
+  const button = (down) => (event) => {
+    const entry = BUTTONS[event.button];
+    if (!entry) return;
+    event.preventDefault();
+    if (down) {
+      element.focus?.();
+      element.setPointerCapture?.(event.pointerId);
+    }
+    station.input.hostKey(entry[2], down);
+    station.postMouse(window, down ? entry[0] : entry[1], mouseKeys(event), ...point(event));
+  };
+
+  const listeners = {
+    keydown: key(true),
+    keyup: key(false),
+    pointerdown: button(true),
+    pointerup: button(false),
+    pointermove: (event) => station.postMouse(window, WM_MOUSEMOVE, mouseKeys(event), ...point(event)),
+    wheel: (event) => {
+      event.preventDefault();
+      const wParam = ((wheelDelta(event) & 0xffff) << 16) | mouseKeys(event);
+      station.postWheel(window, wParam >>> 0, ...point(event));
+    },
+    contextmenu: (event) => event.preventDefault(),
+    blur: () => {
+      held.forEach((event) => listeners.keyup(event));
+      held.clear();
+    },
+  };
+  Object.entries(listeners).forEach(([type, listener]) => {
+    element.addEventListener(type, listener, type === 'wheel' ? { passive: false } : undefined);
+  });
+  return () => {
+    Object.entries(listeners).forEach(([type, listener]) => element.removeEventListener(type, listener));
+  };
+}
@@ -0,0 +1,323 @@
+import {
+  COLOR_WINDOW,
+  COLOR_WINDOWTEXT,
+  DEFAULT_GUI_FONT,
+  GRAY_BRUSH,
+  TRANSPARENT,
+  fontMetrics,
+  systemColor,
+} from '../gdi/gdi-objects.js';
+import { makeRect } from '../gdi/rect-list.js';
+import { int32 } from '../import-plugins/win64-args.js';
+import {
+  EM_GETFIRSTVISIBLELINE,
+  EM_GETLIMITTEXT,
+  EM_GETLINECOUNT,
+  EM_GETSEL,
+  EM_LINEFROMCHAR,
+  EM_LINEINDEX,
+  EM_LINELENGTH,
+  EM_LINESCROLL,
+  EM_REPLACESEL,
+  EM_SCROLLCARET,
+  EM_SETLIMITTEXT,
+  EM_SETREADONLY,
+  EM_SETSEL,
+  EN_CHANGE,
+  ES_AUTOVSCROLL,
+  ES_MULTILINE,
+  ES_NUMBER,
+  ES_READONLY,
+  WHEEL_DELTA,
+  WM_CHAR,
+  WM_ERASEBKGND,
+  WM_GETFONT,
+  WM_GETTEXT,
+  WM_GETTEXTLENGTH,
+  WM_KEYDOWN,
+  WM_LBUTTONDOWN,
+  WM_MOUSEWHEEL,
+  WM_PAINT,
+  WM_SETFONT,
+  WM_SETTEXT,
+  WS_EX_CLIENTEDGE,
+  makeLParam,
+} from './messages.js';
+import { PieceTable } from './piece-table.js';
+import { VK_BACK, VK_DELETE, VK_END, VK_HOME, VK_LEFT, VK_RIGHT } from './virtual-keys.js';
+
+const MARGIN = 2;
+const WHEEL_LINES = 3;
+const NO_LIMIT = 0x7ffffffe;
+
+// The EDIT system class, answering its messages on the host. Text lives in
+// a PieceTable, so EM_SETSEL/EM_REPLACESEL at the end of a long log and
+// WM_GETTEXTLENGTH don't depend on how much text came before. Painting
+// draws only the lines that are both scrolled into view and inside the
+// update region, and an edit invalidates only the lines it changed (or the
+// view, when it scrolls), so redraws are bounded by the window's height.
+// Lines don't wrap and there is no horizontal scrolling.
+//
+// `handle` gets guest strings through `io` ({ readText(pointer),
+// writeText(pointer, text, capacity), writeUInt32(pointer, value) }). It
+// returns { rax, notify }, where notify is an EN_* code for the parent or
+// null, or returns null for messages DefWindowProc should answer.
+export class EditControl {
+  constructor(window, station) {
+    this.window = window;
+    this.station = station;
+    this.text = new PieceTable(window.title);
+    this.selStart = 0;
+    this.selEnd = 0;
+    this.firstLine = 0;
+    this.font = 0;
+    this.limit = NO_LIMIT;
+  }
+
+  get multiline() {
+    return (this.window.style & ES_MULTILINE) !== 0;
+  }
+
+  get readOnly() {
+    return (this.window.style & ES_READONLY) !== 0;
+  }
+
+  fontHandle() {
+    const { gdi } = this.station;
+    return gdi.objects.get(this.font)?.type === 'font' ? this.font : gdi.getStockObject(DEFAULT_GUI_FONT);
+  }
+
+  lineHeight() {
+    return fontMetrics(this.station.gdi.objects.get(this.fontHandle())).lineHeight;
+  }
+
+  visibleLines() {
+    return Math.max(1, Math.floor((this.window.height - MARGIN * 2) / this.lineHeight()));
+  }
+
+  // Client rect of text lines first..last as currently scrolled.
+  linesRect(first, last = Infinity) {
+    const height = this.lineHeight();
+    const top = MARGIN + (first - this.firstLine) * height;
+    const bottom = last === Infinity ? this.window.height : MARGIN + (last + 1 - this.firstLine) * height;
+    return makeRect(0, Math.max(0, top), this.window.width, Math.min(this.window.height, bottom));
+  }
+
+  invalidateLines(first, last) {
+    const rect = this.linesRect(first, last);
+    if (rect.bottom > rect.top) this.station.invalidate(this.window.hwnd, rect, true);
+  }
+
+  invalidateAll() {
+    this.station.invalidate(this.window.hwnd, null, true);
+  }
+
+  scrollTo(line) {
+    const first = Math.max(0, Math.min(line, this.text.lineCount - 1));
+    if (first === this.firstLine) return false;
+    this.firstLine = first;
+    this.invalidateAll();
+    return true;
+  }
+
+  scrollToCaret() {
+    const line = this.text.lineFromOffset(this.selEnd);
+    if (line < this.firstLine) return this.scrollTo(line);
+    const visible = this.visibleLines();
+    return line >= this.firstLine + visible ? this.scrollTo(line - visible + 1) : false;
+  }
+
+  select(start, end) {
+    const caretLine = this.text.lineFromOffset(this.selEnd);
+    const length = this.text.length;
+    const from = start < 0 ? this.selEnd : Math.min(start, length);
+    const to = start < 0 ? this.selEnd : end < 0 ? length : Math.min(end, length);
+    this.selStart = Math.min(from, to);
+    this.selEnd = Math.max(from, to);
+    this.invalidateLines(caretLine, caretLine);
+    const line = this.text.lineFromOffset(this.selEnd);
+    if (line !== caretLine) this.invalidateLines(line, line);
+  }
+
+  // Replaces the selection, leaving the caret after the new text.
+  replaceSelection(text) {
+    const value = this.multiline ? text : text.split(/\r?\n/, 1)[0];
+    const start = this.selStart;
+    const line = this.text.lineFromOffset(start);
+    const lineCount = this.text.lineCount;
+    this.text.replace(start, this.selEnd, value);
+    this.selStart = start + value.length;
+    this.selEnd = this.selStart;
+    if (this.window.style & ES_AUTOVSCROLL && this.scrollToCaret()) return;
+    const last = lineCount === this.text.lineCount ? this.text.lineFromOffset(this.selEnd) : Infinity;
+    this.invalidateLines(line, last);
+  }
+
+  setText(text) {
+    this.text = new PieceTable(this.multiline ? text : text.split(/\r?\n/, 1)[0]);
+    this.selStart = 0;
+    this.selEnd = 0;
+    this.firstLine = 0;
+    this.invalidateAll();
+  }
+
+  // Typed characters: backspace, Enter in multi-line controls and printable
+  // characters, within the text limit and ES_NUMBER.
+  typeChar(code) {
+    if (this.readOnly) return null;
+    if (code === VK_BACK) {
+      if (this.selStart === this.selEnd) {
+        if (!this.selStart) return null;
+        const crlf = this.text.slice(this.selStart - 2, this.selStart) === '\r\n';
+        this.selStart -= crlf ? 2 : 1;
+      }
+      this.replaceSelection('');
+      return EN_CHANGE;
+    }
+    let text = String.fromCharCode(code);
+    if (code === 0x0d) {
+      if (!this.multiline) return null;
+      text = '\r\n';
+    } else if (code < 0x20 || (this.window.style & ES_NUMBER && (code < 0x30 || code > 0x39))) {
+      return null;
+    }
+    if (this.text.length - (this.selEnd - this.selStart) + text.length > this.limit) return null;
+    this.replaceSelection(text);
+    return EN_CHANGE;
+  }
+
+  keyDown(vk) {
+    const caret = this.selEnd;
+    const line = this.text.lineFromOffset(caret);
+    const back = this.text.slice(caret - 2, caret) === '\r\n' ? 2 : 1;
+    const forward = this.text.slice(caret, caret + 2) === '\r\n' ? 2 : 1;
+    switch (vk) {
+      case VK_LEFT:
+        this.select(Math.max(0, caret - back), Math.max(0, caret - back));
+        break;
+      case VK_RIGHT:
+        this.select(caret + forward, caret + forward);
+        break;
+      case VK_HOME:
+        this.select(this.text.lineStart(line), this.text.lineStart(line));
+        break;
+      case VK_END:
+        this.select(this.text.lineEnd(line), this.text.lineEnd(line));
+        break;
+      case VK_DELETE:
+        if (this.readOnly) return null;
+        if (this.selStart === this.selEnd) {
+          if (caret >= this.text.length) return null;
+          this.selEnd += forward;
+        }
+        this.replaceSelection('');
+        return EN_CHANGE;
+      default:
+        return null;
+    }
+    this.scrollToCaret();
+    return null;
+  }
+
+  paint() {
+    const { gdi } = this.station;
+    const { hdc, rect } = this.station.beginPaint(this.window);
+    const client = makeRect(0, 0, this.window.width, this.window.height);
+    gdi.fillRect(hdc, rect, COLOR_WINDOW + 1);
+    if (this.window.exStyle & WS_EX_CLIENTEDGE) gdi.frameRect(hdc, client, gdi.getStockObject(GRAY_BRUSH));
+    gdi.selectObject(hdc, this.fontHandle());
+    gdi.swapState(hdc, 'textColor', systemColor(COLOR_WINDOWTEXT));
+    gdi.swapState(hdc, 'bkMode', TRANSPARENT);
+    const height = this.lineHeight();
+    const first = this.firstLine + Math.max(0, Math.floor((rect.top - MARGIN) / height));
+    const last = Math.min(this.text.lineCount - 1, this.firstLine + Math.floor((rect.bottom - 1 - MARGIN) / height));
+    for (let line = first; line <= last; line++) {
+      const text = this.text.lineText(line);
+      if (text) gdi.textOut(hdc, MARGIN, MARGIN + (line - this.firstLine) * height, text);
+    }
+    if (this.station.focus === this.window.hwnd && !this.readOnly && this.selStart === this.selEnd) {
+      const line = this.text.lineFromOffset(this.selEnd);
+      const prefix = this.text.slice(this.text.lineStart(line), this.selEnd);
+      const x = MARGIN + (prefix ? gdi.textExtent(hdc, prefix).cx : 0);
+      const y = MARGIN + (line - this.firstLine) * height;
+      gdi.fillRect(hdc, makeRect(x, y, x + 1, y + height), COLOR_WINDOWTEXT + 1);
+    }
+    gdi.releaseDC(hdc);
+  }
+
+  handle(message, wParam, lParam, io) {
+    const { text } = this;
+    switch (message) {
+      case WM_SETTEXT:
+        this.setText(io.readText(lParam));
+        return { rax: 1 };
+      case WM_GETTEXT:
+        return { rax: io.writeText(lParam, text.slice(0, Math.max(0, Number(wParam) - 1)), Number(wParam)) };
+      case WM_GETTEXTLENGTH:
+        return { rax: text.length };
+      case WM_SETFONT:
+        this.font = Number(wParam & 0xffffffffn);
+        if (lParam) this.invalidateAll();
+        return { rax: 0 };
+      case WM_GETFONT:
+        return { rax: this.font };
+      case WM_PAINT:
+        this.paint();
+        return { rax: 0 };
+      case WM_ERASEBKGND:
+        return { rax: 1 };
+      case WM_LBUTTONDOWN:
+        this.station.setFocus(this.window.hwnd);
+        return { rax: 0 };
+      case WM_MOUSEWHEEL: {
+        const notches = int32(wParam) >> 16;
+        this.scrollTo(this.firstLine - Math.round((notches / WHEEL_DELTA) * WHEEL_LINES));
+        return { rax: 0 };
+      }
+      case WM_CHAR:
+        return { rax: 0, notify: this.typeChar(Number(wParam & 0xffffn)) };
+      case WM_KEYDOWN:
+        return { rax: 0, notify: this.keyDown(Number(wParam & 0xffn)) };
+      case EM_GETSEL:
+        if (wParam) io.writeUInt32(wParam, this.selStart);
+        if (lParam) io.writeUInt32(lParam, this.selEnd);
+        return { rax: makeLParam(Math.min(this.selStart, 0xffff), Math.min(this.selEnd, 0xffff)) };
+      case EM_SETSEL:
+        this.select(int32(wParam), int32(lParam));
+        return { rax: 0 };
+      case EM_REPLACESEL:
+        this.replaceSelection(io.readText(lParam));
+        return { rax: 0 };
+      case EM_GETLINECOUNT:
+        return { rax: text.lineCount };
+      case EM_LINEINDEX: {
+        const line = int32(wParam) < 0 ? text.lineFromOffset(this.selEnd) : int32(wParam);
+        return { rax: line < text.lineCount ? text.lineStart(line) : -1 };
+      }
+      case EM_LINELENGTH: {
+        const line = text.lineFromOffset(int32(wParam) < 0 ? this.selEnd : int32(wParam));
+        return { rax: text.lineEnd(line) - text.lineStart(line) };
+      }
+      case EM_LINEFROMCHAR:
+        return { rax: text.lineFromOffset(int32(wParam) < 0 ? this.selEnd : int32(wParam)) };
+      case EM_GETFIRSTVISIBLELINE:
+        return { rax: this.firstLine };
+      case EM_LINESCROLL:
+        this.scrollTo(this.firstLine + int32(lParam));
+        return { rax: 1 };
+      case EM_SCROLLCARET:
+        this.scrollToCaret();
+        return { rax: 1 };
+      case EM_SETREADONLY:
+        this.window.style = (wParam ? this.window.style | ES_READONLY : this.window.style & ~ES_READONLY) >>> 0;
+        return { rax: 1 };
+      case EM_SETLIMITTEXT:
+        this.limit = Number(wParam) || NO_LIMIT;
+        return { rax: 0 };
+      case EM_GETLIMITTEXT:
+        return { rax: this.limit };
+      default:
+        return null;
+    }
+  }
+}
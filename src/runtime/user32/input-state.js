@@ -0,0 +1,125 @@
+import {
+  WM_KEYDOWN,
+  WM_KEYUP,
+  WM_LBUTTONDOWN,
+  WM_LBUTTONUP,
+  WM_MBUTTONDOWN,
+  WM_MBUTTONUP,
+  WM_RBUTTONDOWN,
+  WM_RBUTTONUP,
+  WM_SYSKEYDOWN,
+  WM_SYSKEYUP,
+} from './messages.js';
+import { GENERIC_MODIFIER, VK_LBUTTON, VK_MBUTTON, VK_RBUTTON } from './virtual-keys.js';
+
+const KEY_DOWN = 0x80;
+const KEY_TOGGLED = 0x01;
+const LATENCY_SAMPLES = 128;
+
+const BUTTON_MESSAGES = new Map([
+  [WM_LBUTTONDOWN, [VK_LBUTTON, true]],
+  [WM_LBUTTONUP, [VK_LBUTTON, false]],
+  [WM_RBUTTONDOWN, [VK_RBUTTON, true]],
+  [WM_RBUTTONUP, [VK_RBUTTON, false]],
+  [WM_MBUTTONDOWN, [VK_MBUTTON, true]],
+  [WM_MBUTTONUP, [VK_MBUTTON, false]],
+]);
+
+const defaultHostNow = () => (typeof performance !== 'undefined' ? performance.now() : Date.now());
+
+function press(table, vk, down) {
+  const keys = [vk, GENERIC_MODIFIER.get(vk)].filter(Boolean);
+  keys.forEach((key) => {
+    const wasDown = (table[key] & KEY_DOWN) !== 0;
+    if (down && !wasDown) table[key] = (table[key] ^ KEY_TOGGLED) | KEY_DOWN;
+    if (!down) table[key] &= ~KEY_DOWN;
+  });
+}
+
+// GetKeyState and GetAsyncKeyState return a SHORT; sign-extending it keeps
+// both `& 0x8000` and `< 0` tests working.
+function keyStateValue(bits) {
+  return ((bits & KEY_DOWN ? 0x8000 : 0) | (bits & KEY_TOGGLED)) << 16 >> 16;
+}
+
+// Keyboard and mouse button state of one window station, in the two views
+// Win32 offers: `asyncKeys` follows the host as events arrive
+// (GetAsyncKeyState), `keys` follows the guest as it retrieves input
+// messages (GetKeyState). Input messages carry `input: { stamp, key }`: the
+// host time they were captured at and the sided virtual key. Once retrieved
+// they wait for the next presented frame, and the capture-to-present time is
+// kept as a latency sample. Only the newest LATENCY_SAMPLES wait, since older
+// ones would fall out of the samples anyway; with nothing presenting frames
+// the rest are just counted.
+export class InputState {
+  constructor({ now = defaultHostNow } = {}) {
+    this.now = now;
+    this.keys = new Uint8Array(256);
+    this.asyncKeys = new Uint8Array(256);
+    this.chars = new Map();
+    this.retrieved = [];
+    this.unsampled = 0;
+    this.samples = new Float64Array(LATENCY_SAMPLES);
+    this.sampleCount = 0;
+    this.queueDelay = 0;
+  }
+
+  // Host side: a key or button changed. `text` is what TranslateMessage
+  // turns a key down into.
+  hostKey(vk, down, text = '') {
+    press(this.asyncKeys, vk, down);
+    if (down && text) this.chars.set(vk, text);
+  }
+
+  // Guest side: a message left the queue through GetMessage/PeekMessage.
+  retrieve(msg) {
+    const vk = msg.input?.key ?? Number(msg.wParam & 0xffn);
+    if (msg.message === WM_KEYDOWN || msg.message === WM_SYSKEYDOWN) press(this.keys, vk, true);
+    if (msg.message === WM_KEYUP || msg.message === WM_SYSKEYUP) press(this.keys, vk, false);
+    const button = BUTTON_MESSAGES.get(msg.message);
+    if (button) press(this.keys, button[0], button[1]);
+    if (!msg.input) return;
+    if (this.retrieved.length === LATENCY_SAMPLES) {
+      this.retrieved.shift();
+      this.unsampled += 1;
+    }
+    this.retrieved.push(msg.input.stamp);
+    this.queueDelay = this.now() - msg.input.stamp;
+  }
+
+  // A frame reached the screen; everything retrieved so far is now visible.
+  presented() {
+    if (!this.retrieved.length) return;
+    const now = this.now();
+    this.sampleCount += this.unsampled;
+    this.unsampled = 0;
+    this.retrieved.forEach((stamp) => {
+      this.samples[this.sampleCount % LATENCY_SAMPLES] = now - stamp;
+      this.sampleCount += 1;
+    });
+    this.retrieved.length = 0;
+  }
+
+  getKeyState(vk) {
+    return keyStateValue(this.keys[vk & 0xff]);
+  }
+
+  getAsyncKeyState(vk) {
+    return keyStateValue(this.asyncKeys[vk & 0xff] & KEY_DOWN);
+  }
+
+  translate(vk) {
+    return this.chars.get(vk) ?? '';
+  }
+
+  // Milliseconds from host event to the first frame presented after the
+  // guest retrieved it, over the last LATENCY_SAMPLES inputs.
+  latency() {
+    const count = Math.min(this.sampleCount, LATENCY_SAMPLES);
+    if (!count) return { count: 0, last: 0, mean: 0, max: 0, queueDelay: this.queueDelay };
+    const recent = Array.from(this.samples.subarray(0, count));
+    const last = this.samples[(this.sampleCount - 1) % LATENCY_SAMPLES];
+    const total = recent.reduce((sum, value) => sum + value, 0);
+    return { count: this.sampleCount, last, mean: total / count, max: Math.max(...recent), queueDelay: this.queueDelay };
+  }
+}
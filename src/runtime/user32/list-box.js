@@ -0,0 +1,420 @@
+import {
+  COLOR_HIGHLIGHT,
+  COLOR_HIGHLIGHTTEXT,
+  COLOR_WINDOW,
+  COLOR_WINDOWTEXT,
+  DEFAULT_GUI_FONT,
+  GRAY_BRUSH,
+  TRANSPARENT,
+  fontMetrics,
+  systemColor,
+} from '../gdi/gdi-objects.js';
+import { makeRect } from '../gdi/rect-list.js';
+import { int32 } from '../import-plugins/win64-args.js';
+import {
+  LBN_DBLCLK,
+  LBN_SELCHANGE,
+  LBS_NOTIFY,
+  LBS_SORT,
+  LB_ADDSTRING,
+  LB_DELETESTRING,
+  LB_ERR,
+  LB_FINDSTRING,
+  LB_FINDSTRINGEXACT,
+  LB_GETCOUNT,
+  LB_GETCURSEL,
+  LB_GETITEMDATA,
+  LB_GETITEMHEIGHT,
+  LB_GETSEL,
+  LB_GETTEXT,
+  LB_GETTEXTLEN,
+  LB_GETTOPINDEX,
+  LB_INSERTSTRING,
+  LB_RESETCONTENT,
+  LB_SELECTSTRING,
+  LB_SETCURSEL,
+  LB_SETITEMDATA,
+  LB_SETTOPINDEX,
+  WHEEL_DELTA,
+  WM_ERASEBKGND,
+  WM_GETFONT,
+  WM_KEYDOWN,
+  WM_LBUTTONDBLCLK,
+  WM_LBUTTONDOWN,
+  WM_MOUSEWHEEL,
+  WM_PAINT,
+  WM_SETFONT,
+  WS_EX_CLIENTEDGE,
+} from './messages.js';
+import { VK_DOWN, VK_END, VK_HOME, VK_NEXT, VK_PRIOR, VK_UP } from './virtual-keys.js';
+
+const MARGIN = 2;
+const WHEEL_ROWS = 3;
+const INITIAL_CAPACITY = 16;
+// Unused pool strings tolerated before the pool is rebuilt from live items.
+const POOL_SLACK = 256;
+
+// Item strings by small integer id; id 0 means "no item". Adding a string
+// that is already pooled returns its old id, so a list rebuilt with the
+// same strings holds the same ids.
+export class StringPool {
+  constructor() {
+    this.strings = [null];
+    this.ids = new Map();
+  }
+
+  get size() {
+    return this.strings.length - 1;
+  }
+
+  intern(text) {
+    let id = this.ids.get(text);
+    if (id === undefined) {
+      id = this.strings.length;
+      this.strings.push(text);
+      this.ids.set(text, id);
+    }
+    return id;
+  }
+}
+
+// The LISTBOX system class, answering its messages on the host. Items are a
+// Uint32Array of pooled string ids. Changes don't invalidate anything
+// themselves; they only raise the window's paint flag. WM_PAINT then diffs
+// the visible rows against the ids and selection it painted last and
+// redraws the rows that differ, so LB_RESETCONTENT followed by LB_ADDSTRING
+// of the same strings (the usual way to refresh a list) paints nothing, and
+// any change costs at most the visible rows. Single selection only, and no
+// scroll bar is drawn.
+//
+// `handle` follows EditControl: strings go through `io`, and it returns
+// { rax, notify } or null for messages DefWindowProc should answer.
+export class ListBox {
+  constructor(window, station) {
+    this.window = window;
+    this.station = station;
+    this.pool = new StringPool();
+    this.items = new Uint32Array(INITIAL_CAPACITY);
+    this.count = 0;
+    this.data = null;
+    this.selected = -1;
+    this.top = 0;
+    this.font = 0;
+    this.painted = new Uint32Array(0);
+    this.paintedTop = -1;
+    this.paintedSelected = -1;
+  }
+
+  get notifies() {
+    return (this.window.style & LBS_NOTIFY) !== 0;
+  }
+
+  text(index) {
+    return this.pool.strings[this.items[index]];
+  }
+
+  fontHandle() {
+    const { gdi } = this.station;
+    return gdi.objects.get(this.font)?.type === 'font' ? this.font : gdi.getStockObject(DEFAULT_GUI_FONT);
+  }
+
+  itemHeight() {
+    return fontMetrics(this.station.gdi.objects.get(this.fontHandle())).lineHeight;
+  }
+
+  visibleRows() {
+    return Math.max(1, Math.floor(this.window.height / this.itemHeight()));
+  }
+
+  // Rows with any part in view, the last one possibly cut off.
+  shownRows() {
+    return Math.max(1, Math.ceil(this.window.height / this.itemHeight()));
+  }
+
+  rowRect(index) {
+    const height = this.itemHeight();
+    const top = (index - this.top) * height;
+    return makeRect(0, top, this.window.width, top + height);
+  }
+
+  // Raises the paint flag without adding to the update region; paint()
+  // works out what actually changed.
+  changed() {
+    this.station.queue(this.window.threadId).invalidate(this.window.hwnd);
+  }
+
+  scrollTo(index) {
+    const top = Math.max(0, Math.min(index, this.count - 1));
+    if (top === this.top) return;
+    this.top = top;
+    this.changed();
+  }
+
+  ensureVisible(index) {
+    const rows = this.visibleRows();
+    if (index < this.top) this.scrollTo(index);
+    else if (index >= this.top + rows) this.scrollTo(index - rows + 1);
+  }
+
+  // Returns whether the selection moved.
+  select(index) {
+    const selected = index >= 0 && index < this.count ? index : -1;
+    if (selected === this.selected) return false;
+    this.selected = selected;
+    if (selected >= 0) this.ensureVisible(selected);
+    this.changed();
+    return true;
+  }
+
+  insertAt(index, text) {
+    if (this.count === this.items.length) {
+      const grown = new Uint32Array(this.items.length * 2);
+      grown.set(this.items);
+      this.items = grown;
+    }
+    this.items.copyWithin(index + 1, index, this.count);
+    this.items[index] = this.pool.intern(text);
+    this.count++;
+    this.data?.splice(index, 0, 0n);
+    if (this.selected >= index) this.selected++;
+    this.changed();
+    return index;
+  }
+
+  // First index whose string sorts after `text`, ignoring case.
+  sortedIndex(text) {
+    const key = text.toLowerCase();
+    let low = 0;
+    let high = this.count;
+    while (low < high) {
+      const mid = (low + high) >> 1;
+      if (this.text(mid).toLowerCase() <= key) low = mid + 1;
+      else high = mid;
+    }
+    return low;
+  }
+
+  removeAt(index) {
+    this.items.copyWithin(index, index + 1, this.count);
+    this.count--;
+    this.data?.splice(index, 1);
+    if (this.selected === index) this.selected = -1;
+    else if (this.selected > index) this.selected--;
+    if (this.top >= this.count) this.top = Math.max(0, this.count - 1);
+    this.changed();
+    return this.count;
+  }
+
+  reset() {
+    this.count = 0;
+    this.data = null;
+    this.selected = -1;
+    this.top = 0;
+    this.changed();
+  }
+
+  // Case-insensitive search that starts after `start` and wraps around.
+  find(start, text, exact) {
+    const key = text.toLowerCase();
+    const from = start >= 0 && start < this.count ? start + 1 : 0;
+    for (let step = 0; step < this.count; step++) {
+      const index = (from + step) % this.count;
+      const item = this.text(index).toLowerCase();
+      if (exact ? item === key : item.startsWith(key)) return index;
+    }
+    return LB_ERR;
+  }
+
+  // Rebuilds the pool from the live and last painted ids once strings that
+  // left the list outnumber the ones in it.
+  compact() {
+    if (this.pool.size <= this.count * 2 + POOL_SLACK) return;
+    const pool = new StringPool();
+    const remap = (ids, length) => {
+      for (let index = 0; index < length; index++) {
+        if (ids[index]) ids[index] = pool.intern(this.pool.strings[ids[index]]);
+      }
+    };
+    remap(this.items, this.count);
+    remap(this.painted, this.painted.length);
+    this.pool = pool;
+  }
+
+  // Adds the rows that differ from the last paint to the update region.
+  invalidateChanges() {
+    const rows = this.shownRows();
+    if (this.top !== this.paintedTop || rows !== this.painted.length) {
+      this.station.invalidate(this.window.hwnd, null, true);
+      return;
+    }
+    for (let row = 0; row < rows; row++) {
+      const index = this.top + row;
+      const id = index < this.count ? this.items[index] : 0;
+      const selected = index === this.selected;
+      if (this.painted[row] !== id || selected !== (index === this.paintedSelected)) {
+        this.station.invalidate(this.window.hwnd, this.rowRect(index), true);
+      }
+    }
+  }
+
+  paint() {
+    this.invalidateChanges();
+    if (!this.window.updateRects.length) {
+      this.station.validate(this.window.hwnd);
+      return;
+    }
+    const { gdi } = this.station;
+    const { hdc, rect } = this.station.beginPaint(this.window);
+    gdi.fillRect(hdc, rect, COLOR_WINDOW + 1);
+    gdi.selectObject(hdc, this.fontHandle());
+    gdi.swapState(hdc, 'bkMode', TRANSPARENT);
+    const height = this.itemHeight();
+    const first = this.top + Math.floor(rect.top / height);
+    const last = Math.min(this.count - 1, this.top + Math.floor((rect.bottom - 1) / height));
+    for (let index = first; index <= last; index++) {
+      const row = this.rowRect(index);
+      const selected = index === this.selected;
+      if (selected) gdi.fillRect(hdc, row, COLOR_HIGHLIGHT + 1);
+      gdi.swapState(hdc, 'textColor', systemColor(selected ? COLOR_HIGHLIGHTTEXT : COLOR_WINDOWTEXT));
+      gdi.textOut(hdc, MARGIN, row.top, this.text(index));
+    }
+    if (this.window.exStyle & WS_EX_CLIENTEDGE) {
+      gdi.frameRect(hdc, makeRect(0, 0, this.window.width, this.window.height), gdi.getStockObject(GRAY_BRUSH));
+    }
+    gdi.releaseDC(hdc);
+
+    const rows = this.shownRows();
+    if (this.painted.length !== rows) this.painted = new Uint32Array(rows);
+    for (let row = 0; row < rows; row++) {
+      this.painted[row] = this.top + row < this.count ? this.items[this.top + row] : 0;
+    }
+    this.paintedTop = this.top;
+    this.paintedSelected = this.selected;
+    this.compact();
+  }
+
+  keyDown(vk) {
+    const page = this.visibleRows();
+    const current = this.selected < 0 ? this.top : this.selected;
+    const targets = {
+      [VK_UP]: current - 1,
+      [VK_DOWN]: this.selected < 0 ? current : current + 1,
+      [VK_PRIOR]: current - page,
+      [VK_NEXT]: current + page,
+      [VK_HOME]: 0,
+      [VK_END]: this.count - 1,
+    };
+    if (!(vk in targets) || !this.count) return null;
+    const moved = this.select(Math.max(0, Math.min(targets[vk], this.count - 1)));
+    return moved && this.notifies ? LBN_SELCHANGE : null;
+  }
+
+  indexAt(lParam) {
+    const y = int32(lParam) >> 16;
+    const index = this.top + Math.floor(y / this.itemHeight());
+    return y >= 0 && index < this.count ? index : -1;
+  }
+
+  handle(message, wParam, lParam, io) {
+    switch (message) {
+      case WM_SETFONT:
+        this.font = Number(wParam & 0xffffffffn);
+        this.paintedTop = -1;
+        if (lParam) this.changed();
+        return { rax: 0 };
+      case WM_GETFONT:
+        return { rax: this.font };
+      case WM_PAINT:
+        this.paint();
+        return { rax: 0 };
+      case WM_ERASEBKGND:
+        return { rax: 1 };
+      case WM_LBUTTONDOWN: {
+        this.station.setFocus(this.window.hwnd);
+        const index = this.indexAt(lParam);
+        const moved = index >= 0 && this.select(index);
+        return { rax: 0, notify: moved && this.notifies ? LBN_SELCHANGE : null };
+      }
+      case WM_LBUTTONDBLCLK:
+        return { rax: 0, notify: this.indexAt(lParam) >= 0 && this.notifies ? LBN_DBLCLK : null };
+      case WM_MOUSEWHEEL: {
+        const notches = int32(wParam) >> 16;
+        this.scrollTo(this.top - Math.round((notches / WHEEL_DELTA) * WHEEL_ROWS));
+        return { rax: 0 };
+      }
+      case WM_KEYDOWN:
+        return { rax: 0, notify: this.keyDown(Number(wParam & 0xffn)) };
+      case LB_ADDSTRING: {
+        const text = io.readText(lParam);
+        return { rax: this.insertAt(this.window.style & LBS_SORT ? this.sortedIndex(text) : this.count, text) };
+      }
+      case LB_INSERTSTRING: {
+        const index = int32(wParam);
+        if (index > this.count) return { rax: LB_ERR };
+        return { rax: this.insertAt(index < 0 ? this.count : index, io.readText(lParam)) };
+      }
+      case LB_DELETESTRING: {
+        const index = int32(wParam);
+        return { rax: index >= 0 && index < this.count ? this.removeAt(index) : LB_ERR };
+      }
+      case LB_RESETCONTENT:
+        this.reset();
+        return { rax: 0 };
+      case LB_GETCOUNT:
+        return { rax: this.count };
+      case LB_GETTEXT: {
+        const index = int32(wParam);
+        if (index < 0 || index >= this.count) return { rax: LB_ERR };
+        const text = this.text(index);
+        return { rax: io.writeText(lParam, text, text.length + 1) };
+      }
+      case LB_GETTEXTLEN: {
+        const index = int32(wParam);
+        return { rax: index >= 0 && index < this.count ? this.text(index).length : LB_ERR };
+      }
+      case LB_SETCURSEL: {
+        const index = int32(wParam);
+        this.select(index);
+        return { rax: index >= 0 && index < this.count ? index : LB_ERR };
+      }
+      case LB_GETCURSEL:
+        return { rax: this.selected };
+      case LB_GETSEL: {
+        const index = int32(wParam);
+        return { rax: index >= 0 && index < this.count ? Number(index === this.selected) : LB_ERR };
+      }
+      case LB_FINDSTRING:
+      case LB_FINDSTRINGEXACT:
+        return { rax: this.find(int32(wParam), io.readText(lParam), message === LB_FINDSTRINGEXACT) };
+      case LB_SELECTSTRING: {
+        const index = this.find(int32(wParam), io.readText(lParam), false);
+        if (index !== LB_ERR) this.select(index);
+        return { rax: index };
+      }
+      case LB_GETTOPINDEX:
+        return { rax: this.top };
+      case LB_SETTOPINDEX: {
+        const index = int32(wParam);
+        if (index < 0 || index >= Math.max(1, this.count)) return { rax: LB_ERR };
+        this.scrollTo(index);
+        return { rax: 0 };
+      }
+      case LB_GETITEMDATA: {
+        const index = int32(wParam);
+        if (index < 0 || index >= this.count) return { rax: LB_ERR };
+        return { rax: this.data?.[index] ?? 0n };
+      }
+      case LB_SETITEMDATA: {
+        const index = int32(wParam);
+        if (index < 0 || index >= this.count) return { rax: LB_ERR };
+        this.data ??= new Array(this.count).fill(0n);
+        this.data[index] = lParam;
+        return { rax: 1 };
+      }
+      case LB_GETITEMHEIGHT:
+        return { rax: this.itemHeight() };
+      default:
+        return null;
+    }
+  }
+}
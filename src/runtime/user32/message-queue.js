@@ -0,0 +1,138 @@
+import { WM_MOUSEMOVE, WM_PAINT, WM_QUIT, WM_TIMER } from './messages.js';
+
+function inRange(message, min, max) {
+  return (!min && !max) || (message >= min && message <= max);
+}
+
+function matchesWindow(hwnd, filter) {
+  if (filter === -1) return hwnd === 0;
+  return !filter || hwnd === filter;
+}
+
+// Input queue of one guest thread. Posted messages are FIFO; WM_QUIT,
+// WM_PAINT and WM_TIMER are flags that are only turned into messages when
+// nothing posted matches the filter, in that order, which is the order
+// GetMessage retrieves them in. Flags coalesce by construction: a window is
+// either invalid or not, a timer has either elapsed or not. Consecutive
+// WM_MOUSEMOVEs for the same window collapse into the latest one, keeping
+// the capture time of the oldest so input latency is not understated.
+export class ThreadMessageQueue {
+  constructor(threadId, { now = () => Date.now() } = {}) {
+    this.threadId = threadId;
+    this.now = now;
+    this.posted = [];
+    this.quitCode = null;
+    this.invalid = new Set();
+    this.timers = new Map();
+    this.waiters = [];
+    this.disposed = false;
+  }
+
+  post(hwnd, message, wParam = 0n, lParam = 0n, pt = { x: 0, y: 0 }, input = null) {
+    const msg = { hwnd, message, wParam: BigInt(wParam), lParam: BigInt(lParam), time: this.now(), pt, input };
+    const last = this.posted[this.posted.length - 1];
+    if (message === WM_MOUSEMOVE && last?.message === WM_MOUSEMOVE && last.hwnd === hwnd) {
+      if (input && last.input) msg.input = { ...input, stamp: last.input.stamp };
+      this.posted[this.posted.length - 1] = msg;
+    } else {
+      this.posted.push(msg);
+    }
+    this.wake();
+  }
+
+  postQuit(code) {
+    this.quitCode = code;
+    this.wake();
+  }
+
+  invalidate(hwnd) {
+    this.invalid.add(hwnd);
+    this.wake();
+  }
+
+  validate(hwnd) {
+    this.invalid.delete(hwnd);
+  }
+
+  isInvalid(hwnd) {
+    return this.invalid.has(hwnd);
+  }
+
+  addTimer(hwnd, id, proc) {
+    const key = `${hwnd}:${id}`;
+    this.timers.set(key, { hwnd, id, proc, elapsed: false });
+    return key;
+  }
+
+  removeTimer(key) {
+    return this.timers.delete(key);
+  }
+
+  fireTimer(key) {
+    const timer = this.timers.get(key);
+    if (!timer || timer.elapsed) return;
+    timer.elapsed = true;
+    this.wake();
+  }
+
+  removeWindow(hwnd) {
+    this.posted = this.posted.filter((msg) => msg.hwnd !== hwnd);
+    this.invalid.delete(hwnd);
+  }
+
+  // Returns the next message for the filter, or null. Paint messages stay
+  // pending until the window is validated, exactly like on Windows.
+  next({ hwnd = 0, min = 0, max = 0 } = {}, remove = true) {
+    const index = this.posted.findIndex((msg) => matchesWindow(msg.hwnd, hwnd) && inRange(msg.message, min, max));
+    if (index >= 0) {
+      const msg = this.posted[index];
+      if (remove) this.posted.splice(index, 1);
+      return msg;
+    }
+    if (this.quitCode !== null) {
+      const msg = this.synthesize(0, WM_QUIT, BigInt(this.quitCode), 0n);
+      if (remove) this.quitCode = null;
+      return msg;
+    }
+    if (inRange(WM_PAINT, min, max)) {
+      for (const target of this.invalid) {
+        if (matchesWindow(target, hwnd)) return this.synthesize(target, WM_PAINT, 0n, 0n);
+      }
+    }
+    if (inRange(WM_TIMER, min, max)) {
+      for (const timer of this.timers.values()) {
+        if (!timer.elapsed || !matchesWindow(timer.hwnd, hwnd)) continue;
+        if (remove) timer.elapsed = false;
+        return this.synthesize(timer.hwnd, WM_TIMER, BigInt(timer.id), BigInt(timer.proc));
+      }
+    }
+    return null;
+  }
+
+  synthesize(hwnd, message, wParam, lParam) {
+    return { hwnd, message, wParam, lParam, time: this.now(), pt: { x: 0, y: 0 } };
+  }
+
+  hasTimers() {
+    return this.timers.size > 0;
+  }
+
+  wait() {
+    if (this.disposed) return Promise.resolve();
+    return new Promise((resolve) => this.waiters.push(resolve));
+  }
+
+  // Ends the thread's message loop: parked GetMessage calls retrieve WM_QUIT
+  // and later waits return at once instead of hanging on a dead station.
+  dispose() {
+    this.disposed = true;
+    this.postQuit(0);
+  }
+
+  wake() {
+    if (!this.waiters.length) return;
+    const waiters = this.waiters;
+    this.waiters = [];
+    waiters.forEach((resolve) => resolve());
+  }
+}
@@ -0,0 +1,117 @@
+export const WM_NULL = 0x0000;
+export const WM_CREATE = 0x0001;
+export const WM_DESTROY = 0x0002;
+export const WM_MOVE = 0x0003;
+export const WM_SIZE = 0x0005;
+export const WM_ACTIVATE = 0x0006;
+export const WM_SETFOCUS = 0x0007;
+export const WM_KILLFOCUS = 0x0008;
+export const WM_PAINT = 0x000f;
+export const WM_SETTEXT = 0x000c;
+export const WM_GETTEXT = 0x000d;
+export const WM_GETTEXTLENGTH = 0x000e;
+export const WM_CLOSE = 0x0010;
+export const WM_QUIT = 0x0012;
+export const WM_ERASEBKGND = 0x0014;
+export const WM_SHOWWINDOW = 0x0018;
+export const WM_SETCURSOR = 0x0020;
+export const WM_GETMINMAXINFO = 0x0024;
+export const WM_SETFONT = 0x0030;
+export const WM_GETFONT = 0x0031;
+export const WM_NCCREATE = 0x0081;
+export const WM_NCDESTROY = 0x0082;
+export const WM_KEYDOWN = 0x0100;
+export const WM_KEYUP = 0x0101;
+export const WM_CHAR = 0x0102;
+export const WM_SYSKEYDOWN = 0x0104;
+export const WM_SYSKEYUP = 0x0105;
+export const WM_SYSCHAR = 0x0106;
+export const WM_COMMAND = 0x0111;
+export const WM_TIMER = 0x0113;
+export const WM_MOUSEMOVE = 0x0200;
+export const WM_LBUTTONDOWN = 0x0201;
+export const WM_LBUTTONUP = 0x0202;
+export const WM_LBUTTONDBLCLK = 0x0203;
+export const WM_RBUTTONDOWN = 0x0204;
+export const WM_RBUTTONUP = 0x0205;
+export const WM_MBUTTONDOWN = 0x0207;
+export const WM_MBUTTONUP = 0x0208;
+export const WM_MOUSEWHEEL = 0x020a;
+export const WM_CAPTURECHANGED = 0x0215;
+export const WM_USER = 0x0400;
+
+export const EM_GETSEL = 0x00b0;
+export const EM_SETSEL = 0x00b1;
+export const EM_LINESCROLL = 0x00b6;
+export const EM_SCROLLCARET = 0x00b7;
+export const EM_GETLINECOUNT = 0x00ba;
+export const EM_LINEINDEX = 0x00bb;
+export const EM_LINELENGTH = 0x00c1;
+export const EM_REPLACESEL = 0x00c2;
+export const EM_SETLIMITTEXT = 0x00c5;
+export const EM_LINEFROMCHAR = 0x00c9;
+export const EM_GETFIRSTVISIBLELINE = 0x00ce;
+export const EM_SETREADONLY = 0x00cf;
+export const EM_GETLIMITTEXT = 0x00d5;
+
+export const ES_MULTILINE = 0x0004;
+export const ES_AUTOVSCROLL = 0x0040;
+export const ES_READONLY = 0x0800;
+export const ES_NUMBER = 0x2000;
+
+export const EN_CHANGE = 0x0300;
+
+export const LB_ADDSTRING = 0x0180;
+export const LB_INSERTSTRING = 0x0181;
+export const LB_DELETESTRING = 0x0182;
+export const LB_RESETCONTENT = 0x0184;
+export const LB_SETCURSEL = 0x0186;
+export const LB_GETSEL = 0x0187;
+export const LB_GETCURSEL = 0x0188;
+export const LB_GETTEXT = 0x0189;
+export const LB_GETTEXTLEN = 0x018a;
+export const LB_GETCOUNT = 0x018b;
+export const LB_SELECTSTRING = 0x018c;
+export const LB_GETTOPINDEX = 0x018e;
+export const LB_FINDSTRING = 0x018f;
+export const LB_SETTOPINDEX = 0x0197;
+export const LB_GETITEMDATA = 0x0199;
+export const LB_SETITEMDATA = 0x019a;
+export const LB_GETITEMHEIGHT = 0x01a1;
+export const LB_FINDSTRINGEXACT = 0x01a2;
+export const LB_ERR = -1;
+
+export const LBS_NOTIFY = 0x0001;
+export const LBS_SORT = 0x0002;
+
+export const LBN_SELCHANGE = 1;
+export const LBN_DBLCLK = 2;
+
+export const SIZE_RESTORED = 0;
+
+export const MK_LBUTTON = 0x0001;
+export const MK_RBUTTON = 0x0002;
+export const MK_SHIFT = 0x0004;
+export const MK_CONTROL = 0x0008;
+export const MK_MBUTTON = 0x0010;
+export const WHEEL_DELTA = 120;
+
+export const SW_HIDE = 0;
+
+export const PM_REMOVE = 0x0001;
+
+export const GWLP_WNDPROC = -4;
+export const GWLP_HINSTANCE = -6;
+export const GWLP_ID = -12;
+export const GWL_STYLE = -16;
+export const GWL_EXSTYLE = -20;
+export const GWLP_USERDATA = -21;
+
+export const WS_CHILD = 0x40000000;
+export const WS_VISIBLE = 0x10000000;
+export const WS_EX_CLIENTEDGE = 0x0200;
+export const CW_USEDEFAULT = 0x80000000;
+
+export function makeLParam(low, high) {
+  return (((high & 0xffff) << 16) | (low & 0xffff)) >>> 0;
+}
@@ -0,0 +1,147 @@
+// Text stored as a list of pieces, each a span of an immutable chunk (the
+// initial text or one inserted string). An edit splits at most two pieces
+// and never copies existing text; appending at the end, the common case for
+// logs, is a push. Line starts (offsets just past each '\n') are kept sorted
+// and updated only from the edited line on, so an append costs the length
+// of what was appended regardless of how much text there already is.
+export class PieceTable {
+  constructor(text = '') {
+    this.chunks = [];
+    this.pieces = [];
+    this.offsets = [];
+    this.length = 0;
+    this.lineStarts = [0];
+    if (text) this.insert(0, text);
+  }
+
+  get lineCount() {
+    return this.lineStarts.length;
+  }
+
+  // Index of the piece containing `offset`.
+  pieceAt(offset) {
+    let low = 0;
+    let high = this.pieces.length - 1;
+    while (low < high) {
+      const mid = (low + high + 1) >> 1;
+      if (this.offsets[mid] <= offset) low = mid;
+      else high = mid - 1;
+    }
+    return low;
+  }
+
+  // Makes a piece boundary at `offset` and returns the index of the piece
+  // starting there (pieces.length at the end of the text).
+  splitAt(offset) {
+    if (offset >= this.length) return this.pieces.length;
+    const index = this.pieceAt(offset);
+    const piece = this.pieces[index];
+    const cut = offset - this.offsets[index];
+    if (!cut) return index;
+    this.pieces.splice(
+      index,
+      1,
+      { chunk: piece.chunk, start: piece.start, length: cut },
+      { chunk: piece.chunk, start: piece.start + cut, length: piece.length - cut },
+    );
+    this.offsets.splice(index + 1, 0, offset);
+    return index + 1;
+  }
+
+  reindex(from) {
+    let offset = from ? this.offsets[from - 1] + this.pieces[from - 1].length : 0;
+    this.offsets.length = this.pieces.length;
+    for (let index = from; index < this.pieces.length; index++) {
+      this.offsets[index] = offset;
+      offset += this.pieces[index].length;
+    }
+  }
+
+  insert(offset, text) {
+    if (!text) return;
+    const at = Math.max(0, Math.min(offset, this.length));
+    const index = this.splitAt(at);
+    this.chunks.push(text);
+    this.pieces.splice(index, 0, { chunk: this.chunks.length - 1, start: 0, length: text.length });
+    this.reindex(index);
+    this.length += text.length;
+
+    const line = this.lineFromOffset(at);
+    const starts = [];
+    for (let found = text.indexOf('\n'); found !== -1; found = text.indexOf('\n', found + 1)) {
+      starts.push(at + found + 1);
+    }
+    if (line + 1 === this.lineStarts.length) {
+      starts.forEach((start) => this.lineStarts.push(start));
+      return;
+    }
+    const following = this.lineStarts.slice(line + 1).map((start) => start + text.length);
+    this.lineStarts = this.lineStarts.slice(0, line + 1).concat(starts, following);
+  }
+
+  delete(start, end) {
+    const from = Math.max(0, Math.min(start, this.length));
+    const to = Math.max(from, Math.min(end, this.length));
+    if (from === to) return;
+    const first = this.splitAt(from);
+    const last = this.splitAt(to);
+    this.pieces.splice(first, last - first);
+    this.reindex(first);
+    this.length -= to - from;
+
+    const line = this.lineFromOffset(from);
+    let removed = 0;
+    while (line + 1 + removed < this.lineStarts.length && this.lineStarts[line + 1 + removed] <= to) removed++;
+    this.lineStarts.splice(line + 1, removed);
+    for (let index = line + 1; index < this.lineStarts.length; index++) this.lineStarts[index] -= to - from;
+  }
+
+  replace(start, end, text) {
+    this.delete(start, end);
+    this.insert(start, text);
+  }
+
+  slice(start = 0, end = this.length) {
+    const from = Math.max(0, start);
+    const to = Math.min(end, this.length);
+    if (from >= to) return '';
+    const parts = [];
+    for (let index = this.pieceAt(from); index < this.pieces.length && this.offsets[index] < to; index++) {
+      const piece = this.pieces[index];
+      const begin = Math.max(from - this.offsets[index], 0);
+      const finish = Math.min(to - this.offsets[index], piece.length);
+      parts.push(this.chunks[piece.chunk].slice(piece.start + begin, piece.start + finish));
+    }
+    return parts.join('');
+  }
+
+  toString() {
+    return this.slice();
+  }
+
+  lineFromOffset(offset) {
+    let low = 0;
+    let high = this.lineStarts.length - 1;
+    while (low < high) {
+      const mid = (low + high + 1) >> 1;
+      if (this.lineStarts[mid] <= offset) low = mid;
+      else high = mid - 1;
+    }
+    return low;
+  }
+
+  lineStart(line) {
+    return this.lineStarts[Math.max(0, Math.min(line, this.lineStarts.length - 1))];
+  }
+
+  // Offset just past the line's text, before its '\r\n' or '\n'.
+  lineEnd(line) {
+    if (line + 1 >= this.lineStarts.length) return this.length;
+    const end = this.lineStarts[line + 1] - 1;
+    return end > this.lineStarts[line] && this.slice(end - 1, end) === '\r' ? end - 1 : end;
+  }
+
+  lineText(line) {
+    return this.slice(this.lineStart(line), this.lineEnd(line));
+  }
+}
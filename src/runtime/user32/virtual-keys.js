@@ -0,0 +1,125 @@
+export const VK_LBUTTON = 0x01;
+export const VK_RBUTTON = 0x02;
+export const VK_MBUTTON = 0x04;
+export const VK_BACK = 0x08;
+export const VK_TAB = 0x09;
+export const VK_RETURN = 0x0d;
+export const VK_SHIFT = 0x10;
+export const VK_CONTROL = 0x11;
+export const VK_MENU = 0x12;
+export const VK_CAPITAL = 0x14;
+export const VK_ESCAPE = 0x1b;
+export const VK_SPACE = 0x20;
+export const VK_PRIOR = 0x21;
+export const VK_NEXT = 0x22;
+export const VK_END = 0x23;
+export const VK_HOME = 0x24;
+export const VK_LEFT = 0x25;
+export const VK_UP = 0x26;
+export const VK_RIGHT = 0x27;
+export const VK_DOWN = 0x28;
+export const VK_DELETE = 0x2e;
+export const VK_NUMLOCK = 0x90;
+export const VK_SCROLL = 0x91;
+export const VK_LSHIFT = 0xa0;
+export const VK_RSHIFT = 0xa1;
+export const VK_LCONTROL = 0xa2;
+export const VK_RCONTROL = 0xa3;
+export const VK_LMENU = 0xa4;
+export const VK_RMENU = 0xa5;
+
+// Sided modifiers also drive the generic VK_SHIFT/VK_CONTROL/VK_MENU entry,
+// which is what key messages carry in wParam.
+export const GENERIC_MODIFIER = new Map([
+  [VK_LSHIFT, VK_SHIFT],
+  [VK_RSHIFT, VK_SHIFT],
+  [VK_LCONTROL, VK_CONTROL],
+  [VK_RCONTROL, VK_CONTROL],
+  [VK_LMENU, VK_MENU],
+  [VK_RMENU, VK_MENU],
+]);
+
+// KeyboardEvent.code -> [virtual key, set 1 scan code, extended].
+const KEYS = new Map([
+  ['Escape', [VK_ESCAPE, 0x01]],
+  ['Minus', [0xbd, 0x0c]],
+  ['Equal', [0xbb, 0x0d]],
+  ['Backspace', [VK_BACK, 0x0e]],
+  ['Tab', [VK_TAB, 0x0f]],
+  ['BracketLeft', [0xdb, 0x1a]],
+  ['BracketRight', [0xdd, 0x1b]],
+  ['Enter', [VK_RETURN, 0x1c]],
+  ['ControlLeft', [VK_LCONTROL, 0x1d]],
+  ['Semicolon', [0xba, 0x27]],
+  ['Quote', [0xde, 0x28]],
+  ['Backquote', [0xc0, 0x29]],
+  ['ShiftLeft', [VK_LSHIFT, 0x2a]],
+  ['Backslash', [0xdc, 0x2b]],
+  ['Comma', [0xbc, 0x33]],
+  ['Period', [0xbe, 0x34]],
+  ['Slash', [0xbf, 0x35]],
+  ['ShiftRight', [VK_RSHIFT, 0x36]],
+  ['NumpadMultiply', [0x6a, 0x37]],
+  ['AltLeft', [VK_LMENU, 0x38]],
+  ['Space', [VK_SPACE, 0x39]],
+  ['CapsLock', [VK_CAPITAL, 0x3a]],
+  ['NumLock', [VK_NUMLOCK, 0x45]],
+  ['ScrollLock', [VK_SCROLL, 0x46]],
+  ['Numpad7', [0x67, 0x47]],
+  ['Numpad8', [0x68, 0x48]],
+  ['Numpad9', [0x69, 0x49]],
+  ['NumpadSubtract', [0x6d, 0x4a]],
+  ['Numpad4', [0x64, 0x4b]],
+  ['Numpad5', [0x65, 0x4c]],
+  ['Numpad6', [0x66, 0x4d]],
+  ['NumpadAdd', [0x6b, 0x4e]],
+  ['Numpad1', [0x61, 0x4f]],
+  ['Numpad2', [0x62, 0x50]],
+  ['Numpad3', [0x63, 0x51]],
+  ['Numpad0', [0x60, 0x52]],
+  ['NumpadDecimal', [0x6e, 0x53]],
+  ['F11', [0x7a, 0x57]],
+  ['F12', [0x7b, 0x58]],
+  ['NumpadEnter', [VK_RETURN, 0x1c, true]],
+  ['ControlRight', [VK_RCONTROL, 0x1d, true]],
+  ['NumpadDivide', [0x6f, 0x35, true]],
+  ['AltRight', [VK_RMENU, 0x38, true]],
+  ['Home', [VK_HOME, 0x47, true]],
+  ['ArrowUp', [VK_UP, 0x48, true]],
+  ['PageUp', [VK_PRIOR, 0x49, true]],
+  ['ArrowLeft', [VK_LEFT, 0x4b, true]],
+  ['ArrowRight', [VK_RIGHT, 0x4d, true]],
+  ['End', [VK_END, 0x4f, true]],
+  ['ArrowDown', [VK_DOWN, 0x50, true]],
+  ['PageDown', [VK_NEXT, 0x51, true]],
+  ['Insert', [0x2d, 0x52, true]],
+  ['Delete', [VK_DELETE, 0x53, true]],
+  ['MetaLeft', [0x5b, 0x5b, true]],
+  ['MetaRight', [0x5c, 0x5c, true]],
+  ['ContextMenu', [0x5d, 0x5d, true]],
+]);
+
+const LETTER_SCANS = [
+  0x1e, 0x30, 0x2e, 0x20, 0x12, 0x21, 0x22, 0x23, 0x17, 0x24, 0x25, 0x26, 0x32,
+  0x31, 0x18, 0x19, 0x10, 0x13, 0x1f, 0x14, 0x16, 0x2f, 0x11, 0x2d, 0x15, 0x2c,
+];
+
+LETTER_SCANS.forEach((scan, index) => {
+  const letter = String.fromCharCode(0x41 + index);
+  KEYS.set(`Key${letter}`, [0x41 + index, scan]);
+});
+for (let digit = 0; digit <= 9; digit++) {
+  KEYS.set(`Digit${digit}`, [0x30 + digit, digit === 0 ? 0x0b : digit + 1]);
+}
+for (let index = 0; index < 10; index++) {
+  KEYS.set(`F${index + 1}`, [0x70 + index, 0x3b + index]);
+}
+
+// The virtual key, scan code and extended flag for a DOM KeyboardEvent.code,
+// or null for keys Win32 has no code for.
+export function virtualKeyForCode(code) {
+  const entry = KEYS.get(code);
+  if (!entry) return null;
+  const [vk, scan, extended = false] = entry;
+  return { vk, scan, extended };
+}
@@ -0,0 +1,393 @@
+import { Gdi } from '../gdi/gdi.js';
+import { addRect, boundingRect, intersectRect, makeRect, subtractRect } from '../gdi/rect-list.js';
+import { bindCanvasInput } from './dom-input.js';
+import { EditControl } from './edit-control.js';
+import { InputState } from './input-state.js';
+import { ListBox } from './list-box.js';
+import { ThreadMessageQueue } from './message-queue.js';
+import {
+  CW_USEDEFAULT,
+  WM_LBUTTONDOWN,
+  WM_MBUTTONDOWN,
+  WM_MOUSEWHEEL,
+  WM_RBUTTONDOWN,
+  WS_CHILD,
+  makeLParam,
+} from './messages.js';
+
+export const MAIN_THREAD_ID = 1;
+const FIRST_HWND = 0x10010;
+const FIRST_ATOM = 0xc000;
+const FIRST_SYSTEM_ATOM = 0x8000;
+const USER_TIMER_MINIMUM = 10;
+const DEFAULT_WIDTH = 640;
+const DEFAULT_HEIGHT = 480;
+
+// Control classes user32 implements itself: windows of these classes get a
+// host-side `control` that answers their messages instead of a WndProc.
+const SYSTEM_CLASSES = [
+  ['EDIT', (window, station) => new EditControl(window, station)],
+  ['LISTBOX', (window, station) => new ListBox(window, station)],
+];
+
+function resolveDefault(value, fallback) {
+  return (value >>> 0) === CW_USEDEFAULT ? fallback : value;
+}
+
+// Host-side window state for one guest process: registered classes, the
+// window tree, per-thread queues and timers. Everything that has to run guest
+// code (WndProcs, TimerProcs) lives in the user32 import plugin; this class
+// only answers questions and mutates state. Windows with a WindowManager get
+// a canvas surface per top-level window, which `gdi` draws into, and child
+// windows get their own when the manager composites layers. Each window
+// keeps its update region as a short rect list; the queue's paint flag is set
+// while it is non-empty. Host input from each top-level canvas (`bindInput`)
+// is posted like the raw input thread does: mouse messages to the capture
+// window or the window under the cursor, keys to the focus window.
+export class WindowStation {
+  constructor({
+    windowManager = null,
+    now = () => Date.now(),
+    setInterval: startInterval = (fn, ms) => setInterval(fn, ms),
+    clearInterval: stopInterval = (id) => clearInterval(id),
+    requestFrame,
+    hostNow,
+    bindInput = bindCanvasInput,
+  } = {}) {
+    this.windowManager = windowManager;
+    this.gdi = new Gdi({
+      windowManager,
+      onPresent: () => this.input.presented(),
+      ...(requestFrame && { requestFrame }),
+    });
+    this.input = new InputState(hostNow && { now: hostNow });
+    this.bindInput = bindInput;
+    this.unbindInput = new Map();
+    this.focus = 0;
+    this.capture = 0;
+    this.now = now;
+    this.startInterval = startInterval;
+    this.stopInterval = stopInterval;
+    this.classes = new Map();
+    this.atoms = new Map();
+    this.windows = new Map();
+    this.queues = new Map();
+    this.intervals = new Map();
+    this.nextHwnd = FIRST_HWND;
+    this.nextAtom = FIRST_ATOM;
+    this.nextTimerId = 1;
+    SYSTEM_CLASSES.forEach(([name, createControl], index) => {
+      const atom = FIRST_SYSTEM_ATOM + index;
+      this.addClass({ name, atom, wndProc: 0n, style: 0, windowExtra: 0, instance: 0n, background: 0, createControl });
+    });
+  }
+
+  addClass(windowClass) {
+    this.classes.set(windowClass.name.toLowerCase(), windowClass);
+    this.atoms.set(windowClass.atom, windowClass);
+  }
+
+  queue(threadId = MAIN_THREAD_ID) {
+    let queue = this.queues.get(threadId);
+    if (!queue) {
+      queue = new ThreadMessageQueue(threadId, { now: this.now });
+      this.queues.set(threadId, queue);
+    }
+    return queue;
+  }
+
+  registerClass({ name, wndProc, style = 0, windowExtra = 0, instance = 0n, background = 0 }) {
+    if (this.classes.has(name.toLowerCase())) return 0;
+    const atom = this.nextAtom++;
+    this.addClass({ name, atom, wndProc, style, windowExtra, instance, background });
+    return atom;
+  }
+
+  unregisterClass(name) {
+    const windowClass = this.findClass(name);
+    if (!windowClass || windowClass.createControl) return false;
+    this.classes.delete(windowClass.name.toLowerCase());
+    this.atoms.delete(windowClass.atom);
+    return true;
+  }
+
+  findClass(nameOrAtom) {
+    if (typeof nameOrAtom === 'number') return this.atoms.get(nameOrAtom) ?? null;
+    return this.classes.get(String(nameOrAtom).toLowerCase()) ?? null;
+  }
+
+  createWindow({
+    className,
+    title = '',
+    style = 0,
+    exStyle = 0,
+    x,
+    y,
+    width,
+    height,
+    parent = 0,
+    menu = 0n,
+    instance = 0n,
+    unicode = true,
+  }) {
+    const windowClass = this.findClass(className);
+    if (!windowClass) return null;
+    const hwnd = this.nextHwnd;
+    this.nextHwnd += 4;
+    const window = {
+      hwnd,
+      threadId: MAIN_THREAD_ID,
+      windowClass,
+      wndProc: windowClass.wndProc,
+      title,
+      style,
+      exStyle,
+      x: resolveDefault(x, 20),
+      y: resolveDefault(y, 20),
+      width: resolveDefault(width, DEFAULT_WIDTH),
+      height: resolveDefault(height, DEFAULT_HEIGHT),
+      parent,
+      id: menu,
+      instance,
+      unicode,
+      longs: new Map(),
+      visible: false,
+      sizeSent: false,
+      surface: 0,
+      updateRects: [],
+      eraseBackground: false,
+      control: null,
+    };
+    window.control = windowClass.createControl?.(window, this) ?? null;
+    if (!(style & WS_CHILD) && this.windowManager) {
+      window.surface = this.windowManager.createWindow(window.x, window.y, window.width, window.height, title);
+      this.windowManager.markAsExternallyRendered?.(window.surface);
+      const host = this.windowManager.getWindow?.(window.surface);
+      const unbind = this.bindInput?.(host?.canvas, this, window, host?.element ?? host?.canvas);
+      if (unbind) this.unbindInput.set(hwnd, unbind);
+    } else if (this.windowManager?.createChildWindow) {
+      const host = this.getWindow(parent) && this.paintTarget(this.getWindow(parent));
+      if (host?.surface) {
+        const { x: left, y: top, width: w, height: h } = window;
+        window.surface = this.windowManager.createChildWindow(host.surface, host.x + left, host.y + top, w, h);
+      }
+    }
+    this.windows.set(hwnd, window);
+    return window;
+  }
+
+  getWindow(hwnd) {
+    return this.windows.get(hwnd) ?? null;
+  }
+
+  childrenOf(hwnd) {
+    return Array.from(this.windows.values()).filter((window) => window.parent === hwnd);
+  }
+
+  removeWindow(hwnd) {
+    const window = this.windows.get(hwnd);
+    if (!window) return;
+    const queue = this.queue(window.threadId);
+    queue.removeWindow(hwnd);
+    Array.from(queue.timers.values())
+      .filter((timer) => timer.hwnd === hwnd)
+      .forEach((timer) => this.killTimer(hwnd, timer.id));
+    this.windows.delete(hwnd);
+    if (this.focus === hwnd) this.focus = 0;
+    if (this.capture === hwnd) this.capture = 0;
+    this.unbindInput.get(hwnd)?.();
+    this.unbindInput.delete(hwnd);
+    if (!window.surface) return;
+    this.gdi.releaseSurface(window.surface);
+    this.windowManager?.destroyWindow?.(window.surface);
+  }
+
+  clientRect(window) {
+    return makeRect(0, 0, window.width, window.height);
+  }
+
+  // The surface a window draws into and its client origin there: its own
+  // when the window manager composites children, else its top-level's.
+  paintTarget(window) {
+    let x = 0;
+    let y = 0;
+    let current = window;
+    while (!current.surface && this.getWindow(current.parent)) {
+      x += current.x;
+      y += current.y;
+      current = this.getWindow(current.parent);
+    }
+    return { surface: current.surface, x, y };
+  }
+
+  // Offset of a window's client area inside its top-level window.
+  clientOrigin(window) {
+    let x = 0;
+    let y = 0;
+    for (let current = window; this.getWindow(current.parent); current = this.getWindow(current.parent)) {
+      x += current.x;
+      y += current.y;
+    }
+    return { x, y };
+  }
+
+  getDC(window) {
+    return this.gdi.openDC(window, this.paintTarget(window), [this.clientRect(window)]).hdc;
+  }
+
+  // Takes the update region: the DC clips to it, and the window is valid
+  // again. `erase` says whether WM_ERASEBKGND is owed.
+  beginPaint(window) {
+    const rects = window.updateRects;
+    const erase = window.eraseBackground;
+    window.updateRects = [];
+    window.eraseBackground = false;
+    this.queue(window.threadId).validate(window.hwnd);
+    const dc = this.gdi.openDC(window, this.paintTarget(window), rects);
+    return { hdc: dc.hdc, rect: boundingRect(rects), erase };
+  }
+
+  showWindow(window, visible) {
+    window.visible = visible;
+    if (visible && !this.focus && !(window.style & WS_CHILD)) this.focus = window.hwnd;
+    if (!window.surface) return;
+    if (visible) this.windowManager?.showWindow(window.surface);
+    else this.windowManager?.setWindowVisible?.(window.surface, false);
+  }
+
+  topLevelOf(window) {
+    let current = window;
+    for (let parent = this.getWindow(current.parent); parent; parent = this.getWindow(current.parent)) current = parent;
+    return current;
+  }
+
+  setFocus(hwnd) {
+    const previous = this.focus;
+    this.focus = this.getWindow(hwnd) ? hwnd : 0;
+    return previous;
+  }
+
+  setCapture(hwnd) {
+    const previous = this.capture;
+    this.capture = this.getWindow(hwnd) ? hwnd : 0;
+    return previous;
+  }
+
+  // The deepest visible child under a client point of `window`, with the
+  // point in that child's client coordinates.
+  windowFromPoint(window, x, y) {
+    for (const child of this.childrenOf(window.hwnd)) {
+      if (!child.visible) continue;
+      if (x >= child.x && y >= child.y && x < child.x + child.width && y < child.y + child.height) {
+        return this.windowFromPoint(child, x - child.x, y - child.y);
+      }
+    }
+    return { window, x, y };
+  }
+
+  // Input messages carry their host capture time for latency accounting.
+  postInput(window, message, wParam, lParam, pt, key) {
+    const input = { stamp: this.input.now(), key };
+    this.queue(window.threadId).post(window.hwnd, message, BigInt(wParam), BigInt(lParam), pt, input);
+    return true;
+  }
+
+  // (x, y) are client coordinates of the top-level `window` whose canvas
+  // the event arrived on. A button press focuses that window unless focus
+  // is already inside it.
+  postMouse(window, message, wParam, x, y) {
+    const capture = this.getWindow(this.capture);
+    let target = this.windowFromPoint(window, x, y);
+    if (capture) {
+      const origin = this.clientOrigin(capture);
+      target = { window: capture, x: x - origin.x, y: y - origin.y };
+    }
+    const pressed = message === WM_LBUTTONDOWN || message === WM_RBUTTONDOWN || message === WM_MBUTTONDOWN;
+    const focused = this.getWindow(this.focus);
+    if (pressed && (!focused || this.topLevelOf(focused) !== window)) this.focus = window.hwnd;
+    const pt = { x: window.x + x, y: window.y + y };
+    return this.postInput(target.window, message, wParam, makeLParam(target.x, target.y), pt);
+  }
+
+  // Wheel messages go to the focus window with the point in screen
+  // coordinates, as on Windows.
+  postWheel(window, wParam, x, y) {
+    const target = this.getWindow(this.focus) ?? window;
+    const pt = { x: window.x + x, y: window.y + y };
+    return this.postInput(target, WM_MOUSEWHEEL, wParam, makeLParam(pt.x, pt.y), pt);
+  }
+
+  postKey(window, { message, wParam, lParam, key }) {
+    const target = this.getWindow(this.focus) ?? window;
+    return this.postInput(target, message, wParam, lParam, { x: 0, y: 0 }, key);
+  }
+
+  // A null rect means the whole client area; hwnd 0 invalidates every window.
+  invalidate(hwnd, rect = null, erase = true) {
+    const targets = hwnd ? [this.getWindow(hwnd)] : Array.from(this.windows.values());
+    targets.forEach((window) => {
+      if (!window) return;
+      const client = this.clientRect(window);
+      window.updateRects = addRect(window.updateRects, rect ? intersectRect(rect, client) : client);
+      window.eraseBackground ||= erase;
+      if (window.updateRects.length) this.queue(window.threadId).invalidate(window.hwnd);
+    });
+    return targets.every(Boolean);
+  }
+
+  validate(hwnd, rect = null) {
+    const window = this.getWindow(hwnd);
+    if (!window) return false;
+    window.updateRects = rect ? subtractRect(window.updateRects, rect) : [];
+    if (!window.updateRects.length) {
+      window.eraseBackground = false;
+      this.queue(window.threadId).validate(hwnd);
+    }
+    return true;
+  }
+
+  post(hwnd, message, wParam, lParam) {
+    if (!hwnd) {
+      this.queue().post(0, message, wParam, lParam);
+      return true;
+    }
+    const window = this.getWindow(hwnd);
+    if (!window) return false;
+    this.queue(window.threadId).post(hwnd, message, wParam, lParam);
+    return true;
+  }
+
+  // Re-arming an existing (hwnd, id) pair replaces its period, as on
+  // Windows. Window-less timers get a fresh id.
+  setTimer(hwnd, id, ms, proc = 0n) {
+    const window = hwnd ? this.getWindow(hwnd) : null;
+    if (hwnd && !window) return 0;
+    const timerId = hwnd ? BigInt(id) : BigInt(this.nextTimerId++);
+    const queue = this.queue(window?.threadId);
+    this.killTimer(hwnd, timerId);
+    const key = queue.addTimer(hwnd, timerId, proc);
+    const period = Math.max(USER_TIMER_MINIMUM, ms);
+    this.intervals.set(key, { queue, handle: this.startInterval(() => queue.fireTimer(key), period) });
+    return timerId || 1n;
+  }
+
+  killTimer(hwnd, id) {
+    const key = `${hwnd}:${id}`;
+    const interval = this.intervals.get(key);
+    if (!interval) return false;
+    this.stopInterval(interval.handle);
+    this.intervals.delete(key);
+    interval.queue.removeTimer(key);
+    return true;
+  }
+
+  dispose() {
+    this.intervals.forEach(({ handle }) => this.stopInterval(handle));
+    this.intervals.clear();
+    this.unbindInput.forEach((unbind) => unbind());
+    this.unbindInput.clear();
+    this.queues.forEach((queue) => queue.dispose());
+    this.windows.clear();
+    this.gdi.dispose();
+  }
+}
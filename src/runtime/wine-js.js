@@ -1,24 +1,61 @@
 import { extractPrintableStrings } from './string-utils.js';
 import { StringPanel } from './ui/string-panel.js';
+import { ConsolePanel } from './ui/console-panel.js';
 import { WindowManager } from './ui/window-manager.js';
 import { readAnsiString, readWideString } from './memory-readers.js';
-import { createImportHandler } from './import-handler.js';
+import { createImportHandler, createImportBinder } from './import-handler.js';
 import { SimulatorBridge } from './simulator/simulator-bridge.js';
 import { decodeBase64Executable } from './base64.js';
 import { createConsoleOutputImportPlugin } from './import-plugins/console-output-plugin.js';
 import { createWinsockWebSocketImportPlugin } from './import-plugins/winsock-websocket-plugin.js';
+import { createModuleLoaderImportPlugin } from './import-plugins/module-loader-plugin.js';
+import { createWaitImportPlugin } from './import-plugins/wait-plugin.js';
+import { createTimeImportPlugin } from './import-plugins/time-plugin.js';
+import { createUser32ImportPlugin } from './import-plugins/user32-plugin.js';
+import { createGdiImportPlugin } from './import-plugins/gdi-plugin.js';
+import { createDirect2DImportPlugin } from './import-plugins/direct2d-plugin.js';
+import { createWebGLPresenter } from './plugins/directx-webgl-plugin.js';
 import { createX86SimulatorPlugin } from './simulator/plugins/x86-simulator-plugin.js';
 import { BackendBridge } from './services/backend-bridge.js';
 import { BlockDeviceClient } from './services/block-device-client.js';
 import { WinsockBridge } from './services/winsock-bridge.js';
+import { VirtualClock } from './services/virtual-clock.js';
+import { ImageCache } from './cache/image-cache.js';
+import { IndexedDbCacheStore } from './cache/indexeddb-cache-store.js';
+import { StreamingImage } from '../emulator/streaming-image.js';
+import { PeFile } from '../emulator/pe-file.js';
+import { StringScanPool } from './strings/string-scan-pool.js';
+
+const STREAMING_THRESHOLD = 4 * 1024 * 1024;
+
+function createDefaultImageCache(log) {
+  if (typeof indexedDB === 'undefined') return null;
+  return new ImageCache({ store: new IndexedDbCacheStore(), log });
+}
 
 export class WineJS {
-  constructor({ consoleEl, stringEl, canvasEl, statusEl, plugins = [], importPlugins, simulatorPlugins } = {}) {
+  constructor({
+    consoleEl,
+    stringEl,
+    canvasEl,
+    statusEl,
+    plugins = [],
+    importPlugins,
+    simulatorPlugins,
+    imageCache,
+    fastForward = false,
+  } = {}) {
     this.consoleEl = consoleEl;
+    this.consolePanel = new ConsolePanel(consoleEl);
     this.statusEl = statusEl;
     this.apiHooks = {};
     this.modules = new Map();
+    this.cachedImages = new Map();
+    this.cacheStatus = null;
+    this.imageCache = imageCache === undefined ? createDefaultImageCache((message) => this.log(message)) : imageCache;
     this.stringPanel = new StringPanel(stringEl);
+    this.stringScanner = new StringScanPool();
+    this.stringScanGeneration = 0;
     this.windowManager = new WindowManager(canvasEl);
     this.utf8Decoder = new TextDecoder();
     this.utf16Decoder = new TextDecoder('utf-16le');
@@ -31,29 +68,52 @@ export class WineJS {
     this.winsockBridge = new WinsockBridge({
       log: (message) => this.log(message),
     });
+    this.clock = new VirtualClock({ fastForward });
+    this.runGeneration = 0;
 
-    const importHandler = createImportHandler({
+    const importHelpers = {
       readAnsiString: (cpu, address, maxLength) =>
         readAnsiString(cpu, address, this.utf8Decoder, maxLength),
       readWideString: (cpu, address, maxChars) =>
         readWideString(cpu, address, this.utf16Decoder, maxChars),
       log: (message) => this.log(message),
       plugins: this.importPlugins,
-    });
+    };
 
-    this.importHandler = importHandler;
+    this.importHandler = createImportHandler(importHelpers);
+    this.importBinder = createImportBinder(importHelpers);
     this.simulatorBridge = new SimulatorBridge({
       importHandler: (params) => this.importHandler(params),
+      importBinder: (name, state) => this.importBinder(name, state),
     });
 
     const defaultImportPlugins =
       importPlugins ??
       [
+        createUser32ImportPlugin({
+          getWindowManager: () => this.windowManager,
+          getClock: () => this.clock,
+          waitForObject: (handle, options) => this.waitForObject(handle, options),
+        }),
+        createGdiImportPlugin({ stationFor: (cpu) => this.stationFor(cpu) }),
+        createDirect2DImportPlugin({
+          stationFor: (cpu) => this.stationFor(cpu),
+          presenter: createWebGLPresenter(),
+        }),
         createConsoleOutputImportPlugin(),
         createWinsockWebSocketImportPlugin({
           getWinsockBridge: () => this.winsockBridge,
           log: (message) => this.log(message),
         }),
+        createModuleLoaderImportPlugin({
+          log: (message) => this.log(message),
+        }),
+        createTimeImportPlugin({ getClock: () => this.clock }),
+        createWaitImportPlugin({
+          waitForObject: (handle, options) => this.waitForObject(handle, options),
+          schedule: (fn, ms) => this.clock.setTimeout(fn, ms),
+          unschedule: (id) => this.clock.clearTimeout(id),
+        }),
       ];
     defaultImportPlugins.forEach((plugin) => this.registerImportPlugin(plugin));
 
@@ -64,18 +124,15 @@ export class WineJS {
   }
 
   log(message) {
-    if (!this.consoleEl) return;
-    this.consoleEl.textContent += `${message}\n`;
-    this.consoleEl.scrollTop = this.consoleEl.scrollHeight;
+    this.consolePanel.append(message);
   }
 
   clearConsole() {
-    if (this.consoleEl) {
-      this.consoleEl.textContent = '';
-    }
+    this.consolePanel.clear();
   }
 
   clearStrings() {
+    this.stringScanGeneration++;
     this.stringPanel.clear();
   }
 
@@ -83,12 +140,46 @@ export class WineJS {
     this.windowManager.clear();
   }
 
+  // Drops timers, windows and waitable objects left by the previous guest
+  // and restarts virtual time at zero.
+  resetGuestServices() {
+    this.runGeneration++;
+    this.importPlugins.forEach((plugin) => plugin?.reset?.());
+    this.clock.reset();
+  }
+
+  // First import plugin that owns `handle` decides; null reads as signaled.
+  // `options.signal` aborts when the waiter gives up.
+  waitForObject(handle, options) {
+    for (const plugin of this.importPlugins) {
+      const pending = plugin?.waitForObject?.(handle, options);
+      if (pending) return pending;
+    }
+    return null;
+  }
+
+  // The user32 window station (and its GDI) a guest CPU draws through.
+  stationFor(cpu) {
+    const plugin = this.importPlugins.find((candidate) => typeof candidate?.stationFor === 'function');
+    return plugin?.stationFor(cpu) ?? null;
+  }
+
+  // Host input to presented frame, in ms, for the latest guest's windows.
+  inputLatency() {
+    const plugin = this.importPlugins.find((candidate) => candidate?.station);
+    return plugin?.station.input.latency() ?? null;
+  }
+
   setStatus(text) {
     if (this.statusEl) {
       this.statusEl.textContent = text;
     }
   }
 
+  setCacheStatus(state) {
+    this.cacheStatus = state;
+  }
+
   registerPlugin(plugin) {
     if (!plugin) return;
     this.plugins.push(plugin);
@@ -138,9 +229,10 @@ export class WineJS {
   async loadBinary(file) {
     return new Promise((resolve, reject) => {
       const reader = new FileReader();
-      reader.onload = () => {
+      reader.onload = async () => {
         const buffer = new Uint8Array(reader.result);
         this.modules.set(file.name, buffer);
+        this.rememberImageCache(file, await this.lookupImageCache(buffer));
         this.runHook('onFileLoaded', { file, buffer });
         resolve(buffer);
       };
@@ -149,12 +241,75 @@ export class WineJS {
     });
   }
 
+  async lookupImageCache(buffer) {
+    if (!this.imageCache) {
+      this.setCacheStatus(null);
+      return null;
+    }
+    try {
+      const entry = await this.imageCache.lookup(buffer);
+      this.setCacheStatus(entry.hit ? 'hit' : 'miss');
+      return entry;
+    } catch (err) {
+      this.log(`[WineJS] Image cache unavailable: ${err?.message ?? err}`);
+      this.setCacheStatus(null);
+      return null;
+    }
+  }
+
+  rememberImageCache(file, entry) {
+    if (entry) Object.assign(entry, { size: file.size, lastModified: file.lastModified });
+    this.cachedImages.set(file.name, entry);
+  }
+
+  // Cache entries are keyed by the image hash, which a stream only has once
+  // the whole file is in. A file hashed on an earlier run, with the same
+  // name, size and modification time, can use its record from the start.
+  knownImageCache(file) {
+    const entry = this.cachedImages.get(file.name);
+    if (!entry?.record || entry.size !== file.size || entry.lastModified !== file.lastModified) return null;
+    this.setCacheStatus('hit');
+    return entry;
+  }
+
+  storeImageCache(entry, buffer, record) {
+    if (!this.imageCache || !entry || !record) return;
+    this.imageCache.save(entry.hash, buffer.length, record).then((saved) => {
+      if (saved) entry.record = record;
+    });
+  }
+
   extractStrings(buffer) {
     const strings = extractPrintableStrings(buffer);
     this.runHook('onStringsExtracted', { buffer, strings });
     return strings;
   }
 
+  scanStrings(buffer) {
+    const generation = ++this.stringScanGeneration;
+    const isCancelled = () => generation !== this.stringScanGeneration;
+    let sections = [];
+    try {
+      sections = new PeFile(buffer).sections;
+    } catch {
+      sections = [];
+    }
+    this.stringPanel.clear();
+    return this.stringScanner
+      .scan(buffer, { sections, isCancelled, onStrings: (batch) => this.stringPanel.append(batch) })
+      .then((strings) => {
+        if (isCancelled()) return strings;
+        this.stringPanel.finish();
+        this.runHook('onStringsExtracted', { buffer, strings });
+        this.runHook('onStringsDisplayed', { strings });
+        return strings;
+      })
+      .catch((err) => {
+        this.log(`[WineJS] String scan failed: ${err?.message ?? err}`);
+        return [];
+      });
+  }
+
   displayStrings(strings) {
     this.stringPanel.render(strings);
     this.runHook('onStringsDisplayed', { strings });
@@ -168,6 +323,10 @@ export class WineJS {
     return this.simulatorBridge.simulateBinary(buffer, options);
   }
 
+  simulateBinaryAsync(buffer, options = {}) {
+    return this.simulatorBridge.simulateBinaryAsync(buffer, options);
+  }
+
   decodeBase64Executable(payload) {
     return decodeBase64Executable(payload);
   }
@@ -238,7 +397,48 @@ export class WineJS {
     this.windowManager.processMessages();
   }
 
-  run(file) {
+  async loadAndRun(file) {
+    if (typeof file.stream !== 'function' || file.size < STREAMING_THRESHOLD) {
+      await this.loadBinary(file);
+      return this.run(file);
+    }
+    return this.runStreaming(file);
+  }
+
+  async runStreaming(file) {
+    const image = new StreamingImage(file.size);
+    const consuming = image.consume(file.stream());
+    const buffer = image.buffer;
+    this.modules.set(file.name, buffer);
+    this.clearConsole();
+    this.clearWindows();
+    this.resetGuestServices();
+
+    const pe = await image.readHeaders();
+    await image.waitFor(image.startOffset(pe));
+    this.setStatus(`${file.name} — starting with ${((image.loaded / image.size) * 100).toFixed(0)}% resident`);
+    this.runHook('onBeforeSimulate', { file, buffer });
+    const known = this.knownImageCache(file);
+    const simulation = await this.simulateBinaryAsync(buffer, {
+      file,
+      modules: this.modules,
+      pe,
+      streamingImage: image,
+      cacheRecord: known?.record,
+      interactive: true,
+    });
+    await consuming;
+    if (image.error) throw image.error;
+    this.runHook('onFileLoaded', { file, buffer });
+    const cached = known ?? (await this.lookupImageCache(buffer));
+    this.rememberImageCache(file, cached);
+    this.storeImageCache(cached, buffer, simulation.cacheRecord);
+    this.runHook('onAfterSimulate', { file, buffer, simulation });
+    this.followSession(file, simulation);
+    return this.presentSimulation(file, buffer, simulation, cached);
+  }
+
+  async run(file) {
     const buffer = this.modules.get(file.name);
     if (!buffer) {
       this.log('[WineJS] No binary loaded.');
@@ -247,37 +447,61 @@ export class WineJS {
 
     this.clearConsole();
     this.clearWindows();
+    this.resetGuestServices();
 
+    const cached = this.cachedImages.get(file.name);
     this.runHook('onBeforeSimulate', { file, buffer });
-    const simulation = this.simulateBinary(buffer, { file });
+    const simulation = await this.simulateBinaryAsync(buffer, {
+      file,
+      modules: this.modules,
+      cacheRecord: cached?.record,
+      interactive: true,
+    });
+    this.storeImageCache(cached, buffer, simulation.cacheRecord);
     this.runHook('onAfterSimulate', { file, buffer, simulation });
-    const printableStrings = this.extractStrings(buffer).filter((s) => s.trim());
+    this.followSession(file, simulation);
+    return this.presentSimulation(file, buffer, simulation, cached);
+  }
+
+  // A guest presented from its message loop keeps running; report how it
+  // ends unless another run has replaced it in the meantime.
+  followSession(file, simulation) {
+    if (!simulation.session) return;
+    const generation = this.runGeneration;
+    simulation.session.then((ended) => {
+      if (generation !== this.runGeneration) return;
+      if (ended.error) this.log(`[WineJS] x86 simulation failed: ${ended.error}`);
+      this.runHook('onSessionEnd', { file, simulation: ended });
+    });
+  }
+
+  presentSimulation(file, buffer, simulation, cached) {
+    this.stringScan = this.scanStrings(buffer);
     const statusChunks = [`${file.name}`, `${(file.size / 1024).toFixed(1)} KB`];
+    if (cached) statusChunks.push(`cache ${cached.hit ? 'hit' : 'miss'}`);
     if (simulation.error) {
       statusChunks.push(`simulation failed: ${simulation.error}`);
       this.setStatus(statusChunks.join(' — '));
-      this.displayStrings(printableStrings);
       this.log(`[WineJS] x86 simulation failed: ${simulation.error}`);
       this.runHook('onSimulationError', { file, buffer, error: simulation.error });
       return simulation;
     }
-    statusChunks.push(`imports walked: ${simulation.importTrace.length}`);
+    statusChunks.push(`imports walked: ${simulation.importCalls ?? simulation.importTrace.length}`);
     statusChunks.push(simulation.guiIntent ? 'GUI intent via API usage' : 'Console intent via API usage');
     this.setStatus(statusChunks.join(' — '));
-    this.displayStrings(printableStrings);
 
-    if (simulation.guiIntent) {
+    if (simulation.guiIntent && !this.windowManager.windows.size) {
       this.log('[WineJS] GUI intent detected from simulated API calls.');
       const hwnd = this.CreateWindowEx(20, 20, 420, 300, file.name);
       this.ShowWindow(hwnd);
       this.runHook('onGuiIntent', { file, simulation, hwnd });
     }
     if (simulation.consoleLines.length) {
-      simulation.consoleLines.forEach((line) => {
-        if (!line.trim()) return;
-        this.runHook('onConsoleLine', { file, line, simulation });
-        this.callAPI('WriteConsole', line);
-      });
+      const lines = simulation.consoleLines.filter((line) => line.trim());
+      if (this.plugins.some((plugin) => typeof plugin?.onConsoleLine === 'function')) {
+        lines.forEach((line) => this.runHook('onConsoleLine', { file, line, simulation }));
+      }
+      if (lines.length) this.callAPI('WriteConsole', lines.join('\n'));
     } else if (!simulation.guiIntent) {
       this.log('[WineJS] Simulation completed with no console output detected.');
       this.runHook('onSilentConsole', { file, simulation });
@@ -0,0 +1,210 @@
+import { describe, it, expect } from 'vitest';
+import { makeRect } from '../src/runtime/gdi/rect-list.js';
+import { CompositorCore } from '../src/runtime/ui/compositor/compositor-core.js';
+import { LayerTree } from '../src/runtime/ui/compositor/layer-tree.js';
+import { WindowManager } from '../src/runtime/ui/window-manager.js';
+
+function createRecordingContext(log) {
+  return new Proxy(
+    { canvas: { width: 0, height: 0 } },
+    {
+      get(target, key) {
+        if (key in target) return target[key];
+        return (...args) => log.push([key, ...args]);
+      },
+    },
+  );
+}
+
+function createFrameQueue() {
+  const frames = [];
+  return {
+    requestFrame: (fn) => frames.push(fn),
+    run: () => frames.splice(0).forEach((fn) => fn()),
+  };
+}
+
+// Minimal DOM: elements record their listeners, styles and removal.
+function installFakeDocument() {
+  const created = [];
+  globalThis.document = {
+    createElement(tag) {
+      const listeners = new Map();
+      const element = {
+        tag,
+        style: {},
+        dataset: {},
+        addEventListener: (type, fn) => listeners.set(type, fn),
+        dispatch: (type, event = {}) => listeners.get(type)?.(event),
+        remove() {
+          element.removed = true;
+        },
+        getContext: () => null,
+      };
+      created.push(element);
+      return element;
+    },
+  };
+  return created;
+}
+
+describe('LayerTree', () => {
+  it('orders children above parents, clips them and tracks exposed damage', () => {
+    const tree = new LayerTree();
+    tree.create({ id: 1, x: 10, y: 10, width: 100, height: 100 });
+    tree.create({ id: 2, parent: 1, x: 80, y: 80, width: 50, height: 50 });
+    tree.create({ id: 3, x: 50, y: 0, width: 40, height: 40 });
+    tree.takeDamage();
+
+    expect(tree.paintOrder().map(({ layer, clip }) => [layer.id, clip])).toEqual([
+      [1, makeRect(10, 10, 110, 110)],
+      [2, makeRect(90, 90, 110, 110)],
+      [3, makeRect(50, 0, 90, 40)],
+    ]);
+
+    tree.raise(1);
+    expect(tree.paintOrder().map(({ layer }) => layer.id)).toEqual([3, 1, 2]);
+    expect(tree.takeDamage()).toEqual([makeRect(10, 10, 110, 110)]);
+
+    tree.damageContents(2, makeRect(0, 0, 50, 50));
+    expect(tree.takeDamage()).toEqual([makeRect(90, 90, 110, 110)]);
+
+    tree.move(3, 200, 0);
+    expect(tree.takeDamage()).toEqual([makeRect(50, 0, 90, 40), makeRect(200, 0, 240, 40)]);
+
+    expect(tree.destroy(1)).toEqual([2, 1]);
+    expect(tree.paintOrder().map(({ layer }) => layer.id)).toEqual([3]);
+  });
+});
+
+describe('CompositorCore', () => {
+  it('redraws only damaged rects from the layers that cover them', () => {
+    const log = [];
+    const frames = createFrameQueue();
+    const core = new CompositorCore({
+      context: createRecordingContext(log),
+      createSurface: (width, height) => ({ width, height, getContext: () => null }),
+      requestFrame: frames.requestFrame,
+    });
+    core.handle({ type: 'resize', width: 200, height: 100 });
+    core.handle({ type: 'create', id: 1, x: 0, y: 0, width: 100, height: 100 });
+    core.handle({ type: 'create', id: 2, x: 50, y: 20, width: 100, height: 50 });
+    frames.run();
+    expect(core.frames).toBe(1);
+    expect(core.context.canvas.width).toBe(200);
+    log.length = 0;
+
+    core.handle({ type: 'update', id: 1, x: 40, y: 0, width: 20, height: 30 });
+    core.handle({ type: 'update', id: 1, x: 40, y: 10, width: 20, height: 10 });
+    frames.run();
+    const store1 = core.stores.get(1).canvas;
+    const store2 = core.stores.get(2).canvas;
+    expect(log).toEqual([
+      ['clearRect', 40, 0, 20, 30],
+      ['drawImage', store1, 40, 0, 20, 30, 40, 0, 20, 30],
+      ['drawImage', store2, 0, 0, 10, 10, 50, 20, 10, 10],
+    ]);
+
+    log.length = 0;
+    core.handle({ type: 'visible', id: 2, visible: false });
+    frames.run();
+    expect(log[0]).toEqual(['clearRect', 50, 20, 100, 50]);
+    expect(log.slice(1).map((entry) => entry[1])).toEqual([store1]);
+    expect(core.compose()).toBe(0);
+  });
+});
+
+describe('WindowManager', () => {
+  it('turns windows into compositor layers and raises them on press', () => {
+    const created = installFakeDocument();
+    const posted = [];
+    const frames = createFrameQueue();
+    const container = { appendChild: (element) => posted.push(['append', element.className ?? element.tag]) };
+    const manager = new WindowManager(container, {
+      requestFrame: frames.requestFrame,
+      createCompositor: () => ({ worker: false, post: (message) => posted.push(message), dispose() {} }),
+    });
+
+    const first = manager.createWindow(10, 10, 100, 80, 'One');
+    const second = manager.createWindow(60, 40, 120, 90, 'Two');
+    const child = manager.createChildWindow(second, 5, 30, 40, 20);
+    const layers = posted.filter((entry) => entry.type === 'create');
+    expect(layers.map(({ id, parent, visible }) => [id, parent, visible])).toEqual([
+      [first, 0, true],
+      [second, 0, true],
+      [child, second, false],
+    ]);
+    const resize = posted.filter((entry) => entry.type === 'resize').pop();
+    expect(resize).toEqual({ type: 'resize', width: 180, height: 130 });
+    expect(posted.filter((entry) => entry[0] === 'append').map((entry) => entry[1])).toEqual([
+      'compositorOutput',
+      'compositorWindow',
+      'compositorWindow',
+    ]);
+
+    posted.length = 0;
+    manager.damage(child, [makeRect(-5, 0, 10, 10)]);
+    manager.damage(child, [makeRect(0, 0, 10, 10)]);
+    manager.showWindow(child);
+    frames.run();
+    expect(posted).toEqual([
+      { type: 'visible', id: child, visible: true },
+      { type: 'update', id: child, x: 0, y: 0, width: 10, height: 10 },
+    ]);
+
+    posted.length = 0;
+    const firstElement = manager.getWindow(first).element;
+    firstElement.dispatch('pointerdown');
+    expect(posted).toEqual([{ type: 'raise', id: first }]);
+    expect(Number(firstElement.style.zIndex)).toBeGreaterThan(Number(manager.getWindow(second).element.style.zIndex));
+
+    posted.length = 0;
+    manager.destroyWindow(second);
+    expect(posted).toEqual([
+      { type: 'destroy', id: second },
+      { type: 'destroy', id: child },
+    ]);
+    expect(created.some((element) => element.className === 'compositorWindow' && element.removed)).toBe(true);
+    delete globalThis.document;
+  });
+
+  it('sends a worker each frame as one batch, in order with later messages', async () => {
+    installFakeDocument();
+    const captures = [];
+    globalThis.createImageBitmap = (canvas, x, y) =>
+      new Promise((resolve) => captures.push({ resolve: () => resolve({ x, y, close() {} }) }));
+    const posted = [];
+    const frames = createFrameQueue();
+    const manager = new WindowManager(
+      { appendChild() {} },
+      {
+        requestFrame: frames.requestFrame,
+        createCompositor: () => ({ worker: true, post: (message) => posted.push(message), dispose() {} }),
+      },
+    );
+    const hwnd = manager.createWindow(0, 0, 100, 100, 'One');
+    posted.length = 0;
+
+    manager.damage(hwnd, [makeRect(0, 0, 10, 10), makeRect(50, 50, 60, 60)]);
+    frames.run();
+    manager.damage(hwnd, [makeRect(20, 20, 30, 30)]);
+    frames.run();
+    manager.destroyWindow(hwnd);
+    expect(posted).toEqual([]);
+
+    captures[2].resolve();
+    captures[1].resolve();
+    await new Promise((resolve) => setTimeout(resolve, 0));
+    expect(posted).toEqual([]);
+    captures[0].resolve();
+    await new Promise((resolve) => setTimeout(resolve, 0));
+    expect(posted.map((message) => message.type)).toEqual(['batch', 'batch', 'destroy']);
+    expect(posted[0].messages.map(({ x, source }) => [x, source.x])).toEqual([
+      [0, 0],
+      [50, 50],
+    ]);
+    expect(posted[1].messages.map(({ x }) => x)).toEqual([20]);
+    delete globalThis.createImageBitmap;
+    delete globalThis.document;
+  });
+});
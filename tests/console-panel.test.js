@@ -0,0 +1,56 @@
+import { describe, it, expect } from 'vitest';
+import { LineRing } from '../src/runtime/ui/line-ring.js';
+import { ConsolePanel } from '../src/runtime/ui/console-panel.js';
+
+function createStubElement() {
+  return {
+    style: {},
+    children: [],
+    textContent: '',
+    scrollTop: 0,
+    clientHeight: 180,
+    get scrollHeight() {
+      return parseInt(this.children[0]?.style.height ?? '0', 10);
+    },
+    appendChild(child) {
+      this.children.push(child);
+      return child;
+    },
+    addEventListener() {},
+  };
+}
+
+describe('LineRing', () => {
+  it('keeps the newest lines once capacity is reached', () => {
+    const ring = new LineRing(3);
+    ['a', 'b', 'c', 'd', 'e'].forEach((line) => ring.push(line));
+    expect(ring.length).toBe(3);
+    expect(ring.dropped).toBe(2);
+    expect(ring.toArray()).toEqual(['c', 'd', 'e']);
+    expect(ring.get(3)).toBeUndefined();
+    ring.clear();
+    expect(ring.toArray()).toEqual([]);
+  });
+});
+
+describe('ConsolePanel', () => {
+  it('flushes once per frame and only materializes visible rows', () => {
+    const previousDocument = globalThis.document;
+    globalThis.document = { createElement: () => createStubElement() };
+    try {
+      const frames = [];
+      const element = createStubElement();
+      const panel = new ConsolePanel(element, { capacity: 5000, requestFrame: (fn) => frames.push(fn) });
+      for (let i = 0; i < 20000; i++) panel.append(`line ${i}`);
+      expect(frames).toHaveLength(1);
+      frames.shift()();
+      expect(panel.lines.length).toBe(5000);
+      expect(panel.rows.length).toBeLessThan(40);
+      expect(element.scrollTop).toBe(5000 * 18);
+      const shown = panel.rows.filter((row) => row.style.display !== 'none').map((row) => row.textContent);
+      expect(shown[shown.length - 1]).toBe('line 19999');
+    } finally {
+      globalThis.document = previousDocument;
+    }
+  });
+});
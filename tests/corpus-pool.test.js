@@ -0,0 +1,83 @@
+import { describe, it, expect } from 'vitest';
+import fs from 'node:fs';
+import os from 'node:os';
+import path from 'node:path';
+import { spawnSync } from 'node:child_process';
+import { CorpusPool } from '../src/runtime/headless/corpus-pool.js';
+import { buildCorpusReport, classifyFailure } from '../src/runtime/headless/corpus-report.js';
+import { PeImageBuilder } from './helpers/pe-builder.js';
+
+function writeImage(dir, name, code) {
+  const file = path.join(dir, name);
+  fs.writeFileSync(file, new PeImageBuilder().section('.text', 0x1000, 0x200).bytes(0x1000, code).build());
+  return file;
+}
+
+describe('corpus runs', () => {
+  it('classifies failures and builds a missing-instruction histogram', () => {
+    const results = [
+      { file: 'a.exe', exitReason: 'error', error: 'Unsupported opcode 0x65', rip: '0x1', stats: { steps: 4 } },
+      { file: 'b.exe', exitReason: 'error', error: 'Unsupported opcode 0x65', rip: '0x1', stats: { steps: 6 } },
+      { file: 'c.exe', exitReason: 'error', error: 'Unsupported instruction cpuid', rip: '0x1', stats: {} },
+      { file: 'd.exe', exitReason: 'halt', error: null, stats: { steps: 10 } },
+      { file: 'e.exe', exitReason: 'timeout', error: 'Exceeded', stats: {} },
+    ];
+    expect(classifyFailure(results[3])).toBeNull();
+    const report = buildCorpusReport(results, 1000);
+    expect(report.summary).toMatchObject({ files: 5, steps: 20, stepsPerSecond: 20 });
+    expect(report.summary.exitReasons).toEqual({ error: 3, halt: 1, timeout: 1 });
+    expect(report.failures).toEqual({ 'unsupported-opcode': 2, 'unsupported-instruction': 1, timeout: 1 });
+    expect(report.missingInstructions.map(({ instruction, count }) => [instruction, count])).toEqual([
+      ['0x65', 2],
+      ['cpuid', 1],
+    ]);
+  });
+
+  it('fans images across workers and terminates jobs past the time limit', async () => {
+    const dir = fs.mkdtempSync(path.join(os.tmpdir(), 'winejs-corpus-'));
+    try {
+      const files = [
+        writeImage(dir, 'halt.exe', [0x90, 0xf4]),
+        writeImage(dir, 'spin.exe', [0xeb, 0xfe]),
+        writeImage(dir, 'gs.exe', [0x65, 0x48]),
+      ];
+      const pool = new CorpusPool({ size: 2, maxSteps: 1e9, timeLimitMs: 500 });
+      const results = await pool.run(files);
+      expect(results.map((result) => result.exitReason)).toEqual(['halt', 'timeout', 'error']);
+      expect(results[0].stats.steps).toBe(2);
+      expect(results[2].path).toBe(files[2]);
+    } finally {
+      fs.rmSync(dir, { recursive: true, force: true });
+    }
+  });
+
+  it('times out a single image from the command line', () => {
+    const dir = fs.mkdtempSync(path.join(os.tmpdir(), 'winejs-cli-'));
+    try {
+      const file = writeImage(dir, 'spin.exe', [0xeb, 0xfe]);
+      const bin = new URL('../bin/winejs.js', import.meta.url);
+      const args = ['run', file, '--max-steps', '1000000000', '--timeout', '300', '--json'];
+      const run = spawnSync(process.execPath, [bin.pathname, ...args]);
+      expect(run.status).toBe(1);
+      expect(JSON.parse(run.stdout).exitReason).toBe('timeout');
+    } finally {
+      fs.rmSync(dir, { recursive: true, force: true });
+    }
+  });
+
+  it('shares an on-disk image cache between runs', async () => {
+    const dir = fs.mkdtempSync(path.join(os.tmpdir(), 'winejs-cache-'));
+    try {
+      const file = writeImage(dir, 'halt.exe', [0x90, 0xf4]);
+      const cacheDirectory = path.join(dir, 'cache');
+      const pool = new CorpusPool({ size: 1, cacheDirectory });
+      const [first] = await pool.run([file]);
+      const [second] = await pool.run([file]);
+      expect([first.cache, second.cache]).toEqual(['miss', 'hit']);
+      expect(second.exitReason).toBe('halt');
+      expect(fs.readdirSync(cacheDirectory).filter((name) => name.endsWith('.json'))).toHaveLength(1);
+    } finally {
+      fs.rmSync(dir, { recursive: true, force: true });
+    }
+  });
+});
@@ -0,0 +1,359 @@
+import { describe, it, expect } from 'vitest';
+import { PeFile } from '../src/emulator/pe-file.js';
+import { X86CPU } from '../src/emulator/x86/cpu.js';
+import { createImportBinder } from '../src/runtime/import-handler.js';
+import { createDirect2DImportPlugin } from '../src/runtime/import-plugins/direct2d-plugin.js';
+import {
+  CMD_CLEAR,
+  CMD_FILL_ELLIPSE,
+  CMD_FILL_RECT,
+  CMD_LINE,
+  CMD_POP_CLIP,
+  CMD_PUSH_CLIP,
+  CMD_TRANSFORM,
+  CommandBuffer,
+} from '../src/runtime/d2d/command-buffer.js';
+import { INSTANCE_FLOATS, InstanceBatch, SHAPE_FILL_ELLIPSE, SHAPE_LINE } from '../src/runtime/d2d/instance-batch.js';
+import { createWebGLPresenter, DirectXWebGLRenderer } from '../src/runtime/plugins/directx-webgl-plugin.js';
+import { replayCommands } from '../src/runtime/d2d/canvas-renderer.js';
+import { WindowStation } from '../src/runtime/user32/window-station.js';
+import { PeImageBuilder } from './helpers/pe-builder.js';
+import { Assembler } from './helpers/assembler.js';
+
+const IMAGE_BASE = 0x140000000n;
+const FACTORY = 0x3000;
+const TARGET = 0x3008;
+const BRUSH = 0x3010;
+const SIZE = 0x3018;
+const HWND_PROPS = 0x3020;
+const RED = 0x3040;
+const BLUE = 0x3050;
+const FIRST_RECT = 0x3060;
+const SECOND_RECT = 0x3070;
+
+const FACTORY_CREATE_HWND_RENDER_TARGET = 14;
+const TARGET_CREATE_SOLID_COLOR_BRUSH = 8;
+const TARGET_FILL_RECTANGLE = 17;
+const TARGET_BEGIN_DRAW = 48;
+const TARGET_END_DRAW = 49;
+const TARGET_GET_SIZE = 53;
+const BRUSH_SET_COLOR = 8;
+const RELEASE = 2;
+
+const floats = (...values) => Array.from(new Uint8Array(new Float32Array(values).buffer));
+
+// Loads an angle into XMM1, moves it to a zeroed XMM0 and calls
+// D2D1MakeRotateMatrix(angle, center, &matrix).
+function buildRotateImage() {
+  const builder = new PeImageBuilder()
+    .section('.text', 0x1000, 0x200)
+    .section('.idata', 0x2000, 0x400)
+    .section('.data', 0x3000, 0x200, 0xc0000040);
+  const iat = builder.imports(0x2000, 'd2d1.dll', ['D2D1MakeRotateMatrix']);
+  const asm = new Assembler(0x1000)
+    .emit(0x48, 0x83, 0xec, 0x28)
+    .ripRel([0xf3, 0x0f, 0x10, 0x0d], FIRST_RECT)
+    .emit(0x0f, 0x57, 0xc0)
+    .emit(0xf3, 0x0f, 0x10, 0xc1)
+    .ripRel([0x48, 0x8b, 0x15], FIRST_RECT + 4)
+    .ripRel([0x4c, 0x8d, 0x05], SECOND_RECT)
+    .call(iat.D2D1MakeRotateMatrix)
+    .emit(0xf4);
+  builder.bytes(0x1000, asm.bytes()).bytes(FIRST_RECT, floats(90, 10, 0));
+  return new PeFile(builder.build());
+}
+
+// Creates a factory and an HWND render target, then draws two rectangles
+// with one brush whose color changes in between, the way DirectXPong does.
+function buildDrawingImage(hwnd) {
+  const builder = new PeImageBuilder()
+    .section('.text', 0x1000, 0x200)
+    .section('.idata', 0x2000, 0x400)
+    .section('.data', 0x3000, 0x200, 0xc0000040);
+  const iat = builder.imports(0x2000, 'd2d1.dll', ['D2D1CreateFactory']);
+  const loadTarget = (asm) => asm.ripRel([0x48, 0x8b, 0x0d], TARGET);
+  const asm = new Assembler(0x1000)
+    .emit(0x48, 0x83, 0xec, 0x48)
+    .emit(0x31, 0xc9, 0x31, 0xd2, 0x45, 0x31, 0xc0)
+    .ripRel([0x4c, 0x8d, 0x0d], FACTORY)
+    .call(iat.D2D1CreateFactory)
+    .ripRel([0x48, 0x8b, 0x0d], FACTORY)
+    .emit(0x31, 0xd2)
+    .ripRel([0x4c, 0x8d, 0x05], HWND_PROPS)
+    .ripRel([0x4c, 0x8d, 0x0d], TARGET)
+    .method(FACTORY_CREATE_HWND_RENDER_TARGET);
+  loadTarget(asm).method(TARGET_BEGIN_DRAW);
+  loadTarget(asm)
+    .ripRel([0x48, 0x8d, 0x15], RED)
+    .emit(0x45, 0x31, 0xc0)
+    .ripRel([0x4c, 0x8d, 0x0d], BRUSH)
+    .method(TARGET_CREATE_SOLID_COLOR_BRUSH);
+  loadTarget(asm)
+    .ripRel([0x48, 0x8d, 0x15], FIRST_RECT)
+    .ripRel([0x4c, 0x8b, 0x05], BRUSH)
+    .method(TARGET_FILL_RECTANGLE);
+  asm
+    .ripRel([0x48, 0x8b, 0x0d], BRUSH)
+    .ripRel([0x48, 0x8d, 0x15], BLUE)
+    .method(BRUSH_SET_COLOR);
+  loadTarget(asm)
+    .ripRel([0x48, 0x8d, 0x15], SECOND_RECT)
+    .ripRel([0x4c, 0x8b, 0x05], BRUSH)
+    .method(TARGET_FILL_RECTANGLE);
+  loadTarget(asm)
+    .ripRel([0x48, 0x8d, 0x15], SIZE)
+    .method(TARGET_GET_SIZE);
+  loadTarget(asm)
+    .emit(0x31, 0xd2, 0x45, 0x31, 0xc0)
+    .method(TARGET_END_DRAW);
+  asm
+    .ripRel([0x48, 0x8b, 0x0d], BRUSH)
+    .method(RELEASE)
+    .emit(0xf4);
+  builder
+    .bytes(0x1000, asm.bytes())
+    .u64(HWND_PROPS, BigInt(hwnd))
+    .bytes(RED, floats(1, 0, 0, 1))
+    .bytes(BLUE, floats(0, 0, 1, 0.5))
+    .bytes(FIRST_RECT, floats(10, 10, 30, 20))
+    .bytes(SECOND_RECT, floats(40, 10, 60, 20));
+  return new PeFile(builder.build());
+}
+
+// Canvas 2D stand-in that logs method calls and style assignments.
+function createRecordingContext(log) {
+  return new Proxy(
+    { canvas: { width: 200, height: 100 } },
+    {
+      get(target, key) {
+        if (key in target) return target[key];
+        return (...args) => log.push([key, ...args]);
+      },
+      set(target, key, value) {
+        if (key === 'fillStyle') log.push(['fillStyle', value]);
+        target[key] = value;
+        return true;
+      },
+    },
+  );
+}
+
+function createStation(log, frames) {
+  const context = createRecordingContext(log);
+  const windows = new Map();
+  const station = new WindowStation({
+    windowManager: {
+      createWindow(x, y, width, height) {
+        windows.set(1, { canvas: { getContext: () => context }, width, height });
+        return 1;
+      },
+      getWindow: (hwnd) => windows.get(hwnd) ?? null,
+      showWindow() {},
+    },
+    requestFrame: (fn) => frames.push(fn),
+  });
+  station.registerClass({ name: 'Pong', wndProc: 0n });
+  return station;
+}
+
+describe('Direct2D command buffer', () => {
+  it('packs commands into a reusable Float32Array and replays them in order', () => {
+    const commands = new CommandBuffer(4);
+    commands.push(CMD_FILL_RECT, 0, 0, 10, 10, 1, 0, 0, 1);
+    commands.push(CMD_LINE, 0, 0, 5, 5, 2, 0, 1, 0, 1);
+    expect(commands.count).toBe(2);
+    expect(commands.length).toBe(19);
+    const log = [];
+    replayCommands(commands, createRecordingContext(log), { originX: 5, originY: 7 });
+    const methods = log.map(([key]) => key);
+    expect(methods).toEqual([
+      'save',
+      'setTransform',
+      'fillStyle',
+      'fillRect',
+      'beginPath',
+      'moveTo',
+      'lineTo',
+      'stroke',
+      'restore',
+    ]);
+    expect(log[1]).toEqual(['setTransform', 1, 0, 0, 1, 5, 7]);
+    commands.reset();
+    expect(commands.length).toBe(0);
+    expect(commands.data.length).toBe(19);
+  });
+});
+
+describe('Direct2D import plugin', () => {
+  it('serves COM vtables and presents one batched frame per EndDraw', async () => {
+    const log = [];
+    const frames = [];
+    const station = createStation(log, frames);
+    const window = station.createWindow({ className: 'Pong', x: 0, y: 0, width: 200, height: 100 });
+    const plugin = createDirect2DImportPlugin({ stationFor: () => station, requestFrame: (fn) => frames.push(fn) });
+    const bind = createImportBinder({ plugins: [plugin] });
+    const cpu = new X86CPU(buildDrawingImage(window.hwnd));
+    const result = await cpu.runAsync({ hooks: { bindImport: (key) => bind(key, {}) }, maxSteps: 400 });
+    expect(result.exitReason).toBe('halt');
+    const counts = Object.fromEntries(result.importCounts.map(({ name, count }) => [name, count]));
+    expect(counts).toMatchObject({
+      D2D1CreateFactory: 1,
+      'ID2D1RenderTarget::FillRectangle': 2,
+      'ID2D1SolidColorBrush::SetColor': 1,
+      'IUnknown::Release': 1,
+    });
+
+    const read = (rva) => cpu.memory.readUInt(IMAGE_BASE + BigInt(rva), 8);
+    const size = new Float32Array(new Uint32Array([Number(read(SIZE) & 0xffffffffn), Number(read(SIZE) >> 32n)]).buffer);
+    expect(Array.from(size)).toEqual([200, 100]);
+    const [target] = plugin.targetsFor(cpu);
+    expect(target.hwnd).toBe(window.hwnd);
+    expect(target.queued.count).toBe(2);
+    expect(cpu.memory.readUInt(read(BRUSH), 8)).toBe(0n);
+
+    expect(frames).toHaveLength(1);
+    frames[0]();
+    expect(target.presented).toBe(1);
+    expect(log.filter(([key]) => key === 'fillStyle').map(([, value]) => value)).toEqual([
+      'rgba(255, 0, 0, 1)',
+      'rgba(0, 0, 255, 0.5)',
+    ]);
+    expect(log.filter(([key]) => key === 'fillRect')).toEqual([
+      ['fillRect', 10, 10, 20, 10],
+      ['fillRect', 40, 10, 20, 10],
+    ]);
+    plugin.reset();
+    station.dispose();
+  });
+
+  it('reads a leading float argument from XMM0', async () => {
+    const plugin = createDirect2DImportPlugin({ stationFor: () => null, requestFrame: () => {} });
+    const bind = createImportBinder({ plugins: [plugin] });
+    const cpu = new X86CPU(buildRotateImage());
+    const result = await cpu.runAsync({ hooks: { bindImport: (key) => bind(key, {}) }, maxSteps: 100 });
+    expect(result.exitReason).toBe('halt');
+    const bytes = Uint8Array.from({ length: 24 }, (_, index) =>
+      Number(cpu.memory.readUInt(IMAGE_BASE + BigInt(SECOND_RECT + index), 1)),
+    );
+    const matrix = Array.from(new Float32Array(bytes.buffer), (value) => Math.round(value) + 0);
+    expect(matrix).toEqual([0, 1, -1, 0, 10, -10]);
+  });
+});
+
+// WebGL2 stand-in: constants are numbers, getters succeed and every other
+// method is logged as [name, ...args].
+function createRecordingGl(log) {
+  const attributes = new Map();
+  const fixed = {
+    getShaderParameter: () => true,
+    getProgramParameter: () => true,
+    getAttribLocation: (program, name) => {
+      if (!attributes.has(name)) attributes.set(name, attributes.size);
+      return attributes.get(name);
+    },
+  };
+  return new Proxy(fixed, {
+    get(target, key) {
+      if (key in target) return target[key];
+      if (typeof key === 'string' && /^[A-Z_0-9]+$/.test(key)) return key;
+      return (...args) => {
+        log.push([key, ...args]);
+        return key.startsWith('create') || key === 'getUniformLocation' ? { key } : undefined;
+      };
+    },
+  });
+}
+
+function createGlCanvas(log) {
+  const gl = createRecordingGl(log);
+  return { width: 0, height: 0, getContext: (type) => (type === 'webgl2' ? gl : null) };
+}
+
+function scene(ballX) {
+  const commands = new CommandBuffer();
+  commands.push(CMD_CLEAR, 0, 0, 0, 1);
+  for (let index = 0; index < 1000; index++) commands.push(CMD_FILL_RECT, index, 0, index + 1, 4, 1, 1, 1, 1);
+  commands.push(CMD_FILL_ELLIPSE, ballX, 50, 5, 5, 1, 1, 1, 1);
+  return commands;
+}
+
+describe('instanced WebGL replay', () => {
+  it('splits a frame into scissor runs of instances', () => {
+    const commands = new CommandBuffer();
+    commands.push(CMD_CLEAR, 0, 0, 0, 1);
+    commands.push(CMD_TRANSFORM, 1, 0, 0, 1, 10, 20);
+    commands.push(CMD_FILL_RECT, 0, 0, 5, 5, 1, 0, 0, 1);
+    commands.push(CMD_PUSH_CLIP, 0, 0, 50, 50, 0);
+    commands.push(CMD_LINE, 0, 0, 5, 5, 2, 0, 1, 0, 1);
+    commands.push(CMD_FILL_ELLIPSE, 5, 5, 2, 2, 0, 0, 1, 1);
+    commands.push(CMD_POP_CLIP);
+    const batch = new InstanceBatch(1).encode(commands, { width: 200, height: 100 });
+    expect(batch.count).toBe(3);
+    expect(batch.steps).toEqual([
+      { clear: [0, 0, 0, 1], scissor: { left: 0, top: 0, right: 200, bottom: 100 } },
+      { first: 0, count: 1, scissor: { left: 0, top: 0, right: 200, bottom: 100 } },
+      { first: 1, count: 2, scissor: { left: 10, top: 20, right: 60, bottom: 70 } },
+    ]);
+    const ellipse = Array.from(batch.data.subarray(2 * INSTANCE_FLOATS, 3 * INSTANCE_FLOATS));
+    expect(ellipse).toEqual([5, 5, 2, 2, 0, 0, 1, 1, 1, 0, 10, 0, 1, 20, SHAPE_FILL_ELLIPSE, 0]);
+  });
+
+  it('packs each instance into its own sixteen floats', () => {
+    const commands = new CommandBuffer();
+    commands.push(CMD_FILL_RECT, 1, 2, 3, 4, 1, 0, 0, 1);
+    commands.push(CMD_LINE, 5, 6, 7, 8, 3, 0, 1, 0, 1);
+    const batch = new InstanceBatch(3);
+    batch.data.fill(-1);
+    batch.encode(commands, { width: 100, height: 100 });
+    expect(batch.count).toBe(2);
+    expect(Array.from(batch.data.subarray(INSTANCE_FLOATS, 2 * INSTANCE_FLOATS))).toEqual([
+      5, 6, 7, 8, 0, 1, 0, 1, 1, 0, 0, 0, 1, 0, SHAPE_LINE, 3,
+    ]);
+    expect(Array.from(batch.data.subarray(2 * INSTANCE_FLOATS)).every((value) => value === -1)).toBe(true);
+  });
+
+  it('shares programs per context and re-uploads only changed instances', () => {
+    const log = [];
+    const canvas = createGlCanvas(log);
+    const first = new DirectXWebGLRenderer({ canvas });
+    const second = new DirectXWebGLRenderer({ canvas });
+    expect(first.render({ commands: scene(10), width: 320, height: 200 })).toBe(true);
+    expect(second.render({ commands: scene(10), width: 320, height: 200 })).toBe(true);
+    expect(log.filter(([key]) => key === 'createProgram')).toHaveLength(1);
+    expect(log.filter(([key]) => key === 'drawArraysInstanced').map((call) => call.slice(2))).toEqual([
+      [0, 4, 1001],
+      [0, 4, 1001],
+    ]);
+    expect(first.lastUpload).toEqual({ offset: 0, length: 1001 * INSTANCE_FLOATS });
+
+    log.length = 0;
+    first.render({ commands: scene(12), width: 320, height: 200 });
+    const uploads = log.filter(([key]) => key === 'bufferSubData' || key === 'bufferData');
+    expect(uploads).toHaveLength(1);
+    expect(uploads[0][2]).toBe(1000 * INSTANCE_FLOATS * 4);
+    expect(uploads[0][3].length).toBe(1);
+    log.length = 0;
+    first.render({ commands: scene(12), width: 320, height: 200 });
+    expect(log.filter(([key]) => key === 'bufferSubData')).toHaveLength(0);
+    expect(log.filter(([key]) => key === 'viewport')).toHaveLength(0);
+
+    first.dispose();
+    expect(log.filter(([key]) => key === 'deleteProgram')).toHaveLength(0);
+    second.dispose();
+    expect(log.filter(([key]) => key === 'deleteProgram')).toHaveLength(1);
+  });
+
+  it('copies presented frames into the window canvas, or declines without WebGL', () => {
+    const glLog = [];
+    const log = [];
+    const context = createRecordingContext(log);
+    const presenter = createWebGLPresenter({ createCanvas: () => createGlCanvas(glLog) });
+    const target = {};
+    expect(presenter.present(target, scene(0), context, { originX: 4, originY: 6, width: 64, height: 32 })).toBe(true);
+    expect(log.map(([key, , ...args]) => [key, ...args])).toEqual([['drawImage', 0, 0, 64, 32, 4, 6, 64, 32]]);
+    presenter.release(target);
+    expect(glLog.filter(([key]) => key === 'deleteProgram')).toHaveLength(1);
+    const headless = createWebGLPresenter({ createCanvas: () => null });
+    expect(headless.present(target, scene(0), context, { width: 64, height: 32 })).toBe(false);
+  });
+});
@@ -0,0 +1,206 @@
+import { describe, it, expect } from 'vitest';
+import { createUser32ImportPlugin } from '../src/runtime/import-plugins/user32-plugin.js';
+import { readWideString } from '../src/runtime/memory-readers.js';
+import { PieceTable } from '../src/runtime/user32/piece-table.js';
+import { WindowStation } from '../src/runtime/user32/window-station.js';
+import {
+  EM_GETLINECOUNT,
+  EM_LINEINDEX,
+  EM_LINELENGTH,
+  EM_REPLACESEL,
+  EM_SETSEL,
+  EN_CHANGE,
+  ES_AUTOVSCROLL,
+  ES_MULTILINE,
+  ES_NUMBER,
+  ES_READONLY,
+  WM_CHAR,
+  WM_COMMAND,
+  WM_GETTEXTLENGTH,
+  WM_PAINT,
+  WS_CHILD,
+  makeLParam,
+} from '../src/runtime/user32/messages.js';
+
+// Strings pass through `io` as plain JS values keyed by fake pointers.
+function createIo() {
+  const strings = new Map();
+  let next = 0x1000n;
+  return {
+    put(text) {
+      next += 0x100n;
+      strings.set(next, text);
+      return next;
+    },
+    readText: (pointer) => strings.get(pointer) ?? '',
+    writeText: (pointer, text, capacity) => {
+      strings.set(pointer, text.slice(0, capacity - 1));
+      return Math.min(text.length, capacity - 1);
+    },
+    writeUInt32: (pointer, value) => strings.set(pointer, value),
+  };
+}
+
+function createLog(station, style) {
+  const window = station.createWindow({ className: 'edit', style: WS_CHILD | style, width: 200, height: 104 });
+  const io = createIo();
+  const send = (message, wParam = 0n, lParam = 0n) => window.control.handle(message, wParam, lParam, io);
+  return { window, io, send };
+}
+
+// Byte-addressed guest memory for driving plugin handlers directly.
+function createCpu() {
+  const bytes = new Map();
+  const registers = {};
+  const memory = {
+    isRangeFree: () => false,
+    readByte: (address) => bytes.get(address) ?? 0,
+    write: (address, values) => values.forEach((value, index) => bytes.set(address + BigInt(index), value)),
+    writeUInt(address, size, value) {
+      for (let index = 0; index < size; index++) {
+        bytes.set(address + BigInt(index), Number((value >> BigInt(index * 8)) & 0xffn));
+      }
+    },
+  };
+  return { registers, memory, readRegister: (name) => registers[name] ?? 0n };
+}
+
+function writeWide(cpu, address, text) {
+  const values = [];
+  for (const char of `${text}\0`) values.push(char.charCodeAt(0) & 0xff, char.charCodeAt(0) >> 8);
+  cpu.memory.write(address, values);
+}
+
+describe('PieceTable', () => {
+  it('matches a plain string through inserts, deletes and line queries', () => {
+    const table = new PieceTable('first\r\nsecond');
+    let model = 'first\r\nsecond';
+    let seed = 7;
+    const random = (limit) => {
+      seed = (seed * 1103515245 + 12345) % 0x80000000;
+      return seed % limit;
+    };
+    const pieces = ['x', 'line\r\n', '\r\n', 'ab\ncd', ''];
+    for (let step = 0; step < 300; step++) {
+      const at = random(model.length + 1);
+      if (random(3)) {
+        const text = pieces[random(pieces.length)];
+        table.insert(at, text);
+        model = model.slice(0, at) + text + model.slice(at);
+      } else {
+        const end = Math.min(model.length, at + random(6));
+        table.delete(at, end);
+        model = model.slice(0, at) + model.slice(end);
+      }
+    }
+    expect(table.toString()).toBe(model);
+    expect(table.length).toBe(model.length);
+    const lines = model.split('\n');
+    expect(table.lineCount).toBe(lines.length);
+    lines.forEach((line, index) => expect(table.lineText(index)).toBe(line.replace(/\r$/, '')));
+    expect(table.slice(3, 40)).toBe(model.slice(3, 40));
+    const offset = Math.floor(model.length / 2);
+    expect(table.lineFromOffset(offset)).toBe(model.slice(0, offset).split('\n').length - 1);
+  });
+});
+
+describe('EditControl', () => {
+  it('appends log lines without touching earlier text and redraws only visible lines', () => {
+    const station = new WindowStation();
+    const { window, io, send } = createLog(station, ES_MULTILINE | ES_AUTOVSCROLL | ES_READONLY);
+    const control = window.control;
+
+    for (let index = 0; index < 2000; index++) {
+      const length = BigInt(send(WM_GETTEXTLENGTH).rax);
+      send(EM_SETSEL, length, length);
+      send(EM_REPLACESEL, 0n, io.put(`message ${index}\r\n`));
+    }
+    expect(control.text.lineCount).toBe(2001);
+    expect(control.text.pieces.length).toBe(2000);
+    expect(send(EM_GETLINECOUNT).rax).toBe(2001);
+    expect(send(EM_LINELENGTH, BigInt(send(EM_LINEINDEX, 1999n).rax)).rax).toBe('message 1999'.length);
+    expect(control.text.lineText(1234)).toBe('message 1234');
+
+    const visible = control.visibleLines();
+    expect(control.firstLine).toBe(2001 - visible);
+    expect(window.updateRects.every((rect) => rect.bottom <= window.height && rect.top >= 0)).toBe(true);
+
+    const drawn = [];
+    const textOut = station.gdi.textOut.bind(station.gdi);
+    station.gdi.textOut = (hdc, x, y, text) => drawn.push(text) && textOut(hdc, x, y, text);
+    send(WM_PAINT);
+    expect(drawn.length).toBeLessThanOrEqual(visible);
+    expect(drawn[drawn.length - 1]).toBe('message 1999');
+
+    drawn.length = 0;
+    send(EM_SETSEL, BigInt(control.text.length), BigInt(control.text.length));
+    send(EM_REPLACESEL, 0n, io.put('tail'));
+    expect(window.updateRects).toEqual([control.linesRect(2000, 2000)]);
+    send(WM_PAINT);
+    expect(drawn).toEqual(['tail']);
+    station.dispose();
+  });
+
+  it('types into editable controls and reports EN_CHANGE', () => {
+    const station = new WindowStation();
+    const { send, io } = createLog(station, ES_NUMBER);
+    expect(send(WM_CHAR, 0x36n).notify).toBe(EN_CHANGE);
+    expect(send(WM_CHAR, 0x61n).notify).toBe(null);
+    send(WM_CHAR, 0x37n);
+    send(WM_CHAR, 0x08n);
+    send(WM_CHAR, 0x36n);
+    const buffer = io.put('');
+    expect(send(0x000d, 16n, buffer).rax).toBe(2);
+    expect(io.readText(buffer)).toBe('66');
+
+    const readOnly = createLog(station, ES_READONLY);
+    expect(readOnly.send(WM_CHAR, 0x36n).notify).toBe(null);
+    expect(readOnly.send(WM_GETTEXTLENGTH).rax).toBe(0);
+    station.dispose();
+  });
+});
+
+describe('user32 window text', () => {
+  it('routes Get/SetWindowText through WM_*TEXT and control notifications to the parent', () => {
+    const plugin = createUser32ImportPlugin({ yieldToHost: null });
+    const cpu = createCpu();
+    const utf16 = new TextDecoder('utf-16le');
+    const context = { cpu, readWideString: (target, pointer, max) => readWideString(target, pointer, utf16, max) };
+    const call = (name, ...args) => {
+      ['rcx', 'rdx', 'r8', 'r9'].forEach((register, index) => (cpu.registers[register] = args[index] ?? 0n));
+      return plugin.resolveHandler(`user32.dll!${name}`)(context);
+    };
+    const station = plugin.stationFor(cpu);
+    station.registerClass({ name: 'Main', wndProc: 0x401000n });
+    station.registerClass({ name: 'Plain', wndProc: 0n });
+    const main = station.createWindow({ className: 'Main', title: 'Chat' });
+    const status = station.createWindow({ className: 'Plain', style: WS_CHILD, parent: main.hwnd });
+    const edit = station.createWindow({
+      className: 'EDIT',
+      style: WS_CHILD,
+      parent: main.hwnd,
+      menu: 42n,
+      title: '6667',
+    });
+
+    expect(call('getwindowtextlengthw', BigInt(edit.hwnd)).rax).toBe(4n);
+    writeWide(cpu, 0x5000n, 'Server started.');
+    call('setwindowtextw', BigInt(status.hwnd), 0x5000n);
+    expect(status.title).toBe('Server started.');
+    expect(call('getwindowtextlengthw', BigInt(status.hwnd)).rax).toBe(15n);
+    expect(call('getwindowtextw', BigInt(edit.hwnd), 0x6000n, 3n).rax).toBe(2n);
+    expect(readWideString(cpu, 0x6000n, utf16, 16)).toBe('66');
+
+    const typed = call('sendmessagew', BigInt(edit.hwnd), BigInt(WM_CHAR), 0x31n);
+    expect(typed.call.address).toBe(0x401000n);
+    expect(typed.call.args).toEqual([
+      BigInt(main.hwnd),
+      BigInt(WM_COMMAND),
+      BigInt(makeLParam(42, EN_CHANGE)),
+      BigInt(edit.hwnd),
+    ]);
+    expect(typed.call.then(0n)).toEqual({ rax: 0n });
+    expect(edit.control.text.toString()).toBe('16667');
+    plugin.reset();
+  });
+});
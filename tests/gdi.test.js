@@ -0,0 +1,159 @@
+import { describe, it, expect } from 'vitest';
+import { Gdi } from '../src/runtime/gdi/gdi.js';
+import { addRect, subtractRect, makeRect } from '../src/runtime/gdi/rect-list.js';
+import {
+  BLACK_BRUSH,
+  DT_CALCRECT,
+  DT_CENTER,
+  DT_SINGLELINE,
+  DT_VCENTER,
+  TRANSPARENT,
+} from '../src/runtime/gdi/gdi-objects.js';
+import { WindowStation } from '../src/runtime/user32/window-station.js';
+import { WM_PAINT } from '../src/runtime/user32/messages.js';
+
+// Canvas 2D stand-in that logs method calls; measureText is 8 px per char.
+function createRecordingContext(log, label) {
+  return new Proxy(
+    {},
+    {
+      get(target, key) {
+        if (key === 'measureText') return (text) => ({ width: text.length * 8 });
+        if (key in target) return target[key];
+        return (...args) => log.push([label, key, ...args]);
+      },
+      set(target, key, value) {
+        target[key] = value;
+        return true;
+      },
+    },
+  );
+}
+
+function createFakeWindowManager(log) {
+  const windows = new Map();
+  return {
+    createWindow(x, y, width, height) {
+      const hwnd = windows.size + 1;
+      const context = createRecordingContext(log, 'screen');
+      windows.set(hwnd, { canvas: { getContext: () => context }, width, height });
+      return hwnd;
+    },
+    getWindow: (hwnd) => windows.get(hwnd) ?? null,
+    showWindow() {},
+    destroyWindow: (hwnd) => windows.delete(hwnd),
+  };
+}
+
+function createStation(log, frames) {
+  const backingContext = createRecordingContext(log, 'store');
+  const station = new WindowStation({
+    windowManager: createFakeWindowManager(log),
+    requestFrame: (fn) => frames.push(fn),
+  });
+  station.gdi.createBackingStore = () => ({ getContext: () => backingContext });
+  station.registerClass({ name: 'Paint', wndProc: 0n });
+  return station;
+}
+
+const calls = (log, label, method) => log.filter(([target, key]) => target === label && key === method);
+
+describe('update regions', () => {
+  it('keeps a short rect list, dropping covered rects', () => {
+    let rects = addRect([], makeRect(0, 0, 10, 10));
+    rects = addRect(rects, makeRect(2, 2, 5, 5));
+    expect(rects).toHaveLength(1);
+    rects = addRect(rects, makeRect(20, 0, 30, 10));
+    rects = addRect(rects, makeRect(0, 0, 40, 10));
+    expect(rects).toEqual([makeRect(0, 0, 40, 10)]);
+    for (let i = 0; i < 8; i++) rects = addRect(rects, makeRect(i * 50 + 50, 0, i * 50 + 60, 10));
+    expect(rects).toEqual([makeRect(0, 0, 410, 10)]);
+    expect(subtractRect(rects, makeRect(0, 0, 600, 20))).toEqual([]);
+  });
+
+  it('clips BeginPaint to the invalidated rects and reports their bounds', () => {
+    const station = createStation([], []);
+    const window = station.createWindow({ className: 'Paint', x: 0, y: 0, width: 200, height: 100 });
+    station.invalidate(window.hwnd, makeRect(10, 10, 20, 20), false);
+    station.invalidate(window.hwnd, makeRect(50, 40, 300, 60), false);
+    expect(station.queue().next({}, false).message).toBe(WM_PAINT);
+    const paint = station.beginPaint(window);
+    expect(paint.erase).toBe(false);
+    expect(paint.rect).toEqual(makeRect(10, 10, 200, 60));
+    expect(station.gdi.getDC(paint.hdc).clip).toEqual([makeRect(10, 10, 20, 20), makeRect(50, 40, 200, 60)]);
+    expect(station.queue().next()).toBe(null);
+  });
+});
+
+describe('Gdi', () => {
+  it('batches paints into one frame and copies only dirty rects to the screen', () => {
+    const log = [];
+    const frames = [];
+    const station = createStation(log, frames);
+    const { gdi } = station;
+    const window = station.createWindow({ className: 'Paint', x: 0, y: 0, width: 200, height: 100 });
+    station.invalidate(window.hwnd, makeRect(0, 0, 40, 20));
+    const first = station.beginPaint(window).hdc;
+    expect(gdi.fillRect(first, makeRect(0, 0, 200, 100), gdi.getStockObject(BLACK_BRUSH))).toBe(true);
+    gdi.releaseDC(first);
+
+    const second = station.getDC(window);
+    gdi.swapState(second, 'bkMode', TRANSPARENT);
+    gdi.swapState(second, 'textColor', 0x0000ff);
+    const drawn = gdi.drawText(second, 'Hi', makeRect(0, 0, 200, 100), DT_CENTER | DT_VCENTER | DT_SINGLELINE);
+    expect(drawn.height).toBe(20);
+    const measured = gdi.drawText(second, 'Hello\nWorld!', makeRect(5, 5, 0, 0), DT_CALCRECT);
+    expect(measured.rect).toEqual(makeRect(5, 5, 53, 45));
+    gdi.releaseDC(second);
+
+    expect(frames).toHaveLength(1);
+    expect(log).toHaveLength(0);
+    frames[0]();
+    expect(calls(log, 'store', 'clip')).toHaveLength(3);
+    expect(calls(log, 'store', 'fillRect')).toEqual([['store', 'fillRect', 0, 0, 200, 100]]);
+    expect(calls(log, 'store', 'fillText')).toEqual([['store', 'fillText', 'Hi', 92, 40]]);
+    expect(calls(log, 'screen', 'drawImage').map((call) => call.slice(3))).toEqual([[0, 0, 200, 100, 0, 0, 200, 100]]);
+
+    log.length = 0;
+    station.invalidate(window.hwnd, makeRect(10, 10, 50, 30));
+    const third = station.beginPaint(window).hdc;
+    gdi.fillRect(third, makeRect(0, 0, 200, 100), 6);
+    gdi.releaseDC(third);
+    frames[1]();
+    expect(calls(log, 'screen', 'drawImage').map((call) => call.slice(3))).toEqual([[10, 10, 40, 20, 10, 10, 40, 20]]);
+    station.dispose();
+  });
+
+  it('draws from a DC that is never released at every frame', () => {
+    const log = [];
+    const frames = [];
+    const station = createStation(log, frames);
+    const { gdi } = station;
+    const window = station.createWindow({ className: 'Paint', x: 0, y: 0, width: 200, height: 100 });
+    const hdc = station.getDC(window);
+    for (let frame = 0; frame < 3; frame++) {
+      gdi.fillRect(hdc, makeRect(frame * 10, 0, frame * 10 + 10, 10), gdi.getStockObject(BLACK_BRUSH));
+      expect(frames).toHaveLength(1);
+      frames.splice(0).forEach((fn) => fn());
+      expect(gdi.getDC(hdc).ops).toHaveLength(0);
+    }
+    expect(calls(log, 'store', 'fillRect').map((call) => call[2])).toEqual([0, 10, 20]);
+    expect(calls(log, 'screen', 'drawImage')).toHaveLength(3);
+    station.dispose();
+  });
+
+  it('keeps object and DC state without a window manager', () => {
+    const gdi = new Gdi();
+    const dc = gdi.openDC({ hwnd: 1 }, { surface: 0, x: 0, y: 0 }, []);
+    const brush = gdi.createSolidBrush(0x00ff00);
+    const previous = gdi.selectObject(dc.hdc, brush);
+    expect(previous).toBe(gdi.getStockObject(0));
+    expect(gdi.selectObject(dc.hdc, previous)).toBe(brush);
+    expect(gdi.rectangle(dc.hdc, makeRect(0, 0, 10, 10))).toBe(true);
+    expect(dc.ops).toHaveLength(0);
+    expect(gdi.deleteObject(brush)).toBe(true);
+    expect(gdi.deleteObject(brush)).toBe(false);
+    expect(gdi.releaseDC(dc.hdc)).toBe(true);
+    expect(gdi.pending).toHaveLength(0);
+  });
+});
@@ -0,0 +1,111 @@
+import { describe, it, expect } from 'vitest';
+import { Gdi } from '../src/runtime/gdi/gdi.js';
+import { GlyphAtlas } from '../src/runtime/gdi/glyph-atlas.js';
+import { makeFont, TRANSPARENT } from '../src/runtime/gdi/gdi-objects.js';
+import { makeRect } from '../src/runtime/gdi/rect-list.js';
+
+// Canvases whose contexts log method calls; glyphs are 8 px wide, 'i' is 4.
+function createCanvasFactory(log) {
+  let next = 0;
+  return (width, height) => {
+    const canvas = { id: ++next, width, height };
+    const context = new Proxy(
+      { canvas },
+      {
+        get(target, key) {
+          if (key === 'measureText') {
+            return (text) => ({ width: Array.from(text).reduce((sum, char) => sum + (char === 'i' ? 4 : 8), 0) });
+          }
+          if (key in target) return target[key];
+          return (...args) => log.push([canvas.id, key, ...args]);
+        },
+        set(target, key, value) {
+          target[key] = value;
+          return true;
+        },
+      },
+    );
+    canvas.getContext = () => context;
+    return canvas;
+  };
+}
+
+const count = (log, method) => log.filter((entry) => entry[1] === method).length;
+
+describe('GlyphAtlas', () => {
+  it('rasterizes each glyph once per face and blits it afterwards', () => {
+    const log = [];
+    const atlas = new GlyphAtlas({ createCanvas: createCanvasFactory(log), pageSize: 64 });
+    const face = atlas.face('400 12px sans-serif', 15);
+    const target = createCanvasFactory(log)(100, 100).getContext('2d');
+
+    expect(face.measure('hi there')).toBe(60);
+    expect(count(log, 'fillText')).toBe(5);
+    expect(face.layout('hi i', 10, 20).map(({ glyph, x, y }) => [glyph.advance, x, y])).toEqual([
+      [8, 7, 17],
+      [4, 15, 17],
+      [4, 27, 17],
+    ]);
+
+    log.length = 0;
+    face.draw(target, 'hi there', 0, 0, '#000');
+    face.draw(target, 'hi there', 0, 20, '#000');
+    face.draw(target, 'there', 0, 40, '#fff');
+    expect(count(log, 'fillText')).toBe(0);
+    expect(log.filter((entry) => entry[1] === 'drawImage' && entry[0] === target.canvas.id)).toHaveLength(19);
+    // One tint per color for the page that was filled before drawing.
+    expect(log.filter((entry) => entry[1] === 'fillRect').length).toBe(2);
+
+    expect(atlas.face('400 12px sans-serif', 15)).toBe(face);
+    const bold = atlas.face('700 12px sans-serif', 15);
+    bold.measure('hi');
+    expect(count(log, 'fillText')).toBe(2);
+  });
+
+  it('opens pages as glyphs fill up and starts over after the last one', () => {
+    const log = [];
+    const atlas = new GlyphAtlas({ createCanvas: createCanvasFactory(log), pageSize: 32 });
+    const face = atlas.face('400 12px sans-serif', 10);
+    const glyphs = 'abcdefghjklmnopqrstuvwxyz'.split('').map((char) => face.glyph(char));
+    expect(glyphs[0].page).not.toBe(glyphs[glyphs.length - 1].page);
+    glyphs.forEach(({ x, y, width, height }) => {
+      expect(x + width).toBeLessThanOrEqual(32);
+      expect(y + height).toBeLessThanOrEqual(32);
+    });
+    expect(face.glyph(' ').width).toBe(0);
+
+    'ABCDEFGHIJKLMNOPQRSTUVWXYZ'.split('').forEach((char) => face.glyph(char));
+    expect(atlas.pages.length).toBeLessThanOrEqual(8);
+    expect(face.glyphs.has('a')).toBe(false);
+    expect(face.glyphs.has('Z')).toBe(true);
+  });
+
+  it('backs Gdi text so repaints reuse cached glyphs', () => {
+    const log = [];
+    const createCanvas = createCanvasFactory(log);
+    const store = createCanvas(200, 100);
+    const frames = [];
+    const gdi = new Gdi({
+      windowManager: { getWindow: () => ({ canvas: createCanvas(200, 100), width: 200, height: 100 }) },
+      requestFrame: (fn) => frames.push(fn),
+      createBackingStore: () => store,
+      glyphAtlas: new GlyphAtlas({ createCanvas }),
+    });
+    const font = gdi.createFont(makeFont({ height: -12 }));
+    const paint = () => {
+      const { hdc } = gdi.openDC({ hwnd: 1 }, { surface: 1, x: 0, y: 0 }, [makeRect(0, 0, 200, 100)]);
+      gdi.selectObject(hdc, font);
+      gdi.swapState(hdc, 'bkMode', TRANSPARENT);
+      expect(gdi.textExtent(hdc, 'Score 10').cx).toBe(64);
+      gdi.textOut(hdc, 4, 4, 'Score 10');
+      gdi.releaseDC(hdc);
+      frames.splice(0).forEach((fn) => fn());
+    };
+    paint();
+    expect(count(log, 'fillText')).toBe(7);
+    log.length = 0;
+    paint();
+    expect(count(log, 'fillText')).toBe(0);
+    expect(log.filter((entry) => entry[0] === store.id && entry[1] === 'drawImage')).toHaveLength(7);
+  });
+});
@@ -0,0 +1,39 @@
+import { describe, it, expect } from 'vitest';
+import { HeadlessRunner, summarizeImports } from '../src/runtime/headless/headless-runner.js';
+import { PeImageBuilder } from './helpers/pe-builder.js';
+
+function buildImage(code) {
+  return new PeImageBuilder().section('.text', 0x1000, 0x200).bytes(0x1000, code).build();
+}
+
+describe('HeadlessRunner', () => {
+  it('reports exit reason and step counts without a DOM', async () => {
+    const runner = new HeadlessRunner();
+    const halted = await runner.run(buildImage([0x90, 0x90, 0xf4]), { name: 'halt.exe' });
+    expect(halted).toMatchObject({ file: 'halt.exe', exitReason: 'halt', error: null, consoleLines: [] });
+    expect(halted.stats.steps).toBe(3);
+    const spinning = await runner.run(buildImage([0xeb, 0xfe]), { maxSteps: 25 });
+    expect(spinning.exitReason).toBe('max-steps');
+    expect(spinning.stats.steps).toBe(25);
+    const broken = await runner.run(buildImage([0x0f, 0x0b]));
+    expect(broken.exitReason).toBe('error');
+    expect(broken.rip).toBe('0x140001000');
+  });
+
+  it('summarizes import counters by call count', () => {
+    const counts = [
+      { key: 'c!z', count: 1 },
+      { key: 'a!x', count: 3 },
+      { key: 'b!y', count: 2 },
+    ];
+    expect(summarizeImports(counts)).toEqual({
+      calls: 6,
+      unique: 3,
+      top: [
+        { key: 'a!x', count: 3 },
+        { key: 'b!y', count: 2 },
+        { key: 'c!z', count: 1 },
+      ],
+    });
+  });
+});
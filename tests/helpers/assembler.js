@@ -0,0 +1,55 @@
+// Tiny forward-label assembler for the handful of encodings test guests use.
+export class Assembler {
+  constructor(rva) {
+    this.rva = rva;
+    this.code = [];
+    this.labels = new Map();
+    this.fixups = [];
+  }
+
+  get here() {
+    return this.rva + this.code.length;
+  }
+
+  emit(...bytes) {
+    this.code.push(...bytes);
+    return this;
+  }
+
+  ripRel(prefix, target) {
+    const value = target - (this.here + prefix.length + 4);
+    const rel = new Uint8Array(4);
+    new DataView(rel.buffer).setInt32(0, value, true);
+    return this.emit(...prefix, ...rel);
+  }
+
+  // call [rip+target], the shape of every IAT call.
+  call(target) {
+    return this.ripRel([0xff, 0x15], target);
+  }
+
+  // mov rax, [rcx]; call [rax+slot*8] -- a COM method call on rcx.
+  method(slot) {
+    const disp = new Uint8Array(4);
+    new DataView(disp.buffer).setInt32(0, slot * 8, true);
+    return this.emit(0x48, 0x8b, 0x01, 0xff, 0x90, ...disp);
+  }
+
+  jump(opcode, label) {
+    this.emit(opcode, 0);
+    this.fixups.push({ at: this.code.length - 1, label });
+    return this;
+  }
+
+  label(name) {
+    this.labels.set(name, this.here);
+    return this;
+  }
+
+  bytes() {
+    this.fixups.forEach(({ at, label }) => {
+      this.code[at] = (this.labels.get(label) - (this.rva + at + 1)) & 0xff;
+    });
+    return this.code;
+  }
+}
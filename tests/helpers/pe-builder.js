@@ -0,0 +1,137 @@
+const FILE_ALIGNMENT = 0x200;
+const SECTION_ALIGNMENT = 0x1000;
+const HEADER_SIZE = 0x400;
+const PE_OFFSET = 0x40;
+const OPTIONAL_HEADER_SIZE = 0xf0;
+
+function alignUp(value, alignment) {
+  return Math.ceil(value / alignment) * alignment;
+}
+
+export class PeImageBuilder {
+  constructor({ imageBase = 0x140000000n, entryRva = 0x1000, characteristics = 0x22 } = {}) {
+    this.imageBase = imageBase;
+    this.entryRva = entryRva;
+    this.characteristics = characteristics;
+    this.sections = [];
+    this.directories = new Array(16).fill(null).map(() => ({ rva: 0, size: 0 }));
+  }
+
+  section(name, rva, size, characteristics = 0x60000020) {
+    const bytes = new Uint8Array(alignUp(size, FILE_ALIGNMENT));
+    this.sections.push({ name, rva, size, bytes, view: new DataView(bytes.buffer), characteristics });
+    return this;
+  }
+
+  directory(index, rva, size) {
+    this.directories[index] = { rva, size };
+    return this;
+  }
+
+  locate(rva) {
+    const section = this.sections.find((entry) => rva >= entry.rva && rva < entry.rva + entry.bytes.length);
+    if (!section) throw new Error(`RVA 0x${rva.toString(16)} is outside every section`);
+    return { section, offset: rva - section.rva };
+  }
+
+  u8(rva, value) {
+    const { section, offset } = this.locate(rva);
+    section.view.setUint8(offset, value);
+    return this;
+  }
+
+  u16(rva, value) {
+    const { section, offset } = this.locate(rva);
+    section.view.setUint16(offset, value, true);
+    return this;
+  }
+
+  u32(rva, value) {
+    const { section, offset } = this.locate(rva);
+    section.view.setUint32(offset, value >>> 0, true);
+    return this;
+  }
+
+  u64(rva, value) {
+    const { section, offset } = this.locate(rva);
+    section.view.setBigUint64(offset, BigInt.asUintN(64, BigInt(value)), true);
+    return this;
+  }
+
+  bytes(rva, values) {
+    const { section, offset } = this.locate(rva);
+    section.bytes.set(values, offset);
+    return this;
+  }
+
+  // One import descriptor at `rva` with its lookup table, names and IAT;
+  // returns the IAT slot RVA for each name.
+  imports(rva, dll, names) {
+    const lookup = rva + 0x80;
+    const dllName = lookup + (names.length + 1) * 8;
+    const iat = rva + 0x100;
+    this.u32(rva, lookup).u32(rva + 12, dllName).u32(rva + 16, iat).str(dllName, dll);
+    const slots = {};
+    names.forEach((name, index) => {
+      const hintName = rva + 0x200 + index * 0x20;
+      this.u64(lookup + index * 8, hintName).u64(iat + index * 8, hintName).str(hintName + 2, name);
+      slots[name] = iat + index * 8;
+    });
+    this.directory(1, rva, 40);
+    return slots;
+  }
+
+  str(rva, value) {
+    return this.bytes(rva, [...Array.from(value, (ch) => ch.charCodeAt(0)), 0]);
+  }
+
+  build() {
+    let pointer = HEADER_SIZE;
+    const layout = this.sections.map((section) => {
+      const entry = { ...section, pointer };
+      pointer += section.bytes.length;
+      return entry;
+    });
+    const sizeOfImage = alignUp(
+      Math.max(SECTION_ALIGNMENT, ...layout.map((entry) => entry.rva + entry.size)),
+      SECTION_ALIGNMENT,
+    );
+    const out = new Uint8Array(pointer);
+    const view = new DataView(out.buffer);
+    view.setUint16(0, 0x5a4d, true);
+    view.setUint32(0x3c, PE_OFFSET, true);
+    view.setUint32(PE_OFFSET, 0x4550, true);
+    const coff = PE_OFFSET + 4;
+    view.setUint16(coff, 0x8664, true);
+    view.setUint16(coff + 2, layout.length, true);
+    view.setUint16(coff + 16, OPTIONAL_HEADER_SIZE, true);
+    view.setUint16(coff + 18, this.characteristics, true);
+    const opt = coff + 20;
+    view.setUint16(opt, 0x20b, true);
+    view.setUint32(opt + 16, this.entryRva, true);
+    view.setBigUint64(opt + 24, this.imageBase, true);
+    view.setUint32(opt + 32, SECTION_ALIGNMENT, true);
+    view.setUint32(opt + 36, FILE_ALIGNMENT, true);
+    view.setUint32(opt + 56, sizeOfImage, true);
+    view.setUint32(opt + 60, HEADER_SIZE, true);
+    view.setBigUint64(opt + 72, 0x100000n, true);
+    view.setBigUint64(opt + 80, 0x1000n, true);
+    view.setUint32(opt + 0x6c, 16, true);
+    this.directories.forEach(({ rva, size }, index) => {
+      view.setUint32(opt + 0x70 + index * 8, rva, true);
+      view.setUint32(opt + 0x70 + index * 8 + 4, size, true);
+    });
+    const table = opt + OPTIONAL_HEADER_SIZE;
+    layout.forEach((entry, index) => {
+      const base = table + index * 40;
+      Array.from(entry.name.slice(0, 8)).forEach((ch, i) => view.setUint8(base + i, ch.charCodeAt(0)));
+      view.setUint32(base + 8, entry.size, true);
+      view.setUint32(base + 12, entry.rva, true);
+      view.setUint32(base + 16, entry.bytes.length, true);
+      view.setUint32(base + 20, entry.pointer, true);
+      view.setUint32(base + 36, entry.characteristics, true);
+      out.set(entry.bytes, entry.pointer);
+    });
+    return out;
+  }
+}
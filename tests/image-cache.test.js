@@ -0,0 +1,125 @@
+import { describe, it, expect } from 'vitest';
+import { readFileSync, mkdtempSync, rmSync } from 'node:fs';
+import { tmpdir } from 'node:os';
+import path from 'node:path';
+import { PeFile } from '../src/emulator/pe-file.js';
+import { X86Simulator } from '../src/emulator/x86/simulator.js';
+import {
+  ImageCache,
+  MemoryCacheStore,
+  IMAGE_CACHE_VERSION,
+  encodeCacheRecord,
+  decodeCacheRecord,
+} from '../src/runtime/cache/image-cache.js';
+import { FileCacheStore } from '../src/runtime/cache/file-cache-store.js';
+import { createX86SimulatorPlugin } from '../src/runtime/simulator/plugins/x86-simulator-plugin.js';
+import { WineJS } from '../src/runtime/wine-js.js';
+
+const HELLO_WORLD_FIXTURE = JSON.parse(
+  readFileSync(path.join(process.cwd(), 'tests/fixtures/helloWorld.json'), 'utf8'),
+);
+const HELLO_WORLD_BYTES = new Uint8Array(Buffer.from(HELLO_WORLD_FIXTURE.helloWorldExe, 'base64'));
+
+function runToCompletion(simulator) {
+  try {
+    simulator.run({ maxSteps: 200 });
+  } catch {
+    // HelloWorld stops on an unsupported opcode; the decoded prefix is what gets cached.
+  }
+  return simulator.exportCacheRecord();
+}
+
+describe('image cache', () => {
+  it('misses, stores and then hits by content hash', async () => {
+    const cache = new ImageCache({ store: new MemoryCacheStore() });
+    const first = await cache.lookup(HELLO_WORLD_BYTES);
+    expect(first).toMatchObject({ hit: false, record: null });
+    expect(first.hash).toMatch(/^[0-9a-f]{64}$/);
+    const record = runToCompletion(new X86Simulator(HELLO_WORLD_BYTES));
+    expect(await cache.save(first.hash, HELLO_WORLD_BYTES.length, record)).toBe(true);
+    const second = await cache.lookup(HELLO_WORLD_BYTES.slice());
+    expect(second.hit).toBe(true);
+    expect(second.record.version).toBe(IMAGE_CACHE_VERSION);
+    expect(cache.stats).toEqual({ hits: 1, misses: 1 });
+  });
+
+  it('drops records written by another cache version', async () => {
+    const store = new MemoryCacheStore();
+    const stale = new ImageCache({ store, version: IMAGE_CACHE_VERSION - 1 });
+    const { hash } = await stale.lookup(HELLO_WORLD_BYTES);
+    await stale.save(hash, HELLO_WORLD_BYTES.length, { pe: null, code: [] });
+    const current = new ImageCache({ store });
+    expect((await current.lookup(HELLO_WORLD_BYTES)).hit).toBe(false);
+    expect(await store.get(hash)).toBeNull();
+  });
+
+  it('rebuilds the parsed image and decoded code from a record', () => {
+    const record = decodeCacheRecord(encodeCacheRecord(runToCompletion(new X86Simulator(HELLO_WORLD_BYTES))));
+    const fresh = new PeFile(HELLO_WORLD_BYTES);
+    const restored = PeFile.fromCacheRecord(HELLO_WORLD_BYTES, record.pe);
+    expect(restored.imageBase).toBe(fresh.imageBase);
+    expect(restored.getImportDirectory()).toEqual(fresh.getImportDirectory());
+    expect(Array.from(restored.rvaPageOffsets)).toEqual(Array.from(fresh.rvaPageOffsets));
+
+    const simulator = new X86Simulator(HELLO_WORLD_BYTES, { cacheRecord: record });
+    const decoder = simulator.ensureCpu().decoder;
+    expect(decoder.size).toBe(record.code.length);
+    const entry = fresh.imageBase + BigInt(fresh.entryRva);
+    expect(decoder.decode(entry)).toEqual(new X86Simulator(HELLO_WORLD_BYTES).ensureCpu().decoder.decode(entry));
+    expect(runToCompletion(simulator)).toBeNull();
+  });
+
+  it('invalidates decoded instructions when their page is written', () => {
+    const simulator = new X86Simulator(HELLO_WORLD_BYTES);
+    const cpu = simulator.ensureCpu();
+    const entry = simulator.pe.imageBase + BigInt(simulator.pe.entryRva);
+    const decoded = cpu.decoder.decode(entry);
+    expect(cpu.decoder.decode(entry)).toBe(decoded);
+    cpu.memory.write(entry, [0x90]);
+    expect(cpu.decoder.decode(entry).mnemonic).toBe('nop');
+  });
+
+  it('persists records in a cache directory', async () => {
+    const directory = mkdtempSync(path.join(tmpdir(), 'winejs-cache-'));
+    try {
+      const store = new FileCacheStore({ directory: path.join(directory, 'images') });
+      expect(await store.get('missing')).toBeNull();
+      await store.put('abc', '{"ok":true}');
+      expect(await new FileCacheStore({ directory: path.join(directory, 'images') }).get('abc')).toBe('{"ok":true}');
+      await store.delete('abc');
+      expect(await store.get('abc')).toBeNull();
+    } finally {
+      rmSync(directory, { recursive: true, force: true });
+    }
+  });
+
+  it('hands a streamed run the record of a file it has hashed before', async () => {
+    const wine = new WineJS({
+      imageCache: new ImageCache({ store: new MemoryCacheStore() }),
+      importPlugins: [],
+      simulatorPlugins: [createX86SimulatorPlugin({ getSimulatorClass: () => X86Simulator })],
+    });
+    const records = [];
+    const simulate = wine.simulateBinaryAsync.bind(wine);
+    wine.simulateBinaryAsync = (buffer, options) => {
+      records.push(options.cacheRecord ?? null);
+      return simulate(buffer, options);
+    };
+    const file = {
+      name: 'hello.exe',
+      size: HELLO_WORLD_BYTES.length,
+      lastModified: 1,
+      stream: () => new Blob([HELLO_WORLD_BYTES]).stream(),
+    };
+
+    await wine.runStreaming(file);
+    expect(wine.cacheStatus).toBe('miss');
+    await new Promise((resolve) => setTimeout(resolve, 0));
+    await wine.runStreaming(file);
+    expect(wine.cacheStatus).toBe('hit');
+    await wine.runStreaming({ ...file, lastModified: 2 });
+    expect(records[0]).toBe(null);
+    expect(records[1].code.length).toBeGreaterThan(0);
+    expect(records[2]).toBe(null);
+  });
+});
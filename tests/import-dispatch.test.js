@@ -0,0 +1,79 @@
+import { describe, it, expect, vi } from 'vitest';
+import { readFileSync } from 'node:fs';
+import path from 'node:path';
+import { createImportBinder } from '../src/runtime/import-handler.js';
+import { readAnsiString, readWideString } from '../src/runtime/memory-readers.js';
+import { createConsoleOutputImportPlugin } from '../src/runtime/import-plugins/console-output-plugin.js';
+import { SimulatorBridge } from '../src/runtime/simulator/simulator-bridge.js';
+import { createX86SimulatorPlugin } from '../src/runtime/simulator/plugins/x86-simulator-plugin.js';
+import { X86Simulator } from '../src/emulator/x86/simulator.js';
+
+const HELLO_WORLD_FIXTURE = JSON.parse(
+  readFileSync(path.join(process.cwd(), 'tests/fixtures/helloWorld.json'), 'utf8'),
+);
+const HELLO_WORLD_BYTES = new Uint8Array(Buffer.from(HELLO_WORLD_FIXTURE.helloWorldExe, 'base64'));
+
+function createBinder(plugins) {
+  return createImportBinder({
+    readAnsiString: (cpu, address, maxLength) => readAnsiString(cpu, address, new TextDecoder(), maxLength),
+    readWideString: (cpu, address, maxChars) => readWideString(cpu, address, new TextDecoder('utf-16le'), maxChars),
+    plugins,
+  });
+}
+
+function createTextCpu(text, base = 0x4000n) {
+  const bytes = new TextEncoder().encode(`${text}\u0000`);
+  return {
+    readRegister: (reg) => (reg === 'rdx' ? base : reg === 'r8' ? BigInt(text.length) : 0n),
+    memory: { readByte: (address) => bytes[Number(address - base)] ?? 0 },
+  };
+}
+
+describe('import dispatch binding', () => {
+  it('resolves plugin handlers once per import key', () => {
+    const consolePlugin = createConsoleOutputImportPlugin();
+    const resolveSpy = vi.spyOn(consolePlugin, 'resolveHandler');
+    const consoleLines = [];
+    const call = createBinder([consolePlugin])('kernel32.dll!WriteConsoleA', { consoleLines });
+    const cpu = createTextCpu('hi');
+    expect(call(cpu)).toEqual({ rax: 1 });
+    expect(call(cpu)).toEqual({ rax: 1 });
+    expect(consoleLines).toEqual(['hi', 'hi']);
+    expect(resolveSpy).toHaveBeenCalledTimes(1);
+  });
+
+  it('keeps match/handle plugins working behind the binder', () => {
+    const legacy = { match: ({ name }) => name.endsWith('Beep'), handle: () => ({ rax: 42 }) };
+    const binder = createBinder([createConsoleOutputImportPlugin(), legacy]);
+    expect(binder('kernel32.dll!Beep')({})).toEqual({ rax: 42 });
+    expect(binder('kernel32.dll!Sleep')({})).toEqual({ rax: 0 });
+    let gui = false;
+    binder('user32.dll!GetDC', { flagGui: () => (gui = true) })({});
+    expect(gui).toBe(true);
+  });
+
+  it('passes pending handler results through as normalized promises', async () => {
+    const blocking = { resolveHandler: (key) => (key.endsWith('recv') ? () => Promise.resolve(7) : null) };
+    const call = createBinder([blocking])('ws2_32.dll!recv');
+    const pending = call({});
+    expect(typeof pending.then).toBe('function');
+    expect(await pending).toEqual({ rax: 7 });
+  });
+
+  it('binds every import of the image into the CPU dispatch table', () => {
+    const binder = vi.fn(() => () => ({ rax: 0 }));
+    const bridge = new SimulatorBridge({ importHandler: () => ({ rax: 0 }), importBinder: binder });
+    bridge.registerPlugin(createX86SimulatorPlugin({ getSimulatorClass: () => X86Simulator }));
+    const { simulator } = bridge.createSimulator(HELLO_WORLD_BYTES);
+    const { hooks } = bridge.createRunContext();
+    try {
+      simulator.run({ hooks, maxSteps: 1 });
+    } catch {
+      // Only the dispatch table matters here.
+    }
+    const { cpu, pe } = simulator;
+    expect(cpu.importDispatch).toHaveLength(pe.importTable.length);
+    expect(cpu.importDispatch.every((entry) => typeof entry === 'function')).toBe(true);
+    expect(binder.mock.calls.map(([name]) => name)).toEqual(pe.importTable.map((entry) => entry.key));
+  });
+});
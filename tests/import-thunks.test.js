@@ -0,0 +1,142 @@
+import { describe, it, expect } from 'vitest';
+import { PeFile } from '../src/emulator/pe-file.js';
+import { X86CPU } from '../src/emulator/x86/cpu.js';
+import { THUNK_BASE, THUNK_STRIDE } from '../src/emulator/import-thunks.js';
+import { createModuleLoaderImportPlugin } from '../src/runtime/import-plugins/module-loader-plugin.js';
+import { PeImageBuilder } from './helpers/pe-builder.js';
+
+function rel32(value) {
+  const bytes = new Uint8Array(4);
+  new DataView(bytes.buffer).setInt32(0, value, true);
+  return Array.from(bytes);
+}
+
+// kernel32!Beep and kernel32!Sleep reached three ways: call [iat], a
+// `jmp [iat]` stub and an indirect call through a register.
+function buildThunkImage() {
+  const builder = new PeImageBuilder().section('.text', 0x1000, 0x200).section('.idata', 0x2000, 0x400);
+  builder
+    .bytes(0x1000, [0xff, 0x15, ...rel32(0x2100 - 0x1006)])
+    .bytes(0x1006, [0xe8, ...rel32(0x1020 - 0x100b)])
+    .bytes(0x100b, [0x48, 0x8b, 0x05, ...rel32(0x2100 - 0x1012)])
+    .bytes(0x1012, [0xff, 0xd0, 0xf4])
+    .bytes(0x1020, [0xff, 0x25, ...rel32(0x2108 - 0x1026)]);
+  builder
+    .u32(0x2000, 0x2080)
+    .u32(0x2000 + 12, 0x20c0)
+    .u32(0x2000 + 16, 0x2100)
+    .u64(0x2080, 0x2200)
+    .u64(0x2088, 0x2210)
+    .u64(0x2100, 0x2200)
+    .u64(0x2108, 0x2210)
+    .str(0x20c0, 'KERNEL32.dll')
+    .str(0x2202, 'Beep')
+    .str(0x2212, 'Sleep')
+    .directory(1, 0x2000, 40);
+  return new PeFile(builder.build());
+}
+
+describe('import thunks', () => {
+  it('fills IAT slots with addresses inside the thunk region', () => {
+    const pe = buildThunkImage();
+    const cpu = new X86CPU(pe);
+    pe.getImportDirectory().forEach((slot) => {
+      expect(cpu.memory.readUInt(slot.iatAddress, 8)).toBe(THUNK_BASE + BigInt(slot.id) * THUNK_STRIDE);
+    });
+  });
+
+  it('dispatches direct, stubbed and register calls through the thunk address', () => {
+    const cpu = new X86CPU(buildThunkImage());
+    const calls = [];
+    const hooks = {
+      bindImport: (key) => () => {
+        calls.push(key);
+        return { rax: calls.length };
+      },
+    };
+    const { imports } = cpu.run({ hooks, maxSteps: 64 });
+    expect(calls).toEqual(['kernel32.dll!Beep', 'kernel32.dll!Sleep', 'kernel32.dll!Beep']);
+    expect(imports.map((entry) => entry.name)).toEqual(['Beep', 'Sleep', 'Beep']);
+    expect(cpu.readRegister('rax')).toBe(3n);
+    expect(cpu.readRegister('rip')).toBe(0x140001014n);
+  });
+
+  it('hands out thunks for GetProcAddress on modules without an image', () => {
+    const cpu = new X86CPU(buildThunkImage());
+    const user32 = cpu.loader.ensureModule('USER32');
+    expect(user32.virtual).toBe(true);
+    const address = cpu.loader.getProcAddress(user32, 'MessageBoxW');
+    expect(cpu.thunks.entryAt(address)).toMatchObject({ key: 'user32.dll!MessageBoxW' });
+    expect(cpu.loader.getProcAddress('user32.dll', 'MessageBoxW')).toBe(address);
+    expect(cpu.thunks.entryAt(cpu.memory.readUInt(0x140002100n, 8)).name).toBe('Beep');
+  });
+
+  it('resolves system DLLs through the LoadLibrary and GetProcAddress imports', () => {
+    const cpu = new X86CPU(buildThunkImage());
+    const plugin = createModuleLoaderImportPlugin();
+    const strings = new Map([
+      [0x10000n, 'user32.dll'],
+      [0x20000n, 'MessageBoxA'],
+      [0x30000n, 'USER32'],
+    ]);
+    const call = (name, rcx, rdx = 0n) => {
+      cpu.writeRegister('rcx', rcx);
+      cpu.writeRegister('rdx', rdx);
+      const context = { cpu, readAnsiString: (_, pointer) => strings.get(pointer) };
+      return plugin.resolveHandler(`kernel32.dll!${name}`)(context).rax;
+    };
+    const module = call('loadlibrarya', 0x10000n);
+    expect(module).not.toBe(0n);
+    expect(call('getmodulehandlea', 0x30000n)).toBe(module);
+    const address = call('getprocaddress', module, 0x20000n);
+    expect(cpu.thunks.entryAt(address)).toMatchObject({ key: 'user32.dll!MessageBoxA' });
+  });
+
+  it('answers GetModuleHandle only for modules already in the process', () => {
+    const requested = [];
+    const cpu = new X86CPU(buildThunkImage(), { resolveImage: (name) => requested.push(name) && null });
+    const plugin = createModuleLoaderImportPlugin();
+    const strings = new Map([
+      [0x10000n, 'missing.dll'],
+      [0x20000n, 'user32.dll'],
+      [0x30000n, 'KERNEL32'],
+    ]);
+    const getModuleHandle = (pointer) => {
+      cpu.writeRegister('rcx', pointer);
+      const context = { cpu, readAnsiString: (_, address) => strings.get(address) };
+      return plugin.resolveHandler('kernel32.dll!getmodulehandlea')(context).rax;
+    };
+    const regions = cpu.memory.regions.length;
+    expect(getModuleHandle(0x10000n)).toBe(0n);
+    expect(getModuleHandle(0x20000n)).toBe(0n);
+    expect(cpu.loader.getModule('missing.dll')).toBeNull();
+    expect(cpu.memory.regions.length).toBe(regions);
+    const kernel32 = getModuleHandle(0x30000n);
+    expect(kernel32).not.toBe(0n);
+    expect(getModuleHandle(0x30000n)).toBe(kernel32);
+    expect(requested.filter((name) => name !== 'kernel32.dll')).toEqual([]);
+  });
+
+  it('parks on a pending import and resumes at the call site with its result', async () => {
+    const cpu = new X86CPU(buildThunkImage());
+    let release;
+    const blocked = new Promise((resolve) => (release = resolve));
+    const calls = [];
+    const hooks = {
+      bindImport: (key) => () => {
+        calls.push(key);
+        return key.endsWith('Sleep') ? blocked : { rax: 1 };
+      },
+    };
+    const parked = cpu.run({ hooks, maxSteps: 64 });
+    expect(parked.suspended).toBe(true);
+    expect(cpu.thunks.entryAt(cpu.readRegister('rip')).name).toBe('Sleep');
+    expect(() => cpu.run({ hooks })).toThrow(/suspended/);
+    const resumed = cpu.runAsync({ hooks, maxSteps: 4 });
+    setTimeout(() => release({ rax: 0x55 }), 0);
+    const result = await resumed;
+    expect(result.suspended).toBe(false);
+    expect(calls).toEqual(['kernel32.dll!Beep', 'kernel32.dll!Sleep', 'kernel32.dll!Beep']);
+    expect(cpu.readRegister('rip')).toBe(0x140001014n);
+  });
+});
@@ -0,0 +1,42 @@
+import { describe, it, expect } from 'vitest';
+import { ImportTrace, countImports } from '../src/emulator/import-trace.js';
+
+const ENTRIES = [
+  { id: 0, key: 'user32.dll!GetMessageW', dll: 'user32.dll', name: 'GetMessageW' },
+  { id: 1, key: 'user32.dll!DispatchMessageW', dll: 'user32.dll', name: 'DispatchMessageW' },
+];
+
+describe('ImportTrace', () => {
+  it('keeps exact counters while the ring only holds recent calls', () => {
+    const trace = new ImportTrace({ capacity: 4, importCount: 2 });
+    for (let step = 0; step < 1000; step++) trace.record(step & 1, step, BigInt(step));
+    expect(trace.total).toBe(1000);
+    expect(trace.length).toBe(4);
+    expect(trace.recent(ENTRIES).map(({ name, step, rax }) => [name, step, rax])).toEqual([
+      ['GetMessageW', 996, 996n],
+      ['DispatchMessageW', 997, 997n],
+      ['GetMessageW', 998, 998n],
+      ['DispatchMessageW', 999, 999n],
+    ]);
+    expect(trace.counters(ENTRIES).map(({ key, count }) => [key, count])).toEqual([
+      ['user32.dll!GetMessageW', 500],
+      ['user32.dll!DispatchMessageW', 500],
+    ]);
+  });
+
+  it('grows the counter table for imports interned after load', () => {
+    const trace = new ImportTrace({ capacity: 2 });
+    trace.record(40, 1, -1n);
+    expect(trace.counts[40]).toBe(1);
+    expect(trace.recent([])[0].rax).toBe(0xffffffffffffffffn);
+    trace.clear();
+    expect(trace.total).toBe(0);
+    expect(trace.counters([])).toEqual([]);
+  });
+
+  it('counts plain trace arrays from simulators without a ring', () => {
+    expect(countImports([{ dll: 'd3d11.dll', name: 'A' }, { dll: 'd3d11.dll', name: 'A' }])).toEqual([
+      { key: 'd3d11.dll!A', dll: 'd3d11.dll', name: 'A', count: 2 },
+    ]);
+  });
+});
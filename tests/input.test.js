@@ -0,0 +1,175 @@
+import { describe, it, expect } from 'vitest';
+import { createUser32ImportPlugin } from '../src/runtime/import-plugins/user32-plugin.js';
+import { keyLParam, translateKeyEvent, wheelDelta } from '../src/runtime/user32/dom-input.js';
+import { WindowStation } from '../src/runtime/user32/window-station.js';
+import { InputState } from '../src/runtime/user32/input-state.js';
+import {
+  MK_LBUTTON,
+  WM_KEYDOWN,
+  WM_KEYUP,
+  WM_LBUTTONDOWN,
+  WM_LBUTTONUP,
+  WM_MOUSEMOVE,
+  WM_MOUSEWHEEL,
+  WM_SYSKEYDOWN,
+  WS_CHILD,
+  WS_VISIBLE,
+  makeLParam,
+} from '../src/runtime/user32/messages.js';
+import { VK_SHIFT, VK_UP, virtualKeyForCode } from '../src/runtime/user32/virtual-keys.js';
+
+// Canvas stand-in that keeps its listeners and is drawn at half size, so
+// client coordinates are twice the CSS offsets.
+function createInputCanvas() {
+  const listeners = new Map();
+  return {
+    width: 200,
+    height: 100,
+    tabIndex: -1,
+    addEventListener: (type, listener) => listeners.set(type, listener),
+    removeEventListener: (type) => listeners.delete(type),
+    getBoundingClientRect: () => ({ left: 10, top: 20, width: 100, height: 50 }),
+    dispatch(type, fields = {}) {
+      listeners.get(type)?.({ preventDefault() {}, buttons: 0, ...fields });
+    },
+    listeners,
+  };
+}
+
+function createStation(clock) {
+  const canvas = createInputCanvas();
+  const station = new WindowStation({
+    windowManager: {
+      createWindow: () => 1,
+      getWindow: () => ({ canvas }),
+      showWindow() {},
+    },
+    requestFrame: () => 0,
+    hostNow: () => clock.now,
+  });
+  station.registerClass({ name: 'Pong', wndProc: 0n });
+  const window = station.createWindow({ className: 'Pong', x: 30, y: 40, width: 200, height: 100 });
+  station.showWindow(window, true);
+  return { station, canvas, window };
+}
+
+const drain = (queue) => {
+  const messages = [];
+  for (let msg = queue.next(); msg; msg = queue.next()) messages.push(msg);
+  return messages;
+};
+
+describe('DOM input translation', () => {
+  it('packs key message lParams the way Win32 does', () => {
+    expect(translateKeyEvent({ code: 'KeyW', key: 'w' }, true)).toEqual({
+      message: WM_KEYDOWN,
+      wParam: 0x57n,
+      lParam: 0x00110001n,
+      key: 0x57,
+      text: 'w',
+    });
+    expect(translateKeyEvent({ code: 'KeyW', key: 'w' }, false).lParam).toBe(0xc0110001n);
+    expect(translateKeyEvent({ code: 'KeyW', key: 'w', repeat: true }, true).lParam).toBe(0x40110001n);
+    expect(keyLParam(virtualKeyForCode('ArrowUp'), { down: true })).toBe(0x01480001n);
+    const altF4 = translateKeyEvent({ code: 'F4', key: 'F4', altKey: true }, true);
+    expect(altF4.message).toBe(WM_SYSKEYDOWN);
+    expect(altF4.lParam).toBe(0x203e0001n);
+    const shift = translateKeyEvent({ code: 'ShiftRight', key: 'Shift' }, true);
+    expect([shift.wParam, shift.key, shift.text]).toEqual([BigInt(VK_SHIFT), 0xa1, '']);
+    expect(translateKeyEvent({ code: 'Lang1' }, true)).toBe(null);
+    expect(wheelDelta({ deltaY: -100, deltaMode: 0 })).toBe(120);
+    expect(wheelDelta({ deltaY: 3, deltaMode: 1 })).toBe(-120);
+  });
+});
+
+describe('window station input', () => {
+  it('routes canvas events to windows, coalescing mouse moves', () => {
+    const clock = { now: 0 };
+    const { station, canvas, window } = createStation(clock);
+    expect(canvas.tabIndex).toBe(0);
+    const child = station.createWindow({
+      className: 'Pong',
+      style: WS_CHILD | WS_VISIBLE,
+      x: 100,
+      y: 0,
+      width: 100,
+      height: 100,
+      parent: window.hwnd,
+    });
+    station.showWindow(child, true);
+
+    canvas.dispatch('pointerdown', { button: 0, buttons: 1, clientX: 15, clientY: 25 });
+    canvas.dispatch('pointermove', { buttons: 1, clientX: 65, clientY: 25 });
+    canvas.dispatch('pointermove', { buttons: 1, clientX: 70, clientY: 30 });
+    canvas.dispatch('pointerup', { button: 0, clientX: 70, clientY: 30 });
+    canvas.dispatch('keydown', { code: 'ArrowUp', key: 'ArrowUp' });
+    canvas.dispatch('wheel', { deltaY: 100, deltaMode: 0, clientX: 10, clientY: 20 });
+    const messages = drain(station.queue());
+    expect(messages.map(({ hwnd, message, wParam, lParam }) => [hwnd, message, wParam, lParam])).toEqual([
+      [window.hwnd, WM_LBUTTONDOWN, BigInt(MK_LBUTTON), BigInt(makeLParam(10, 10))],
+      [child.hwnd, WM_MOUSEMOVE, BigInt(MK_LBUTTON), BigInt(makeLParam(20, 20))],
+      [child.hwnd, WM_LBUTTONUP, 0n, BigInt(makeLParam(20, 20))],
+      [window.hwnd, WM_KEYDOWN, BigInt(VK_UP), 0x01480001n],
+      [window.hwnd, WM_MOUSEWHEEL, BigInt(((-120 & 0xffff) << 16) >>> 0), BigInt(makeLParam(30, 40))],
+    ]);
+    expect(messages[1].pt).toEqual({ x: 30 + 120, y: 40 + 20 });
+
+    station.setCapture(child.hwnd);
+    canvas.dispatch('pointermove', { clientX: 15, clientY: 25 });
+    const [captured] = drain(station.queue());
+    expect([captured.hwnd, captured.lParam]).toEqual([child.hwnd, BigInt(makeLParam(-90, 10))]);
+
+    canvas.dispatch('keydown', { code: 'KeyS', key: 's' });
+    canvas.dispatch('blur');
+    expect(drain(station.queue()).map(({ message, wParam }) => [message, wParam])).toEqual([
+      [WM_KEYDOWN, 0x53n],
+      [WM_KEYUP, BigInt(VK_UP)],
+      [WM_KEYUP, 0x53n],
+    ]);
+    station.removeWindow(window.hwnd);
+    expect(canvas.listeners.size).toBe(0);
+  });
+
+  it('tracks async and message-time key state and measures input latency', () => {
+    const clock = { now: 100 };
+    const { station, canvas } = createStation(clock);
+    const plugin = createUser32ImportPlugin({ yieldToHost: null });
+    const registers = {};
+    const cpu = { readRegister: (name) => registers[name] ?? 0n, memory: { isRangeFree: () => false } };
+    const call = (name, ...args) => {
+      ['rcx', 'rdx', 'r8', 'r9'].forEach((register, index) => (registers[register] = args[index] ?? 0n));
+      return plugin.resolveHandler(`user32.dll!${name}`)({ cpu }).rax;
+    };
+    const guestStation = plugin.stationFor(cpu);
+    guestStation.input = station.input;
+
+    canvas.dispatch('keydown', { code: 'KeyW', key: 'w' });
+    expect(station.input.getAsyncKeyState(0x57)).toBe(-0x8000);
+    expect(station.input.getKeyState(0x57)).toBe(0);
+
+    clock.now = 104;
+    const [keyDown] = drain(station.queue()).map((msg) => (station.input.retrieve(msg), msg));
+    expect(keyDown.message).toBe(WM_KEYDOWN);
+    expect(call('getkeystate', 0x57n)).toBe(0xffffffffffff8001n);
+    expect(call('getasynckeystate', 0x57n)).toBe(0xffffffffffff8000n);
+    expect(call('getkeystate', 0x41n)).toBe(0n);
+
+    clock.now = 112;
+    station.gdi.onPresent();
+    expect(station.input.latency()).toEqual({ count: 1, last: 12, mean: 12, max: 12, queueDelay: 4 });
+    station.input.presented();
+    expect(station.input.latency().count).toBe(1);
+    station.dispose();
+  });
+
+  it('keeps a bounded backlog of inputs waiting for a frame', () => {
+    const clock = { now: 0 };
+    const input = new InputState({ now: () => clock.now });
+    for (let stamp = 0; stamp < 1000; stamp++) input.retrieve({ message: WM_KEYDOWN, wParam: 0x41n, input: { stamp } });
+    expect(input.retrieved.length).toBeLessThanOrEqual(128);
+    clock.now = 1000;
+    input.presented();
+    expect(input.retrieved).toHaveLength(0);
+    expect(input.latency()).toMatchObject({ count: 1000, last: 1, max: 128 });
+  });
+});
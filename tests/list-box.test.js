@@ -0,0 +1,145 @@
+import { describe, it, expect } from 'vitest';
+import { WindowStation } from '../src/runtime/user32/window-station.js';
+import {
+  LBN_SELCHANGE,
+  LBS_NOTIFY,
+  LBS_SORT,
+  LB_ADDSTRING,
+  LB_ERR,
+  LB_FINDSTRING,
+  LB_GETCOUNT,
+  LB_GETCURSEL,
+  LB_GETITEMDATA,
+  LB_GETTEXT,
+  LB_INSERTSTRING,
+  LB_RESETCONTENT,
+  LB_SETCURSEL,
+  LB_SETITEMDATA,
+  WM_KEYDOWN,
+  WM_PAINT,
+  WS_CHILD,
+} from '../src/runtime/user32/messages.js';
+import { VK_DOWN, VK_END } from '../src/runtime/user32/virtual-keys.js';
+
+function createList(station, style = 0) {
+  const window = station.createWindow({ className: 'ListBox', style: WS_CHILD | style, width: 120, height: 160 });
+  const strings = new Map();
+  let next = 0x1000n;
+  const io = {
+    readText: (pointer) => strings.get(pointer) ?? '',
+    writeText: (pointer, text, capacity) => {
+      strings.set(pointer, text.slice(0, capacity - 1));
+      return Math.min(text.length, capacity - 1);
+    },
+  };
+  const send = (message, wParam = 0n, lParam = 0n) => window.control.handle(message, wParam, lParam, io);
+  const add = (text) => {
+    next += 0x100n;
+    strings.set(next, text);
+    return send(LB_ADDSTRING, 0n, next).rax;
+  };
+  return { window, send, add, strings, queue: station.queue(window.threadId) };
+}
+
+// Records the text drawn and DCs opened while painting.
+function watchPaint(station) {
+  const drawn = [];
+  let opened = 0;
+  const { gdi } = station;
+  const textOut = gdi.textOut.bind(gdi);
+  const openDC = gdi.openDC.bind(gdi);
+  gdi.textOut = (hdc, x, y, text) => drawn.push(text) && textOut(hdc, x, y, text);
+  gdi.openDC = (...args) => {
+    opened++;
+    return openDC(...args);
+  };
+  return {
+    drawn,
+    get opened() {
+      return opened;
+    },
+  };
+}
+
+describe('ListBox', () => {
+  it('turns a reset and re-add of the same clients into an empty repaint', () => {
+    const station = new WindowStation();
+    const list = createList(station);
+    const clients = Array.from({ length: 3000 }, (_, index) => `user${index}`);
+    const update = (names) => {
+      list.send(LB_RESETCONTENT);
+      names.forEach(list.add);
+    };
+    update(clients);
+    const rows = list.window.control.shownRows();
+    const paint = watchPaint(station);
+    list.send(WM_PAINT);
+    expect(paint.drawn).toEqual(clients.slice(0, rows));
+
+    paint.drawn.length = 0;
+    update(clients);
+    expect(list.queue.isInvalid(list.window.hwnd)).toBe(true);
+    const opened = paint.opened;
+    list.send(WM_PAINT);
+    expect(paint.drawn).toEqual([]);
+    expect(paint.opened).toBe(opened);
+    expect(list.queue.isInvalid(list.window.hwnd)).toBe(false);
+    expect(list.window.control.pool.size).toBe(3000);
+
+    const left = clients.filter((name) => name !== 'user2' && name !== 'user2500');
+    update(left);
+    list.send(WM_PAINT);
+    expect(paint.drawn).toEqual(left.slice(2, rows));
+    expect(list.send(LB_GETCOUNT).rax).toBe(2998);
+
+    paint.drawn.length = 0;
+    update(left.concat('late'));
+    list.send(WM_PAINT);
+    expect(paint.drawn).toEqual([]);
+    station.dispose();
+  });
+
+  it('keeps the string pool bounded across changing contents', () => {
+    const station = new WindowStation();
+    const list = createList(station);
+    for (let round = 0; round < 20; round++) {
+      list.send(LB_RESETCONTENT);
+      for (let index = 0; index < 100; index++) list.add(`round${round}-${index}`);
+      list.send(WM_PAINT);
+    }
+    const control = list.window.control;
+    expect(control.pool.size).toBeLessThanOrEqual(control.count * 2 + 256);
+    const text = 0x9000n;
+    list.send(LB_GETTEXT, 99n, text);
+    expect(list.strings.get(text)).toBe('round19-99');
+    station.dispose();
+  });
+
+  it('sorts, finds, selects and carries item data', () => {
+    const station = new WindowStation();
+    const list = createList(station, LBS_SORT | LBS_NOTIFY);
+    ['delta', 'Alpha', 'charlie', 'bravo'].forEach(list.add);
+    const control = list.window.control;
+    expect(Array.from({ length: control.count }, (_, index) => control.text(index))).toEqual([
+      'Alpha',
+      'bravo',
+      'charlie',
+      'delta',
+    ]);
+    list.strings.set(0x8000n, 'CH');
+    expect(list.send(LB_FINDSTRING, -1n, 0x8000n).rax).toBe(2);
+    expect(list.send(LB_SETITEMDATA, 1n, 0x1234n).rax).toBe(1);
+
+    list.strings.set(0x8100n, 'aardvark');
+    expect(list.send(LB_INSERTSTRING, 0n, 0x8100n).rax).toBe(0);
+    expect(list.send(LB_GETITEMDATA, 2n).rax).toBe(0x1234n);
+    expect(list.send(LB_SETCURSEL, 9n).rax).toBe(LB_ERR);
+
+    expect(list.send(WM_KEYDOWN, BigInt(VK_DOWN)).notify).toBe(LBN_SELCHANGE);
+    expect(list.send(LB_GETCURSEL).rax).toBe(0);
+    list.send(WM_KEYDOWN, BigInt(VK_END));
+    expect(list.send(LB_GETCURSEL).rax).toBe(4);
+    expect(list.send(WM_KEYDOWN, BigInt(VK_END)).notify).toBe(null);
+    station.dispose();
+  });
+});
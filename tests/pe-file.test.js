@@ -0,0 +1,184 @@
+import { describe, it, expect } from 'vitest';
+import { readFileSync } from 'node:fs';
+import path from 'node:path';
+import { PeFile } from '../src/emulator/pe-file.js';
+import { X86Simulator } from '../src/emulator/x86/simulator.js';
+import { PeImageBuilder } from './helpers/pe-builder.js';
+
+const HELLO_WORLD_FIXTURE = JSON.parse(
+  readFileSync(path.join(process.cwd(), 'tests/fixtures/helloWorld.json'), 'utf8'),
+);
+const HELLO_WORLD_BYTES = new Uint8Array(Buffer.from(HELLO_WORLD_FIXTURE.helloWorldExe, 'base64'));
+
+function createSectionTable(sections, sizeOfImage) {
+  const pe = Object.create(PeFile.prototype);
+  pe.sections = sections;
+  pe.sizeOfImage = sizeOfImage;
+  pe.buildRvaIndex();
+  return pe;
+}
+
+describe('PeFile RVA translation', () => {
+  it('matches a linear section scan for every RVA in the image', () => {
+    const pe = new PeFile(HELLO_WORLD_BYTES);
+    for (let rva = 0; rva < pe.sizeOfImage + 0x2000; rva += 7) {
+      expect(pe.rvaToOffset(rva)).toBe(pe.scanSectionOffset(rva));
+    }
+    expect(pe.rvaToOffset(-16)).toBeNull();
+  });
+
+  it('falls back to the sorted section index for sub-page section alignment', () => {
+    const pe = createSectionTable(
+      [
+        { name: '.data', virtualAddress: 0x1200, virtualSize: 0x80, sizeOfRawData: 0x200, pointerToRawData: 0x600 },
+        { name: '.text', virtualAddress: 0x1000, virtualSize: 0x180, sizeOfRawData: 0x200, pointerToRawData: 0x400 },
+      ],
+      0x2000,
+    );
+    expect(pe.rvaToOffset(0x1010)).toBe(0x410);
+    expect(pe.rvaToOffset(0x1210)).toBe(0x610);
+    expect(pe.rvaToOffset(0x1400)).toBeNull();
+    expect(pe.rvaToOffset(0x1800)).toBeNull();
+  });
+});
+
+describe('PeFile import parsing', () => {
+  function buildImportImage() {
+    const builder = new PeImageBuilder().section('.idata', 0x2000, 0x400);
+    // kernel32.dll: one named import plus one by ordinal.
+    builder
+      .u32(0x2000, 0x2100)
+      .u32(0x2000 + 12, 0x2180)
+      .u32(0x2000 + 16, 0x2140)
+      .u64(0x2100, 0x2200)
+      .u64(0x2108, (1n << 63n) | 17n)
+      .u64(0x2140, 0x2200)
+      .u64(0x2148, (1n << 63n) | 17n)
+      .str(0x2180, 'KERNEL32.dll')
+      .u16(0x2200, 3)
+      .str(0x2202, 'WriteConsoleW')
+      .directory(1, 0x2000, 40);
+    // Delay-loaded user32.dll importing the same name twice resolves to one ID.
+    builder
+      .u32(0x2300, 1)
+      .u32(0x2304, 0x2380)
+      .u32(0x2308, 0x2390)
+      .u32(0x230c, 0x23a0)
+      .u32(0x2310, 0x23c0)
+      .str(0x2380, 'USER32.dll')
+      .u64(0x23c0, 0x2220)
+      .u64(0x23c8, 0x2220)
+      .u16(0x2220, 0)
+      .str(0x2222, 'MessageBoxW')
+      .directory(13, 0x2300, 64);
+    return new PeFile(builder.build());
+  }
+
+  it('resolves named, ordinal and delay-load imports with stable IDs', () => {
+    const pe = buildImportImage();
+    const slots = pe.getImportDirectory();
+    expect(slots.map((slot) => slot.key)).toEqual([
+      'kernel32.dll!WriteConsoleW',
+      'kernel32.dll!#17',
+      'user32.dll!MessageBoxW',
+      'user32.dll!MessageBoxW',
+    ]);
+    expect(slots[1]).toMatchObject({ ordinal: 17, delayLoad: false });
+    expect(slots[2]).toMatchObject({ delayLoad: true, iatAddress: pe.imageBase + 0x23a0n });
+    expect(slots[2].id).toBe(slots[3].id);
+    expect(pe.importTable).toHaveLength(3);
+    expect(pe.importTable[slots[0].id].hint).toBe(3);
+    expect(pe.imports.get(pe.imageBase + 0x2148n).key).toBe('kernel32.dll!#17');
+    expect(pe.delayImports[0]).toMatchObject({ dll: 'user32.dll', iatRva: 0x23a0 });
+  });
+
+  it('parses the import directory once and reuses the result', () => {
+    const pe = buildImportImage();
+    expect(pe.getImportDirectory()).toBe(pe.getImportDirectory());
+  });
+});
+
+describe('Module loading', () => {
+  function buildLibraryImage() {
+    const builder = new PeImageBuilder({ characteristics: 0x2022 })
+      .section('.text', 0x1000, 0x200)
+      .section('.edata', 0x2000, 0x200)
+      .section('.data', 0x3000, 0x200)
+      .section('.reloc', 0x4000, 0x200);
+    builder
+      .u32(0x2000 + 12, 0x2100)
+      .u32(0x2000 + 16, 5)
+      .u32(0x2000 + 20, 2)
+      .u32(0x2000 + 24, 1)
+      .u32(0x2000 + 28, 0x2040)
+      .u32(0x2000 + 32, 0x2060)
+      .u32(0x2000 + 36, 0x2070)
+      .u32(0x2040, 0x1000)
+      .u32(0x2044, 0x1010)
+      .u32(0x2060, 0x2110)
+      .u16(0x2070, 1)
+      .str(0x2100, 'mylib.dll')
+      .str(0x2110, 'Foo')
+      .directory(0, 0x2000, 0x120);
+    builder
+      .u64(0x3000, 0x140001000n)
+      .u32(0x4000, 0x3000)
+      .u32(0x4004, 12)
+      .u16(0x4008, (10 << 12) | 0)
+      .directory(5, 0x4000, 12);
+    return builder.build();
+  }
+
+  function buildMainImage() {
+    return new PeImageBuilder()
+      .section('.text', 0x1000, 0x200)
+      .section('.idata', 0x2000, 0x200)
+      .u32(0x2000, 0x2100)
+      .u32(0x2000 + 12, 0x2180)
+      .u32(0x2000 + 16, 0x2140)
+      .u64(0x2100, 0x2190)
+      .u64(0x2140, 0x2190)
+      .str(0x2180, 'MYLIB.dll')
+      .u16(0x2190, 0)
+      .str(0x2192, 'Foo')
+      .directory(1, 0x2000, 40)
+      .build();
+  }
+
+  it('rebases a conflicting image and resolves exports by name and ordinal', () => {
+    const simulator = new X86Simulator(buildMainImage());
+    const module = simulator.loadModule(buildLibraryImage(), 'mylib.dll');
+    const { loader, memory } = simulator.cpu;
+    expect(module.base).not.toBe(0x140000000n);
+    expect(module.relocated).toBe(1);
+    expect(memory.readUInt(module.base + 0x3000n, 8)).toBe(module.base + 0x1000n);
+    expect(loader.getProcAddress('MYLIB', 'Foo')).toBe(module.base + 0x1010n);
+    expect(loader.getProcAddress('mylib.dll', 5)).toBe(module.base + 0x1000n);
+    expect(loader.getProcAddress('mylib.dll', 'Missing')).toBeNull();
+    expect(memory.readUInt(0x140002140n, 8)).toBe(module.base + 0x1010n);
+  });
+
+  it('binds main image imports against modules supplied up front', () => {
+    const simulator = new X86Simulator(buildMainImage(), { modules: { 'MyLib.DLL': buildLibraryImage() } });
+    const { loader, memory } = simulator.ensureCpu();
+    const module = loader.getModule('mylib');
+    expect(module).not.toBeNull();
+    expect(memory.readUInt(0x140002140n, 8)).toBe(module.base + 0x1010n);
+    simulator.reset();
+    expect(memory.readUInt(0x140002140n, 8)).toBe(module.base + 0x1010n);
+    expect(memory.tracking).toBe(false);
+  });
+
+  it('restores loaded modules on reset, from a checkpoint only when asked for one', () => {
+    for (const checkpoint of [false, true]) {
+      const simulator = new X86Simulator(buildMainImage(), { checkpoint });
+      const module = simulator.loadModule(buildLibraryImage(), 'mylib.dll');
+      simulator.cpu.memory.writeUInt(0x140002140n, 8, 0n);
+      simulator.reset();
+      const { loader, memory } = simulator.cpu;
+      expect(memory.tracking).toBe(checkpoint);
+      expect(loader.getModule('mylib').base).toBe(module.base);
+      expect(memory.readUInt(0x140002140n, 8)).toBe(module.base + 0x1010n);
+    }
+  });
+});
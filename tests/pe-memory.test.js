@@ -0,0 +1,120 @@
+import { describe, it, expect } from 'vitest';
+import { readFileSync } from 'node:fs';
+import path from 'node:path';
+import { PeFile } from '../src/emulator/pe-file.js';
+import { PeMemory } from '../src/emulator/pe-memory.js';
+import { GuestStack, PAGE_SIZE, STACK_TOP } from '../src/emulator/guest-stack.js';
+import { X86CPU } from '../src/emulator/x86/cpu.js';
+
+const HELLO_WORLD_FIXTURE = JSON.parse(
+  readFileSync(path.join(process.cwd(), 'tests/fixtures/helloWorld.json'), 'utf8'),
+);
+const HELLO_WORLD_BYTES = new Uint8Array(Buffer.from(HELLO_WORLD_FIXTURE.helloWorldExe, 'base64'));
+
+function createPe(overrides = {}) {
+  return {
+    buffer: new Uint8Array(64),
+    vaToOffset() {
+      return 0;
+    },
+    imageBase: 0n,
+    entryRva: 0,
+    getImportDirectory() {
+      return [];
+    },
+    imports: new Map(),
+    ...overrides,
+  };
+}
+
+describe('guest stack region', () => {
+  it('sizes the stack from the PE header reserve and commit', () => {
+    const pe = new PeFile(HELLO_WORLD_BYTES);
+    const memory = new PeMemory(pe);
+    expect(pe.sizeOfStackReserve).toBeGreaterThan(0);
+    expect(memory.stack.size).toBe(Math.ceil(pe.sizeOfStackReserve / PAGE_SIZE) * PAGE_SIZE);
+    expect(memory.stack.top).toBe(STACK_TOP);
+  });
+
+  it('starts the CPU with rsp inside the committed stack', () => {
+    const cpu = new X86CPU(createPe());
+    const rsp = cpu.readRegister('rsp');
+    expect(cpu.memory.stack.contains(rsp, 8)).toBe(true);
+    expect(rsp % 16n).toBe(8n);
+  });
+
+  it('round-trips push and pop through the stack region', () => {
+    const cpu = new X86CPU(createPe());
+    const start = cpu.readRegister('rsp');
+    cpu.push(0x1122334455667788n);
+    cpu.push(-1n);
+    expect(cpu.readRegister('rsp')).toBe(start - 16n);
+    expect(cpu.memory.readUInt(start - 8n, 8)).toBe(0x1122334455667788n);
+    expect(cpu.pop()).toBe(0xffffffffffffffffn);
+    expect(cpu.pop()).toBe(0x1122334455667788n);
+    expect(cpu.readRegister('rsp')).toBe(start);
+    expect(cpu.memory.pages.size).toBe(0);
+  });
+
+  it('commits the guard page on touch and faults below it', () => {
+    const stack = new GuestStack({ reserve: PAGE_SIZE * 4, commit: PAGE_SIZE });
+    const guard = stack.guardPage;
+    stack.writeUInt64(guard, 7n);
+    expect(stack.readUInt64(guard)).toBe(7n);
+    expect(stack.guardPage).toBe(guard - BigInt(PAGE_SIZE));
+    expect(() => stack.readUInt64(stack.guardPage - BigInt(PAGE_SIZE))).toThrow(/access violation/);
+    stack.readUInt64(stack.guardPage);
+    expect(() => stack.readUInt64(stack.guardPage)).toThrow(/Stack overflow/);
+  });
+});
+
+describe('dirty page tracking', () => {
+  it('restores only pages written since the checkpoint', () => {
+    const cpu = new X86CPU(createPe());
+    cpu.memory.writeUInt(0x5000n, 8, 0xaan);
+    cpu.checkpoint();
+    cpu.memory.writeUInt(0x5000n, 8, 0xbbn);
+    cpu.memory.write(0x9ffen, new Uint8Array([1, 2, 3, 4]));
+    cpu.push(0x42n);
+    cpu.writeRegister('rax', 7n);
+    expect(cpu.memory.dirtyPages.pages()).toEqual([0x5, 0x9, 0xa, 0xfffff]);
+    expect(cpu.restoreCheckpoint()).toBe(4);
+    expect(cpu.memory.readUInt(0x5000n, 8)).toBe(0xaan);
+    expect(cpu.memory.pages.has(0xa)).toBe(false);
+    expect(cpu.readRegister('rax')).toBe(0n);
+    expect(cpu.memory.readUInt(cpu.readRegister('rsp') - 8n, 8)).toBe(0n);
+  });
+
+  it('leaves dirty state alone when a tracked write faults', () => {
+    const cpu = new X86CPU(createPe({ buffer: new Uint8Array(0x3000), vaToOffset: (address) => Number(address) }));
+    cpu.checkpoint();
+    cpu.memory.residency = { loaded: 0x2000 };
+    expect(() => cpu.memory.writeUInt(0x1ffcn, 8, 0x1122334455667788n)).toThrow(/not resident/);
+    expect(cpu.memory.dirtyPages.pages()).toEqual([]);
+    expect(() => cpu.createSnapshot()).not.toThrow();
+
+    cpu.memory.residency.loaded = 0x3000;
+    cpu.memory.writeUInt(0x1ffcn, 8, 0x1122334455667788n);
+    expect(cpu.memory.getDirtyPages().map(({ page, bytes }) => [page, bytes.length])).toEqual([
+      [1, PAGE_SIZE],
+      [2, PAGE_SIZE],
+    ]);
+    cpu.restoreCheckpoint();
+    expect(cpu.memory.readUInt(0x1ffcn, 8)).toBe(0n);
+  });
+
+  it('round-trips incremental snapshots against the checkpoint', () => {
+    const cpu = new X86CPU(createPe());
+    cpu.checkpoint();
+    cpu.memory.writeUInt(0x7000n, 4, 0xdeadbeefn);
+    cpu.push(0x99n);
+    cpu.writeRegister('rbx', 0x1234n);
+    const snapshot = cpu.createSnapshot();
+    cpu.restoreCheckpoint();
+    expect(cpu.memory.readUInt(0x7000n, 4)).toBe(0n);
+    cpu.restoreSnapshot(snapshot);
+    expect(cpu.memory.readUInt(0x7000n, 4)).toBe(0xdeadbeefn);
+    expect(cpu.pop()).toBe(0x99n);
+    expect(cpu.readRegister('rbx')).toBe(0x1234n);
+  });
+});
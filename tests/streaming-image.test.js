@@ -0,0 +1,104 @@
+import { describe, it, expect } from 'vitest';
+import { StreamingImage } from '../src/emulator/streaming-image.js';
+import { X86Simulator } from '../src/emulator/x86/simulator.js';
+import { PeImageBuilder } from './helpers/pe-builder.js';
+
+function buildImage() {
+  return new PeImageBuilder()
+    .section('.text', 0x1000, 0x200)
+    .section('.data', 0x3000, 0x200)
+    .bytes(0x1000, [0x48, 0xbb])
+    .u64(0x1002, 0x140003000n)
+    .bytes(0x100a, [0x48, 0x8b, 0x03, 0xf4])
+    .u64(0x3000, 0x1122334455667788n)
+    .build();
+}
+
+// `add qword [rbx], 1` on a qword straddling two .data pages, then reads it
+// back into rax.
+function buildStraddlingImage() {
+  return new PeImageBuilder()
+    .section('.text', 0x1000, 0x200)
+    .section('.data', 0x3000, 0x2000)
+    .section('.reloc', 0x5000, 0x200, 0x42000040)
+    .directory(5, 0x5000, 8)
+    .bytes(0x1000, [0x48, 0xbb])
+    .u64(0x1002, 0x140003ffcn)
+    .bytes(0x100a, [0x48, 0x83, 0x03, 0x01, 0x48, 0x8b, 0x03, 0xf4])
+    .u64(0x3ffc, 0xffffffffn)
+    .build();
+}
+
+function streamOf(bytes, chunkSize) {
+  let offset = 0;
+  return new ReadableStream({
+    pull(controller) {
+      if (offset >= bytes.length) {
+        controller.close();
+        return;
+      }
+      controller.enqueue(bytes.slice(offset, offset + chunkSize));
+      offset += chunkSize;
+    },
+  });
+}
+
+describe('streaming image loading', () => {
+  it('parses headers and reports the resident prefix needed to start', async () => {
+    const bytes = buildImage();
+    const image = new StreamingImage(bytes.length);
+    const consuming = image.consume(streamOf(bytes, 0x100));
+    const pe = await image.readHeaders();
+    expect(pe.entryRva).toBe(0x1000);
+    expect(image.startOffset(pe)).toBe(0x600);
+    await consuming;
+    expect(image.loaded).toBe(bytes.length);
+    expect(Array.from(image.buffer)).toEqual(Array.from(bytes));
+  });
+
+  it('parks the CPU on a page fault until the chunk arrives', async () => {
+    const bytes = buildImage();
+    const image = new StreamingImage(bytes.length);
+    image.append(bytes.subarray(0, 0x600));
+    const pe = await image.readHeaders();
+    const simulator = new X86Simulator(image.buffer, { pe, streamingImage: image });
+    expect(() => simulator.run()).toThrow(/not resident/);
+
+    const running = simulator.runAsync();
+    await Promise.resolve();
+    expect(simulator.cpu.readRegister('rax')).toBe(0n);
+    image.append(bytes.subarray(0x600));
+    image.finish();
+    await running;
+    expect(simulator.cpu.readRegister('rax')).toBe(0x1122334455667788n);
+  });
+
+  it('keeps relocations resident and retries a faulting store from scratch', async () => {
+    const bytes = buildStraddlingImage();
+    const image = new StreamingImage(bytes.length);
+    image.append(bytes.subarray(0, 0x400));
+    const pe = await image.readHeaders();
+    const dataOffset = pe.sections[1].pointerToRawData;
+    expect(image.startOffset(pe)).toBe(bytes.length);
+
+    // The qword itself is resident but the rest of its second page is not,
+    // so the store faults after the load has succeeded.
+    image.append(bytes.subarray(0x400, dataOffset + 0x1008));
+    const simulator = new X86Simulator(image.buffer, { pe, streamingImage: image });
+    const running = simulator.runAsync();
+    await new Promise((resolve) => setTimeout(resolve, 0));
+    expect(simulator.cpu.memory.readUInt(0x140003ffcn, 4)).toBe(0xffffffffn);
+    image.append(bytes.subarray(dataOffset + 0x1008));
+    image.finish();
+    expect((await running).exitReason).toBe('halt');
+    expect(simulator.cpu.readRegister('rax')).toBe(0x100000000n);
+  });
+
+  it('rejects waiters when the stream ends early', async () => {
+    const image = new StreamingImage(0x2000);
+    image.append(new Uint8Array(0x100));
+    const waiting = image.waitFor(0x1000);
+    image.finish();
+    await expect(waiting).rejects.toThrow(/Stream ended/);
+  });
+});
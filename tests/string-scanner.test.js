@@ -0,0 +1,89 @@
+import { describe, it, expect } from 'vitest';
+import { scanStringsInRange, extractPrintableStrings } from '../src/runtime/strings/string-scanner.js';
+import { StringScanPool } from '../src/runtime/strings/string-scan-pool.js';
+
+function legacyExtract(buffer) {
+  const strings = [];
+  let current = '';
+  for (const byte of buffer) {
+    if ((byte >= 32 && byte <= 126) || byte === 10 || byte === 13) current += String.fromCharCode(byte);
+    else if (current) {
+      strings.push(current);
+      current = '';
+    }
+  }
+  if (current) strings.push(current);
+  return strings;
+}
+
+function seededBytes(length, seed = 7) {
+  const bytes = new Uint8Array(length);
+  let state = seed;
+  for (let i = 0; i < length; i++) {
+    state = (state * 1103515245 + 12345) >>> 0;
+    const roll = state >>> 24;
+    bytes[i] = roll < 150 ? 32 + (roll % 95) : roll < 200 ? 0 : roll;
+  }
+  return bytes;
+}
+
+function wide(text) {
+  return Array.from(text).flatMap((ch) => [ch.charCodeAt(0), 0]);
+}
+
+function fakeWorkerFactory() {
+  return () => ({
+    postMessage(data) {
+      setTimeout(() => {
+        const strings = scanStringsInRange(data.bytes, data.start, data.end, data.options);
+        this.onmessage({ data: { id: data.id, strings } });
+      }, 0);
+    },
+    terminate() {},
+  });
+}
+
+describe('string scanner', () => {
+  it('matches the byte-at-a-time scan regardless of alignment', () => {
+    const bytes = seededBytes(4099);
+    expect(extractPrintableStrings(bytes)).toEqual(legacyExtract(bytes));
+    expect(extractPrintableStrings(bytes.subarray(1))).toEqual(legacyExtract(bytes.subarray(1)));
+  });
+
+  it('finds ASCII and UTF-16LE runs above the minimum length', () => {
+    const bytes = Uint8Array.from([0, 0, ...wide('Hello World'), 0, 0, 1, ...Array.from('abc\0abcdef', (c) => c.charCodeAt(0))]);
+    const found = scanStringsInRange(bytes, 0, bytes.length, { minLength: 4 });
+    expect(found.map(({ offset, encoding, value }) => [offset, encoding, value])).toEqual([
+      [2, 'utf-16le', 'Hello World'],
+      [31, 'ascii', 'abcdef'],
+    ]);
+  });
+
+  it('delivers chunked results in order with section attribution', async () => {
+    const bytes = seededBytes(2048, 11);
+    bytes.fill(65, 120, 300);
+    const sections = [{ name: '.rdata', pointerToRawData: 1024, sizeOfRawData: 1024 }];
+    const batches = [];
+    const pool = new StringScanPool({ createWorker: () => null, chunkSize: 64 });
+    const strings = await pool.scan(bytes, { sections, onStrings: (batch) => batches.push(batch) });
+    const whole = scanStringsInRange(bytes, 0, bytes.length);
+    expect(strings.map(({ offset, value }) => [offset, value])).toEqual(whole.map(({ offset, value }) => [offset, value]));
+    expect(batches.length).toBeGreaterThan(1);
+    expect(batches.flat()).toEqual(strings);
+    expect(strings.find((entry) => entry.offset >= 1024).section).toBe('.rdata');
+    expect(strings.find((entry) => entry.offset < 1024).section).toBeNull();
+  });
+
+  it('completes runs that outgrow a worker chunk', async () => {
+    const bytes = seededBytes(1024, 3);
+    bytes.fill(66, 50, 400);
+    bytes.set(wide('W'.repeat(60)), 500);
+    const pool = new StringScanPool({ workerCount: 3, createWorker: fakeWorkerFactory(), chunkSize: 64 });
+    const strings = await pool.scan(bytes);
+    const whole = scanStringsInRange(bytes, 0, bytes.length);
+    expect(strings.map(({ offset, length, encoding }) => [offset, length, encoding])).toEqual(
+      whole.map(({ offset, length, encoding }) => [offset, length, encoding]),
+    );
+    pool.dispose();
+  });
+});
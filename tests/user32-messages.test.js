@@ -0,0 +1,266 @@
+import { describe, it, expect } from 'vitest';
+import { PeFile } from '../src/emulator/pe-file.js';
+import { X86CPU } from '../src/emulator/x86/cpu.js';
+import { createImportBinder } from '../src/runtime/import-handler.js';
+import { readAnsiString, readWideString } from '../src/runtime/memory-readers.js';
+import { createUser32ImportPlugin } from '../src/runtime/import-plugins/user32-plugin.js';
+import { ThreadMessageQueue } from '../src/runtime/user32/message-queue.js';
+import { WindowStation } from '../src/runtime/user32/window-station.js';
+import { X86Simulator } from '../src/emulator/x86/simulator.js';
+import { createX86SimulatorPlugin } from '../src/runtime/simulator/plugins/x86-simulator-plugin.js';
+import { WineJS } from '../src/runtime/wine-js.js';
+import { WM_MOUSEMOVE, WM_PAINT, WM_QUIT, WM_TIMER, WM_USER } from '../src/runtime/user32/messages.js';
+import { PeImageBuilder } from './helpers/pe-builder.js';
+import { Assembler } from './helpers/assembler.js';
+
+const IMAGE_BASE = 0x140000000n;
+const IMPORTS = [
+  'RegisterClassExW',
+  'CreateWindowExW',
+  'PostMessageW',
+  'GetMessageW',
+  'DispatchMessageW',
+  'PostQuitMessage',
+  'DefWindowProcW',
+  'SendMessageW',
+];
+const WNDCLASS = 0x3000;
+const CLASS_NAME = 0x3100;
+const MSG = 0x3200;
+const POSTED_VALUE = 0x3300;
+const SENT_VALUE = 0x3308;
+
+// Registers a class, creates a window (whose WM_CREATE handler SendMessages
+// itself), posts WM_USER+1 and pumps GetMessage/DispatchMessage until the
+// WndProc answers the posted message with PostQuitMessage.
+function buildWindowImage() {
+  const builder = new PeImageBuilder()
+    .section('.text', 0x1000, 0x200)
+    .section('.idata', 0x2000, 0x400)
+    .section('.data', 0x3000, 0x400, 0xc0000040);
+  const iat = builder.imports(0x2000, 'USER32.dll', IMPORTS);
+  const asm = new Assembler(0x1000);
+  asm
+    .emit(0x48, 0x83, 0xec, 0x68)
+    .ripRel([0x48, 0x8d, 0x0d], WNDCLASS)
+    .call(iat.RegisterClassExW)
+    .emit(0x31, 0xc9)
+    .ripRel([0x48, 0x8d, 0x15], CLASS_NAME)
+    .emit(0x45, 0x31, 0xc0, 0x45, 0x31, 0xc9)
+    .call(iat.CreateWindowExW)
+    .emit(0x48, 0x89, 0xc1)
+    .emit(0xba, 0x01, 0x04, 0x00, 0x00)
+    .emit(0x41, 0xb8, 0x07, 0x00, 0x00, 0x00)
+    .emit(0x45, 0x31, 0xc9)
+    .call(iat.PostMessageW)
+    .label('loop')
+    .ripRel([0x48, 0x8d, 0x0d], MSG)
+    .emit(0x31, 0xd2, 0x45, 0x31, 0xc0, 0x45, 0x31, 0xc9)
+    .call(iat.GetMessageW)
+    .emit(0x85, 0xc0)
+    .jump(0x74, 'done')
+    .ripRel([0x48, 0x8d, 0x0d], MSG)
+    .call(iat.DispatchMessageW)
+    .jump(0xeb, 'loop')
+    .label('done')
+    .emit(0xf4);
+  const wndProc = asm.here;
+  asm
+    .emit(0x48, 0x83, 0xec, 0x28)
+    .emit(0x81, 0xfa, 0x01, 0x04, 0x00, 0x00)
+    .jump(0x74, 'posted')
+    .emit(0x81, 0xfa, 0x02, 0x04, 0x00, 0x00)
+    .jump(0x74, 'sent')
+    .emit(0x83, 0xfa, 0x01)
+    .jump(0x74, 'create')
+    .call(iat.DefWindowProcW)
+    .emit(0x48, 0x83, 0xc4, 0x28, 0xc3)
+    .label('posted')
+    .ripRel([0x4c, 0x89, 0x05], POSTED_VALUE)
+    .emit(0x31, 0xc9)
+    .call(iat.PostQuitMessage)
+    .jump(0xeb, 'return')
+    .label('sent')
+    .ripRel([0x4c, 0x89, 0x05], SENT_VALUE)
+    .jump(0xeb, 'return')
+    .label('create')
+    .emit(0xba, 0x02, 0x04, 0x00, 0x00)
+    .emit(0x41, 0xb8, 0x05, 0x00, 0x00, 0x00)
+    .emit(0x45, 0x31, 0xc9)
+    .call(iat.SendMessageW)
+    .label('return')
+    .emit(0x31, 0xc0, 0x48, 0x83, 0xc4, 0x28, 0xc3);
+
+  builder.bytes(0x1000, asm.bytes());
+  builder
+    .u32(WNDCLASS, 80)
+    .u64(WNDCLASS + 8, IMAGE_BASE + BigInt(wndProc))
+    .u64(WNDCLASS + 64, IMAGE_BASE + BigInt(CLASS_NAME))
+    .bytes(CLASS_NAME, [0x44, 0, 0x65, 0, 0x6d, 0, 0x6f, 0, 0, 0]);
+  return new PeFile(builder.build());
+}
+
+// Pumps GetMessageW on an empty queue until it returns WM_QUIT, then halts.
+function buildMessageLoopImage() {
+  const builder = new PeImageBuilder()
+    .section('.text', 0x1000, 0x200)
+    .section('.idata', 0x2000, 0x400)
+    .section('.data', 0x3000, 0x400, 0xc0000040);
+  const iat = builder.imports(0x2000, 'USER32.dll', ['GetMessageW']);
+  const asm = new Assembler(0x1000);
+  asm
+    .emit(0x48, 0x83, 0xec, 0x28)
+    .label('loop')
+    .ripRel([0x48, 0x8d, 0x0d], MSG)
+    .emit(0x31, 0xd2, 0x45, 0x31, 0xc0, 0x45, 0x31, 0xc9)
+    .call(iat.GetMessageW)
+    .emit(0x85, 0xc0)
+    .jump(0x75, 'loop')
+    .emit(0xf4);
+  builder.bytes(0x1000, asm.bytes());
+  return builder.build();
+}
+
+function createHooks(plugin) {
+  const bind = createImportBinder({
+    readAnsiString: (cpu, address, maxLength) => readAnsiString(cpu, address, new TextDecoder(), maxLength),
+    readWideString: (cpu, address, maxChars) => readWideString(cpu, address, new TextDecoder('utf-16le'), maxChars),
+    plugins: [plugin],
+  });
+  return { bindImport: (key) => bind(key, {}) };
+}
+
+describe('ThreadMessageQueue', () => {
+  it('retrieves posted, quit, paint and timer messages in GetMessage order', () => {
+    const queue = new ThreadMessageQueue(1, { now: () => 0 });
+    const timer = queue.addTimer(7, 1, 0n);
+    queue.fireTimer(timer);
+    queue.fireTimer(timer);
+    queue.invalidate(7);
+    queue.invalidate(7);
+    queue.post(7, WM_MOUSEMOVE, 0n, 1n);
+    queue.post(7, WM_MOUSEMOVE, 0n, 2n);
+    queue.post(7, WM_USER);
+    queue.post(7, WM_MOUSEMOVE, 0n, 3n);
+    const drained = [];
+    for (let msg = queue.next(); msg; msg = queue.next()) {
+      drained.push([msg.message, Number(msg.lParam)]);
+      if (msg.message === WM_PAINT) queue.validate(msg.hwnd);
+    }
+    expect(drained).toEqual([
+      [WM_MOUSEMOVE, 2],
+      [WM_USER, 0],
+      [WM_MOUSEMOVE, 3],
+      [WM_PAINT, 0],
+      [WM_TIMER, 0],
+    ]);
+    queue.postQuit(3);
+    queue.invalidate(7);
+    expect(queue.next({ min: WM_PAINT, max: WM_PAINT }, false).message).toBe(WM_QUIT);
+    expect(queue.next().wParam).toBe(3n);
+    expect(queue.next().message).toBe(WM_PAINT);
+    expect(queue.next().message).toBe(WM_PAINT);
+  });
+
+  it('drives window timers from the injected interval source', () => {
+    const intervals = new Map();
+    const station = new WindowStation({
+      setInterval: (fn, ms) => {
+        intervals.set(intervals.size + 1, { fn, ms });
+        return intervals.size;
+      },
+      clearInterval: (id) => intervals.delete(id),
+    });
+    station.registerClass({ name: 'Demo', wndProc: 0n });
+    const window = station.createWindow({ className: 'demo', x: 0, y: 0, width: 10, height: 10 });
+    expect(station.setTimer(window.hwnd, 4n, 1, 0n)).toBe(4n);
+    expect(intervals.get(1).ms).toBe(10);
+    intervals.get(1).fn();
+    intervals.get(1).fn();
+    const queue = station.queue();
+    expect(queue.next()).toMatchObject({ hwnd: window.hwnd, message: WM_TIMER, wParam: 4n });
+    expect(queue.next()).toBe(null);
+    station.removeWindow(window.hwnd);
+    expect(intervals.size).toBe(0);
+  });
+});
+
+describe('user32 import plugin', () => {
+  it('runs the guest WndProc for sent, posted and created messages', async () => {
+    const cpu = new X86CPU(buildWindowImage());
+    const plugin = createUser32ImportPlugin();
+    const result = await cpu.runAsync({ hooks: createHooks(plugin), maxSteps: 400 });
+    expect(result.exitReason).toBe('halt');
+    expect(cpu.memory.readUInt(IMAGE_BASE + BigInt(POSTED_VALUE), 8)).toBe(7n);
+    expect(cpu.memory.readUInt(IMAGE_BASE + BigInt(SENT_VALUE), 8)).toBe(5n);
+    const counts = Object.fromEntries(result.importCounts.map(({ name, count }) => [name, count]));
+    expect(counts).toMatchObject({ DefWindowProcW: 1, SendMessageW: 1, GetMessageW: 2, DispatchMessageW: 1 });
+    expect(cpu.guestFrames).toHaveLength(0);
+    expect(cpu.readRegister('rsp')).toBe(cpu.memory.stack.initialPointer - 0x68n);
+    const [window] = plugin.stationFor(cpu).windows.values();
+    expect(window.windowClass.name).toBe('Demo');
+    plugin.reset();
+  });
+
+  it('parks GetMessage on an empty queue until a message is posted', async () => {
+    const cpu = new X86CPU(buildWindowImage());
+    const plugin = createUser32ImportPlugin();
+    const hooks = createHooks(plugin);
+    const station = plugin.stationFor(cpu);
+    const originalPost = station.post.bind(station);
+    station.post = () => true;
+    const parked = cpu.run({ hooks, maxSteps: 400 });
+    expect(parked.suspended).toBe(true);
+    expect(cpu.thunks.entryAt(cpu.readRegister('rip')).name).toBe('GetMessageW');
+    const resumed = cpu.runAsync({ hooks, maxSteps: 400 });
+    const [window] = station.windows.values();
+    setTimeout(() => originalPost(window.hwnd, WM_USER + 1, 9n, 0n), 0);
+    expect((await resumed).exitReason).toBe('halt');
+    expect(cpu.memory.readUInt(IMAGE_BASE + BigInt(POSTED_VALUE), 8)).toBe(9n);
+    plugin.reset();
+  });
+
+  it('presents a WineJS run once the guest parks in its message loop', async () => {
+    const user32 = createUser32ImportPlugin();
+    const ended = [];
+    const wine = new WineJS({
+      imageCache: null,
+      importPlugins: [user32],
+      simulatorPlugins: [createX86SimulatorPlugin({ getSimulatorClass: () => X86Simulator })],
+      plugins: [{ onSessionEnd: ({ simulation }) => ended.push(simulation.exitReason) }],
+    });
+    const image = buildMessageLoopImage();
+    const file = { name: 'loop.exe', size: image.length };
+    wine.modules.set(file.name, image);
+
+    const simulation = await wine.run(file);
+    expect(simulation.exitReason).toBe('message-loop');
+    expect(simulation.interactive).toBe(true);
+    expect(simulation.guiIntent).toBe(true);
+    expect(ended).toEqual([]);
+
+    user32.station.queue().postQuit(0);
+    expect((await simulation.session).exitReason).toBe('halt');
+    expect(ended).toEqual(['halt']);
+
+    const rerun = await wine.run(file);
+    wine.resetGuestServices();
+    expect((await rerun.session).exitReason).toBe('halt');
+    expect(ended).toEqual(['halt']);
+  });
+
+  it('hands a parked GetMessage WM_QUIT when the plugin is reset', async () => {
+    const cpu = new X86CPU(buildWindowImage());
+    const plugin = createUser32ImportPlugin();
+    const hooks = createHooks(plugin);
+    const station = plugin.stationFor(cpu);
+    station.post = () => true;
+    expect(cpu.run({ hooks, maxSteps: 400 }).suspended).toBe(true);
+    const resumed = cpu.runAsync({ hooks, maxSteps: 400 });
+    setTimeout(() => plugin.reset(), 0);
+    expect((await resumed).exitReason).toBe('halt');
+    expect(cpu.memory.readUInt(IMAGE_BASE + BigInt(MSG + 8), 4)).toBe(BigInt(WM_QUIT));
+    expect(station.queue().waiters).toHaveLength(0);
+    await station.queue().wait();
+  });
+});
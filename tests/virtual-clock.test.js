@@ -0,0 +1,144 @@
+import { describe, it, expect } from 'vitest';
+import { PeFile } from '../src/emulator/pe-file.js';
+import { X86CPU } from '../src/emulator/x86/cpu.js';
+import { createImportBinder } from '../src/runtime/import-handler.js';
+import { VirtualClock } from '../src/runtime/services/virtual-clock.js';
+import { createTimeImportPlugin } from '../src/runtime/import-plugins/time-plugin.js';
+import { createWaitImportPlugin } from '../src/runtime/import-plugins/wait-plugin.js';
+import { PeImageBuilder } from './helpers/pe-builder.js';
+import { Assembler } from './helpers/assembler.js';
+
+const IMAGE_BASE = 0x140000000n;
+const FIRST_COUNT = 0x3000;
+const SECOND_COUNT = 0x3008;
+const DUE_TIME = 0x3010;
+
+// Samples QueryPerformanceCounter around Sleep(60000) and a waitable timer
+// armed 2 s out and waited on with WaitForSingleObject.
+function buildTimingImage() {
+  const builder = new PeImageBuilder()
+    .section('.text', 0x1000, 0x200)
+    .section('.idata', 0x2000, 0x400)
+    .section('.data', 0x3000, 0x200, 0xc0000040);
+  const iat = builder.imports(0x2000, 'KERNEL32.dll', [
+    'QueryPerformanceCounter',
+    'Sleep',
+    'CreateWaitableTimerW',
+    'SetWaitableTimer',
+    'WaitForSingleObject',
+  ]);
+  const asm = new Assembler(0x1000)
+    .emit(0x48, 0x83, 0xec, 0x38)
+    .ripRel([0x48, 0x8d, 0x0d], FIRST_COUNT)
+    .call(iat.QueryPerformanceCounter)
+    .emit(0xb9, 0x60, 0xea, 0x00, 0x00)
+    .call(iat.Sleep)
+    .emit(0x31, 0xc9, 0x31, 0xd2, 0x45, 0x31, 0xc0)
+    .call(iat.CreateWaitableTimerW)
+    .emit(0x48, 0x89, 0xc3, 0x48, 0x89, 0xc1)
+    .ripRel([0x48, 0x8d, 0x15], DUE_TIME)
+    .emit(0x45, 0x31, 0xc0, 0x45, 0x31, 0xc9)
+    .call(iat.SetWaitableTimer)
+    .emit(0x48, 0x89, 0xd9, 0xba, 0xff, 0xff, 0xff, 0xff)
+    .call(iat.WaitForSingleObject)
+    .ripRel([0x48, 0x8d, 0x0d], SECOND_COUNT)
+    .call(iat.QueryPerformanceCounter)
+    .emit(0xf4);
+  builder.bytes(0x1000, asm.bytes()).u64(DUE_TIME, -20000000n);
+  return new PeFile(builder.build());
+}
+
+describe('VirtualClock', () => {
+  it('jumps idle waits to the next deadline in fast-forward mode', async () => {
+    const clock = new VirtualClock({ fastForward: true, hostNow: () => 0 });
+    const fired = [];
+    const interval = clock.setInterval(() => fired.push(clock.now()), 16);
+    await clock.sleep(100);
+    clock.clearInterval(interval);
+    expect(clock.now()).toBe(100);
+    expect(fired).toEqual([16, 32, 48, 64, 80, 96]);
+  });
+
+  it('keeps real-time deadlines against host time', async () => {
+    let host = 0;
+    const scheduled = [];
+    const clock = new VirtualClock({
+      hostNow: () => host,
+      hostSetTimeout: (fn, ms) => scheduled.push({ fn, ms }),
+      hostClearTimeout: () => {},
+    });
+    let fired = false;
+    clock.setTimeout(() => (fired = true), 50);
+    expect(scheduled.at(-1).ms).toBe(50);
+    host = 50;
+    scheduled.at(-1).fn();
+    expect(fired).toBe(true);
+    expect(clock.now()).toBe(50);
+  });
+});
+
+describe('time import plugin', () => {
+  it('advances the performance counter through fast-forwarded waits', async () => {
+    const clock = new VirtualClock({ fastForward: true });
+    const timePlugin = createTimeImportPlugin({ getClock: () => clock });
+    const waitPlugin = createWaitImportPlugin({
+      waitForObject: (handle) => timePlugin.waitForObject(handle),
+      schedule: (fn, ms) => clock.setTimeout(fn, ms),
+    });
+    const bind = createImportBinder({ plugins: [timePlugin, waitPlugin] });
+    const cpu = new X86CPU(buildTimingImage());
+    const started = performance.now();
+    const result = await cpu.runAsync({ hooks: { bindImport: (key) => bind(key, {}) }, maxSteps: 200 });
+    expect(result.exitReason).toBe('halt');
+    expect(performance.now() - started).toBeLessThan(2000);
+    const ticks =
+      cpu.memory.readUInt(IMAGE_BASE + BigInt(SECOND_COUNT), 8) - cpu.memory.readUInt(IMAGE_BASE + BigInt(FIRST_COUNT), 8);
+    expect(ticks >= 620000000n).toBe(true);
+    expect(clock.now()).toBeGreaterThanOrEqual(62000);
+  });
+});
+
+describe('timer waits', () => {
+  // Calls a kernel32 handler with the given argument registers; `memory`
+  // backs the pointer reads SetWaitableTimer makes.
+  function createCaller(plugins, memory = new Map()) {
+    return (name, rcx = 0n, rdx = 0n, r8 = 0n) => {
+      const registers = { rcx: BigInt(rcx), rdx: BigInt(rdx), r8: BigInt(r8) };
+      const cpu = {
+        readRegister: (register) => registers[register] ?? 0n,
+        memory: { readUInt: (address) => memory.get(address) },
+      };
+      const handler = plugins.map((plugin) => plugin.resolveHandler(`kernel32.dll!${name}`)).find(Boolean);
+      return Promise.resolve(handler({ cpu })).then((result) => BigInt(result.rax));
+    };
+  }
+
+  it('leaves a timed-out wait no claim on the next signal', async () => {
+    const clock = new VirtualClock({ fastForward: true });
+    const timePlugin = createTimeImportPlugin({ getClock: () => clock });
+    const waitPlugin = createWaitImportPlugin({
+      waitForObject: (handle, options) => timePlugin.waitForObject(handle, options),
+      schedule: (fn, ms) => clock.setTimeout(fn, ms),
+      unschedule: (id) => clock.clearTimeout(id),
+    });
+    const call = createCaller([timePlugin, waitPlugin], new Map([[0x10n, -500000n]]));
+    const timer = await call('createwaitabletimerw');
+
+    expect(await call('waitforsingleobject', timer, 10)).toBe(0x102n);
+    await call('setwaitabletimer', timer, 0x10n);
+    await clock.sleep(100);
+    expect(await call('waitforsingleobject', timer, 10)).toBe(0n);
+
+    await call('setwaitabletimer', timer, 0x10n);
+    expect(await call('waitforsingleobject', timer, 5000)).toBe(0n);
+    expect(clock.timers.size).toBe(0);
+  });
+
+  it('fails pending sleeps, INFINITE included, on reset', async () => {
+    const waitPlugin = createWaitImportPlugin();
+    const call = createCaller([waitPlugin]);
+    const forever = call('sleep', 0xffffffff);
+    waitPlugin.reset();
+    await expect(forever).rejects.toThrow(/reset/);
+  });
+});
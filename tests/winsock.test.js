@@ -0,0 +1,78 @@
+import { describe, it, expect } from 'vitest';
+import { WinsockBridge } from '../src/runtime/services/winsock-bridge.js';
+import { createWinsockWebSocketImportPlugin } from '../src/runtime/import-plugins/winsock-websocket-plugin.js';
+
+const SOCKET_ERROR = 0xffffffffn;
+
+// Backend bridge stand-in whose pushed events the test fires by hand.
+function createBackend() {
+  const handlers = new Map();
+  return {
+    connected: true,
+    isConnected() {
+      return this.connected;
+    },
+    request: async () => ({}),
+    subscribe: (event, handler) => {
+      handlers.set(event, handler);
+      return () => handlers.delete(event);
+    },
+    push: (event, payload) => handlers.get(event)?.(payload),
+  };
+}
+
+// recv(socket, 0x1000, length, 0) against a buffer the test can read back.
+function createRecv(bridge) {
+  const plugin = createWinsockWebSocketImportPlugin({ getWinsockBridge: () => bridge });
+  const recv = plugin.resolveHandler('ws2_32.dll!recv');
+  const written = [];
+  return {
+    written,
+    call: async (socket, length = 16) => {
+      const registers = { rcx: BigInt(socket), rdx: 0x1000n, r8: BigInt(length) };
+      const cpu = {
+        readRegister: (name) => registers[name] ?? 0n,
+        memory: { write: (address, bytes) => written.push(Array.from(bytes)) },
+      };
+      return BigInt((await recv({ cpu })).rax);
+    },
+  };
+}
+
+describe('winsock recv', () => {
+  it('delivers queued and late data on an open socket', async () => {
+    const backend = createBackend();
+    const bridge = new WinsockBridge({ bridge: backend });
+    await bridge.openConnection({ connectionId: 7, host: '10.0.0.1', port: 80 });
+    const recv = createRecv(bridge);
+    backend.push('winsock:data', { connectionId: 7, data: 'AQID' });
+    expect(await recv.call(7)).toBe(3n);
+    const pending = recv.call(7);
+    backend.push('winsock:data', { connectionId: 7, data: 'BA==' });
+    expect(await pending).toBe(1n);
+    expect(recv.written).toEqual([[1, 2, 3], [4]]);
+  });
+
+  it('returns instead of waiting on closed, failed and unknown sockets', async () => {
+    const backend = createBackend();
+    const bridge = new WinsockBridge({ bridge: backend });
+    const recv = createRecv(bridge);
+    await bridge.openConnection({ connectionId: 1, host: '10.0.0.1', port: 80 });
+    await bridge.openConnection({ connectionId: 2, host: '10.0.0.1', port: 81 });
+    await bridge.openConnection({ connectionId: 3, host: '10.0.0.1', port: 82 });
+
+    const parked = recv.call(1);
+    backend.push('winsock:closed', { connectionId: 1 });
+    expect(await parked).toBe(0n);
+    expect(await recv.call(1)).toBe(0n);
+
+    backend.push('winsock:error', { connectionId: 2 });
+    expect(await recv.call(2)).toBe(SOCKET_ERROR);
+    expect(await recv.call(9)).toBe(SOCKET_ERROR);
+
+    const lost = recv.call(3);
+    bridge.setBridge(null);
+    expect(await lost).toBe(SOCKET_ERROR);
+    expect(bridge.listeners.size).toBe(0);
+  });
+});